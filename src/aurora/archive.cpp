@@ -23,6 +23,8 @@
  */
 
 #include "src/common/system.h"
+#include "src/common/memreadstream.h"
+#include "src/common/mappedfile.h"
 
 #include "src/aurora/archive.h"
 
@@ -64,4 +66,17 @@ uint32_t Archive::findResource(const Common::UString &name, FileType type) const
 	return 0xFFFFFFFF;
 }
 
+Common::SeekableReadStream *Archive::getSubStream(Common::SeekableReadStream &archive,
+                                                  size_t offset, size_t size, bool tryNoCopy) {
+
+	const Common::MappedFileReadStream *mapped = dynamic_cast<const Common::MappedFileReadStream *>(&archive);
+	if (mapped)
+		return mapped->createView(offset, offset + size);
+
+	if (tryNoCopy)
+		return new Common::SeekableSubReadStream(&archive, offset, offset + size);
+
+	return archive.readStreamAt(offset, size);
+}
+
 } // End of namespace Aurora
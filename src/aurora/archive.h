@@ -80,6 +80,27 @@ public:
 	uint32_t findResource(uint64_t hash) const;
 	/** Return the index of the resource matching the name and type, or 0xFFFFFFFF if not found. */
 	uint32_t findResource(const Common::UString &name, FileType type) const;
+
+protected:
+	/** Return a stream of a part of an archive's data.
+	 *
+	 *  If the archive data is a memory-mapped file, this returns a view into
+	 *  the mapping, without copying anything. Otherwise, if tryNoCopy is true,
+	 *  a SeekableSubReadStream of the archive stream is returned. If not, the
+	 *  data is read into a new MemoryReadStream.
+	 *
+	 *  All of these only ever use positional reads on the archive stream and
+	 *  never change its position, so several threads can get resources out
+	 *  of the same archive at the same time.
+	 *
+	 *  @param  archive The stream of the whole archive.
+	 *  @param  offset The offset of the data within the archive.
+	 *  @param  size The size of the data.
+	 *  @param  tryNoCopy Try to return a SeekableSubReadStream of the archive instead of copying.
+	 *  @return A (sub)stream of the data.
+	 */
+	static Common::SeekableReadStream *getSubStream(Common::SeekableReadStream &archive,
+	                                                size_t offset, size_t size, bool tryNoCopy);
 };
 
 } // End of namespace Aurora
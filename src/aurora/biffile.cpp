@@ -141,12 +141,7 @@ uint32_t BIFFile::getResourceSize(uint32_t index) const {
 Common::SeekableReadStream *BIFFile::getResource(uint32_t index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy)
-		return new Common::SeekableSubReadStream(_bif.get(), res.offset, res.offset + res.size);
-
-	_bif->seek(res.offset);
-
-	return _bif->readStream(res.size);
+	return getSubStream(*_bif, res.offset, res.size, tryNoCopy);
 }
 
 } // End of namespace Aurora
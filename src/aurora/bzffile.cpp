@@ -27,6 +27,8 @@
 
 #include <cassert>
 
+#include <memory>
+
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
@@ -145,10 +147,10 @@ uint32_t BZFFile::getResourceSize(uint32_t index) const {
 Common::SeekableReadStream *BZFFile::getResource(uint32_t index, bool UNUSED(tryNoCopy)) const {
 	const IResource &res = getIResource(index);
 
-	_bzf->seek(res.offset);
-
 #ifdef ENABLE_LZMA
-	return Common::decompressLZMA1(*_bzf, res.packedSize, res.size, true);
+	std::unique_ptr<Common::SeekableReadStream> packed(_bzf->readStreamAt(res.offset, res.packedSize));
+
+	return Common::decompressLZMA1(*packed, res.packedSize, res.size, true);
 #else
 	throw Common::Exception("LZMA decompression disabled when building without liblzma");
 #endif
@@ -34,6 +34,7 @@
 
 #include "src/common/memreadstream.h"
 #include "src/common/readfile.h"
+#include "src/common/mappedfile.h"
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
@@ -718,13 +719,23 @@ uint32_t ERFFile::getResourceSize(uint32_t index) const {
 Common::SeekableReadStream *ERFFile::getResource(uint32_t index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy && (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone))
-		return new Common::SeekableSubReadStream(_erf.get(), res.offset, res.offset + res.packedSize);
+	const bool isPlain = (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone);
 
-	_erf->seek(res.offset);
+	const Common::MappedFileReadStream *mapped = dynamic_cast<const Common::MappedFileReadStream *>(_erf.get());
+	if ((mapped || tryNoCopy) && isPlain)
+		return getSubStream(*_erf, res.offset, res.packedSize, tryNoCopy);
 
 	// Read
-	Common::MemoryReadStream *stream = _erf->readStream(res.packedSize);
+	Common::MemoryReadStream *stream = 0;
+	if (mapped) {
+		// Decrypt and decompress straight out of the mapping, without copying the packed data first
+		if ((res.offset > mapped->size()) || (res.packedSize > (mapped->size() - res.offset)))
+			throw Common::Exception(Common::kReadError);
+
+		stream = new Common::MemoryReadStream(mapped->getData() + res.offset, res.packedSize);
+
+	} else
+		stream = _erf->readStreamAt(res.offset, res.packedSize);
 
 	// Decrypt
 	if (_header.encryption != kEncryptionNone)
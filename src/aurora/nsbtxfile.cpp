@@ -100,6 +100,12 @@ uint32_t NSBTXFile::getITEXSize(const Texture &texture) {
 	return kXEOSITEXHeaderSize + kXEOSITEXMipMapHeaderSize + texture.width * texture.height * 4;
 }
 
+uint32_t NSBTXFile::getDataSize(const Texture &texture) {
+	static const uint8_t kBitsPerPixel[] = { 0, 8, 2, 4, 8, 0, 8, 16 };
+
+	return (texture.width * texture.height * kBitsPerPixel[(size_t)texture.format]) / 8;
+}
+
 uint32_t NSBTXFile::getResourceSize(uint32_t index) const {
 	if (index >= _textures.size())
 		throw Common::Exception("Texture index out of range (%u/%u)", index, (uint)_textures.size());
@@ -107,6 +113,17 @@ uint32_t NSBTXFile::getResourceSize(uint32_t index) const {
 	return getITEXSize(_textures[index]);
 }
 
+Common::MemoryReadStreamEndian *NSBTXFile::readDataAt(Common::SeekableSubReadStreamEndian &nsbtx,
+                                                      size_t offset, size_t size) {
+
+	std::unique_ptr<byte[]> data = std::make_unique<byte[]>(size);
+
+	if (nsbtx.readAt(offset, data.get(), size) != size)
+		throw Common::Exception(Common::kReadError);
+
+	return new Common::MemoryReadStreamEndian(data.release(), size, nsbtx.isBigEndian(), true);
+}
+
 void NSBTXFile::writeITEXHeader(const ReadContext &ctx) {
 	ctx.stream->writeUint32BE(kXEOSID);
 	ctx.stream->writeUint32BE(kITEXID);
@@ -139,7 +156,7 @@ void NSBTXFile::getTexture2bpp(const ReadContext &ctx) {
 	for (uint32_t y = 0; y < ctx.texture->height; y++) {
 		for (uint32_t x = 0; x < ctx.texture->width; ) {
 
-			uint8_t pixels = ctx.nsbtx->readByte();
+			uint8_t pixels = ctx.data->readByte();
 			for (uint32_t n = 0; n < 4; n++, x++, pixels >>= 2) {
 				const uint8_t pixel = pixels & 3;
 
@@ -160,7 +177,7 @@ void NSBTXFile::getTexture4bpp(const ReadContext &ctx) {
 	for (uint32_t y = 0; y < ctx.texture->height; y++) {
 		for (uint32_t x = 0; x < ctx.texture->width; ) {
 
-			uint8_t pixels = ctx.nsbtx->readByte();
+			uint8_t pixels = ctx.data->readByte();
 			for (uint32_t n = 0; n < 2; n++, x++, pixels >>= 4) {
 				const uint8_t pixel = pixels & 0xF;
 
@@ -180,7 +197,7 @@ void NSBTXFile::getTexture4bpp(const ReadContext &ctx) {
 void NSBTXFile::getTexture8bpp(const ReadContext &ctx) {
 	for (uint32_t y = 0; y < ctx.texture->height; y++) {
 		for (uint32_t x = 0; x < ctx.texture->width; x++) {
-			const uint8_t pixel = ctx.nsbtx->readByte();
+			const uint8_t pixel = ctx.data->readByte();
 
 			const byte r = ctx.palette[pixel * 3 + 0];
 			const byte g = ctx.palette[pixel * 3 + 1];
@@ -196,7 +213,7 @@ void NSBTXFile::getTexture8bpp(const ReadContext &ctx) {
 void NSBTXFile::getTexture16bpp(const ReadContext &ctx) {
 	for (uint32_t y = 0; y < ctx.texture->height; y++) {
 		for (uint32_t x = 0; x < ctx.texture->width; x++) {
-			const uint16_t pixel = ctx.nsbtx->readUint16();
+			const uint16_t pixel = ctx.data->readUint16();
 
 			const byte r = ( pixel        & 0x1F) << 3;
 			const byte g = ((pixel >>  5) & 0x1F) << 3;
@@ -212,7 +229,7 @@ void NSBTXFile::getTexture16bpp(const ReadContext &ctx) {
 void NSBTXFile::getTextureA3I5(const ReadContext &ctx) {
 	for (uint32_t y = 0; y < ctx.texture->height; y++) {
 		for (uint32_t x = 0; x < ctx.texture->width; x++) {
-			const uint8_t pixel = ctx.nsbtx->readByte();
+			const uint8_t pixel = ctx.data->readByte();
 
 			const uint8_t index = pixel & 0x1F;
 
@@ -230,7 +247,7 @@ void NSBTXFile::getTextureA3I5(const ReadContext &ctx) {
 void NSBTXFile::getTextureA5I3(const ReadContext &ctx) {
 	for (uint32_t y = 0; y < ctx.texture->height; y++) {
 		for (uint32_t x = 0; x < ctx.texture->width; x++) {
-			const uint8_t pixel = ctx.nsbtx->readByte();
+			const uint8_t pixel = ctx.data->readByte();
 
 			const uint8_t index = pixel & 0x07;
 
@@ -275,12 +292,15 @@ void NSBTXFile::getPalette(ReadContext &ctx) const {
 	std::unique_ptr<byte[]> palData = std::make_unique<byte[]>(size);
 	memset(palData.get(), 0, size);
 
-	ctx.nsbtx->seek(palette->offset);
+	const size_t available = ctx.nsbtx->size() - MIN<size_t>(palette->offset, ctx.nsbtx->size());
+
+	const uint16_t palDataSize = MIN<size_t>(size, (available / 2) * 3);
 
-	const uint16_t palDataSize = MIN<size_t>(size, ((ctx.nsbtx->size() - ctx.nsbtx->pos()) / 2) * 3);
+	std::unique_ptr<Common::MemoryReadStreamEndian>
+		palStream(readDataAt(*ctx.nsbtx, palette->offset, (palDataSize / 3) * 2));
 
 	for (uint16_t i = 0; i < palDataSize; i += 3) {
-		const uint16_t pixel = ctx.nsbtx->readUint16();
+		const uint16_t pixel = palStream->readUint16();
 
 		palData[i + 0] = ( pixel        & 0x1F) << 3;
 		palData[i + 1] = ((pixel >>  5) & 0x1F) << 3;
@@ -290,8 +310,8 @@ void NSBTXFile::getPalette(ReadContext &ctx) const {
 	ctx.palette.reset(palData.release());
 }
 
-void NSBTXFile::getTexture(const ReadContext &ctx) {
-	ctx.nsbtx->seek(ctx.texture->offset);
+void NSBTXFile::getTexture(ReadContext &ctx) {
+	ctx.data.reset(readDataAt(*ctx.nsbtx, ctx.texture->offset, getDataSize(*ctx.texture)));
 
 	switch (ctx.texture->format) {
 		case kFormat2bpp:
@@ -38,6 +38,7 @@
 
 namespace Common {
 	class WriteStream;
+	class MemoryReadStreamEndian;
 }
 
 namespace Aurora {
@@ -107,6 +108,9 @@ private:
 		Common::SeekableSubReadStreamEndian *nsbtx;
 		Common::WriteStream *stream;
 
+		/** The pixel data of the texture, read out of the NSBTX in one go. */
+		std::unique_ptr<Common::MemoryReadStreamEndian> data;
+
 		ReadContext(Common::SeekableSubReadStreamEndian &n, const Texture &t, Common::WriteStream &s);
 		~ReadContext();
 	};
@@ -147,11 +151,16 @@ private:
 	void getPalette(ReadContext &ctx) const;
 
 	static uint32_t getITEXSize(const Texture &texture);
+	static uint32_t getDataSize(const Texture &texture);
+
+	/** Read data out of the NSBTX without changing its stream position. */
+	static Common::MemoryReadStreamEndian *readDataAt(Common::SeekableSubReadStreamEndian &nsbtx,
+	                                                  size_t offset, size_t size);
 
 	static void writeITEXHeader(const ReadContext &ctx);
 	static void writePixel(const ReadContext &ctx, byte r, byte g, byte b, byte a);
 
-	static void getTexture     (const ReadContext &ctx);
+	static void getTexture     (ReadContext &ctx);
 	static void getTexture2bpp (const ReadContext &ctx);
 	static void getTexture4bpp (const ReadContext &ctx);
 	static void getTexture8bpp (const ReadContext &ctx);
@@ -85,17 +85,7 @@ FunctionContext FunctionManager::createContext(const Common::UString &function)
 }
 
 void FunctionManager::call(const Common::UString &function, FunctionContext &ctx) const {
-	debugCN(Common::kDebugEngineScripts, 5, "%s %s(%s)", formatType(ctx.getReturn().getType()).c_str(),
-	        ctx.getName().c_str(), formatParams(ctx).c_str());
-
-	find(function).func(ctx);
-
-	const Common::UString r = formatReturn(ctx);
-	debugC(Common::kDebugEngineScripts, 5, "%s%s", r.empty() ? "" : " => ", r.c_str());
-
-	if (DebugMan.getVerbosityLevel(Common::kDebugEngineScripts) < 5)
-		debugC(Common::kDebugEngineScripts, 2, "%s %s(%s)%s%s", formatType(ctx.getReturn().getType()).c_str(),
-		       ctx.getName().c_str(), formatParams(ctx).c_str(), r.empty() ? "" : " => ", r.c_str());
+	callFunction(find(function), ctx);
 }
 
 FunctionContext FunctionManager::createContext(uint32_t function) const {
@@ -103,10 +93,20 @@ FunctionContext FunctionManager::createContext(uint32_t function) const {
 }
 
 void FunctionManager::call(uint32_t function, FunctionContext &ctx) const {
+	callFunction(find(function), ctx);
+}
+
+void FunctionManager::callFunction(const FunctionEntry &function, FunctionContext &ctx) const {
+	// Formatting all the parameters is expensive, so only do that when anybody's listening
+	if (!DebugMan.isEnabled(Common::kDebugEngineScripts, 2)) {
+		function.func(ctx);
+		return;
+	}
+
 	debugCN(Common::kDebugEngineScripts, 5, "%s %s(%s)", formatType(ctx.getReturn().getType()).c_str(),
 	        ctx.getName().c_str(), formatParams(ctx).c_str());
 
-	find(function).func(ctx);
+	function.func(ctx);
 
 	const Common::UString r = formatReturn(ctx);
 	debugC(Common::kDebugEngineScripts, 5, "%s%s", r.empty() ? "" : " => ", r.c_str());
@@ -75,6 +75,8 @@ private:
 
 	const FunctionEntry &find(const Common::UString &function) const;
 	const FunctionEntry &find(uint32_t function) const;
+
+	void callFunction(const FunctionEntry &function, FunctionContext &ctx) const;
 };
 
 } // End of namespace NWScript
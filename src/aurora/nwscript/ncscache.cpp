@@ -0,0 +1,115 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A cache of decoded NWScript programs.
+ */
+
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+
+#include "src/aurora/resman.h"
+
+#include "src/aurora/nwscript/ncscache.h"
+#include "src/aurora/nwscript/ncsprogram.h"
+
+DECLARE_SINGLETON(Aurora::NWScript::NCSCache)
+
+namespace Aurora {
+
+namespace NWScript {
+
+NCSCache::NCSCache() : _generation(0), _hits(0), _misses(0), _invalidations(0) {
+}
+
+NCSCache::~NCSCache() {
+}
+
+std::shared_ptr<const NCSProgram> NCSCache::get(const Common::UString &name) {
+	uint32_t generation;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		checkGeneration();
+
+		ProgramMap::const_iterator program = _programs.find(name);
+		if (program != _programs.end()) {
+			_hits++;
+			return program->second;
+		}
+
+		_misses++;
+		generation = _generation;
+	}
+
+	// Load the program without holding the lock, so that other threads aren't held up
+
+	std::unique_ptr<Common::SeekableReadStream> stream(ResMan.getResource(name, kFileTypeNCS));
+	if (!stream)
+		throw Common::Exception("No such NCS \"%s\"", name.c_str());
+
+	std::shared_ptr<const NCSProgram> program = std::make_shared<NCSProgram>(*stream);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	checkGeneration();
+
+	// Only keep the program if the resources didn't change while we were loading it
+	if (_generation == generation)
+		program = _programs.insert(std::make_pair(name, program)).first->second;
+
+	return program;
+}
+
+void NCSCache::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_programs.clear();
+}
+
+NCSCache::Stats NCSCache::getStats() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Stats stats;
+
+	stats.programCount  = _programs.size();
+	stats.hits          = _hits;
+	stats.misses        = _misses;
+	stats.invalidations = _invalidations;
+
+	return stats;
+}
+
+void NCSCache::checkGeneration() {
+	const uint32_t generation = ResMan.getGeneration();
+	if (generation == _generation)
+		return;
+
+	if (!_programs.empty())
+		_invalidations++;
+
+	_programs.clear();
+	_generation = generation;
+}
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
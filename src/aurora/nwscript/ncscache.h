@@ -0,0 +1,101 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A cache of decoded NWScript programs.
+ */
+
+#ifndef AURORA_NWSCRIPT_NCSCACHE_H
+#define AURORA_NWSCRIPT_NCSCACHE_H
+
+#include <map>
+#include <memory>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/singleton.h"
+#include "src/common/mutex.h"
+
+namespace Aurora {
+
+namespace NWScript {
+
+class NCSProgram;
+
+/** A process-wide cache of decoded NWScript programs, indexed by resref.
+ *
+ *  Decoded programs are immutable, so any number of scripts can run the
+ *  same program at the same time. Running a script by name then only
+ *  needs to allocate the script's execution state.
+ *
+ *  Whenever the resources known to the resource manager change, for
+ *  example when a change set is undone on leaving a module, the whole
+ *  cache is dropped. Scripts still running keep their program alive.
+ */
+class NCSCache : public Common::Singleton<NCSCache> {
+public:
+	struct Stats {
+		size_t programCount; ///< The number of programs currently cached.
+
+		uint64_t hits;          ///< The number of programs found in the cache.
+		uint64_t misses;        ///< The number of programs that had to be loaded.
+		uint64_t invalidations; ///< The number of times the cache was dropped.
+	};
+
+	NCSCache();
+	~NCSCache();
+
+	/** Return the decoded program of this script, loading it if necessary.
+	 *
+	 *  Throws an exception if the script doesn't exist or is broken.
+	 */
+	std::shared_ptr<const NCSProgram> get(const Common::UString &name);
+
+	/** Remove all programs from the cache. */
+	void clear();
+
+	Stats getStats() const;
+
+private:
+	typedef std::map<Common::UString, std::shared_ptr<const NCSProgram>, Common::UString::iless> ProgramMap;
+
+	ProgramMap _programs;
+
+	/** The resource manager generation the cached programs were loaded in. */
+	uint32_t _generation;
+
+	uint64_t _hits;
+	uint64_t _misses;
+	uint64_t _invalidations;
+
+	mutable std::mutex _mutex;
+
+	/** Drop all programs if the resources changed since they were loaded. */
+	void checkGeneration();
+};
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
+
+/** Shortcut for accessing the NWScript program cache. */
+#define NCSCacheMan Aurora::NWScript::NCSCache::instance()
+
+#endif // AURORA_NWSCRIPT_NCSCACHE_H
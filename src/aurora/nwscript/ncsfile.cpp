@@ -30,6 +30,10 @@
 
 #include <cassert>
 
+#include <vector>
+#include <utility>
+#include <chrono>
+
 #include <boost/make_shared.hpp>
 
 #include "src/common/util.h"
@@ -37,34 +41,68 @@
 #include "src/common/maths.h"
 #include "src/common/ustring.h"
 #include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
 #include "src/common/encoding.h"
 #include "src/common/debug.h"
-
-#include "src/aurora/resman.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/nwscript/ncsfile.h"
+#include "src/aurora/nwscript/ncscache.h"
+#include "src/aurora/nwscript/ncsprofiler.h"
 #include "src/aurora/nwscript/object.h"
 #include "src/aurora/nwscript/functionman.h"
 
 using Common::kDebugScripts;
 
-static const uint32_t kNCSTag    = MKTAG('N', 'C', 'S', ' ');
-static const uint32_t kVersion10 = MKTAG('V', '1', '.', '0');
-
 static const uint32_t kScriptObjectSelf        = 0x00000000;
 static const uint32_t kScriptObjectInvalid     = 0x00000001;
 static const uint32_t kScriptObjectInvalid2    = 0xFFFFFFFF;
 static const uint32_t kScriptObjectTypeInvalid = 0x7F000000;
 
+/** The number of stack elements a new stack has room for. */
+static const size_t kStackReserve = 256;
+/** The maximum number of stacks kept around for reuse. */
+static const size_t kSpareStacks  = 16;
+
 namespace Aurora {
 
 namespace NWScript {
 
+/** The storage of stacks of finished scripts, for the next scripts to reuse.
+ *
+ *  That way, running a script doesn't need to allocate its stack anew.
+ */
+static std::vector< std::vector<Variable> > spareStacks;
+static std::mutex spareStacksMutex;
+
 NCSStack::NCSStack() {
+	{
+		std::lock_guard<std::mutex> lock(spareStacksMutex);
+
+		if (!spareStacks.empty()) {
+			swap(spareStacks.back());
+			spareStacks.pop_back();
+		}
+	}
+
+	if (capacity() < kStackReserve)
+		reserve(kStackReserve);
+
 	reset();
 }
 
 NCSStack::~NCSStack() {
+	try {
+		clear();
+
+		std::lock_guard<std::mutex> lock(spareStacksMutex);
+
+		if (spareStacks.size() < kSpareStacks) {
+			spareStacks.push_back(std::vector<Variable>());
+			spareStacks.back().swap(*this);
+		}
+	} catch (...) {
+	}
 }
 
 void NCSStack::reset() {
@@ -89,7 +127,21 @@ Variable NCSStack::pop() {
 	if (_stackPtr == -1)
 		throw Common::Exception("NCSStack: Stack underflow");
 
-	return at(_stackPtr--);
+	return std::move(at(_stackPtr--));
+}
+
+int32_t NCSStack::popInt() {
+	if (_stackPtr == -1)
+		throw Common::Exception("NCSStack: Stack underflow");
+
+	return at(_stackPtr--).getInt();
+}
+
+float NCSStack::popFloat() {
+	if (_stackPtr == -1)
+		throw Common::Exception("NCSStack: Stack underflow");
+
+	return at(_stackPtr--).getFloat();
 }
 
 void NCSStack::push(const Variable &obj) {
@@ -104,6 +156,18 @@ void NCSStack::push(const Variable &obj) {
 	_stackPtr++;
 }
 
+void NCSStack::push(Variable &&obj) {
+	if (_stackPtr == 0x7FFFFFFF) // Like this will ever happen :P
+		throw Common::Exception("NCSStack: Stack overflow");
+
+	if (_stackPtr == (int32_t)size() - 1)
+		push_back(std::move(obj));
+	else
+		at(_stackPtr + 1) = std::move(obj);
+
+	_stackPtr++;
+}
+
 Variable &NCSStack::getRelSP(int32_t pos) {
 	if ((pos > -4) || ((pos % 4) != 0))
 		throw Common::Exception("NCSStack::get(): Illegal position %d", pos);
@@ -276,18 +340,19 @@ void NCSFile::setupOpcodes() {
 
 #undef OPCODE
 
-NCSFile::NCSFile(Common::SeekableReadStream *ncs) : _script(ncs) {
-	assert(_script);
+NCSFile::NCSFile(Common::SeekableReadStream *ncs) : _interpreter(kInterpreterDecoded),
+	_instructionBudget(0), _suspended(false), _resumeInstruction(NCSProgram::kInvalidInstruction) {
 
-	load();
+	assert(ncs);
+
+	std::unique_ptr<Common::SeekableReadStream> stream(ncs);
+	load(std::make_shared<NCSProgram>(*stream));
 }
 
-NCSFile::NCSFile(const Common::UString &ncs) : _name(ncs) {
-	_script.reset(ResMan.getResource(ncs, kFileTypeNCS));
-	if (!_script)
-		throw Common::Exception("No such NCS \"%s\"", ncs.c_str());
+NCSFile::NCSFile(const Common::UString &ncs) : _name(ncs), _interpreter(kInterpreterDecoded),
+	_instructionBudget(0), _suspended(false), _resumeInstruction(NCSProgram::kInvalidInstruction) {
 
-	load();
+	load(NCSCacheMan.get(ncs));
 }
 
 NCSFile::~NCSFile() {
@@ -305,6 +370,26 @@ void NCSFile::setEnvironment(const VariableContainer &env) {
 	_env = env;
 }
 
+void NCSFile::setInterpreter(Interpreter interpreter) {
+	_interpreter = interpreter;
+}
+
+NCSFile::Interpreter NCSFile::getInterpreter() const {
+	return _interpreter;
+}
+
+void NCSFile::setInstructionBudget(size_t budget) {
+	_instructionBudget = budget;
+}
+
+size_t NCSFile::getInstructionBudget() const {
+	return _instructionBudget;
+}
+
+bool NCSFile::isSuspended() const {
+	return _suspended;
+}
+
 void NCSFile::setParameters(std::vector<int> parameters) {
 	_parameters = parameters;
 }
@@ -327,29 +412,16 @@ const Common::UString &NCSFile::getParameterString() const {
 ScriptState NCSFile::getEmptyState() {
 	ScriptState state;
 
-	state.offset = 13; // 8 byte header + 5 byte program size dummy op
+	state.offset = NCSProgram::kStartOffset;
 
 	return state;
 }
 
-void NCSFile::load() {
-	readHeader(*_script);
-
-	if (_id != kNCSTag)
-		throw Common::Exception("Try to load non-NCS file");
-
-	if (_version != kVersion10)
-		throw Common::Exception("Unsupported NCS file version %08X", _version);
+void NCSFile::load(const std::shared_ptr<const NCSProgram> &program) {
+	_program = program;
 
-	byte lengthOpcode = _script->readByte();
-	if (lengthOpcode != 0x42)
-		throw Common::Exception("Script size opcode != 0x42 (0x%02X)", lengthOpcode);
-
-	uint32_t length = _script->readUint32BE();
-	if (length > ((uint32_t) _script->size()))
-		throw Common::Exception("Script size %u > stream size %u", length, (uint)_script->size());
-	if (length < ((uint32_t) _script->size()))
-		warning("TODO: NCSFile::load(): Script size %u < stream size %u", length, (uint)_script->size());
+	_script = std::make_unique<Common::MemoryReadStream>(_program->getData(), _program->getSize());
+	readHeader(*_script);
 
 	setupOpcodes();
 
@@ -365,7 +437,9 @@ void NCSFile::reset() {
 	_storedState.setType(kTypeVoid);
 	_return.setType(kTypeVoid);
 
-	_script->seek(13); // 8 byte header + 5 byte program size dummy op
+	_suspended = false;
+
+	_script->seek(NCSProgram::kStartOffset);
 }
 
 const Variable &NCSFile::run(Object *owner, Object *triggerer) {
@@ -399,15 +473,68 @@ const Variable &NCSFile::run(const ScriptState &state, const ObjectReference own
 	for (var = state.locals.rbegin(); var != state.locals.rend(); ++var)
 		_stack.push(*var);
 
-	return execute(owner, triggerer);
+	return execute(state.offset, owner, triggerer);
 }
 
-const Variable &NCSFile::execute(const ObjectReference owner, const ObjectReference triggerer) {
+const Variable &NCSFile::execute(uint32_t offset, const ObjectReference owner, const ObjectReference triggerer) {
 	_owner     = owner;
 	_triggerer = triggerer;
 
-	while (executeStep())
-		;
+	_resumeInstruction = NCSProgram::kInvalidInstruction;
+	if (_interpreter == kInterpreterDecoded)
+		_resumeInstruction = _program->findInstruction(offset);
+
+	return executeSlice();
+}
+
+const Variable &NCSFile::resume() {
+	if (!_suspended)
+		throw Common::Exception("NCSFile::resume(): Script \"%s\" isn't suspended", _name.c_str());
+
+	debugC(kDebugScripts, 1, "=== Resuming script \"%s\" ===", _name.c_str());
+
+	return executeSlice();
+}
+
+const Variable &NCSFile::executeSlice() {
+	typedef std::chrono::steady_clock Clock;
+
+	// Profiling isn't free, so only do it when somebody's interested
+	const bool profile = !_name.empty() && NCSProfilerMan.isEnabled();
+
+	const Clock::time_point start = profile ? Clock::now() : Clock::time_point();
+
+	const size_t initialBudget = (_instructionBudget == 0) ? SIZE_MAX : _instructionBudget;
+	size_t budget = initialBudget;
+
+	_suspended = false;
+
+	if (_resumeInstruction != NCSProgram::kInvalidInstruction) {
+		_suspended = !executeDecoded(_resumeInstruction, budget);
+	} else {
+		while (true) {
+			if (budget == 0) {
+				_suspended = true;
+				break;
+			}
+
+			if (!executeStep())
+				break;
+
+			budget--;
+		}
+	}
+
+	if (profile) {
+		const uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+		NCSProfilerMan.record(_name, initialBudget - budget, time, !_suspended);
+	}
+
+	if (_suspended) {
+		debugC(kDebugScripts, 1, "=> Script \"%s\" suspended", _name.c_str());
+		return _return;
+	}
 
 	if (!_stack.empty())
 		_return = _stack.top();
@@ -446,9 +573,430 @@ bool NCSFile::executeStep() {
 	return true;
 }
 
+/** Compare two values for the GEQ, GT, LT and LEQ opcodes. */
+template<typename T>
+static inline bool compareValues(uint8_t opcode, T a, T b) {
+	switch (opcode) {
+		case kOpcodeGEQ:
+			return a >= b;
+		case kOpcodeGT:
+			return a >  b;
+		case kOpcodeLT:
+			return a <  b;
+		default:
+			return a <= b;
+	}
+}
+
+/** Calculate the result of the ADD, SUB and MUL opcodes. */
+template<typename T>
+static inline T calculateValues(uint8_t opcode, T a, T b) {
+	switch (opcode) {
+		case kOpcodeADD:
+			return a + b;
+		case kOpcodeSUB:
+			return a - b;
+		default:
+			return a * b;
+	}
+}
+
+bool NCSFile::executeDecoded(size_t start, size_t &budget) {
+	const std::vector<NCSInstruction> &instructions = _program->getInstructions();
+
+	// Only format all the debug output if anybody wants to see it
+	const bool debug = DebugMan.isEnabled(kDebugScripts, 1);
+
+	size_t left = budget;
+
+	size_t pc = start;
+	while (true) {
+		if (left == 0) {
+			// Out of budget. Remember where we are, so that we can continue from here
+			_resumeInstruction = pc;
+			budget = 0;
+
+			return false;
+		}
+
+		left--;
+
+		const NCSInstruction &instruction = instructions[pc++];
+		const InstructionType type = (InstructionType) instruction.type;
+
+		if (instruction.opcode == kOpcodeEnd)
+			break;
+
+		if (debug)
+			debugC(kDebugScripts, 1, "NWScript opcode %s [0x%02X]",
+			       _opcodes[instruction.opcode].desc, instruction.opcode);
+
+		/* The common cases are handled right here. Everything else, including
+		 * all errors, is left to the reference interpreter. */
+
+		switch (instruction.opcode) {
+			case kOpcodeNOP:
+			case kOpcodeNOP2:
+				break;
+
+			case kOpcodeCPDOWNSP: {
+				int32_t offset = instruction.args[0];
+				int32_t size   = instruction.args[1];
+
+				if ((type != kInstTypeDirect) || ((size % 4) != 0)) {
+					executeReference(instruction);
+					break;
+				}
+
+				int32_t startPos = -size;
+				while (size > 0) {
+					_stack.setRelSP(offset, _stack.getRelSP(startPos));
+
+					startPos += 4;
+					offset   += 4;
+					size     -= 4;
+				}
+				break;
+			}
+
+			case kOpcodeCPTOPSP: {
+				const int32_t offset = instruction.args[0];
+				int32_t       size   = instruction.args[1];
+
+				if ((type != kInstTypeDirect) || ((size % 4) != 0)) {
+					executeReference(instruction);
+					break;
+				}
+
+				for (; size > 0; size -= 4)
+					_stack.push(_stack.getRelSP(offset));
+				break;
+			}
+
+			case kOpcodeCPDOWNBP: {
+				int32_t offset = instruction.args[0] - 4;
+				int32_t size   = instruction.args[1];
+
+				if ((type != kInstTypeDirect) || ((size % 4) != 0)) {
+					executeReference(instruction);
+					break;
+				}
+
+				int32_t startPos = -size;
+				while (size > 0) {
+					_stack.setRelBP(offset, _stack.getRelSP(startPos));
+
+					startPos += 4;
+					offset   += 4;
+					size     -= 4;
+				}
+				break;
+			}
+
+			case kOpcodeCPTOPBP: {
+				int32_t offset = instruction.args[0] - 4;
+				int32_t size   = instruction.args[1];
+
+				if ((type != kInstTypeDirect) || ((size % 4) != 0)) {
+					executeReference(instruction);
+					break;
+				}
+
+				for (; size > 0; size -= 4, offset += 4)
+					_stack.push(_stack.getRelBP(offset));
+				break;
+			}
+
+			case kOpcodeRSADD:
+				switch (type) {
+					case kInstTypeInt:
+						_stack.push(kTypeInt);
+						break;
+					case kInstTypeFloat:
+						_stack.push(kTypeFloat);
+						break;
+					case kInstTypeString:
+					case kInstTypeResource:
+						_stack.push(kTypeString);
+						break;
+					case kInstTypeObject:
+						_stack.push(kTypeObject);
+						break;
+					default:
+						executeReference(instruction);
+						break;
+				}
+				break;
+
+			case kOpcodeCONST:
+				switch (type) {
+					case kInstTypeInt:
+						_stack.push(instruction.args[0]);
+						break;
+					case kInstTypeFloat:
+						_stack.push(instruction.floatValue);
+						break;
+					case kInstTypeString:
+					case kInstTypeResource:
+						_stack.push(_program->getString(instruction.args[0]));
+						break;
+					case kInstTypeObject:
+						if ((uint32_t) instruction.args[0] == kScriptObjectSelf)
+							_stack.push(_owner);
+						else
+							executeReference(instruction);
+						break;
+					default:
+						executeReference(instruction);
+						break;
+				}
+				break;
+
+			case kOpcodeACTION:
+				if (type != kInstTypeNone) {
+					executeReference(instruction);
+					break;
+				}
+
+				callAction(instruction.args[0], instruction.args[1]);
+				break;
+
+			case kOpcodeLOGAND:
+			case kOpcodeLOGOR:
+			case kOpcodeINCOR:
+			case kOpcodeEXCOR:
+			case kOpcodeBOOLAND: {
+				if (type != kInstTypeIntInt) {
+					executeReference(instruction);
+					break;
+				}
+
+				const int32_t arg1 = _stack.popInt();
+				const int32_t arg2 = _stack.popInt();
+
+				switch (instruction.opcode) {
+					case kOpcodeLOGAND:
+						_stack.push(arg1 && arg2);
+						break;
+					case kOpcodeLOGOR:
+						_stack.push(arg1 || arg2);
+						break;
+					case kOpcodeINCOR:
+						_stack.push(arg1 | arg2);
+						break;
+					case kOpcodeEXCOR:
+						_stack.push(arg1 ^ arg2);
+						break;
+					default:
+						_stack.push(arg1 & arg2);
+						break;
+				}
+				break;
+			}
+
+			case kOpcodeEQ:
+			case kOpcodeNEQ: {
+				if (type == kInstTypeStructStruct) {
+					executeReference(instruction);
+					break;
+				}
+
+				const bool equal = _stack.getRelSP(-4) == _stack.getRelSP(-8);
+				_stack.setStackPtr(_stack.getStackPtr() + 8);
+
+				_stack.push((instruction.opcode == kOpcodeEQ) ? equal : !equal);
+				break;
+			}
+
+			case kOpcodeGEQ:
+			case kOpcodeGT:
+			case kOpcodeLT:
+			case kOpcodeLEQ:
+				if (type == kInstTypeIntInt) {
+					const int32_t arg1 = _stack.popInt();
+					const int32_t arg2 = _stack.popInt();
+
+					_stack.push(compareValues(instruction.opcode, arg2, arg1));
+				} else if (type == kInstTypeFloatFloat) {
+					const float arg1 = _stack.popFloat();
+					const float arg2 = _stack.popFloat();
+
+					_stack.push(compareValues(instruction.opcode, arg2, arg1));
+				} else
+					executeReference(instruction);
+				break;
+
+			case kOpcodeADD:
+			case kOpcodeSUB:
+			case kOpcodeMUL:
+				if (type == kInstTypeIntInt) {
+					const int32_t op2 = _stack.popInt();
+					const int32_t op1 = _stack.popInt();
+
+					_stack.push(calculateValues(instruction.opcode, op1, op2));
+				} else if ((type == kInstTypeFloatFloat) || (type == kInstTypeIntFloat) || (type == kInstTypeFloatInt)) {
+					const float op2 = (type == kInstTypeFloatInt) ? ((float) _stack.popInt()) : _stack.popFloat();
+					const float op1 = (type == kInstTypeIntFloat) ? ((float) _stack.popInt()) : _stack.popFloat();
+
+					_stack.push(calculateValues(instruction.opcode, op1, op2));
+				} else
+					executeReference(instruction);
+				break;
+
+			case kOpcodeNEG:
+				if      (type == kInstTypeInt)
+					_stack.push(-_stack.popInt());
+				else if (type == kInstTypeFloat)
+					_stack.push(-_stack.popFloat());
+				else
+					executeReference(instruction);
+				break;
+
+			case kOpcodeCOMP:
+				if (type == kInstTypeInt)
+					_stack.push(~_stack.popInt());
+				else
+					executeReference(instruction);
+				break;
+
+			case kOpcodeNOT:
+				if (type == kInstTypeInt)
+					_stack.push(!_stack.popInt());
+				else
+					executeReference(instruction);
+				break;
+
+			case kOpcodeMOVSP:
+				if (type == kInstTypeNone)
+					_stack.setStackPtr(_stack.getStackPtr() - instruction.args[0]);
+				else
+					executeReference(instruction);
+				break;
+
+			case kOpcodeDECSP:
+			case kOpcodeINCSP: {
+				if (type != kInstTypeInt) {
+					executeReference(instruction);
+					break;
+				}
+
+				const int32_t offset = instruction.args[0];
+				const int32_t delta  = (instruction.opcode == kOpcodeINCSP) ? 1 : -1;
+
+				_stack.setRelSP(offset, _stack.getRelSP(offset).getInt() + delta);
+				break;
+			}
+
+			case kOpcodeDECBP:
+			case kOpcodeINCBP: {
+				if (type != kInstTypeInt) {
+					executeReference(instruction);
+					break;
+				}
+
+				const int32_t offset = instruction.args[0];
+				const int32_t delta  = (instruction.opcode == kOpcodeINCBP) ? 1 : -1;
+
+				_stack.setRelBP(offset, _stack.getRelBP(offset).getInt() + delta);
+				break;
+			}
+
+			case kOpcodeSAVEBP:
+				if (type != kInstTypeNone) {
+					executeReference(instruction);
+					break;
+				}
+
+				_stack.push(_stack.getBasePtr());
+				_stack.setBasePtr(_stack.getStackPtr());
+				break;
+
+			case kOpcodeRESTOREBP:
+				if (type != kInstTypeNone) {
+					executeReference(instruction);
+					break;
+				}
+
+				_stack.setBasePtr(_stack.popInt());
+				break;
+
+			// Jumps change the instruction index instead of the stream position
+
+			case kOpcodeJMP:
+				if (type != kInstTypeNone) {
+					executeReference(instruction);
+					break;
+				}
+
+				pc = instruction.target;
+				break;
+
+			case kOpcodeJSR:
+				if (type != kInstTypeNone) {
+					executeReference(instruction);
+					break;
+				}
+
+				_returnOffsets.push(pc);
+				pc = instruction.target;
+				break;
+
+			case kOpcodeJZ:
+				if (type != kInstTypeNone) {
+					executeReference(instruction);
+					break;
+				}
+
+				if (!_stack.popInt())
+					pc = instruction.target;
+				break;
+
+			case kOpcodeJNZ:
+				if (type != kInstTypeNone) {
+					executeReference(instruction);
+					break;
+				}
+
+				if (_stack.popInt())
+					pc = instruction.target;
+				break;
+
+			case kOpcodeRETN:
+				// Returning from the main function ends the script
+				pc = instructions.size() - 1;
+				if (!_returnOffsets.empty()) {
+					pc = _returnOffsets.top();
+					_returnOffsets.pop();
+				}
+				break;
+
+			default:
+				executeReference(instruction);
+				break;
+		}
+
+		if (debug) {
+			_stack.print();
+			debugC(kDebugScripts, 2, "[RETURN: %d]",
+			       _returnOffsets.empty() ? -1 : (int) instructions[_returnOffsets.top()].address);
+		}
+	}
+
+	budget = left;
+
+	return true;
+}
+
+void NCSFile::executeReference(const NCSInstruction &instruction) {
+	// Position the stream at the instruction's arguments, as if the opcode and type were just read
+	_script->seek(instruction.address + 2);
+
+	(this->*(_opcodes[instruction.opcode].proc))((InstructionType) instruction.type);
+}
+
 void NCSFile::decompile() {
 	uint32_t oldScriptPos = _script->pos();
-	_script->seek(13); // 8 byte header + 5 byte program size dummy op
+	_script->seek(NCSProgram::kStartOffset);
 
 	// TODO
 
@@ -620,7 +1168,7 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 		case kTypeObject:
 		case kTypeEngineType:
 		case kTypeArray:
-			_stack.push(retVal);
+			_stack.push(std::move(retVal));
 			break;
 
 		case kTypeVector: {
@@ -650,6 +1198,11 @@ void NCSFile::o_action(InstructionType type) {
 	uint16_t routineNumber = _script->readUint16BE();
 	uint8_t  argCount      = _script->readByte();
 
+	callAction(routineNumber, argCount);
+}
+
+/** Helper function for o_action(), setting up the engine function call. */
+void NCSFile::callAction(uint16_t routineNumber, uint8_t argCount) {
 	Aurora::NWScript::FunctionContext ctx = FunctionMan.createContext(routineNumber);
 
 	try {
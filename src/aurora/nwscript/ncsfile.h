@@ -38,6 +38,7 @@
 #include "src/aurora/nwscript/variable.h"
 #include "src/aurora/nwscript/variablecontainer.h"
 #include "src/aurora/nwscript/objectref.h"
+#include "src/aurora/nwscript/ncsprogram.h"
 
 namespace Common {
 	class UString;
@@ -60,6 +61,12 @@ public:
 	Variable &top();
 	Variable pop();
 	void push(const Variable &obj);
+	void push(Variable &&obj);
+
+	/** Pop the top-most element, which has to be an int, without copying it. */
+	int32_t popInt();
+	/** Pop the top-most element, which has to be a float, without copying it. */
+	float popFloat();
 
 	Variable &getRelSP(int32_t pos);
 	void setRelSP(int32_t pos, const Variable &obj);
@@ -85,7 +92,20 @@ private:
 /** An NCS, BioWare's NWN Compile Script. */
 class NCSFile : public AuroraFile {
 public:
+	/** The way the script's bytecode is executed. */
+	enum Interpreter {
+		/** Run the instructions decoded when loading the script (default).
+		 *
+		 *  If the script couldn't be decoded, it's run by the reference
+		 *  interpreter instead.
+		 */
+		kInterpreterDecoded,
+		/** Read and run the bytecode instruction by instruction. */
+		kInterpreterReference
+	};
+
 	NCSFile(Common::SeekableReadStream *ncs);
+	/** Load the script with this resref, through the cache of decoded programs. */
 	NCSFile(const Common::UString &ncs);
 	~NCSFile();
 
@@ -102,6 +122,11 @@ public:
 	/** Overwrite the environment. */
 	void setEnvironment(const VariableContainer &env);
 
+	/** Set the way the script's bytecode is executed. */
+	void setInterpreter(Interpreter interpreter);
+	/** Return the way the script's bytecode is executed. */
+	Interpreter getInterpreter() const;
+
 	/** Run the current script, from start to finish. */
 	const Variable &run(Object *owner = 0, Object *triggerer = 0);
 	const Variable &run(const ObjectReference owner = ObjectReference(),
@@ -113,6 +138,26 @@ public:
 	                    const ObjectReference owner = ObjectReference(),
 	                    const ObjectReference triggerer = ObjectReference());
 
+	/** Set how many instructions the script may run before it's suspended. 0 means no limit. */
+	void setInstructionBudget(size_t budget);
+	/** Return how many instructions the script may run before it's suspended. */
+	size_t getInstructionBudget() const;
+
+	/** Did the script stop because it ran out of its instruction budget?
+	 *
+	 *  A suspended script keeps its whole execution state, including the
+	 *  stack and the subroutine return addresses, and can be continued
+	 *  with resume(). Running it from the start again drops that state.
+	 */
+	bool isSuspended() const;
+
+	/** Continue the suspended script, with a fresh instruction budget.
+	 *
+	 *  Returns the script's return value once it finished, or a void value
+	 *  if it was suspended again.
+	 */
+	const Variable &resume();
+
 	// KotOR2's parameter handling
 
 	/** Set the parameters of the script. */
@@ -128,62 +173,20 @@ public:
 	static ScriptState getEmptyState();
 
 private:
-	enum InstructionType {
-		// Unary
-		kInstTypeNone        =  0,
-		kInstTypeDirect      =  1,
-		kInstTypeInt         =  3,
-		kInstTypeFloat       =  4,
-		kInstTypeString      =  5,
-		kInstTypeObject      =  6,
-		kInstTypeResource    = 96,
-		kInstTypeEngineType0 = 16, // NWN:     effect        DA: event
-		kInstTypeEngineType1 = 17, // NWN:     event         DA: location
-		kInstTypeEngineType2 = 18, // NWN:     location      DA: command
-		kInstTypeEngineType3 = 19, // NWN:     talent        DA: effect
-		kInstTypeEngineType4 = 20, // NWN:     itemproperty  DA: itemproperty
-		kInstTypeEngineType5 = 21, // Witcher: mod           DA: player
-
-		// Arrays
-		kInstTypeIntArray          = 64,
-		kInstTypeFloatArray        = 65,
-		kInstTypeStringArray       = 66,
-		kInstTypeObjectArray       = 67,
-		kInstTypeResourceArray     = 68,
-		kInstTypeEngineType0Array  = 80,
-		kInstTypeEngineType1Array  = 81,
-		kInstTypeEngineType2Array  = 82,
-		kInstTypeEngineType3Array  = 83,
-		kInstTypeEngineType4Array  = 84,
-		kInstTypeEngineType5Array  = 85,
-
-		// Binary
-		kInstTypeIntInt                 = 32,
-		kInstTypeFloatFloat             = 33,
-		kInstTypeObjectObject           = 34,
-		kInstTypeStringString           = 35,
-		kInstTypeStructStruct           = 36,
-		kInstTypeIntFloat               = 37,
-		kInstTypeFloatInt               = 38,
-		kInstTypeEngineType0EngineType0 = 48,
-		kInstTypeEngineType1EngineType1 = 49,
-		kInstTypeEngineType2EngineType2 = 50,
-		kInstTypeEngineType3EngineType3 = 51,
-		kInstTypeEngineType4EngineType4 = 52,
-		kInstTypeEngineType5EngineType5 = 53,
-		kInstTypeVectorVector           = 58,
-		kInstTypeVectorFloat            = 59,
-		kInstTypeFloatVector            = 60
-	};
-
 	Common::UString _name;
 
 	std::vector<int> _parameters;
 	Common::UString _parameterString;
 
 	NCSStack _stack;
+
+	/** The decoded script. */
+	std::shared_ptr<const NCSProgram> _program;
+	/** The script's bytecode, for the reference interpreter. */
 	std::unique_ptr<Common::SeekableReadStream> _script;
 
+	Interpreter _interpreter;
+
 	Variable _return;
 
 	ObjectReference _owner;
@@ -193,6 +196,13 @@ private:
 
 	std::stack<uint32_t> _returnOffsets;
 
+	/** The number of instructions the script may run in one go, 0 for no limit. */
+	size_t _instructionBudget;
+	/** Did the script run out of its instruction budget? */
+	bool _suspended;
+	/** The decoded instruction to continue with, or kInvalidInstruction for the reference interpreter. */
+	size_t _resumeInstruction;
+
 	Variable _storedState;
 
 	typedef void (NCSFile::*OpcodeProc)(InstructionType type);
@@ -204,20 +214,34 @@ private:
 	size_t _opcodeListSize;
 	void setupOpcodes();
 
-	void load();
+	void load(const std::shared_ptr<const NCSProgram> &program);
 
 	/** Reset the script for another execution. */
 	void reset();
 
-	const Variable &execute(const ObjectReference owner = ObjectReference(),
+	/** Execute the script, starting with the instruction at this offset. */
+	const Variable &execute(uint32_t offset, const ObjectReference owner = ObjectReference(),
 	                        const ObjectReference triggerer = ObjectReference());
 
+	/** Execute the script from where it stands, until it ends or the budget runs out. */
+	const Variable &executeSlice();
+
 	/** Execute one script step. */
 	bool executeStep();
 
+	/** Execute the decoded script, starting with the instruction at this index.
+	 *
+	 *  Stops when the script ends, or after budget instructions. The budget
+	 *  left over is written back. Returns false if the script was suspended.
+	 */
+	bool executeDecoded(size_t start, size_t &budget);
+	/** Execute this decoded instruction with the reference interpreter. */
+	void executeReference(const NCSInstruction &instruction);
+
 	void decompile(); // TODO
 
 	void callEngine(Aurora::NWScript::FunctionContext &ctx, uint32_t function, uint8_t argCount);
+	void callAction(uint16_t routineNumber, uint8_t argCount);
 
 	// Opcode declarations
 	DECLARE_OPCODE(o_nop);
@@ -0,0 +1,99 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Timing statistics of NWScript runs.
+ */
+
+#include <algorithm>
+
+#include "src/common/util.h"
+
+#include "src/aurora/nwscript/ncsprofiler.h"
+
+DECLARE_SINGLETON(Aurora::NWScript::NCSProfiler)
+
+namespace Aurora {
+
+namespace NWScript {
+
+NCSProfiler::ScriptStats::ScriptStats(const Common::UString &n) : name(n), runs(0), slices(0),
+	instructions(0), time(0), maxSliceTime(0) {
+}
+
+
+NCSProfiler::NCSProfiler() : _enabled(false) {
+}
+
+NCSProfiler::~NCSProfiler() {
+}
+
+void NCSProfiler::setEnabled(bool enabled) {
+	_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool NCSProfiler::isEnabled() const {
+	return _enabled.load(std::memory_order_relaxed);
+}
+
+void NCSProfiler::record(const Common::UString &name, uint64_t instructions, uint64_t time, bool finished) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	StatsMap::iterator stats = _stats.find(name);
+	if (stats == _stats.end())
+		stats = _stats.insert(std::make_pair(name, ScriptStats(name))).first;
+
+	if (finished)
+		stats->second.runs++;
+
+	stats->second.slices++;
+	stats->second.instructions += instructions;
+
+	stats->second.time         += time;
+	stats->second.maxSliceTime  = MAX(stats->second.maxSliceTime, time);
+}
+
+std::vector<NCSProfiler::ScriptStats> NCSProfiler::getStats() const {
+	std::vector<ScriptStats> stats;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		stats.reserve(_stats.size());
+		for (StatsMap::const_iterator s = _stats.begin(); s != _stats.end(); ++s)
+			stats.push_back(s->second);
+	}
+
+	std::stable_sort(stats.begin(), stats.end(), [](const ScriptStats &a, const ScriptStats &b) {
+		return a.time > b.time;
+	});
+
+	return stats;
+}
+
+void NCSProfiler::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_stats.clear();
+}
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
@@ -0,0 +1,104 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Timing statistics of NWScript runs.
+ */
+
+#ifndef AURORA_NWSCRIPT_NCSPROFILER_H
+#define AURORA_NWSCRIPT_NCSPROFILER_H
+
+#include <map>
+#include <vector>
+#include <atomic>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/singleton.h"
+#include "src/common/mutex.h"
+
+namespace Aurora {
+
+namespace NWScript {
+
+/** Collects how often and how long each script ran.
+ *
+ *  A script run may be split into several slices, when it ran out of its
+ *  instruction budget and was resumed later on.
+ *
+ *  Profiling is disabled by default. Scripts are only timed while it's
+ *  enabled, for example with the "scriptstats" console command.
+ */
+class NCSProfiler : public Common::Singleton<NCSProfiler> {
+public:
+	struct ScriptStats {
+		Common::UString name;
+
+		uint64_t runs;         ///< The number of runs that finished.
+		uint64_t slices;       ///< The number of times the script was run or resumed.
+		uint64_t instructions; ///< The number of instructions executed.
+
+		uint64_t time;         ///< The time spent in the script, in nanoseconds.
+		uint64_t maxSliceTime; ///< The longest slice, in nanoseconds.
+
+		ScriptStats(const Common::UString &n = "");
+	};
+
+	NCSProfiler();
+	~NCSProfiler();
+
+	/** Enable or disable the profiling of script runs. */
+	void setEnabled(bool enabled);
+	/** Are script runs currently profiled? */
+	bool isEnabled() const;
+
+	/** Record one slice of a script run.
+	 *
+	 *  @param name The name of the script.
+	 *  @param instructions The number of instructions executed in this slice.
+	 *  @param time The time the slice took, in nanoseconds.
+	 *  @param finished Did the script run to its end?
+	 */
+	void record(const Common::UString &name, uint64_t instructions, uint64_t time, bool finished);
+
+	/** Return the statistics of all scripts, the ones that took the longest first. */
+	std::vector<ScriptStats> getStats() const;
+
+	/** Forget all statistics. */
+	void clear();
+
+private:
+	typedef std::map<Common::UString, ScriptStats, Common::UString::iless> StatsMap;
+
+	StatsMap _stats;
+
+	std::atomic<bool> _enabled;
+
+	mutable std::mutex _mutex;
+};
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
+
+/** Shortcut for accessing the NWScript profiler. */
+#define NCSProfilerMan Aurora::NWScript::NCSProfiler::instance()
+
+#endif // AURORA_NWSCRIPT_NCSPROFILER_H
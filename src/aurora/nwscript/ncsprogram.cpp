@@ -0,0 +1,301 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A decoded NWScript bytecode program.
+ */
+
+#include <cassert>
+
+#include <algorithm>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
+#include "src/common/encoding.h"
+
+#include "src/aurora/aurorafile.h"
+
+#include "src/aurora/nwscript/ncsprogram.h"
+
+static const uint32_t kNCSTag    = MKTAG('N', 'C', 'S', ' ');
+static const uint32_t kVersion10 = MKTAG('V', '1', '.', '0');
+
+namespace Aurora {
+
+namespace NWScript {
+
+const size_t   NCSProgram::kInvalidInstruction;
+const uint32_t NCSProgram::kStartOffset;
+
+NCSProgram::NCSProgram(Common::SeekableReadStream &ncs) : _size(0), _decoded(false) {
+	load(ncs);
+	decode();
+}
+
+NCSProgram::~NCSProgram() {
+}
+
+const byte *NCSProgram::getData() const {
+	return _data.get();
+}
+
+size_t NCSProgram::getSize() const {
+	return _size;
+}
+
+bool NCSProgram::isDecoded() const {
+	return _decoded;
+}
+
+const std::vector<NCSInstruction> &NCSProgram::getInstructions() const {
+	return _instructions;
+}
+
+const Common::UString &NCSProgram::getString(size_t index) const {
+	assert(index < _strings.size());
+
+	return _strings[index];
+}
+
+size_t NCSProgram::findInstruction(uint32_t address) const {
+	if (!_decoded)
+		return kInvalidInstruction;
+
+	return lookupInstruction(address);
+}
+
+size_t NCSProgram::lookupInstruction(uint32_t address) const {
+	if (_instructions.empty())
+		return kInvalidInstruction;
+
+	// Running into any of the bytes after the last full instruction ends the script
+	const NCSInstruction &end = _instructions.back();
+	if ((address >= end.address) && (address <= _size))
+		return _instructions.size() - 1;
+
+	std::vector<NCSInstruction>::const_iterator instruction =
+		std::lower_bound(_instructions.begin(), _instructions.end(), address,
+		                 [](const NCSInstruction &i, uint32_t a) { return i.address < a; });
+
+	if ((instruction == _instructions.end()) || (instruction->address != address))
+		return kInvalidInstruction;
+
+	return instruction - _instructions.begin();
+}
+
+void NCSProgram::load(Common::SeekableReadStream &ncs) {
+	ncs.seek(0);
+
+	_size = ncs.size();
+	_data = std::make_unique<byte[]>(_size);
+
+	if (ncs.read(_data.get(), _size) != _size)
+		throw Common::Exception(Common::kReadError);
+
+	Common::MemoryReadStream script(_data.get(), _size);
+
+	uint32_t id, version;
+	AuroraFile::readHeader(script, id, version);
+
+	if (id != kNCSTag)
+		throw Common::Exception("Try to load non-NCS file");
+
+	if (version != kVersion10)
+		throw Common::Exception("Unsupported NCS file version %08X", version);
+
+	byte lengthOpcode = script.readByte();
+	if (lengthOpcode != 0x42)
+		throw Common::Exception("Script size opcode != 0x42 (0x%02X)", lengthOpcode);
+
+	uint32_t length = script.readUint32BE();
+	if (length > ((uint32_t) _size))
+		throw Common::Exception("Script size %u > stream size %u", length, (uint)_size);
+	if (length < ((uint32_t) _size))
+		warning("TODO: NCSProgram::load(): Script size %u < stream size %u", length, (uint)_size);
+}
+
+void NCSProgram::decode() {
+	Common::MemoryReadStream script(_data.get(), _size);
+	script.seek(kStartOffset);
+
+	try {
+		// The script ends where there's not even a full opcode and type left
+		while ((script.size() - script.pos()) >= 2) {
+			_instructions.push_back(NCSInstruction());
+			decodeInstruction(script, _instructions.back());
+		}
+	} catch (...) {
+		// Truncated or unknown instructions, we need to run this one the slow way
+		_instructions.clear();
+		_strings.clear();
+		return;
+	}
+
+	NCSInstruction end;
+	end.address = script.pos();
+
+	_instructions.push_back(end);
+
+	if (!resolveJumps()) {
+		_instructions.clear();
+		_strings.clear();
+		return;
+	}
+
+	_decoded = true;
+}
+
+void NCSProgram::decodeInstruction(Common::SeekableReadStream &script, NCSInstruction &instruction) {
+	instruction.address = script.pos();
+	instruction.opcode  = script.readByte();
+	instruction.type    = script.readByte();
+
+	switch (instruction.opcode) {
+		case kOpcodeNOP:
+		case kOpcodeRSADD:
+		case kOpcodeLOGAND:
+		case kOpcodeLOGOR:
+		case kOpcodeINCOR:
+		case kOpcodeEXCOR:
+		case kOpcodeBOOLAND:
+		case kOpcodeGEQ:
+		case kOpcodeGT:
+		case kOpcodeLT:
+		case kOpcodeLEQ:
+		case kOpcodeSHLEFT:
+		case kOpcodeSHRIGHT:
+		case kOpcodeUSHRIGHT:
+		case kOpcodeADD:
+		case kOpcodeSUB:
+		case kOpcodeMUL:
+		case kOpcodeDIV:
+		case kOpcodeMOD:
+		case kOpcodeNEG:
+		case kOpcodeCOMP:
+		case kOpcodeSTORESTATEALL:
+		case kOpcodeRETN:
+		case kOpcodeNOT:
+		case kOpcodeSAVEBP:
+		case kOpcodeRESTOREBP:
+		case kOpcodeNOP2:
+			break;
+
+		case kOpcodeCPDOWNSP:
+		case kOpcodeCPTOPSP:
+		case kOpcodeCPDOWNBP:
+		case kOpcodeCPTOPBP:
+		case kOpcodeWRITEARRAY:
+		case kOpcodeREADARRAY:
+		case kOpcodeGETREF:
+		case kOpcodeGETREFARRAY:
+			instruction.args[0] = script.readSint32BE();
+			instruction.args[1] = script.readSint16BE();
+			break;
+
+		case kOpcodeMOVSP:
+		case kOpcodeJMP:
+		case kOpcodeJSR:
+		case kOpcodeJZ:
+		case kOpcodeJNZ:
+		case kOpcodeDECSP:
+		case kOpcodeINCSP:
+		case kOpcodeDECBP:
+		case kOpcodeINCBP:
+			instruction.args[0] = script.readSint32BE();
+			break;
+
+		case kOpcodeCONST:
+			switch (instruction.type) {
+				case kInstTypeInt:
+					instruction.args[0] = script.readSint32BE();
+					break;
+
+				case kInstTypeFloat:
+					instruction.floatValue = script.readIEEEFloatBE();
+					break;
+
+				case kInstTypeString:
+				case kInstTypeResource: {
+					const size_t length = script.readUint16BE();
+
+					instruction.args[0] = _strings.size();
+					_strings.push_back(Common::readStringFixed(script, Common::kEncodingASCII, length));
+					break;
+				}
+
+				case kInstTypeObject:
+					instruction.args[0] = (int32_t) script.readUint32BE();
+					break;
+
+				default:
+					// Illegal, but that's only an error once it's executed
+					break;
+			}
+			break;
+
+		case kOpcodeACTION:
+			instruction.args[0] = script.readUint16BE();
+			instruction.args[1] = script.readByte();
+			break;
+
+		case kOpcodeEQ:
+		case kOpcodeNEQ:
+			// Comparisons between two structs (or two vectors) come with the size of the type
+			if (instruction.type == kInstTypeStructStruct)
+				instruction.args[0] = script.readUint16BE();
+			break;
+
+		case kOpcodeDESTRUCT:
+			instruction.args[0] = script.readSint16BE();
+			instruction.args[1] = script.readSint16BE();
+			instruction.args[2] = script.readSint16BE();
+			break;
+
+		case kOpcodeSTORESTATE:
+			instruction.args[0] = (int32_t) script.readUint32BE();
+			instruction.args[1] = (int32_t) script.readUint32BE();
+			break;
+
+		default:
+			throw Common::Exception("Illegal instruction 0x%02x", instruction.opcode);
+	}
+}
+
+bool NCSProgram::resolveJumps() {
+	for (std::vector<NCSInstruction>::iterator i = _instructions.begin(); i != _instructions.end(); ++i) {
+		if ((i->opcode != kOpcodeJMP) && (i->opcode != kOpcodeJSR) &&
+		    (i->opcode != kOpcodeJZ)  && (i->opcode != kOpcodeJNZ))
+			continue;
+
+		const size_t target = lookupInstruction(i->address + i->args[0]);
+		if (target == kInvalidInstruction)
+			return false;
+
+		i->target = target;
+	}
+
+	return true;
+}
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
@@ -0,0 +1,241 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A decoded NWScript bytecode program.
+ */
+
+#ifndef AURORA_NWSCRIPT_NCSPROGRAM_H
+#define AURORA_NWSCRIPT_NCSPROGRAM_H
+
+#include <vector>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+namespace NWScript {
+
+/** The opcodes of the NWScript bytecode instructions. */
+enum Opcode {
+	kOpcodeNOP           = 0x00, ///< Doesn't exist.
+	kOpcodeCPDOWNSP      = 0x01,
+	kOpcodeRSADD         = 0x02,
+	kOpcodeCPTOPSP       = 0x03,
+	kOpcodeCONST         = 0x04,
+	kOpcodeACTION        = 0x05,
+	kOpcodeLOGAND        = 0x06,
+	kOpcodeLOGOR         = 0x07,
+	kOpcodeINCOR         = 0x08,
+	kOpcodeEXCOR         = 0x09,
+	kOpcodeBOOLAND       = 0x0A,
+	kOpcodeEQ            = 0x0B,
+	kOpcodeNEQ           = 0x0C,
+	kOpcodeGEQ           = 0x0D,
+	kOpcodeGT            = 0x0E,
+	kOpcodeLT            = 0x0F,
+	kOpcodeLEQ           = 0x10,
+	kOpcodeSHLEFT        = 0x11,
+	kOpcodeSHRIGHT       = 0x12,
+	kOpcodeUSHRIGHT      = 0x13,
+	kOpcodeADD           = 0x14,
+	kOpcodeSUB           = 0x15,
+	kOpcodeMUL           = 0x16,
+	kOpcodeDIV           = 0x17,
+	kOpcodeMOD           = 0x18,
+	kOpcodeNEG           = 0x19,
+	kOpcodeCOMP          = 0x1A,
+	kOpcodeMOVSP         = 0x1B,
+	kOpcodeSTORESTATEALL = 0x1C,
+	kOpcodeJMP           = 0x1D,
+	kOpcodeJSR           = 0x1E,
+	kOpcodeJZ            = 0x1F,
+	kOpcodeRETN          = 0x20,
+	kOpcodeDESTRUCT      = 0x21,
+	kOpcodeNOT           = 0x22,
+	kOpcodeDECSP         = 0x23,
+	kOpcodeINCSP         = 0x24,
+	kOpcodeJNZ           = 0x25,
+	kOpcodeCPDOWNBP      = 0x26,
+	kOpcodeCPTOPBP       = 0x27,
+	kOpcodeDECBP         = 0x28,
+	kOpcodeINCBP         = 0x29,
+	kOpcodeSAVEBP        = 0x2A,
+	kOpcodeRESTOREBP     = 0x2B,
+	kOpcodeSTORESTATE    = 0x2C,
+	kOpcodeNOP2          = 0x2D, ///< Another no-op.
+	kOpcodeWRITEARRAY    = 0x30,
+	kOpcodeREADARRAY     = 0x32,
+	kOpcodeGETREF        = 0x37,
+	kOpcodeGETREFARRAY   = 0x39,
+
+	kOpcodeEnd           = 0xFF  ///< Not a real opcode, marks the end of a decoded program.
+};
+
+/** The type of an NWScript bytecode instruction, which are mostly the types of its operands. */
+enum InstructionType {
+	// Unary
+	kInstTypeNone        =  0,
+	kInstTypeDirect      =  1,
+	kInstTypeInt         =  3,
+	kInstTypeFloat       =  4,
+	kInstTypeString      =  5,
+	kInstTypeObject      =  6,
+	kInstTypeResource    = 96,
+	kInstTypeEngineType0 = 16, // NWN:     effect        DA: event
+	kInstTypeEngineType1 = 17, // NWN:     event         DA: location
+	kInstTypeEngineType2 = 18, // NWN:     location      DA: command
+	kInstTypeEngineType3 = 19, // NWN:     talent        DA: effect
+	kInstTypeEngineType4 = 20, // NWN:     itemproperty  DA: itemproperty
+	kInstTypeEngineType5 = 21, // Witcher: mod           DA: player
+
+	// Arrays
+	kInstTypeIntArray          = 64,
+	kInstTypeFloatArray        = 65,
+	kInstTypeStringArray       = 66,
+	kInstTypeObjectArray       = 67,
+	kInstTypeResourceArray     = 68,
+	kInstTypeEngineType0Array  = 80,
+	kInstTypeEngineType1Array  = 81,
+	kInstTypeEngineType2Array  = 82,
+	kInstTypeEngineType3Array  = 83,
+	kInstTypeEngineType4Array  = 84,
+	kInstTypeEngineType5Array  = 85,
+
+	// Binary
+	kInstTypeIntInt                 = 32,
+	kInstTypeFloatFloat             = 33,
+	kInstTypeObjectObject           = 34,
+	kInstTypeStringString           = 35,
+	kInstTypeStructStruct           = 36,
+	kInstTypeIntFloat               = 37,
+	kInstTypeFloatInt               = 38,
+	kInstTypeEngineType0EngineType0 = 48,
+	kInstTypeEngineType1EngineType1 = 49,
+	kInstTypeEngineType2EngineType2 = 50,
+	kInstTypeEngineType3EngineType3 = 51,
+	kInstTypeEngineType4EngineType4 = 52,
+	kInstTypeEngineType5EngineType5 = 53,
+	kInstTypeVectorVector           = 58,
+	kInstTypeVectorFloat            = 59,
+	kInstTypeFloatVector            = 60
+};
+
+/** One decoded NWScript bytecode instruction. */
+struct NCSInstruction {
+	uint32_t address; ///< The offset of the instruction within the script.
+
+	uint8_t opcode; ///< The opcode, see Opcode.
+	uint8_t type;   ///< The instruction type, see InstructionType.
+
+	/** The direct arguments, in the order they're found in the bytecode.
+	 *
+	 *  String constants are replaced by their index into the program's
+	 *  string table, and float constants are found in floatValue instead.
+	 */
+	int32_t args[3];
+
+	float floatValue; ///< The value of a float constant.
+
+	/** For jumps, the index of the instruction jumped to. */
+	uint32_t target;
+
+	NCSInstruction() : address(0), opcode(kOpcodeEnd), type(kInstTypeNone), floatValue(0.0f), target(0) {
+		args[0] = args[1] = args[2] = 0;
+	}
+};
+
+/** A NWScript bytecode program, decoded once into a compact array of instructions.
+ *
+ *  The decoding resolves jump targets into instruction indices and parses
+ *  all constants and operand sizes, so that the program can be executed
+ *  without having to read the bytecode again. The original bytecode is
+ *  kept as well.
+ *
+ *  Once created, a program is never modified.
+ */
+class NCSProgram : boost::noncopyable {
+public:
+	/** Returned by findInstruction() if there's no instruction at an address. */
+	static const size_t kInvalidInstruction = SIZE_MAX;
+
+	/** The offset of the first instruction: 8 byte header + 5 byte program size dummy op. */
+	static const uint32_t kStartOffset = 13;
+
+	/** Read and decode the program in this NCS stream. */
+	NCSProgram(Common::SeekableReadStream &ncs);
+	~NCSProgram();
+
+	/** Return the raw bytecode, including the header. */
+	const byte *getData() const;
+	/** Return the size of the raw bytecode. */
+	size_t getSize() const;
+
+	/** Was the bytecode successfully decoded?
+	 *
+	 *  If it wasn't, for example because of an unknown opcode or a jump
+	 *  to outside the program, the bytecode can only be run instruction
+	 *  by instruction.
+	 */
+	bool isDecoded() const;
+
+	/** Return all decoded instructions. The last one is always a kOpcodeEnd. */
+	const std::vector<NCSInstruction> &getInstructions() const;
+
+	/** Return a string constant. */
+	const Common::UString &getString(size_t index) const;
+
+	/** Return the index of the instruction at this address, or kInvalidInstruction. */
+	size_t findInstruction(uint32_t address) const;
+
+private:
+	std::unique_ptr<byte[]> _data;
+	size_t _size;
+
+	bool _decoded;
+
+	std::vector<NCSInstruction> _instructions;
+	std::vector<Common::UString> _strings;
+
+	void load(Common::SeekableReadStream &ncs);
+	void decode();
+
+	/** Decode the instruction starting at the current position of the stream. */
+	void decodeInstruction(Common::SeekableReadStream &script, NCSInstruction &instruction);
+	/** Resolve the jump targets into instruction indices. */
+	bool resolveJumps();
+
+	/** Find the instruction at this address, whether the decoding is finished or not. */
+	size_t lookupInstruction(uint32_t address) const;
+};
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
+
+#endif // AURORA_NWSCRIPT_NCSPROGRAM_H
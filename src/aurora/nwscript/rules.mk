@@ -32,7 +32,10 @@ src_aurora_nwscript_libnwscript_la_SOURCES += \
     src/aurora/nwscript/object.h \
     src/aurora/nwscript/objectcontainer.h \
     src/aurora/nwscript/functionman.h \
+    src/aurora/nwscript/ncsprogram.h \
     src/aurora/nwscript/ncsfile.h \
+    src/aurora/nwscript/ncscache.h \
+    src/aurora/nwscript/ncsprofiler.h \
     src/aurora/nwscript/objectref.h \
     src/aurora/nwscript/objectman.h \
     $(EMPTY)
@@ -44,7 +47,10 @@ src_aurora_nwscript_libnwscript_la_SOURCES += \
     src/aurora/nwscript/functioncontext.cpp \
     src/aurora/nwscript/objectcontainer.cpp \
     src/aurora/nwscript/functionman.cpp \
+    src/aurora/nwscript/ncsprogram.cpp \
     src/aurora/nwscript/ncsfile.cpp \
+    src/aurora/nwscript/ncscache.cpp \
+    src/aurora/nwscript/ncsprofiler.cpp \
     src/aurora/nwscript/objectref.cpp \
     src/aurora/nwscript/objectman.cpp \
     $(EMPTY)
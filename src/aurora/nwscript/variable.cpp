@@ -24,6 +24,9 @@
 
 #include <cassert>
 
+#include <new>
+#include <utility>
+
 #include <boost/make_shared.hpp>
 
 #include "src/common/error.h"
@@ -93,34 +96,29 @@ Variable::Variable(const Variable &var) : _type(kTypeVoid) {
 	*this = var;
 }
 
+Variable::Variable(Variable &&var) noexcept : _type(kTypeVoid) {
+	*this = std::move(var);
+}
+
 Variable::~Variable() {
-	try {
-		setType(kTypeVoid);
-	} catch (...) {
-	}
+	destroy();
 }
 
 void Variable::setType(Type type) {
-	_array.reset();
-
-	if      (_type == kTypeString)
-		delete _value._string;
-	else if (_type == kTypeObject)
-		delete _value._object;
-	else if (_type == kTypeEngineType)
-		delete _value._engineType;
-	else if (_type == kTypeScriptState)
-		delete _value._scriptState;
+	destroy();
+	construct(type);
+}
 
-	_type = type;
+void Variable::construct(Type type) {
+	assert(_type == kTypeVoid);
 
-	switch (_type) {
+	switch (type) {
 		case kTypeVoid:
 		case kTypeAny:
 			break;
 
 		case kTypeArray:
-			_array = boost::make_shared<Array>();
+			new (&_value._array) ArrayPtr(boost::make_shared<Array>());
 			break;
 
 		case kTypeInt:
@@ -132,11 +130,11 @@ void Variable::setType(Type type) {
 			break;
 
 		case kTypeString:
-			_value._string = new Common::UString;
+			new (&_value._string) Common::UString;
 			break;
 
 		case kTypeObject:
-			_value._object = new ObjectReference;
+			new (&_value._object) ObjectReference;
 			break;
 
 		case kTypeVector:
@@ -161,24 +159,93 @@ void Variable::setType(Type type) {
 			throw Common::Exception("Variable::setType(): Invalid type %d", type);
 			break;
 	}
+
+	_type = type;
+}
+
+void Variable::destroy() {
+	if      (_type == kTypeString)
+		string().~UString();
+	else if (_type == kTypeObject)
+		object().~ObjectReference();
+	else if (_type == kTypeArray)
+		array().~ArrayPtr();
+	else if (_type == kTypeEngineType)
+		delete _value._engineType;
+	else if (_type == kTypeScriptState)
+		delete _value._scriptState;
+
+	_type = kTypeVoid;
 }
 
 Variable &Variable::operator=(const Variable &var) {
 	if (&var == this)
 		return *this;
 
-	setType(var._type);
+	if ((var._type == kTypeArray) && (_type != kTypeArray)) {
+		// Share the other variable's array, without creating an empty one first
+		destroy();
+
+		new (&_value._array) ArrayPtr(var.array());
+		_type = kTypeArray;
+
+		return *this;
+	}
+
+	// Assigning a value of the same type can reuse what's already there
+	if (_type != var._type)
+		setType(var._type);
 
 	if      (_type == kTypeString)
-		*_value._string = *var._value._string;
+		string() = var.string();
 	else if (_type == kTypeObject)
-		*_value._object = *var._value._object;
+		object() = var.object();
 	else if (_type == kTypeEngineType)
 		*this = var._value._engineType;
 	else if (_type == kTypeScriptState)
 		*_value._scriptState = *var._value._scriptState;
 	else if (_type == kTypeArray)
-		_array = var._array;
+		array() = var.array();
+	else
+		_value = var._value;
+
+	return *this;
+}
+
+Variable &Variable::operator=(Variable &&var) noexcept {
+	if (&var == this)
+		return *this;
+
+	if ((var._type == kTypeEngineType) || (var._type == kTypeScriptState)) {
+		// Take over the other variable's value, leaving it void
+		destroy();
+
+		_type  = var._type;
+		_value = var._value;
+
+		var._type = kTypeVoid;
+
+		return *this;
+	}
+
+	if ((var._type == kTypeArray) && (_type != kTypeArray)) {
+		destroy();
+
+		new (&_value._array) ArrayPtr(std::move(var.array()));
+		_type = kTypeArray;
+
+		return *this;
+	}
+
+	if (_type != var._type)
+		setType(var._type);
+
+	if      (_type == kTypeString)
+		string() = std::move(var.string());
+	else if (_type == kTypeObject)
+		object() = var.object();
+	else if (_type == kTypeArray)
+		array().swap(var.array());
 	else
 		_value = var._value;
 
@@ -207,7 +274,7 @@ Variable &Variable::operator=(const Common::UString &value) {
 	if (_type != kTypeString)
 		throw Common::Exception("Can't assign a string value to a non-string variable");
 
-	*_value._string = value;
+	string() = value;
 
 	return *this;
 }
@@ -216,7 +283,7 @@ Variable &Variable::operator=(Object *value) {
 	if (_type != kTypeObject)
 		throw Common::Exception("Can't assign an object value to a non-object variable");
 
-	*_value._object = value;
+	object() = value;
 
 	return *this;
 }
@@ -225,7 +292,7 @@ Variable &Variable::operator=(const ObjectReference &value) {
 	if (_type != kTypeObject)
 		throw Common::Exception("Can't assign an object value to a non-object variable");
 
-	*_value._object = value;
+	object() = value;
 
 	return *this;
 }
@@ -267,10 +334,10 @@ bool Variable::operator==(const Variable &var) const {
 			return _value._float == var._value._float;
 
 		case kTypeString:
-			return *_value._string == *var._value._string;
+			return string() == var.string();
 
 		case kTypeObject:
-			return *_value._object == *var._value._object;
+			return object().getId() == var.object().getId();
 
 		case kTypeVector:
 			return _value._vector[0] == var._value._vector[0] &&
@@ -278,7 +345,7 @@ bool Variable::operator==(const Variable &var) const {
 			       _value._vector[2] == var._value._vector[2];
 
 		case kTypeArray:
-			return _array.get() && var._array.get() && *_array == *var._array;
+			return array().get() && var.array().get() && *array() == *var.array();
 
 		default:
 			break;
@@ -313,21 +380,21 @@ const Common::UString &Variable::getString() const {
 	if (_type != kTypeString)
 		throw Common::Exception("Can't get a string value from a non-string variable");
 
-	return *_value._string;
+	return string();
 }
 
 Common::UString &Variable::getString() {
 	if (_type != kTypeString)
 		throw Common::Exception("Can't get a string value from a non-string variable");
 
-	return *_value._string;
+	return string();
 }
 
 Object *Variable::getObject() const {
 	if (_type != kTypeObject)
 		throw Common::Exception("Can't get an object value from a non-object variable");
 
-	return **_value._object;
+	return *object();
 }
 
 EngineType *Variable::getEngineType() const {
@@ -359,41 +426,41 @@ const Variable::Array &Variable::getArray() const {
 	if (_type != kTypeArray)
 		throw Common::Exception("Can't get an array value from a non-array variable");
 
-	assert(_array.get());
+	assert(array().get());
 
-	return *_array;
+	return *array();
 }
 
 Variable::Array &Variable::getArray() {
 	if (_type != kTypeArray)
 		throw Common::Exception("Can't get an array value from a non-array variable");
 
-	assert(_array.get());
+	assert(array().get());
 
-	return *_array;
+	return *array();
 }
 
 size_t Variable::getArraySize() const {
 	if (_type != kTypeArray)
 		throw Common::Exception("Can't get an array size from a non-array variable");
 
-	assert(_array.get());
+	assert(array().get());
 
-	return _array->size();
+	return array()->size();
 }
 
 void Variable::growArray(Type type, size_t size) {
 	if (_type != kTypeArray)
 		throw Common::Exception("Can't grow a non-array variable");
 
-	assert(_array.get());
+	assert(array().get());
 
-	if (!_array->empty() && (*_array)[0].get() && (*_array)[0]->getType() != type)
-		throw Common::Exception("Array type mismatch (%d vs %d)", (*_array)[0]->getType(), type);
+	if (!array()->empty() && (*array())[0].get() && (*array())[0]->getType() != type)
+		throw Common::Exception("Array type mismatch (%d vs %d)", (*array())[0]->getType(), type);
 
-	_array->reserve(size);
-	while (_array->size() < size)
-		_array->push_back(boost::make_shared<Variable>(Variable(type)));
+	array()->reserve(size);
+	while (array()->size() < size)
+		array()->push_back(boost::make_shared<Variable>(Variable(type)));
 }
 
 ScriptState &Variable::getScriptState() {
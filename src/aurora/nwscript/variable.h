@@ -26,18 +26,17 @@
 #define AURORA_NWSCRIPT_VARIABLE_H
 
 #include <vector>
+#include <type_traits>
 
 #include <boost/shared_ptr.hpp>
 
 #include "src/common/types.h"
+#include "src/common/ustring.h"
 
 #include "src/aurora/types.h"
 
 #include "src/aurora/nwscript/types.h"
-
-namespace Common {
-	class UString;
-}
+#include "src/aurora/nwscript/objectref.h"
 
 namespace Aurora {
 
@@ -45,7 +44,6 @@ namespace NWScript {
 
 class Object;
 class EngineType;
-class ObjectReference;
 
 struct ScriptState {
 	uint32_t offset;
@@ -53,6 +51,13 @@ struct ScriptState {
 	std::vector<class Variable> locals;
 };
 
+/** A value in an NWScript script.
+ *
+ *  Strings, objects and arrays live directly inside the variable, so that
+ *  creating, copying and moving int, float, object and short string
+ *  values never touches the heap. Only arrays are reference-counted, and
+ *  shared between copies of a variable.
+ */
 class Variable {
 public:
 	typedef std::vector< boost::shared_ptr<Variable> > Array;
@@ -67,11 +72,13 @@ public:
 	Variable(const EngineType &value);
 	Variable(float x, float y, float z);
 	Variable(const Variable &var);
+	Variable(Variable &&var) noexcept;
 	~Variable();
 
 	void setType(Type type);
 
 	Variable &operator=(const Variable &var);
+	Variable &operator=(Variable &&var) noexcept;
 
 	Variable &operator=(int32_t value);
 	Variable &operator=(float value);
@@ -110,22 +117,65 @@ public:
 	void setReference(Variable *reference);
 
 private:
+	typedef boost::shared_ptr<Array> ArrayPtr;
+
 	Type _type;
 
 	union {
 		int32_t _int;
 		float _float;
-		Common::UString *_string;
-		ObjectReference *_object;
 		float _vector[3];
 		ScriptState *_scriptState;
 		EngineType *_engineType;
 		Variable *_reference;
+
+		/** A Common::UString, constructed in place. */
+		std::aligned_storage<sizeof(Common::UString), alignof(Common::UString)>::type _string;
+		/** An ObjectReference, constructed in place. */
+		std::aligned_storage<sizeof(ObjectReference), alignof(ObjectReference)>::type _object;
+		/** A shared pointer to an Array, constructed in place. */
+		std::aligned_storage<sizeof(ArrayPtr), alignof(ArrayPtr)>::type _array;
 	} _value;
 
-	boost::shared_ptr<Array> _array;
+	Common::UString &string();
+	const Common::UString &string() const;
+
+	ObjectReference &object();
+	const ObjectReference &object() const;
+
+	ArrayPtr &array();
+	const ArrayPtr &array() const;
+
+	/** Construct the default value of this type. */
+	void construct(Type type);
+	/** Destroy the current value, leaving a void variable. */
+	void destroy();
 };
 
+inline Common::UString &Variable::string() {
+	return *reinterpret_cast<Common::UString *>(&_value._string);
+}
+
+inline const Common::UString &Variable::string() const {
+	return *reinterpret_cast<const Common::UString *>(&_value._string);
+}
+
+inline ObjectReference &Variable::object() {
+	return *reinterpret_cast<ObjectReference *>(&_value._object);
+}
+
+inline const ObjectReference &Variable::object() const {
+	return *reinterpret_cast<const ObjectReference *>(&_value._object);
+}
+
+inline Variable::ArrayPtr &Variable::array() {
+	return *reinterpret_cast<ArrayPtr *>(&_value._array);
+}
+
+inline const Variable::ArrayPtr &Variable::array() const {
+	return *reinterpret_cast<const ArrayPtr *>(&_value._array);
+}
+
 } // End of namespace NWScript
 
 } // End of namespace Aurora
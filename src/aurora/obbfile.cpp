@@ -191,7 +191,8 @@ Common::SeekableReadStream *OBBFile::getResource(uint32_t index, bool UNUSED(try
 
 	const IResource &res = getIResource(index);
 
-	_obb->seek(res.offset);
+	// Our own cursor into the OBB, so that we don't touch the position of the shared stream
+	Common::SeekableSubReadStream obb(_obb.get(), res.offset, _obb->size());
 
 	std::unique_ptr<byte[]> data = std::make_unique<byte[]>(res.uncompressedSize);
 
@@ -200,7 +201,7 @@ Common::SeekableReadStream *OBBFile::getResource(uint32_t index, bool UNUSED(try
 
 	while (bytesLeft > 0) {
 		const size_t bytesChunk =
-			Common::decompressDeflateChunk(*_obb, Common::kWindowBitsMax,
+			Common::decompressDeflateChunk(obb, Common::kWindowBitsMax,
 			                               data.get() + offset, bytesLeft, 4096);
 
 		offset    += bytesChunk;
@@ -0,0 +1,280 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A persistent cache of archive resource indices.
+ */
+
+/* The cache file is laid out like this, all values little endian:
+ *
+ *  - uint32: Magic ID, 'XRIC' (big endian)
+ *  - uint32: Version
+ *  - uint32: Number of entries
+ *  - Entries:
+ *    - string: Path of the archive
+ *    - uint32: Size of the entry data
+ *    - Entry data:
+ *      - uint32: Number of files
+ *      - Files:
+ *        - string: Path of the file
+ *        - uint64: Size of the file
+ *        - uint64: Modification time of the file
+ *        - uint32: Name hash algorithm
+ *        - uint32: Number of resources
+ *        - Resources:
+ *          - string: Name
+ *          - uint64: Hash
+ *          - uint32: File type
+ *          - uint32: Index within the archive
+ *
+ * Strings are stored as a uint32 length, followed by that many bytes of UTF-8.
+ */
+
+#include <cstring>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+#include "src/common/encoding.h"
+#include "src/common/filepath.h"
+#include "src/common/mappedfile.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+#include "src/common/writefile.h"
+
+#include "src/aurora/resindexcache.h"
+
+static const uint32_t kCacheID      = MKTAG('X', 'R', 'I', 'C');
+static const uint32_t kCacheVersion = 1;
+
+namespace Aurora {
+
+static Common::UString readString(Common::SeekableReadStream &stream) {
+	const uint32_t length = stream.readUint32LE();
+	if (length > (stream.size() - stream.pos()))
+		throw Common::Exception(Common::kReadError);
+
+	return Common::readStringFixed(stream, Common::kEncodingUTF8, length);
+}
+
+
+ResourceIndexCache::File::File() : size(0), time(0), hashAlgo(Common::kHashNone) {
+}
+
+
+ResourceIndexCache::Entry::Entry() : data(0), size(0) {
+}
+
+
+ResourceIndexCache::ResourceIndexCache() : _modified(false) {
+}
+
+ResourceIndexCache::~ResourceIndexCache() {
+}
+
+void ResourceIndexCache::clear() {
+	_modified = !_entries.empty();
+
+	_entries.clear();
+	_file.reset();
+}
+
+bool ResourceIndexCache::isModified() const {
+	return _modified;
+}
+
+void ResourceIndexCache::load(const Common::UString &fileName) {
+	clear();
+
+	std::unique_ptr<Common::MappedFileReadStream> file =
+		std::make_unique<Common::MappedFileReadStream>(fileName);
+
+	const uint32_t id = file->readUint32BE();
+	if (id != kCacheID)
+		throw Common::Exception("Not a resource index cache file (%s)", Common::debugTag(id).c_str());
+
+	const uint32_t version = file->readUint32LE();
+	if (version != kCacheVersion)
+		throw Common::Exception("Unsupported resource index cache version %u", version);
+
+	const uint32_t count = file->readUint32LE();
+
+	EntryMap entries;
+	for (uint32_t i = 0; i < count; i++) {
+		const Common::UString path = readString(*file);
+
+		Entry &entry = entries[path];
+
+		entry.size = file->readUint32LE();
+		if (entry.size > (file->size() - file->pos()))
+			throw Common::Exception("Resource index cache entry \"%s\" out of range", path.c_str());
+
+		entry.data = file->getData() + file->pos();
+
+		file->skip(entry.size);
+	}
+
+	_entries.swap(entries);
+	_file = std::move(file);
+
+	_modified = false;
+}
+
+void ResourceIndexCache::save(const Common::UString &fileName) {
+	// We might be overwriting the file we loaded from, so we can't leave it mapped
+	detachFile();
+
+	Common::WriteFile file(fileName);
+
+	file.writeUint32BE(kCacheID);
+	file.writeUint32LE(kCacheVersion);
+	file.writeUint32LE(_entries.size());
+
+	for (EntryMap::const_iterator e = _entries.begin(); e != _entries.end(); ++e) {
+		writeString(file, e->first);
+
+		file.writeUint32LE(e->second.ownData.size());
+		file.write(e->second.ownData.data(), e->second.ownData.size());
+	}
+
+	file.flush();
+	file.close();
+
+	_modified = false;
+}
+
+void ResourceIndexCache::detachFile() {
+	if (!_file)
+		return;
+
+	for (EntryMap::iterator e = _entries.begin(); e != _entries.end(); ++e) {
+		if (!e->second.data)
+			continue;
+
+		e->second.ownData.assign(e->second.data, e->second.data + e->second.size);
+		e->second.data = 0;
+	}
+
+	_file.reset();
+}
+
+void ResourceIndexCache::writeString(Common::WriteStream &stream, const Common::UString &str) {
+	stream.writeUint32LE(strlen(str.c_str()));
+	stream.writeString(str);
+}
+
+bool ResourceIndexCache::statFile(File &file) {
+	if (!Common::FilePath::isRegularFile(file.path))
+		return false;
+
+	file.size = Common::FilePath::getFileSize(file.path);
+	file.time = Common::FilePath::getModificationTime(file.path);
+
+	return (file.size != Common::kFileInvalid) && (file.time != (std::time_t) -1);
+}
+
+bool ResourceIndexCache::find(const Common::UString &path, FileList &files) const {
+	EntryMap::const_iterator e = _entries.find(path);
+	if (e == _entries.end())
+		return false;
+
+	const byte *data = e->second.data ? e->second.data : e->second.ownData.data();
+
+	files.clear();
+
+	try {
+		Common::MemoryReadStream stream(data, e->second.size);
+
+		const uint32_t fileCount = stream.readUint32LE();
+		if (fileCount > stream.size())
+			throw Common::Exception(Common::kReadError);
+
+		files.resize(fileCount);
+		for (FileList::iterator f = files.begin(); f != files.end(); ++f) {
+			f->path     = readString(stream);
+			f->size     = stream.readUint64LE();
+			f->time     = (std::time_t) stream.readSint64LE();
+			f->hashAlgo = (Common::HashAlgo) stream.readSint32LE();
+
+			// Don't bother decoding the resources if the file changed anyway
+			File current;
+			current.path = f->path;
+
+			if (!statFile(current) || (current.size != f->size) || (current.time != f->time)) {
+				files.clear();
+				return false;
+			}
+
+			const uint32_t resCount = stream.readUint32LE();
+			for (uint32_t i = 0; i < resCount; i++) {
+				f->resources.push_back(Archive::Resource());
+				Archive::Resource &res = f->resources.back();
+
+				res.name  = readString(stream);
+				res.hash  = stream.readUint64LE();
+				res.type  = (FileType) stream.readUint32LE();
+				res.index = stream.readUint32LE();
+			}
+		}
+
+	} catch (...) {
+		// A broken entry is just an entry we don't have
+		files.clear();
+		return false;
+	}
+
+	return true;
+}
+
+void ResourceIndexCache::add(const Common::UString &path, FileList &files) {
+	for (FileList::iterator f = files.begin(); f != files.end(); ++f)
+		if (!statFile(*f))
+			return;
+
+	Common::MemoryWriteStreamDynamic stream(true);
+
+	stream.writeUint32LE(files.size());
+	for (FileList::const_iterator f = files.begin(); f != files.end(); ++f) {
+		writeString(stream, f->path);
+
+		stream.writeUint64LE(f->size);
+		stream.writeUint64LE((uint64_t) f->time);
+		stream.writeUint32LE((uint32_t) f->hashAlgo);
+
+		stream.writeUint32LE(f->resources.size());
+		for (Archive::ResourceList::const_iterator r = f->resources.begin(); r != f->resources.end(); ++r) {
+			writeString(stream, r->name);
+
+			stream.writeUint64LE(r->hash);
+			stream.writeUint32LE((uint32_t) r->type);
+			stream.writeUint32LE(r->index);
+		}
+	}
+
+	Entry &entry = _entries[path];
+
+	entry.data = 0;
+	entry.size = stream.size();
+	entry.ownData.assign(stream.getData(), stream.getData() + stream.size());
+
+	_modified = true;
+}
+
+} // End of namespace Aurora
@@ -0,0 +1,156 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A persistent cache of archive resource indices.
+ */
+
+#ifndef AURORA_RESINDEXCACHE_H
+#define AURORA_RESINDEXCACHE_H
+
+#include <ctime>
+
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/hash.h"
+
+#include "src/aurora/archive.h"
+
+namespace Common {
+	class MappedFileReadStream;
+	class WriteStream;
+}
+
+namespace Aurora {
+
+/** A cache of the resource lists of archive files, saved between runs.
+ *
+ *  Reading the resource list of an archive means parsing its header and
+ *  its whole resource table, which adds up over the hundreds of archives
+ *  some games come with. This cache stores these lists in a single file,
+ *  together with the size and modification time of the archive files
+ *  they were read from.
+ *
+ *  Loading the cache only maps the file into memory and collects the
+ *  paths of the archives in it. The resource lists of an archive are
+ *  only decoded, and checked against the archive files on disk, when
+ *  they are looked up. If any of the files changed, the lookup fails,
+ *  and the archive needs to be indexed the usual way.
+ *
+ *  A cache entry can span several files: the resource list of a KEY
+ *  file is spread over all its BIF files.
+ */
+class ResourceIndexCache : boost::noncopyable {
+public:
+	/** A file whose resources are cached. */
+	struct File {
+		Common::UString path; ///< The absolute path of the file.
+
+		size_t      size; ///< The size of the file.
+		std::time_t time; ///< The modification time of the file.
+
+		/** With which algorithm are the names in the archive hashed? */
+		Common::HashAlgo hashAlgo;
+
+		/** The resources in the archive. */
+		Archive::ResourceList resources;
+
+		File();
+	};
+
+	typedef std::vector<File> FileList;
+
+	ResourceIndexCache();
+	~ResourceIndexCache();
+
+	/** Remove all entries from the cache. */
+	void clear();
+
+	/** Load the cache from a file, replacing all current entries.
+	 *
+	 *  Throws if the file is not a valid cache file of the current version.
+	 */
+	void load(const Common::UString &fileName);
+
+	/** Save the cache into a file. */
+	void save(const Common::UString &fileName);
+
+	/** Was the cache changed since it was loaded or saved? */
+	bool isModified() const;
+
+	/** Look up the cached resources of an archive.
+	 *
+	 *  @param  path The absolute path of the archive file.
+	 *  @param  files The cached files making up this archive.
+	 *  @return true if there was an entry and all of its files are still unchanged.
+	 */
+	bool find(const Common::UString &path, FileList &files) const;
+
+	/** Add the resources of an archive to the cache, replacing an existing entry.
+	 *
+	 *  The size and modification time of each file are read from disk.
+	 *  If that fails, the archive is not added.
+	 *
+	 *  @param path The absolute path of the archive file.
+	 *  @param files The files making up this archive.
+	 */
+	void add(const Common::UString &path, FileList &files);
+
+private:
+	/** A cache entry, in its serialized form. */
+	struct Entry {
+		/** The serialized data, if it points into the loaded file. */
+		const byte *data;
+		/** The size of the serialized data. */
+		size_t size;
+
+		/** The serialized data, if it's not from the loaded file. */
+		std::vector<byte> ownData;
+
+		Entry();
+	};
+
+	typedef std::map<Common::UString, Entry> EntryMap;
+
+	/** The file we loaded the cache from. */
+	std::unique_ptr<Common::MappedFileReadStream> _file;
+
+	EntryMap _entries;
+
+	bool _modified;
+
+
+	/** Make all entries independent of the loaded file, and close it. */
+	void detachFile();
+
+	static void writeString(Common::WriteStream &stream, const Common::UString &str);
+
+	static bool statFile(File &file);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_RESINDEXCACHE_H
@@ -25,6 +25,7 @@
 #include <cassert>
 
 #include <memory>
+#include <algorithm>
 
 #include <boost/scope_exit.hpp>
 
@@ -32,10 +33,13 @@
 #include "src/common/error.h"
 #include "src/common/readstream.h"
 #include "src/common/filepath.h"
-#include "src/common/readfile.h"
+#include "src/common/mappedfile.h"
 #include "src/common/writefile.h"
+#include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/resman.h"
+#include "src/aurora/resindexcache.h"
 #include "src/aurora/util.h"
 
 #include "src/aurora/keyfile.h"
@@ -58,6 +62,12 @@ DECLARE_SINGLETON(Aurora::ResourceManager)
 
 namespace Aurora {
 
+/** The default maximum memory used for prefetched resources. */
+static const size_t kPrefetchCacheSize = 64 * 1024 * 1024;
+
+/** The maximum number of threads reading resources in the background. */
+static const size_t kPrefetchThreadCount = 4;
+
 ResourceManager::KnownArchive::KnownArchive() :
 	type(kArchiveMAX), resource(0), opened(0) {
 
@@ -72,8 +82,8 @@ ResourceManager::KnownArchive::KnownArchive(ArchiveType t, const Common::UString
 ResourceManager::OpenedArchive::OpenedArchive() : archive(0), known(0), parent(0) {
 }
 
-void ResourceManager::OpenedArchive::set(KnownArchive &kA, Archive &a) {
-	archive = &a;
+void ResourceManager::OpenedArchive::set(KnownArchive &kA, Archive *a) {
+	archive = a;
 	known   = &kA;
 
 	if (known->opened)
@@ -107,8 +117,12 @@ bool ResourceManager::Resource::operator<(const Resource &right) const {
 }
 
 
+ResourceManager::Prefetch::Prefetch(const Resource &res) : resource(&res), state(kPrefetchQueued) {
+}
+
+
 ResourceManager::ResourceManager() : _hasSmall(false),
-	_hashAlgo(Common::kHashFNV64) {
+	_hashAlgo(Common::kHashFNV64), _generation(0), _prefetchSize(0), _prefetchCacheSize(kPrefetchCacheSize) {
 
 	// These file types are archives
 
@@ -174,6 +188,8 @@ ResourceManager::ResourceManager() : _hasSmall(false),
 
 ResourceManager::~ResourceManager() {
 	clearResources();
+
+	_prefetchPool.reset();
 }
 
 void ResourceManager::clear() {
@@ -187,6 +203,8 @@ void ResourceManager::clear() {
 }
 
 void ResourceManager::clearResources() {
+	clearPrefetches();
+
 	_cursorRemap.clear();
 
 	_baseDir.clear();
@@ -201,7 +219,12 @@ void ResourceManager::clearResources() {
 
 	_resources.clear();
 
+	_resourcePool.clear();
+	_freeResources.clear();
+
 	_changes.clear();
+
+	_generation++;
 }
 
 void ResourceManager::setRIMsAreERFs(bool rimsAreERFs) {
@@ -266,6 +289,40 @@ const Common::UString &ResourceManager::getDataBase() const {
 	return _baseDir;
 }
 
+void ResourceManager::setIndexCache(const Common::UString &file) {
+	if (_indexCache && (file == _indexCacheFile))
+		return;
+
+	_indexCache.reset();
+	_indexCacheFile = file;
+
+	if (_indexCacheFile.empty())
+		return;
+
+	_indexCache = std::make_unique<ResourceIndexCache>();
+	if (!Common::FilePath::isRegularFile(_indexCacheFile))
+		return;
+
+	try {
+		_indexCache->load(_indexCacheFile);
+	} catch (...) {
+		Common::exceptionDispatcherWarning("Failed to load resource index cache \"%s\"", _indexCacheFile.c_str());
+
+		_indexCache->clear();
+	}
+}
+
+void ResourceManager::saveIndexCache() {
+	if (!_indexCache || !_indexCache->isModified())
+		return;
+
+	try {
+		_indexCache->save(_indexCacheFile);
+	} catch (...) {
+		Common::exceptionDispatcherWarning("Failed to save resource index cache \"%s\"", _indexCacheFile.c_str());
+	}
+}
+
 ResourceManager::KnownArchive *ResourceManager::findArchive(const Common::UString &file) {
 	ArchiveType archiveType = getArchiveType(file);
 	if (((size_t) archiveType) >= kArchiveMAX)
@@ -291,6 +348,16 @@ ResourceManager::KnownArchive *ResourceManager::findArchive(Common::UString file
 	return 0;
 }
 
+ResourceManager::KnownArchive *ResourceManager::findArchiveByPath(const Common::UString &path,
+                                                                  KnownArchives &archives) {
+
+	for (KnownArchives::iterator a = archives.begin(); a != archives.end(); ++a)
+		if (a->resource && (a->resource->source == kSourceFile) && (a->resource->path == path))
+			return &*a;
+
+	return 0;
+}
+
 bool ResourceManager::hasArchive(const Common::UString &file) {
 	return findArchive(file) != 0;
 }
@@ -302,62 +369,93 @@ Common::SeekableReadStream *ResourceManager::openArchiveStream(const KnownArchiv
 	return getResource(*archive.resource, true);
 }
 
-void ResourceManager::indexArchive(const Common::UString &file, uint32_t priority,
-                                   const std::vector<byte> &password, Common::ChangeID *changeID) {
-
-	KnownArchive *knownArchive = findArchive(file);
-	if (!knownArchive)
-		throw Common::Exception("No such archive file \"%s\"", file.c_str());
-
-	if (knownArchive->type == kArchiveBIF)
-		throw Common::Exception("Attempted to index a lone BIF");
+Archive *ResourceManager::openArchive(const KnownArchive &archive, const std::vector<byte> &password) const {
+	if ((archive.type == kArchiveKEY) || (((size_t) archive.type) >= kArchiveMAX))
+		throw Common::Exception("Invalid archive type %d", archive.type);
 
-	Change *change = 0;
-	if (changeID)
-		change = newChangeSet(*changeID);
+	Common::SeekableReadStream *archiveStream = openArchiveStream(archive);
 
-	Common::SeekableReadStream *archiveStream = openArchiveStream(*knownArchive);
+	switch (archive.type) {
+		case kArchiveBIF:
+			if (Common::FilePath::getExtension(archive.name).equalsIgnoreCase(".bzf"))
+				return new BZFFile(archiveStream);
 
-	std::unique_ptr<Archive> archive;
-	switch (knownArchive->type) {
-		case kArchiveKEY:
-			indexKEY(archiveStream, priority, change);
-			break;
+			return new BIFFile(archiveStream);
 
 		case kArchiveNDS:
-			archive = std::make_unique<NDSFile>(archiveStream);
-			break;
+			return new NDSFile(archiveStream);
 
 		case kArchiveHERF:
-			archive = std::make_unique<HERFFile>(archiveStream);
-			break;
+			return new HERFFile(archiveStream);
 
 		case kArchiveERF:
-			archive = std::make_unique<ERFFile>(archiveStream, password);
-			break;
+			return new ERFFile(archiveStream, password);
 
 		case kArchiveRIM:
-			archive = std::make_unique<RIMFile>(archiveStream);
-			break;
+			return new RIMFile(archiveStream);
 
 		case kArchiveZIP:
-			archive = std::make_unique<ZIPFile>(archiveStream);
-			break;
+			return new ZIPFile(archiveStream);
 
 		case kArchiveEXE:
-			archive = std::make_unique<PEFile>(archiveStream, _cursorRemap);
-			break;
+			return new PEFile(archiveStream, _cursorRemap);
 
 		case kArchiveNSBTX:
-			archive = std::make_unique<NSBTXFile>(archiveStream);
-			break;
+			return new NSBTXFile(archiveStream);
 
 		default:
-			throw Common::Exception("Invalid archive type %d", knownArchive->type);
+			break;
+	}
+
+	delete archiveStream;
+	throw Common::Exception("Invalid archive type %d", archive.type);
+}
+
+Archive &ResourceManager::getArchive(OpenedArchive &archive) const {
+	std::lock_guard<std::mutex> lock(_archiveMutex);
+
+	// Archives indexed from the cache are only opened when we first need them
+	if (!archive.archive) {
+		assert(archive.known);
+
+		archive.archive = openArchive(*archive.known, archive.password);
+	}
+
+	return *archive.archive;
+}
+
+void ResourceManager::indexArchive(const Common::UString &file, uint32_t priority,
+                                   const std::vector<byte> &password, Common::ChangeID *changeID) {
+
+	KnownArchive *knownArchive = findArchive(file);
+	if (!knownArchive)
+		throw Common::Exception("No such archive file \"%s\"", file.c_str());
+
+	if (knownArchive->type == kArchiveBIF)
+		throw Common::Exception("Attempted to index a lone BIF");
+
+	// The workers mustn't read anything while we're changing the resources
+	clearPrefetches();
+
+	Change *change = 0;
+	if (changeID)
+		change = newChangeSet(*changeID);
+
+	if (indexCachedArchive(*knownArchive, priority, password, change))
+		return;
+
+	if (knownArchive->type == kArchiveKEY) {
+		indexKEY(*knownArchive, priority, change);
+		return;
 	}
 
-	if (archive)
-		indexArchive(*knownArchive, archive.release(), priority, change);
+	Archive *archive = openArchive(*knownArchive, password);
+
+	if (isIndexCacheable(*knownArchive))
+		addToIndexCache(*knownArchive, std::vector<KnownArchive *>(1, knownArchive),
+		                std::vector<const Archive *>(1, archive));
+
+	indexArchive(*knownArchive, archive, priority, change);
 }
 
 void ResourceManager::indexArchive(const Common::UString &file, uint32_t priority, Common::ChangeID *changeID) {
@@ -405,11 +503,14 @@ uint32_t ResourceManager::openKEYBIFs(Common::SeekableReadStream *keyStream,
 	return archives.size();
 }
 
-void ResourceManager::indexKEY(Common::SeekableReadStream *stream, uint32_t priority, Change *change) {
+void ResourceManager::indexKEY(KnownArchive &key, uint32_t priority, Change *change) {
 	std::vector<KnownArchive *> archives;
 	std::vector<KEYDataFile *> keyData;
 
-	const uint32_t count = openKEYBIFs(stream, archives, keyData);
+	const uint32_t count = openKEYBIFs(openArchiveStream(key), archives, keyData);
+
+	if (isIndexCacheable(key))
+		addToIndexCache(key, archives, std::vector<const Archive *>(keyData.begin(), keyData.end()));
 
 	for (uint32_t i = 0; i < count; i++)
 		indexArchive(*archives[i], keyData[i], priority, change);
@@ -423,6 +524,14 @@ void ResourceManager::indexArchive(KnownArchive &knownArchive, Archive *archive,
 		throw Common::Exception("ResourceManager::indexArchive(): Archive uses a different name hashing "
 		                        "algorithm than we do (%d vs. %d)", (int) hashAlgo, (int) _hashAlgo);
 
+	OpenedArchive &openedArchive = addOpenedArchive(knownArchive, archive, change);
+
+	indexArchiveResources(openedArchive, archive->getResources(), hashAlgo, priority, change);
+}
+
+ResourceManager::OpenedArchive &ResourceManager::addOpenedArchive(KnownArchive &knownArchive, Archive *archive,
+                                                                  Change *change) {
+
 	bool couldSet = false;
 	_openedArchives.push_back(OpenedArchive());
 
@@ -433,20 +542,27 @@ void ResourceManager::indexArchive(KnownArchive &knownArchive, Archive *archive,
 		}
 	} BOOST_SCOPE_EXIT_END
 
-	_openedArchives.back().set(knownArchive, *archive);
+	_openedArchives.back().set(knownArchive, archive);
 	couldSet = true;
 
 	// Add the information of the new archive to the change set
 	if (change)
 		change->_change->openedArchives.push_back(--_openedArchives.end());
 
-	const Archive::ResourceList &resources = archive->getResources();
+	return _openedArchives.back();
+}
+
+void ResourceManager::indexArchiveResources(OpenedArchive &archive, const Archive::ResourceList &resources,
+                                            Common::HashAlgo hashAlgo, uint32_t priority, Change *change) {
+
+	_resources.reserve(_resources.size() + resources.size());
+
 	for (Archive::ResourceList::const_iterator resource = resources.begin(); resource != resources.end(); ++resource) {
 		// Build the resource record
 		Resource res;
 		res.priority     = priority;
 		res.source       = kSourceArchive;
-		res.archive      = &_openedArchives.back();
+		res.archive      = &archive;
 		res.archiveIndex = resource->index;
 		res.name         = resource->name;
 		res.type         = resource->type;
@@ -472,6 +588,84 @@ void ResourceManager::indexArchive(KnownArchive &knownArchive, Archive *archive,
 	}
 }
 
+bool ResourceManager::isIndexCacheable(const KnownArchive &archive) const {
+	if (!_indexCache || !archive.resource)
+		return false;
+
+	/* We only cache archives that are direct files. The resource names in
+	 * executables depend on the cursor remap, so we leave those out as well. */
+	return (archive.resource->source == kSourceFile) && (archive.type != kArchiveEXE);
+}
+
+bool ResourceManager::indexCachedArchive(KnownArchive &knownArchive, uint32_t priority,
+                                         const std::vector<byte> &password, Change *change) {
+
+	if (!isIndexCacheable(knownArchive))
+		return false;
+
+	ResourceIndexCache::FileList files;
+	if (!_indexCache->find(knownArchive.resource->path, files) || files.empty())
+		return false;
+
+	// The resources of a KEY are found in its BIFs. The KEY itself is the first file
+	const size_t first = (knownArchive.type == kArchiveKEY) ? 1 : 0;
+	if ((knownArchive.type != kArchiveKEY) && (files.size() != 1))
+		return false;
+
+	std::vector<KnownArchive *> archives;
+	for (size_t i = first; i < files.size(); i++) {
+		KnownArchive *archive = &knownArchive;
+		if (knownArchive.type == kArchiveKEY)
+			archive = findArchiveByPath(files[i].path, _knownArchives[kArchiveBIF]);
+
+		if (!archive || archive->opened)
+			return false;
+
+		// Let the archive be indexed the usual way, and fail there
+		if ((files[i].hashAlgo != Common::kHashNone) && (files[i].hashAlgo != _hashAlgo))
+			return false;
+
+		archives.push_back(archive);
+	}
+
+	for (size_t i = 0; i < archives.size(); i++) {
+		OpenedArchive &openedArchive = addOpenedArchive(*archives[i], 0, change);
+		openedArchive.password = password;
+
+		const ResourceIndexCache::File &file = files[first + i];
+
+		indexArchiveResources(openedArchive, file.resources, file.hashAlgo, priority, change);
+	}
+
+	return true;
+}
+
+void ResourceManager::addToIndexCache(const KnownArchive &knownArchive, const std::vector<KnownArchive *> &archives,
+                                      const std::vector<const Archive *> &data) {
+
+	assert(archives.size() == data.size());
+
+	ResourceIndexCache::FileList files;
+
+	if (knownArchive.type == kArchiveKEY) {
+		files.push_back(ResourceIndexCache::File());
+		files.back().path = knownArchive.resource->path;
+	}
+
+	for (size_t i = 0; i < archives.size(); i++) {
+		if (!archives[i]->resource || (archives[i]->resource->source != kSourceFile))
+			return;
+
+		files.push_back(ResourceIndexCache::File());
+
+		files.back().path      = archives[i]->resource->path;
+		files.back().hashAlgo  = data[i]->getNameHashAlgo();
+		files.back().resources = data[i]->getResources();
+	}
+
+	_indexCache->add(knownArchive.resource->path, files);
+}
+
 bool ResourceManager::hasResourceDir(const Common::UString &dir) {
 	if (_baseDir.empty())
 		return false;
@@ -489,6 +683,9 @@ void ResourceManager::indexResourceFile(const Common::UString &file, uint32_t pr
 	if (!Common::FilePath::isRegularFile(path))
 		throw Common::Exception("No such file \"%s\"", file.c_str());
 
+	// The workers mustn't read anything while we're changing the resources
+	clearPrefetches();
+
 	Change *change = 0;
 	if (changeID)
 		change = newChangeSet(*changeID);
@@ -510,6 +707,9 @@ void ResourceManager::indexResourceDir(const Common::UString &dir, const char *g
 	Common::FileList files;
 	files.addDirectory(directory, depth);
 
+	// The workers mustn't read anything while we're changing the resources
+	clearPrefetches();
+
 	Change *change = 0;
 	if (changeID)
 		change = newChangeSet(*changeID);
@@ -533,6 +733,9 @@ void ResourceManager::undo(Common::ChangeID &changeID) {
 	if (!change || (change->_change == _changes.end()))
 		return;
 
+	// The prefetches might reference resources we're about to remove
+	clearPrefetches();
+
 	// Removing all changes in the opened archives list
 	for (OpenedArchiveChanges::iterator oaChange = change->_change->openedArchives.begin();
 	     oaChange != change->_change->openedArchives.end(); ++oaChange) {
@@ -584,25 +787,34 @@ void ResourceManager::undo(Common::ChangeID &changeID) {
 	for (ResourceChanges::iterator resChange = change->_change->resources.begin();
 	     resChange != change->_change->resources.end(); ++resChange) {
 
+		Resource *res = resChange->resource;
+
 		// If the resource still has an archive attached, it was added by a
 		// declareResources() call and needs to be removed manually
-		if (resChange->resIt->selfArchive.first) {
-			if (resChange->resIt->selfArchive.second->opened)
+		if (res->selfArchive.first) {
+			if (res->selfArchive.second->opened)
 				throw Common::Exception("Attempted to deindex an archive resource that's still opened");
 
-			resChange->resIt->selfArchive.first->erase(resChange->resIt->selfArchive.second);
+			res->selfArchive.first->erase(res->selfArchive.second);
 		}
 
 		// Remove the resource, and the name list too if it's empty
-		resChange->hashIt->second.erase(resChange->resIt);
+		ResourceList *resList = _resources.find(resChange->hash);
+		assert(resList);
+
+		resList->erase(std::find(resList->begin(), resList->end(), res));
 
-		if (resChange->hashIt->second.empty())
-			_resources.erase(resChange->hashIt);
+		if (resList->empty())
+			_resources.erase(resChange->hash);
+
+		freeResource(res);
 	}
 
 	// Now we can remove the change set from our list of change sets
 	_changes.erase(change->_change);
 
+	_generation++;
+
 	// And finally set the change ID to a defined empty state
 	changeID.clear();
 }
@@ -612,19 +824,21 @@ void ResourceManager::addTypeAlias(FileType alias, FileType realType) {
 }
 
 void ResourceManager::blacklist(const Common::UString &name, FileType type) {
-	ResourceMap::iterator resList = _resources.find(getHash(name, type));
-	if (resList == _resources.end())
+	ResourceList *resList = _resources.find(getHash(name, type));
+	if (!resList)
 		return;
 
-	for (ResourceList::iterator res = resList->second.begin(); res != resList->second.end(); ++res)
-		res->priority = 0;
+	for (ResourceList::iterator res = resList->begin(); res != resList->end(); ++res)
+		(*res)->priority = 0;
+
+	_generation++;
 }
 
 void ResourceManager::declareResource(const Common::UString &name, FileType type) {
 	bool isSmall = false;
 
-	ResourceMap::iterator resList = _resources.find(getHash(name, type));
-	if (resList == _resources.end()) {
+	ResourceList *resList = _resources.find(getHash(name, type));
+	if (!resList) {
 		if (_hasSmall) {
 			Common::UString smallName = TypeMan.addFileType(TypeMan.setFileType(name, type), kFileTypeSMALL);
 
@@ -632,23 +846,32 @@ void ResourceManager::declareResource(const Common::UString &name, FileType type
 			isSmall = true;
 		}
 
-		if (resList == _resources.end())
+		if (!resList)
 			return;
 	}
 
-	for (ResourceList::iterator r = resList->second.begin(); r != resList->second.end(); ++r) {
-		r->name    = name;
-		r->type    = type;
-		r->isSmall = isSmall;
+	// The workers mustn't read these resources while we're changing them
+	clearPrefetches();
+
+	for (ResourceList::iterator r = resList->begin(); r != resList->end(); ++r) {
+		(*r)->name    = name;
+		(*r)->type    = type;
+		(*r)->isSmall = isSmall;
 
-		checkResourceIsArchive(*r, 0);
+		checkResourceIsArchive(**r, 0);
 	}
+
+	_generation++;
 }
 
 void ResourceManager::declareResource(const Common::UString &name) {
 	declareResource(TypeMan.setFileType(name, kFileTypeNone), TypeMan.getFileType(name));
 }
 
+uint32_t ResourceManager::getGeneration() const {
+	return _generation.load();
+}
+
 bool ResourceManager::hasResource(const Common::UString &name, FileType type) const {
 	std::vector<FileType> types;
 
@@ -704,10 +927,10 @@ Common::UString ResourceManager::findResourceFile(const Common::UString &name,
 
 uint32_t ResourceManager::getResourceSize(const Resource &res) const {
 	if (res.source == kSourceArchive) {
-		if ((res.archive == 0) || (res.archive->archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
+		if ((res.archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
 			return 0xFFFFFFFF;
 
-		return res.archive->archive->getResourceSize(res.archiveIndex);
+		return getArchive(*res.archive).getResourceSize(res.archiveIndex);
 	}
 
 	if (res.source == kSourceFile)
@@ -717,10 +940,10 @@ uint32_t ResourceManager::getResourceSize(const Resource &res) const {
 }
 
 Common::SeekableReadStream *ResourceManager::getArchiveResource(const Resource &res, bool tryNoCopy) const {
-	if ((res.archive == 0) || (res.archive->archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
+	if ((res.archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
 		throw Common::Exception("Archive resource has no archive");
 
-	return res.archive->archive->getResource(res.archiveIndex, tryNoCopy);
+	return getArchive(*res.archive).getResource(res.archiveIndex, tryNoCopy);
 }
 
 Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &name, FileType type) const {
@@ -762,11 +985,19 @@ Common::SeekableReadStream *ResourceManager::getResource(uint64_t hash, FileType
 }
 
 Common::SeekableReadStream *ResourceManager::getResource(const Resource &res, bool tryNoCopy) const {
+	Common::SeekableReadStream *stream = takePrefetch(res);
+	if (stream)
+		return stream;
+
+	return openResource(res, tryNoCopy);
+}
+
+Common::SeekableReadStream *ResourceManager::openResource(const Resource &res, bool tryNoCopy) const {
 	Common::SeekableReadStream *stream = 0;
 
 	switch (res.source) {
 		case kSourceFile:
-			stream = new Common::ReadFile(res.path);
+			stream = new Common::MappedFileReadStream(res.path);
 			break;
 
 		case kSourceArchive:
@@ -802,32 +1033,35 @@ Common::SeekableReadStream *ResourceManager::getResource(ResourceType resType,
 void ResourceManager::getAvailableResources(FileType type,
 		std::list<ResourceID> &list) const {
 
-	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
-		if (!r->second.empty() && (r->second.front().type == type)) {
-			list.push_back(ResourceID());
-
-			list.back().name = r->second.front().name;
-			list.back().type = r->second.front().type;
-			list.back().hash = r->first;
-		}
-	}
+	getAvailableResources(std::vector<FileType>(1, type), list);
 }
 
 void ResourceManager::getAvailableResources(const std::vector<FileType> &types,
 		std::list<ResourceID> &list) const {
 
+	std::vector<FileType> sortedTypes(types);
+	std::sort(sortedTypes.begin(), sortedTypes.end());
+
+	std::vector<ResourceID> found;
+
 	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
-		for (std::vector<FileType>::const_iterator t = types.begin(); t != types.end(); ++t) {
-			if (!r->second.empty() && (r->second.front().type == *t)) {
-				list.push_back(ResourceID());
+		if (r->empty() || !std::binary_search(sortedTypes.begin(), sortedTypes.end(), r->front()->type))
+			continue;
 
-				list.back().name = r->second.front().name;
-				list.back().type = r->second.front().type;
-				list.back().hash = r->first;
-			}
-		}
+		found.push_back(ResourceID());
 
+		found.back().name = r->front()->name;
+		found.back().type = r->front()->type;
+		found.back().hash = r.hash();
 	}
+
+	/* The hash index is unordered. Sort by hash, so that the order of the
+	 * resources we return doesn't depend on the order they were indexed in. */
+	std::stable_sort(found.begin(), found.end(), [](const ResourceID &a, const ResourceID &b) {
+		return a.hash < b.hash;
+	});
+
+	list.insert(list.end(), found.begin(), found.end());
 }
 
 void ResourceManager::getAvailableResources(ResourceType type,
@@ -836,6 +1070,202 @@ void ResourceManager::getAvailableResources(ResourceType type,
 	getAvailableResources(_resourceTypeTypes[type], list);
 }
 
+std::future<std::unique_ptr<Common::SeekableReadStream>>
+ResourceManager::getResourceAsync(const Common::UString &name, FileType type) {
+	const Resource *res = getRes(name, type);
+	if (!res) {
+		std::promise<std::unique_ptr<Common::SeekableReadStream>> none;
+		none.set_value(std::unique_ptr<Common::SeekableReadStream>());
+
+		return none.get_future();
+	}
+
+	return getPrefetchPool().submit([this, res]() {
+		return std::unique_ptr<Common::SeekableReadStream>(getResource(*res));
+	});
+}
+
+Common::ThreadPool &ResourceManager::getPrefetchPool() {
+	std::lock_guard<std::mutex> lock(_prefetchPoolMutex);
+
+	if (!_prefetchPool) {
+		const size_t threadCount = MIN(Common::ThreadPool::getHardwareThreadCount(), kPrefetchThreadCount);
+
+		_prefetchPool = std::make_unique<Common::ThreadPool>(threadCount, "resman");
+	}
+
+	return *_prefetchPool;
+}
+
+void ResourceManager::prefetch(const Common::UString &name, FileType type) {
+	const Resource *res = getRes(name, type);
+	if (res)
+		prefetch(*res);
+}
+
+void ResourceManager::prefetch(const Common::UString &name, ResourceType type) {
+	assert((type >= 0) && (type < kResourceMAX));
+
+	const Resource *res = getRes(name, _resourceTypeTypes[type]);
+	if (res)
+		prefetch(*res);
+}
+
+void ResourceManager::prefetch(const Resource &res) {
+	{
+		std::lock_guard<std::mutex> lock(_prefetchMutex);
+
+		if (_prefetchMap.find(&res) != _prefetchMap.end())
+			return;
+
+		_prefetches.push_back(Prefetch(res));
+		_prefetchMap[&res] = --_prefetches.end();
+	}
+
+	getPrefetchPool().submit([this, &res]() { loadPrefetch(res); });
+}
+
+void ResourceManager::loadPrefetch(const Resource &res) {
+	{
+		std::lock_guard<std::mutex> lock(_prefetchMutex);
+
+		// The prefetch might have already been picked up or dropped
+		PrefetchMap::iterator p = _prefetchMap.find(&res);
+		if ((p == _prefetchMap.end()) || (p->second->state != kPrefetchQueued))
+			return;
+
+		p->second->state = kPrefetchLoading;
+	}
+
+	std::unique_ptr<Common::SeekableReadStream> stream;
+	try {
+		stream.reset(openResource(res, false));
+
+		// Mapped files and views aren't read until they're accessed. Make sure they are
+		if (!dynamic_cast<Common::MemoryReadStream *>(stream.get()))
+			stream.reset(stream->readStream(stream->size()));
+
+	} catch (...) {
+		// Leave the error for when the resource is actually requested
+		stream.reset();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_prefetchMutex);
+
+		// Nobody removes a prefetch that's loading, so it's still there
+		PrefetchMap::iterator p = _prefetchMap.find(&res);
+		assert(p != _prefetchMap.end());
+
+		if (stream) {
+			_prefetchSize += stream->size();
+
+			p->second->stream = std::move(stream);
+			p->second->state  = kPrefetchReady;
+
+			_prefetches.splice(_prefetches.end(), _prefetches, p->second);
+
+			evictPrefetches();
+
+		} else {
+			_prefetches.erase(p->second);
+			_prefetchMap.erase(p);
+		}
+	}
+
+	_prefetchDone.notify_all();
+}
+
+Common::SeekableReadStream *ResourceManager::takePrefetch(const Resource &res) const {
+	std::unique_lock<std::mutex> lock(_prefetchMutex);
+
+	PrefetchMap::iterator p = _prefetchMap.find(&res);
+	if (p == _prefetchMap.end())
+		return 0;
+
+	// If a worker is reading the resource right now, wait for it to finish
+	while ((p != _prefetchMap.end()) && (p->second->state == kPrefetchLoading)) {
+		_prefetchDone.wait(lock);
+
+		p = _prefetchMap.find(&res);
+	}
+
+	if (p == _prefetchMap.end())
+		return 0;
+
+	/* If it's still queued, we'll just read it ourselves. Removing it
+	 * here makes the worker skip it. */
+	std::unique_ptr<Common::SeekableReadStream> stream = std::move(p->second->stream);
+	if (stream)
+		_prefetchSize -= stream->size();
+
+	_prefetches.erase(p->second);
+	_prefetchMap.erase(p);
+
+	return stream.release();
+}
+
+void ResourceManager::evictPrefetches() const {
+	PrefetchList::iterator p = _prefetches.begin();
+	while ((_prefetchSize > _prefetchCacheSize) && (p != _prefetches.end())) {
+		if (p->state != kPrefetchReady) {
+			++p;
+			continue;
+		}
+
+		_prefetchSize -= p->stream->size();
+
+		_prefetchMap.erase(p->resource);
+		p = _prefetches.erase(p);
+	}
+}
+
+void ResourceManager::setPrefetchCacheSize(size_t size) {
+	std::lock_guard<std::mutex> lock(_prefetchMutex);
+
+	_prefetchCacheSize = size;
+	evictPrefetches();
+}
+
+void ResourceManager::clearPrefetches() {
+	{
+		std::lock_guard<std::mutex> lock(_prefetchMutex);
+
+		// Drop everything that's not currently being read
+		PrefetchList::iterator p = _prefetches.begin();
+		while (p != _prefetches.end()) {
+			if (p->state == kPrefetchLoading) {
+				++p;
+				continue;
+			}
+
+			if (p->stream)
+				_prefetchSize -= p->stream->size();
+
+			_prefetchMap.erase(p->resource);
+			p = _prefetches.erase(p);
+		}
+	}
+
+	// Wait for the workers to finish, including all getResourceAsync() calls
+	Common::ThreadPool *prefetchPool = 0;
+	{
+		std::lock_guard<std::mutex> lock(_prefetchPoolMutex);
+
+		prefetchPool = _prefetchPool.get();
+	}
+
+	if (prefetchPool)
+		prefetchPool->wait();
+
+	std::lock_guard<std::mutex> lock(_prefetchMutex);
+
+	_prefetches.clear();
+	_prefetchMap.clear();
+
+	_prefetchSize = 0;
+}
+
 ArchiveType ResourceManager::getArchiveType(FileType type) const {
 	for (size_t i = 0; i < kArchiveMAX; i++)
 		if (_archiveTypeTypes[i].find(type) != _archiveTypeTypes[i].end())
@@ -902,17 +1332,17 @@ inline uint64_t ResourceManager::getHash(const Common::UString &name) const {
 	return Common::hashString(name.toLower(), _hashAlgo);
 }
 
-void ResourceManager::checkHashCollision(const Resource &resource, ResourceMap::const_iterator resList) {
-	if (resource.name.empty() || resList->second.empty())
+void ResourceManager::checkHashCollision(const Resource &resource, const ResourceList &resList) {
+	if (resource.name.empty() || resList.empty())
 		return;
 
 	Common::UString newName = TypeMan.setFileType(resource.name, resource.type).toLower();
 
-	for (ResourceList::const_iterator r = resList->second.begin(); r != resList->second.end(); ++r) {
-		if (r->name.empty())
+	for (ResourceList::const_iterator r = resList.begin(); r != resList.end(); ++r) {
+		if ((*r)->name.empty())
 			continue;
 
-		Common::UString oldName = TypeMan.setFileType(r->name, r->type).toLower();
+		Common::UString oldName = TypeMan.setFileType((*r)->name, (*r)->type).toLower();
 		if (oldName != newName) {
 			warning("ResourceManager: Found hash collision: %s (\"%s\" and \"%s\")",
 					Common::formatHash(getHash(oldName)).c_str(), oldName.c_str(), newName.c_str());
@@ -952,37 +1382,53 @@ bool ResourceManager::checkResourceIsArchive(Resource &resource, Change *change)
 	return true;
 }
 
-void ResourceManager::addResource(Resource &resource, uint64_t hash, Change *change) {
-	ResourceMap::iterator resList = _resources.find(hash);
-	if (resList == _resources.end()) {
-		// We don't have a resource with this name yet, create a new resource list for it
+ResourceManager::Resource *ResourceManager::allocateResource(const Resource &resource) {
+	if (_freeResources.empty()) {
+		_resourcePool.push_back(resource);
+		return &_resourcePool.back();
+	}
 
-		std::pair<ResourceMap::iterator, bool> result;
+	Resource *res = _freeResources.back();
+	_freeResources.pop_back();
 
-		result = _resources.insert(std::make_pair(hash, ResourceList()));
+	*res = resource;
+	return res;
+}
 
-		resList = result.first;
-	}
+void ResourceManager::freeResource(Resource *resource) {
+	// Clear it, so that it doesn't keep its strings around
+	*resource = Resource();
+
+	_freeResources.push_back(resource);
+}
+
+void ResourceManager::addResource(Resource &resource, uint64_t hash, Change *change) {
+	// Find the list of resources with this name, creating a new one if necessary
+	ResourceList &resList = _resources[hash];
 
 #ifdef CHECK_HASH_COLLISION
 	checkHashCollision(resource, resList);
 #endif
 
 	// Add the resource to the list
-	resList->second.push_back(resource);
-	Resource *res = &resList->second.back();
+	Resource *res = allocateResource(resource);
+	resList.push_back(res);
 
 	checkResourceIsArchive(*res, change);
 
 	// Remember the resource in the change set
 	if (change) {
 		change->_change->resources.push_back(ResourceChange());
-		change->_change->resources.back().hashIt = resList;
-		change->_change->resources.back().resIt  = --resList->second.end();
+		change->_change->resources.back().hash     = hash;
+		change->_change->resources.back().resource = res;
 	}
 
 	// Resort the list by priority
-	resList->second.sort();
+	std::stable_sort(resList.begin(), resList.end(), [](const Resource *a, const Resource *b) {
+		return *a < *b;
+	});
+
+	_generation++;
 }
 
 void ResourceManager::addResource(const Common::UString &path, Change *change, uint32_t priority) {
@@ -1016,11 +1462,11 @@ void ResourceManager::addResources(const Common::FileList &files, Change *change
 }
 
 const ResourceManager::Resource *ResourceManager::getRes(uint64_t hash) const {
-	ResourceMap::const_iterator r = _resources.find(hash);
-	if ((r == _resources.end()) || r->second.empty() || (r->second.back().priority == 0))
+	const ResourceList *resList = _resources.find(hash);
+	if (!resList || resList->empty() || (resList->back()->priority == 0))
 		return 0;
 
-	return &r->second.back();
+	return resList->back();
 }
 
 const ResourceManager::Resource *ResourceManager::getRes(const Common::UString &name,
@@ -1060,15 +1506,22 @@ void ResourceManager::dumpResourcesList(const Common::UString &fileName) const {
 	file.writeString("                Name                 |        Hash        |     Size    \n");
 	file.writeString("-------------------------------------|--------------------|-------------\n");
 
-	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
-		if (r->second.empty())
-			continue;
+	// Sort the hashes, so that the dump doesn't depend on the order things were indexed in
+	std::vector<uint64_t> hashes;
+	hashes.reserve(_resources.size());
+
+	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r)
+		if (!r->empty())
+			hashes.push_back(r.hash());
+
+	std::sort(hashes.begin(), hashes.end());
 
-		const Resource &res = r->second.back();
+	for (std::vector<uint64_t>::const_iterator h = hashes.begin(); h != hashes.end(); ++h) {
+		const Resource &res = *_resources.find(*h)->back();
 
 		const Common::UString &name = res.name;
 		const Common::UString   ext = TypeMan.setFileType("", res.type);
-		const uint64_t         hash = r->first;
+		const uint64_t         hash = *h;
 		const uint32_t         size = getResourceSize(res);
 
 		const Common::UString line =
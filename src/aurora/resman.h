@@ -27,27 +27,35 @@
 
 #include <list>
 #include <vector>
+#include <deque>
 #include <map>
 #include <set>
+#include <memory>
+#include <future>
+#include <atomic>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
 #include "src/common/singleton.h"
 #include "src/common/filelist.h"
 #include "src/common/hash.h"
+#include "src/common/hashindex.h"
 #include "src/common/changeid.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
+#include "src/aurora/archive.h"
 
 namespace Common {
 	class SeekableReadStream;
+	class ThreadPool;
 }
 
 namespace Aurora {
 
-class Archive;
 class KEYFile;
 class KEYDataFile;
+class ResourceIndexCache;
 
 /** A resource manager holding information about and handling all request for all
  *  resources usable by the game.
@@ -107,6 +115,22 @@ public:
 	const Common::UString &getDataBase() const;
 	// '---
 
+	// .--- Index cache
+	/** Use a file to cache the resource lists of archives between runs.
+	 *
+	 *  If the file exists, the cache is loaded from it. An archive that's
+	 *  found in the cache, and that hasn't changed on disk since, is not
+	 *  parsed when it's indexed. Instead, it's only opened once a resource
+	 *  is actually read from it.
+	 *
+	 *  @param file The cache file. If empty, no index cache is used.
+	 */
+	void setIndexCache(const Common::UString &file);
+
+	/** Write the index cache back into its file, if it changed. */
+	void saveIndexCache();
+	// '---
+
 	// .--- Archives
 	/** Does a specific archive exist?
 	 *
@@ -205,6 +229,14 @@ public:
 	 *  @param name The name (with extension) of the resource.
 	 */
 	void declareResource(const Common::UString &name);
+
+	/** Return a counter that changes whenever the set of known resources changes.
+	 *
+	 *  Anything caching data read from resources can compare this to the
+	 *  value it saw when filling its cache, to find out whether the cached
+	 *  data might be stale.
+	 */
+	uint32_t getGeneration() const;
 	// '---
 
 	// .--- Resources
@@ -331,6 +363,18 @@ public:
 	Common::SeekableReadStream *getResource(ResourceType resType,
 			const Common::UString &name, FileType *foundType = 0) const;
 
+	/** Return a resource, read in the background.
+	 *
+	 *  The resource is looked up right away, but read (and decompressed,
+	 *  if necessary) by a worker thread.
+	 *
+	 *  @param  name The name (ResRef) of the resource.
+	 *  @param  type The resource's type.
+	 *  @return A future of the resource stream, which will be 0 if the resource doesn't exist.
+	 */
+	std::future<std::unique_ptr<Common::SeekableReadStream>> getResourceAsync(const Common::UString &name,
+	                                                                         FileType type);
+
 	/** Return a list of all available resources of the specified type. */
 	void getAvailableResources(FileType type, std::list<ResourceID> &list) const;
 	/** Return a list of all available resources of the specified type. */
@@ -339,6 +383,43 @@ public:
 	void getAvailableResources(ResourceType type, std::list<ResourceID> &list) const;
 	// '---
 
+	// .--- Prefetching
+	/** Start reading a resource in the background, before it's needed.
+	 *
+	 *  The resource is read, and decompressed if necessary, by a worker
+	 *  thread. It's then kept in memory until it's requested with one of
+	 *  the getResource() methods. If it's requested while still being read,
+	 *  getResource() waits for the worker to finish.
+	 *
+	 *  Only a limited amount of memory is used for prefetched resources.
+	 *  If that's exceeded, the resources prefetched the longest time ago
+	 *  are dropped again.
+	 *
+	 *  Indexing, declaring or undoing resources waits for the workers and
+	 *  drops all prefetched resources, so that no worker ever reads a
+	 *  resource that's being changed.
+	 *
+	 *  Does nothing if the resource doesn't exist.
+	 *
+	 *  @param name The name (ResRef) of the resource.
+	 *  @param type The resource's type.
+	 */
+	void prefetch(const Common::UString &name, FileType type);
+
+	/** Start reading a resource in the background, before it's needed.
+	 *
+	 *  @param name The name (ResRef) of the resource.
+	 *  @param type The resource's type.
+	 */
+	void prefetch(const Common::UString &name, ResourceType type);
+
+	/** Set the maximum memory, in bytes, used to hold prefetched resources. */
+	void setPrefetchCacheSize(size_t size);
+
+	/** Wait for all running prefetches and drop all prefetched resources. */
+	void clearPrefetches();
+	// '---
+
 	/** Dump a list of all resources into a file. */
 	void dumpResourcesList(const Common::UString &fileName) const;
 
@@ -366,9 +447,12 @@ private:
 	};
 
 	struct OpenedArchive {
-		/** The actual archive. */
+		/** The actual archive, or 0 if it was indexed from the cache and not needed yet. */
 		Archive *archive;
 
+		/** The password to open the archive with, if it isn't opened yet. */
+		std::vector<byte> password;
+
 		/** The information we know about this archive. */
 		KnownArchive *known;
 
@@ -379,7 +463,7 @@ private:
 
 		OpenedArchive();
 
-		void set(KnownArchive &kA, Archive &a);
+		void set(KnownArchive &kA, Archive *a);
 	};
 
 	/** List of all known archive files. */
@@ -425,10 +509,12 @@ private:
 		bool operator<(const Resource &right) const;
 	};
 
-	/** List of resources, sorted by priority. */
-	typedef std::list<Resource> ResourceList;
+	/** List of resources with the same hashed name, sorted by priority. */
+	typedef std::vector<Resource *> ResourceList;
 	/** Map over resources, indexed by their hashed name. */
-	typedef std::map<uint64_t, ResourceList> ResourceMap;
+	typedef Common::HashIndex<ResourceList> ResourceMap;
+	/** Storage of all resources. Growing it never moves the resources already in it. */
+	typedef std::deque<Resource> ResourcePool;
 	// '---
 
 	// .--- Changes
@@ -438,8 +524,8 @@ private:
 	typedef OpenedArchives::iterator OpenedArchiveChange;
 	/** A change produced by indexing archive resources. */
 	struct ResourceChange {
-		ResourceMap::iterator  hashIt;
-		ResourceList::iterator resIt;
+		uint64_t  hash;     ///< The hashed name the resource was indexed under.
+		Resource *resource; ///< The resource itself.
 	};
 
 	typedef std::list<KnownArchiveChange>  KnownArchiveChanges;
@@ -470,6 +556,29 @@ private:
 	};
 	// '---
 
+	// .--- Prefetching
+	enum PrefetchState {
+		kPrefetchQueued , ///< Waiting for a worker.
+		kPrefetchLoading, ///< Being read by a worker.
+		kPrefetchReady    ///< Read and waiting to be picked up.
+	};
+
+	/** A resource being read, or already read, in the background. */
+	struct Prefetch {
+		const Resource *resource;
+		PrefetchState   state;
+
+		/** The resource's data, once it's ready. */
+		std::unique_ptr<Common::SeekableReadStream> stream;
+
+		Prefetch(const Resource &res);
+	};
+
+	/** All prefetches, the ones finished the longest time ago first. */
+	typedef std::list<Prefetch> PrefetchList;
+	typedef std::map<const Resource *, PrefetchList::iterator> PrefetchMap;
+	// '---
+
 
 	/** Do we have "small" files? */
 	bool _hasSmall;
@@ -494,32 +603,78 @@ private:
 	ResourceMap   _resources; ///< All currently known resources.
 	ChangeSetList _changes;   ///< Changes produced by indexing the currently known resources.
 
+	std::atomic<uint32_t> _generation; ///< Changed whenever _resources changes.
+
+	ResourcePool            _resourcePool;  ///< The actual resources in _resources.
+	std::vector<Resource *> _freeResources; ///< Unused resources in the pool, ready to be reused.
+
 	FileTypeSet  _archiveTypeTypes [kArchiveMAX];  ///< All valid archive types file types.
 	FileTypeList _resourceTypeTypes[kResourceMAX]; ///< All valid resource type file types.
 
+	std::unique_ptr<ResourceIndexCache> _indexCache; ///< The cache of archive resource lists.
+	Common::UString _indexCacheFile;                 ///< The file the index cache lives in.
+
+	/** Protects opening archives that were indexed from the cache. */
+	mutable std::mutex _archiveMutex;
+
+	/** The workers reading resources in the background. */
+	std::unique_ptr<Common::ThreadPool> _prefetchPool;
+	/** Protects the creation of the prefetch workers. */
+	std::mutex _prefetchPoolMutex;
+
+	mutable PrefetchList _prefetches;        ///< All prefetched resources.
+	mutable PrefetchMap  _prefetchMap;       ///< The prefetched resources, indexed by resource.
+	mutable size_t       _prefetchSize;      ///< The memory used by prefetched resources.
+	size_t               _prefetchCacheSize; ///< The maximum memory used by prefetched resources.
+
+	/** Protects the prefetched resources. */
+	mutable std::mutex _prefetchMutex;
+	/** Signaled when a worker finished a prefetch. */
+	mutable std::condition_variable _prefetchDone;
+
 
 	void clearResources();
 
 	// .--- Searching for archives
 	KnownArchive *findArchive(const Common::UString &file);
 	KnownArchive *findArchive(Common::UString file, KnownArchives &archives);
+	KnownArchive *findArchiveByPath(const Common::UString &path, KnownArchives &archives);
 	// '---
 
 	// .--- Indexing archives
-	void indexKEY(Common::SeekableReadStream *stream, uint32_t priority, Change *change);
+	void indexKEY(KnownArchive &key, uint32_t priority, Change *change);
 	uint32_t openKEYBIFs(Common::SeekableReadStream *keyStream,
 	                   std::vector<KnownArchive *> &archives, std::vector<KEYDataFile *> &keyData);
 
 	void indexArchive(KnownArchive &knownArchive, Archive *archive,
 	                  uint32_t priority, Change *change);
+	void indexArchiveResources(OpenedArchive &archive, const Archive::ResourceList &resources,
+	                           Common::HashAlgo hashAlgo, uint32_t priority, Change *change);
+
+	OpenedArchive &addOpenedArchive(KnownArchive &knownArchive, Archive *archive, Change *change);
 
 	Common::SeekableReadStream *openArchiveStream(const KnownArchive &archive) const;
+	Archive *openArchive(const KnownArchive &archive, const std::vector<byte> &password) const;
+
+	Archive &getArchive(OpenedArchive &archive) const;
+	// '---
+
+	// .--- Index cache
+	bool isIndexCacheable(const KnownArchive &archive) const;
+
+	bool indexCachedArchive(KnownArchive &knownArchive, uint32_t priority,
+	                        const std::vector<byte> &password, Change *change);
+	void addToIndexCache(const KnownArchive &knownArchive, const std::vector<KnownArchive *> &archives,
+	                     const std::vector<const Archive *> &data);
 	// '---
 
 	// .--- Adding resources
 
 	bool checkResourceIsArchive(Resource &resource, Change *change);
 
+	Resource *allocateResource(const Resource &resource);
+	void freeResource(Resource *resource);
+
 	void addResource(Resource &resource, uint64_t hash, Change *change);
 	void addResource(const Common::UString &path, Change *change, uint32_t priority);
 
@@ -532,12 +687,23 @@ private:
 	const Resource *getRes(const Common::UString &name, FileType type) const;
 
 	Common::SeekableReadStream *getResource(const Resource &res, bool tryNoCopy = false) const;
+	Common::SeekableReadStream *openResource(const Resource &res, bool tryNoCopy) const;
 
 	Common::SeekableReadStream *getArchiveResource(const Resource &res, bool tryNoCopy = false) const;
 
 	uint32_t getResourceSize(const Resource &res) const;
 	// '---
 
+	// .--- Prefetching
+	Common::ThreadPool &getPrefetchPool();
+
+	void prefetch(const Resource &res);
+	void loadPrefetch(const Resource &res);
+
+	Common::SeekableReadStream *takePrefetch(const Resource &res) const;
+	void evictPrefetches() const;
+	// '---
+
 	// .--- Resource utility methods
 	bool normalizeType(Resource &resource);
 
@@ -548,7 +714,7 @@ private:
 	inline uint64_t getHash(const Common::UString &name, FileType type) const;
 	inline uint64_t getHash(const Common::UString &name) const;
 
-	void checkHashCollision(const Resource &resource, ResourceMap::const_iterator resList);
+	void checkHashCollision(const Resource &resource, const ResourceList &resList);
 
 	Change *newChangeSet(Common::ChangeID &changeID);
 	// '---
@@ -108,12 +108,7 @@ uint32_t RIMFile::getResourceSize(uint32_t index) const {
 Common::SeekableReadStream *RIMFile::getResource(uint32_t index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy)
-		return new Common::SeekableSubReadStream(_rim.get(), res.offset, res.offset + res.size);
-
-	_rim->seek(res.offset);
-
-	return _rim->readStream(res.size);
+	return getSubStream(*_rim, res.offset, res.size, tryNoCopy);
 }
 
 } // End of namespace Aurora
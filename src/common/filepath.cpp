@@ -41,6 +41,7 @@ using boost::filesystem::exists;
 using boost::filesystem::is_regular_file;
 using boost::filesystem::is_directory;
 using boost::filesystem::file_size;
+using boost::filesystem::last_write_time;
 using boost::filesystem::directory_iterator;
 using boost::filesystem::create_directories;
 
@@ -79,6 +80,16 @@ size_t FilePath::getFileSize(const UString &p) {
 	return size;
 }
 
+std::time_t FilePath::getModificationTime(const UString &p) {
+	try {
+		return last_write_time(p.c_str());
+	} catch (...) {
+	}
+
+	warning("Failed to get modification time of file \"%s\"", p.c_str());
+	return (std::time_t) -1;
+}
+
 UString FilePath::getFile(const UString &p) {
 	path file(p.c_str());
 
@@ -25,6 +25,7 @@
 #ifndef COMMON_FILEPATH_H
 #define COMMON_FILEPATH_H
 
+#include <ctime>
 #include <list>
 
 #include "src/common/types.h"
@@ -58,6 +59,13 @@ public:
 	 */
 	static size_t getFileSize(const UString &p);
 
+	/** Return the time a file was last modified.
+	 *
+	 *  @param  p The file to look up.
+	 *  @return The modification time of the file or -1 if not a valid file.
+	 */
+	static std::time_t getModificationTime(const UString &p);
+
 	/** Return a file name without its path.
 	 *
 	 *  Example: "/path/to/file.ext" > "file.ext"
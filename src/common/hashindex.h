@@ -0,0 +1,305 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A flat hash table indexed by precomputed 64-bit hashes.
+ */
+
+#ifndef COMMON_HASHINDEX_H
+#define COMMON_HASHINDEX_H
+
+#include <cassert>
+#include <cstddef>
+
+#include <vector>
+#include <utility>
+
+#include "src/common/types.h"
+
+namespace Common {
+
+/** A flat, open-addressing hash table, mapping 64-bit hashes to values.
+ *
+ *  The keys are hashes that have already been computed (like the hashed
+ *  resource names in Aurora archives), so they are used as they are,
+ *  without hashing them again. The slot states and keys are kept in
+ *  their own arrays, separate from the values, so that probing only
+ *  touches a few tightly packed cache lines.
+ *
+ *  Collisions are resolved with linear probing. Erased slots are marked
+ *  as deleted, and those are cleaned up whenever the table is rebuilt.
+ *
+ *  Inserting or erasing values invalidates all pointers to values and
+ *  all iterators.
+ */
+template<typename T>
+class HashIndex {
+private:
+	enum SlotState {
+		kSlotEmpty   = 0,
+		kSlotUsed    = 1,
+		kSlotDeleted = 2
+	};
+
+public:
+	/** Iterating over all values in the index, in no particular order. */
+	template<typename I, typename V>
+	class Iterator {
+	public:
+		Iterator(I *index, size_t slot) : _index(index), _slot(slot) {
+			skip();
+		}
+
+		/** Return the hash the current value is indexed by. */
+		uint64_t hash() const {
+			return _index->_hashes[_slot];
+		}
+
+		V &operator*() const {
+			return _index->_values[_slot];
+		}
+
+		V *operator->() const {
+			return &_index->_values[_slot];
+		}
+
+		Iterator &operator++() {
+			_slot++;
+			skip();
+
+			return *this;
+		}
+
+		bool operator==(const Iterator &right) const {
+			return (_index == right._index) && (_slot == right._slot);
+		}
+
+		bool operator!=(const Iterator &right) const {
+			return !(*this == right);
+		}
+
+	private:
+		I     *_index;
+		size_t _slot;
+
+		void skip() {
+			while ((_slot < _index->_states.size()) && (_index->_states[_slot] != kSlotUsed))
+				_slot++;
+		}
+	};
+
+	typedef Iterator<HashIndex, T> iterator;
+	typedef Iterator<const HashIndex, const T> const_iterator;
+
+	HashIndex() : _size(0), _deleted(0), _mask(0) {
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+
+	/** Return the number of values in the index. */
+	size_t size() const {
+		return _size;
+	}
+
+	/** Return the number of slots in the table. */
+	size_t capacity() const {
+		return _states.size();
+	}
+
+	void clear() {
+		_states.clear();
+		_hashes.clear();
+		_values.clear();
+
+		_size    = 0;
+		_deleted = 0;
+		_mask    = 0;
+	}
+
+	/** Make sure the index can hold at least this many values without growing. */
+	void reserve(size_t count) {
+		size_t slots = (size_t)kMinSlots;
+		while (((slots * kMaxLoadNum) / kMaxLoadDen) < count)
+			slots *= 2;
+
+		if (slots > _states.size())
+			rehash(slots);
+	}
+
+	/** Return the value for this hash, or 0 if there is none. */
+	T *find(uint64_t hash) {
+		const size_t slot = findSlot(hash);
+		if (slot == kSlotInvalid)
+			return 0;
+
+		return &_values[slot];
+	}
+
+	/** Return the value for this hash, or 0 if there is none. */
+	const T *find(uint64_t hash) const {
+		const size_t slot = findSlot(hash);
+		if (slot == kSlotInvalid)
+			return 0;
+
+		return &_values[slot];
+	}
+
+	/** Return the value for this hash, inserting a default-constructed one if there is none. */
+	T &operator[](uint64_t hash) {
+		size_t slot = findSlot(hash);
+		if (slot != kSlotInvalid)
+			return _values[slot];
+
+		/* Rebuild the table before it gets too full. If it's mostly deleted
+		 * slots making it full, just clean those up. Otherwise, grow so
+		 * that the table is at most half of the maximum load afterwards. */
+		if (((_size + _deleted + 1) * kMaxLoadDen) > (_states.size() * kMaxLoadNum)) {
+			size_t slots = _states.empty() ? (size_t)kMinSlots : _states.size();
+			while (((_size + 1) * 2 * kMaxLoadDen) > (slots * kMaxLoadNum))
+				slots *= 2;
+
+			rehash(slots);
+		}
+
+		slot = insertSlot(hash);
+		if (_states[slot] == kSlotDeleted)
+			_deleted--;
+
+		_states[slot] = kSlotUsed;
+		_hashes[slot] = hash;
+		_values[slot] = T();
+
+		_size++;
+
+		return _values[slot];
+	}
+
+	/** Remove the value for this hash. Returns false if there was none. */
+	bool erase(uint64_t hash) {
+		const size_t slot = findSlot(hash);
+		if (slot == kSlotInvalid)
+			return false;
+
+		_states[slot] = kSlotDeleted;
+		_values[slot] = T();
+
+		_size--;
+		_deleted++;
+
+		return true;
+	}
+
+	iterator begin() {
+		return iterator(this, 0);
+	}
+
+	iterator end() {
+		return iterator(this, _states.size());
+	}
+
+	const_iterator begin() const {
+		return const_iterator(this, 0);
+	}
+
+	const_iterator end() const {
+		return const_iterator(this, _states.size());
+	}
+
+private:
+	enum {
+		kMinSlots   = 16,
+		kMaxLoadNum =  7, ///< Maximum load factor, numerator.
+		kMaxLoadDen = 10  ///< Maximum load factor, denominator.
+	};
+
+	static const size_t kSlotInvalid = SIZE_MAX;
+
+	std::vector<byte>     _states; ///< The state of each slot.
+	std::vector<uint64_t> _hashes; ///< The key of each used slot.
+	std::vector<T>        _values; ///< The value of each used slot.
+
+	size_t _size;    ///< The number of used slots.
+	size_t _deleted; ///< The number of deleted slots.
+	size_t _mask;    ///< The number of slots minus 1.
+
+	/** The first slot to probe for a hash.
+	 *
+	 *  The hashes we get might not be well-distributed in their lower bits,
+	 *  so we mix all of them in with a Fibonacci multiplication first. */
+	size_t homeSlot(uint64_t hash) const {
+		return (size_t)((hash * 0x9E3779B97F4A7C15ULL) >> 32) & _mask;
+	}
+
+	size_t findSlot(uint64_t hash) const {
+		if (_states.empty())
+			return kSlotInvalid;
+
+		for (size_t slot = homeSlot(hash); ; slot = (slot + 1) & _mask) {
+			if (_states[slot] == kSlotEmpty)
+				return kSlotInvalid;
+
+			if ((_states[slot] == kSlotUsed) && (_hashes[slot] == hash))
+				return slot;
+		}
+	}
+
+	/** Find a free slot for a hash that's not yet in the table. */
+	size_t insertSlot(uint64_t hash) const {
+		assert(!_states.empty());
+
+		size_t slot = homeSlot(hash);
+		while (_states[slot] == kSlotUsed)
+			slot = (slot + 1) & _mask;
+
+		return slot;
+	}
+
+	void rehash(size_t slots) {
+		assert((slots & (slots - 1)) == 0);
+
+		std::vector<byte>     oldStates(slots, (byte)kSlotEmpty);
+		std::vector<uint64_t> oldHashes(slots, 0);
+		std::vector<T>        oldValues(slots);
+
+		_states.swap(oldStates);
+		_hashes.swap(oldHashes);
+		_values.swap(oldValues);
+
+		_mask    = slots - 1;
+		_deleted = 0;
+
+		for (size_t i = 0; i < oldStates.size(); i++) {
+			if (oldStates[i] != kSlotUsed)
+				continue;
+
+			const size_t slot = insertSlot(oldHashes[i]);
+
+			_states[slot] = kSlotUsed;
+			_hashes[slot] = oldHashes[i];
+			_values[slot] = std::move(oldValues[i]);
+		}
+	}
+};
+
+} // End of namespace Common
+
+#endif // COMMON_HASHINDEX_H
@@ -0,0 +1,262 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the stream reading interfaces for memory-mapped files.
+ */
+
+#include "src/common/system.h"
+
+#if defined(WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#endif
+
+#if defined(UNIX)
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <cassert>
+#include <cstring>
+
+#include <boost/filesystem/path.hpp>
+
+#include "src/common/util.h"
+#include "src/common/mappedfile.h"
+#include "src/common/readfile.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+
+namespace Common {
+
+/** The actual mapping of a file, shared between all streams viewing it. */
+struct MappedFileReadStream::Mapping : boost::noncopyable {
+	const byte *data; ///< The mapped file data.
+	size_t      size; ///< The size of the mapped file data.
+
+	/** If the file couldn't be mapped, the file data was read into this buffer. */
+	std::unique_ptr<byte[]> buffer;
+
+	Mapping(const UString &fileName);
+	~Mapping();
+
+private:
+	bool map(const UString &fileName);
+	void unmap();
+
+	void read(const UString &fileName);
+};
+
+MappedFileReadStream::Mapping::Mapping(const UString &fileName) : data(0), size(0) {
+	if (!map(fileName))
+		read(fileName);
+}
+
+MappedFileReadStream::Mapping::~Mapping() {
+	if (!buffer)
+		unmap();
+}
+
+void MappedFileReadStream::Mapping::read(const UString &fileName) {
+	ReadFile file(fileName);
+
+	size = file.size();
+
+	buffer = std::make_unique<byte[]>(size);
+	file.readChecked(buffer.get(), size);
+
+	data = buffer.get();
+}
+
+// .--- Platform-specific mapping ---.
+#if defined(WIN32)
+
+bool MappedFileReadStream::Mapping::map(const UString &fileName) {
+	HANDLE file = CreateFileW(boost::filesystem::path(fileName.c_str()).c_str(), GENERIC_READ,
+	                          FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart <= 0) ||
+	    ((uint64_t)fileSize.QuadPart > (uint64_t)SIZE_MAX)) {
+
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+	CloseHandle(file);
+
+	if (!mapping)
+		return false;
+
+	// The view keeps the file mapping object alive on its own
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+
+	if (!view)
+		return false;
+
+	data = static_cast<const byte *>(view);
+	size = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+
+void MappedFileReadStream::Mapping::unmap() {
+	if (data)
+		UnmapViewOfFile(data);
+}
+
+#elif defined(UNIX)
+
+bool MappedFileReadStream::Mapping::map(const UString &fileName) {
+	const int fd = ::open(boost::filesystem::path(fileName.c_str()).c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if ((fstat(fd, &fileStat) != 0) || (fileStat.st_size <= 0) ||
+	    ((uint64_t)fileStat.st_size > (uint64_t)SIZE_MAX)) {
+
+		::close(fd);
+		return false;
+	}
+
+	// The mapping keeps the file open on its own
+	void *view = mmap(0, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if (view == MAP_FAILED)
+		return false;
+
+	data = static_cast<const byte *>(view);
+	size = (size_t)fileStat.st_size;
+
+	return true;
+}
+
+void MappedFileReadStream::Mapping::unmap() {
+	if (data)
+		munmap(const_cast<byte *>(data), size);
+}
+
+#else
+
+bool MappedFileReadStream::Mapping::map(const UString &UNUSED(fileName)) {
+	return false;
+}
+
+void MappedFileReadStream::Mapping::unmap() {
+}
+
+#endif
+// '--- Platform-specific mapping ---'
+
+
+MappedFileReadStream::MappedFileReadStream(const UString &fileName) :
+	_mapping(std::make_shared<Mapping>(fileName)), _data(_mapping->data), _size(_mapping->size),
+	_pos(0), _eos(false) {
+
+}
+
+MappedFileReadStream::MappedFileReadStream(const std::shared_ptr<Mapping> &mapping,
+                                           const byte *data, size_t dataSize) :
+	_mapping(mapping), _data(data), _size(dataSize), _pos(0), _eos(false) {
+
+}
+
+MappedFileReadStream::~MappedFileReadStream() {
+}
+
+bool MappedFileReadStream::eos() const {
+	return _eos;
+}
+
+size_t MappedFileReadStream::pos() const {
+	return _pos;
+}
+
+size_t MappedFileReadStream::size() const {
+	return _size;
+}
+
+size_t MappedFileReadStream::seek(ptrdiff_t offset, Origin whence) {
+	assert(_pos <= _size);
+
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, size());
+	if (newPos > _size)
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+
+	// Reset end-of-stream flag on a successful seek
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t MappedFileReadStream::read(void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	// Read at most as many bytes as are still available...
+	if (dataSize > _size - _pos) {
+		dataSize = _size - _pos;
+		_eos = true;
+	}
+
+	std::memcpy(dataPtr, _data + _pos, dataSize);
+
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+size_t MappedFileReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	if (offset >= _size)
+		return 0;
+
+	dataSize = MIN(dataSize, _size - offset);
+	std::memcpy(dataPtr, _data + offset, dataSize);
+
+	return dataSize;
+}
+
+const byte *MappedFileReadStream::getData() const {
+	return _data;
+}
+
+MappedFileReadStream *MappedFileReadStream::createView(size_t begin, size_t end) const {
+	if ((begin > end) || (end > _size))
+		throw Exception("Invalid view range %u-%u into a mapped file of size %u",
+		                (uint)begin, (uint)end, (uint)_size);
+
+	return new MappedFileReadStream(_mapping, _data + begin, end - begin);
+}
+
+} // End of namespace Common
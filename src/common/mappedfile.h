@@ -0,0 +1,104 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the stream reading interfaces for memory-mapped files.
+ */
+
+#ifndef COMMON_MAPPEDFILE_H
+#define COMMON_MAPPEDFILE_H
+
+#include <cstddef>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/readstream.h"
+
+namespace Common {
+
+class UString;
+
+/** A read-only stream over a file mapped into memory.
+ *
+ *  The whole file is mapped once, and reading from the stream is then
+ *  just a memcpy() out of the mapping. Additionally, views into parts of
+ *  the file can be created with createView(). These views share the
+ *  mapping with the stream they were created from, so they neither
+ *  allocate nor copy any data. The file stays mapped until the last
+ *  stream referencing the mapping has been destroyed.
+ *
+ *  If the file can't be mapped (or the platform doesn't support memory
+ *  mapping), the file is read into memory as a whole instead.
+ */
+class MappedFileReadStream : boost::noncopyable, public SeekableReadStream {
+public:
+	/** Map the file with the given fileName into memory.
+	 *
+	 *  Throws an exception if the file can't be opened.
+	 */
+	MappedFileReadStream(const UString &fileName);
+	~MappedFileReadStream();
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
+	/** Return a pointer to the complete data this stream is viewing. */
+	const byte *getData() const;
+
+	/** Create a new stream viewing a part of this stream.
+	 *
+	 *  The new stream shares this stream's mapping, but has its own position.
+	 *  No data is copied. The view stays valid even after this stream has been
+	 *  destroyed.
+	 *
+	 *  Throws an exception if the range lies outside this stream.
+	 *
+	 *  @param  begin The offset of the first byte to view, relative to this stream.
+	 *  @param  end   The offset after the last byte to view, relative to this stream.
+	 *  @return A new MappedFileReadStream viewing the specified range.
+	 */
+	MappedFileReadStream *createView(size_t begin, size_t end) const;
+
+private:
+	struct Mapping;
+
+	MappedFileReadStream(const std::shared_ptr<Mapping> &mapping, const byte *data, size_t dataSize);
+
+	std::shared_ptr<Mapping> _mapping; ///< The mapping we're viewing.
+
+	const byte *_data; ///< The start of the data we're viewing.
+	size_t      _size; ///< The size of the data we're viewing.
+
+	size_t _pos;
+	bool   _eos;
+};
+
+} // End of namespace Common
+
+#endif // COMMON_MAPPEDFILE_H
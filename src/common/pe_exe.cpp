@@ -267,8 +267,7 @@ SeekableReadStream *PEResources::getResource(const PEResourceID &type, const PER
 		return 0;
 
 	const Resource &resource = _resources.find(type)->second.find(name)->second.find(langList[0])->second; // fun stuff
-	_exe->seek(resource.offset);
-	return _exe->readStream(resource.size);
+	return _exe->readStreamAt(resource.offset, resource.size);
 }
 
 SeekableReadStream *PEResources::getResource(const PEResourceID &type, const PEResourceID &name,
@@ -288,8 +287,7 @@ SeekableReadStream *PEResources::getResource(const PEResourceID &type, const PER
 		return 0;
 
 	const Resource &resource = langMap.find(lang)->second;
-	_exe->seek(resource.offset);
-	return _exe->readStream(resource.size);
+	return _exe->readStreamAt(resource.offset, resource.size);
 }
 
 } // End of namespace Common
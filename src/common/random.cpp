@@ -29,18 +29,22 @@ DECLARE_SINGLETON(Common::Random);
 namespace Common {
 
 Random::Random() {
-	std::random_device rd;
-	_generator.seed(rd());
+}
+
+std::mt19937 &Random::getGenerator() {
+	static thread_local std::mt19937 generator(std::random_device{}());
+
+	return generator;
 }
 
 int Random::getNext(int min, int max) {
 	std::uniform_int_distribution<int> dist(min, max - 1);
-	return dist(_generator);
+	return dist(getGenerator());
 }
 
 float Random::getNext(float min, float max) {
 	std::uniform_real_distribution<float> dist(min, max);
-	return dist(_generator);
+	return dist(getGenerator());
 }
 
 } // End of namespace Common
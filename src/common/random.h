@@ -31,6 +31,11 @@
 
 namespace Common {
 
+/** Random number generation.
+ *
+ *  Every thread draws from its own generator, so this can be used from
+ *  any number of threads at once.
+ */
 class Random : public Singleton<Random> {
 public:
 	Random();
@@ -42,7 +47,8 @@ public:
 	float getNext(float min, float max);
 
 private:
-	std::mt19937 _generator;
+	/** Return the generator of the calling thread. */
+	static std::mt19937 &getGenerator();
 };
 
 } // End of namespace Common
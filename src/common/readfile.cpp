@@ -22,11 +22,20 @@
  *  Implementing the stream reading interfaces for files.
  */
 
+#include "src/common/system.h"
+
+#if defined(UNIX)
+	#include <cerrno>
+
+	#include <unistd.h>
+#endif
+
 #include <cassert>
 #include <cstddef>
 
 #include "src/common/readfile.h"
 #include "src/common/error.h"
+#include "src/common/util.h"
 #include "src/common/ustring.h"
 #include "src/common/platform.h"
 
@@ -44,6 +53,18 @@ ReadFile::~ReadFile() {
 	close();
 }
 
+#if defined(UNIX)
+/** Positional reads use pread(), which never moves the file position, so no lock is needed. */
+static inline std::unique_lock<std::mutex> lockHandle(std::mutex &UNUSED(mutex)) {
+	return std::unique_lock<std::mutex>();
+}
+#else
+/** readAt() has to move the file position, so every access to the handle takes the lock. */
+static inline std::unique_lock<std::mutex> lockHandle(std::mutex &mutex) {
+	return std::unique_lock<std::mutex>(mutex);
+}
+#endif
+
 static long getInitialSize(std::FILE *handle) {
 	if (!handle)
 		return -1;
@@ -98,6 +119,8 @@ bool ReadFile::eos() const {
 	if (!_handle)
 		return true;
 
+	std::unique_lock<std::mutex> lock = lockHandle(_mutex);
+
 	return std::feof(_handle) != 0;
 }
 
@@ -105,6 +128,8 @@ size_t ReadFile::pos() const {
 	if (!_handle)
 		return kPositionInvalid;
 
+	std::unique_lock<std::mutex> lock = lockHandle(_mutex);
+
 	return (size_t)std::ftell(_handle);
 }
 
@@ -120,7 +145,9 @@ size_t ReadFile::seek(ptrdiff_t offset, Origin whence) {
 	if (!_handle)
 		throw Exception(kSeekError);
 
-	size_t oldPos = pos();
+	std::unique_lock<std::mutex> lock = lockHandle(_mutex);
+
+	const size_t oldPos = (size_t)std::ftell(_handle);
 
 	if (std::fseek(_handle, offset, kSeekToWhence[whence]) != 0)
 		throw Exception(kSeekError);
@@ -137,7 +164,79 @@ size_t ReadFile::read(void *dataPtr, size_t dataSize) {
 		return 0;
 
 	assert(dataPtr);
+
+	std::unique_lock<std::mutex> lock = lockHandle(_mutex);
+
 	return std::fread(dataPtr, 1, dataSize, _handle);
 }
 
+#if defined(UNIX)
+
+size_t ReadFile::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (!_handle || (offset >= _size))
+		return 0;
+
+	assert(dataPtr);
+
+	/* pread() neither uses nor changes the file offset, and it bypasses the
+	 * stdio buffer. Since we never write to the file, the data we get is
+	 * consistent with what fread() would return. */
+
+	const int fd = fileno(_handle);
+
+	byte  *data      = static_cast<byte *>(dataPtr);
+	size_t bytesRead = 0;
+
+	dataSize = MIN(dataSize, _size - offset);
+	while (bytesRead < dataSize) {
+		const ssize_t n = pread(fd, data + bytesRead, dataSize - bytesRead, offset + bytesRead);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			break;
+		}
+
+		if (n == 0)
+			break;
+
+		bytesRead += n;
+	}
+
+	return bytesRead;
+}
+
+#else
+
+size_t ReadFile::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (!_handle || (offset >= _size))
+		return 0;
+
+	assert(dataPtr);
+
+	/* No positional reads on a FILE handle here. Move the file position under
+	 * the lock, which read() and seek() take as well, and restore both the
+	 * position and the end-of-file indicator afterwards. */
+
+	std::unique_lock<std::mutex> lock = lockHandle(_mutex);
+
+	const long oldPos = std::ftell(_handle);
+	const bool oldEOS = std::feof(_handle) != 0;
+
+	if ((oldPos < 0) || (std::fseek(_handle, offset, SEEK_SET) != 0))
+		return 0;
+
+	const size_t bytesRead = std::fread(dataPtr, 1, MIN(dataSize, _size - offset), _handle);
+
+	std::fseek(_handle, oldPos, SEEK_SET);
+
+	// The end-of-file indicator is only ever set at the end of the file, so reading there sets it again
+	if (oldEOS)
+		std::fgetc(_handle);
+
+	return bytesRead;
+}
+
+#endif
+
 } // End of namespace Common
@@ -28,6 +28,8 @@
 #include <cstdio>
 #include <cstddef>
 
+#include <mutex>
+
 #include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
@@ -68,9 +70,14 @@ public:
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
 	size_t read(void *dataPtr, size_t dataSize);
 
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
+
 protected:
 	std::FILE *_handle; ///< The actual file handle.
 	size_t _size;       ///< The file's size.
+
+	/** Serializes access to the handle where readAt() has to move the file position. */
+	mutable std::mutex _mutex;
 };
 
 } // End of namespace Common
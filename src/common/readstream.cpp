@@ -49,6 +49,7 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 
 #include <memory>
 
@@ -82,6 +83,15 @@ SeekableReadStream::SeekableReadStream() {
 SeekableReadStream::~SeekableReadStream() {
 }
 
+MemoryReadStream *SeekableReadStream::readStreamAt(size_t offset, size_t dataSize) {
+	std::unique_ptr<byte[]> buf = std::make_unique<byte[]>(dataSize);
+
+	if (readAt(offset, buf.get(), dataSize) != dataSize)
+		throw Exception(kReadError);
+
+	return new MemoryReadStream(buf.release(), dataSize, true);
+}
+
 size_t SeekableReadStream::evalSeek(ptrdiff_t offset, Origin whence, size_t pos, size_t begin, size_t size) {
 	switch (whence) {
 		case kOriginEnd:
@@ -126,19 +136,25 @@ size_t SubReadStream::read(void *dataPtr, size_t dataSize) {
 }
 
 
+const size_t SeekableSubReadStream::kBufferSize;
+
 SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, size_t begin,
                                              size_t end, bool disposeParentStream) :
-	SubReadStream(parentStream, end, disposeParentStream), _parentStream(parentStream), _begin(begin) {
+	SubReadStream(parentStream, end, disposeParentStream), _parentStream(parentStream), _begin(begin),
+	_bufferPos(0), _bufferSize(0) {
 
 	assert(_begin <= _end);
 
 	_pos = begin;
-	_parentStream->seek(_pos);
 }
 
 SeekableSubReadStream::~SeekableSubReadStream() {
 }
 
+bool SeekableSubReadStream::eos() const {
+	return _eos;
+}
+
 size_t SeekableSubReadStream::pos() const {
 	return _pos - _begin;
 }
@@ -158,12 +174,68 @@ size_t SeekableSubReadStream::seek(ptrdiff_t offset, Origin whence) {
 
 	_pos = newPos;
 
-	_parentStream->seek(_pos);
 	_eos = false; // reset eos on successful seek
 
 	return oldPos;
 }
 
+size_t SeekableSubReadStream::read(void *dataPtr, size_t dataSize) {
+	if (dataSize > (size_t)(_end - _pos)) {
+		dataSize = _end - _pos;
+		_eos = true;
+	}
+
+	size_t bytesRead;
+	if (dataSize < kBufferSize)
+		bytesRead = readBuffered(dataPtr, dataSize);
+	else
+		bytesRead = _parentStream->readAt(_pos, dataPtr, dataSize);
+
+	if (bytesRead < dataSize)
+		_eos = true;
+
+	_pos += bytesRead;
+
+	return bytesRead;
+}
+
+size_t SeekableSubReadStream::readBuffered(void *dataPtr, size_t dataSize) {
+	byte *data = static_cast<byte *>(dataPtr);
+
+	size_t bytesRead = 0;
+	while (bytesRead < dataSize) {
+		const size_t pos = _pos + bytesRead;
+
+		if ((pos < _bufferPos) || (pos >= (_bufferPos + _bufferSize))) {
+			if (!_buffer)
+				_buffer = std::make_unique<byte[]>(kBufferSize);
+
+			_bufferPos  = pos;
+			_bufferSize = _parentStream->readAt(pos, _buffer.get(), MIN<size_t>(kBufferSize, _end - pos));
+
+			if (_bufferSize == 0)
+				break;
+		}
+
+		const size_t n = MIN<size_t>(dataSize - bytesRead, _bufferPos + _bufferSize - pos);
+
+		std::memcpy(data + bytesRead, _buffer.get() + (pos - _bufferPos), n);
+		bytesRead += n;
+	}
+
+	return bytesRead;
+}
+
+size_t SeekableSubReadStream::readAt(size_t offset, void *dataPtr, size_t dataSize) {
+	if (offset >= size())
+		return 0;
+
+	if (dataSize > (size() - offset))
+		dataSize = size() - offset;
+
+	return _parentStream->readAt(_begin + offset, dataPtr, dataSize);
+}
+
 
 SeekableSubReadStreamEndian::SeekableSubReadStreamEndian(SeekableReadStream *parentStream,
 		size_t begin, size_t end, bool bigEndian, bool disposeParentStream) :
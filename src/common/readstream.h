@@ -52,6 +52,8 @@
 
 #include <cstddef>
 
+#include <memory>
+
 #include "src/common/types.h"
 #include "src/common/endianness.h"
 #include "src/common/disposableptr.h"
@@ -316,6 +318,30 @@ public:
 		return seek(offset, kOriginCurrent);
 	}
 
+	/** Read data from an absolute position in the stream, without changing the
+	 *  stream position indicator or the end-of-file indicator.
+	 *
+	 *  Every seekable stream has to implement this in a way that is safe
+	 *  against concurrent calls of readAt(), read() and seek(). Memory,
+	 *  memory-mapped and file streams, and substreams thereof, read from an
+	 *  arbitrary position directly, without any shared state, so any number
+	 *  of threads can call readAt() on the same stream concurrently.
+	 *
+	 *  @param  offset   the position in the stream to read from.
+	 *  @param  dataPtr  pointer to a buffer into which the data is read.
+	 *  @param  dataSize number of bytes to be read.
+	 *  @return the number of bytes which were actually read.
+	 */
+	virtual size_t readAt(size_t offset, void *dataPtr, size_t dataSize) = 0;
+
+	/** Read the specified amount of data from an absolute position in the stream
+	 *  into a new[]'ed buffer which then is wrapped into a MemoryReadStream.
+	 *  Like readAt(), this doesn't change the stream position.
+	 *
+	 *  When reading fails, a kReadError exception is thrown.
+	 */
+	MemoryReadStream *readStreamAt(size_t offset, size_t dataSize);
+
 	/** Evaluate the seek offset relative to whence into a position from the beginning. */
 	static size_t evalSeek(ptrdiff_t offset, Origin whence, size_t pos, size_t begin, size_t size);
 };
@@ -349,10 +375,15 @@ protected:
 
 /** SeekableSubReadStream provides access to a SeekableReadStream restricted to
  *  the range [begin, end).
- *  The same caveats apply to SeekableSubReadStream as do to SeekableReadStream.
  *
- *  Manipulating the parent stream directly /will/ mess up a substream.
- *  @see SubReadStream
+ *  Unlike SubReadStream, a SeekableSubReadStream keeps its own position and
+ *  reads through the parent's readAt(). It never changes the parent's position,
+ *  so manipulating the parent stream or other substreams does not affect it.
+ *  Several substreams of the same parent can be read concurrently from
+ *  different threads.
+ *
+ *  Small reads, like readByte() or readUint32LE(), are served from an
+ *  internal buffer, so that they don't each go through the parent.
  */
 class SeekableSubReadStream : public SubReadStream, public SeekableReadStream {
 public:
@@ -360,23 +391,38 @@ public:
 	                      bool disposeParentStream = false);
 	~SeekableSubReadStream();
 
+	bool eos() const;
+
 	size_t pos() const;
 	size_t size() const;
 
 	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize);
 
 protected:
 	SeekableReadStream *_parentStream;
 
 	size_t _begin;
+
+private:
+	/** Reads smaller than this are served from a buffer filled by a single readAt(). */
+	static const size_t kBufferSize = 4096;
+
+	std::unique_ptr<byte[]> _buffer;
+
+	size_t _bufferPos;  ///< The position within the parent stream the buffer starts at.
+	size_t _bufferSize; ///< The number of valid bytes in the buffer.
+
+	size_t readBuffered(void *dataPtr, size_t dataSize);
 };
 
 
 /** This is a wrapper around SeekableSubReadStream, but it adds non-endian
  *  read methods whose endianness is set on the stream creation.
  *
- *  Manipulating the parent stream directly /will/ mess up a substream.
- *  @see SubReadStream
+ *  @see SeekableSubReadStream
  */
 class SeekableSubReadStreamEndian : public SeekableSubReadStream {
 private:
@@ -387,6 +433,10 @@ public:
 	                            bool bigEndian = false, bool disposeParentStream = false);
 	~SeekableSubReadStreamEndian();
 
+	bool isBigEndian() const {
+		return _bigEndian;
+	}
+
 	uint16_t readUint16() {
 		return _bigEndian ? readUint16BE() : readUint16LE();
 	}
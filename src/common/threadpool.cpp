@@ -0,0 +1,200 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A pool of worker threads.
+ */
+
+#include <cassert>
+
+#include <atomic>
+#include <exception>
+
+#include "src/common/util.h"
+#include "src/common/threadpool.h"
+#include "src/common/error.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(size_t threadCount, const UString &name) : _busy(0), _stop(false), _name(name) {
+	if (threadCount == 0)
+		threadCount = getHardwareThreadCount();
+
+	try {
+		for (size_t i = 0; i < threadCount; i++)
+			_threads.push_back(std::thread(&ThreadPool::threadMethod, this));
+	} catch (...) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+
+		_jobAvailable.notify_all();
+		for (std::vector<std::thread>::iterator t = _threads.begin(); t != _threads.end(); ++t)
+			t->join();
+
+		throw Exception("Failed to create thread pool \"%s\"", _name.c_str());
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_stop = true;
+		_jobs.clear();
+	}
+
+	_jobAvailable.notify_all();
+
+	for (std::vector<std::thread>::iterator t = _threads.begin(); t != _threads.end(); ++t)
+		t->join();
+}
+
+size_t ThreadPool::getThreadCount() const {
+	return _threads.size();
+}
+
+size_t ThreadPool::getHardwareThreadCount() {
+	const size_t count = std::thread::hardware_concurrency();
+
+	return (count == 0) ? 1 : count;
+}
+
+void ThreadPool::queue(std::function<void()> &&job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_jobs.push_back(std::move(job));
+	}
+
+	_jobAvailable.notify_one();
+}
+
+bool ThreadPool::isWorkerThread() const {
+	const std::thread::id id = std::this_thread::get_id();
+
+	for (std::vector<std::thread>::const_iterator t = _threads.begin(); t != _threads.end(); ++t)
+		if (t->get_id() == id)
+			return true;
+
+	return false;
+}
+
+void ThreadPool::wait() {
+	// Waiting from within a job would wait for that job to finish, forever
+	assert(!isWorkerThread());
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_jobsDone.wait(lock, [this]() { return _jobs.empty() && (_busy == 0); });
+}
+
+/** The state of one parallelFor() call, shared between all threads working on it. */
+struct ParallelForState {
+	std::function<void(size_t)> job;
+
+	size_t count;
+
+	std::atomic<size_t> next; ///< The next index to run.
+	std::atomic<size_t> done; ///< The number of indices finished.
+
+	std::exception_ptr exception; ///< The first exception thrown by the job.
+
+	std::mutex mutex;
+	std::condition_variable finished;
+
+	ParallelForState(size_t c, const std::function<void(size_t)> &j) : job(j), count(c), next(0), done(0) {
+	}
+
+	/** Run indices until there are none left. */
+	void run() {
+		size_t index;
+		while ((index = next.fetch_add(1)) < count) {
+			try {
+				job(index);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!exception)
+					exception = std::current_exception();
+			}
+
+			if (done.fetch_add(1) == (count - 1)) {
+				std::lock_guard<std::mutex> lock(mutex);
+				finished.notify_all();
+			}
+		}
+	}
+};
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &job) {
+	if (count == 0)
+		return;
+
+	std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>(count, job);
+
+	/* Helpers that only get to run after everything is done find no index
+	 * left and return right away. We don't wait for them. */
+	const size_t helpers = MIN(_threads.size(), count - 1);
+	for (size_t i = 0; i < helpers; i++)
+		queue([state]() { state->run(); });
+
+	state->run();
+
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&state]() { return state->done.load() == state->count; });
+	}
+
+	if (state->exception)
+		std::rethrow_exception(state->exception);
+}
+
+void ThreadPool::threadMethod() {
+	if (!_name.empty())
+		Thread::setCurrentThreadName(_name);
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true) {
+		_jobAvailable.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+		if (_stop)
+			break;
+
+		std::function<void()> job = std::move(_jobs.front());
+		_jobs.pop_front();
+
+		_busy++;
+		lock.unlock();
+
+		// Exceptions are caught by the packaged task and end up in the future
+		job();
+
+		lock.lock();
+		_busy--;
+
+		if (_jobs.empty() && (_busy == 0))
+			_jobsDone.notify_all();
+	}
+
+	_jobsDone.notify_all();
+}
+
+} // End of namespace Common
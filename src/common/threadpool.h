@@ -0,0 +1,127 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A pool of worker threads.
+ */
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <future>
+#include <functional>
+#include <utility>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/thread.h"
+#include "src/common/mutex.h"
+
+namespace Common {
+
+/** A pool of worker threads, running jobs in the order they were submitted.
+ *
+ *  Jobs are plain callables. An exception thrown by a job is captured in
+ *  the future returned when it was submitted.
+ *
+ *  Destroying the pool waits for the jobs currently running to finish.
+ *  Jobs that haven't been started yet are dropped; their futures will
+ *  report a broken promise.
+ */
+class ThreadPool : boost::noncopyable {
+public:
+	/** Create a thread pool.
+	 *
+	 *  @param threadCount The number of worker threads. If 0, use as many
+	 *                     as there are hardware threads.
+	 *  @param name The name of the worker threads, for debugging purposes.
+	 */
+	ThreadPool(size_t threadCount = 0, const UString &name = "");
+	~ThreadPool();
+
+	/** Return the number of worker threads. */
+	size_t getThreadCount() const;
+
+	/** Queue a job to be run by one of the worker threads. */
+	template<typename F>
+	std::future<decltype(std::declval<F &>()())> submit(F job) {
+		typedef decltype(std::declval<F &>()()) Result;
+
+		std::shared_ptr<std::packaged_task<Result()>> task =
+			std::make_shared<std::packaged_task<Result()>>(std::move(job));
+
+		std::future<Result> future = task->get_future();
+
+		queue([task]() { (*task)(); });
+
+		return future;
+	}
+
+	/** Wait until all jobs submitted so far are finished.
+	 *
+	 *  This waits for the jobs of all callers. It must not be called from
+	 *  within a job of the same pool, since it would then wait for itself.
+	 *  Use parallelFor() for nested work instead.
+	 */
+	void wait();
+
+	/** Run job(0) to job(count - 1), spread over the worker threads.
+	 *
+	 *  The calling thread helps out and only returns once all indices are
+	 *  done. This can safely be called from within a job of the same pool:
+	 *  if all workers are busy, the calling thread does all the work itself.
+	 *
+	 *  If any of the jobs throws, the first exception is rethrown here.
+	 */
+	void parallelFor(size_t count, const std::function<void(size_t)> &job);
+
+	/** Return the number of hardware threads, or 1 if that's unknown. */
+	static size_t getHardwareThreadCount();
+
+private:
+	std::vector<std::thread> _threads;
+
+	std::deque<std::function<void()>> _jobs;
+
+	size_t _busy; ///< The number of jobs currently running.
+	bool   _stop; ///< Should the worker threads stop?
+
+	std::mutex _mutex;
+	std::condition_variable _jobAvailable; ///< Signaled when a job was queued.
+	std::condition_variable _jobsDone;     ///< Signaled when a worker runs out of jobs.
+
+	UString _name;
+
+	void queue(std::function<void()> &&job);
+
+	/** Is the calling thread one of our worker threads? */
+	bool isWorkerThread() const;
+
+	void threadMethod();
+};
+
+} // End of namespace Common
+
+#endif // COMMON_THREADPOOL_H
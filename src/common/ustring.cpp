@@ -27,6 +27,8 @@
 #include <cctype>
 #include <cstring>
 
+#include <utility>
+
 #include <boost/algorithm/string/replace.hpp>
 
 #include "src/common/ustring.h"
@@ -42,6 +44,11 @@ UString::UString(const UString &str) {
 	*this = str;
 }
 
+UString::UString(UString &&str) noexcept : _string(std::move(str._string)), _size(str._size) {
+	str._string.clear();
+	str._size = 0;
+}
+
 UString::UString(const std::string &str) {
 	*this = str;
 }
@@ -74,6 +81,19 @@ UString &UString::operator=(const UString &str) {
 	return *this;
 }
 
+UString &UString::operator=(UString &&str) noexcept {
+	if (&str == this)
+		return *this;
+
+	_string = std::move(str._string);
+	_size   = str._size;
+
+	str._string.clear();
+	str._size = 0;
+
+	return *this;
+}
+
 UString &UString::operator=(const std::string &str) {
 	_string = str;
 
@@ -66,6 +66,8 @@ public:
 	UString();
 	/** Copy constructor. */
 	UString(const UString &str);
+	/** Move constructor. The other string is left empty. */
+	UString(UString &&str) noexcept;
 	/** Construct UString from an UTF-8 string. */
 	UString(const std::string &str);
 	/** Construct UString from an UTF-8 string. */
@@ -79,6 +81,7 @@ public:
 	~UString();
 
 	UString &operator=(const UString &str);
+	UString &operator=(UString &&str) noexcept;
 	UString &operator=(const std::string &str);
 	UString &operator=(const char *str);
 
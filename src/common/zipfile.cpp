@@ -24,12 +24,15 @@
 
 #include <cassert>
 
+#include <memory>
+
 #include "src/common/zipfile.h"
 #include "src/common/error.h"
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/encoding.h"
 #include "src/common/memreadstream.h"
+#include "src/common/mappedfile.h"
 #include "src/common/deflate.h"
 
 namespace Common {
@@ -129,29 +132,30 @@ const ZipFile::IFile &ZipFile::getIFile(uint32_t index) const {
 	return _iFiles[index];
 }
 
-void ZipFile::getFileProperties(SeekableReadStream &zip, const IFile &file,
+size_t ZipFile::getFileProperties(SeekableReadStream &zip, const IFile &file,
 		uint16_t &compMethod, uint32_t &compSize, uint32_t &realSize) const {
 
-	zip.seek(file.offset);
+	/* Read the local file header with a positional read, without touching
+	 * the position of the ZIP stream. This way, several threads can get
+	 * files out of the same ZIP at the same time. */
 
-	uint32_t tag = zip.readUint32LE();
+	byte header[30];
+	if (zip.readAt(file.offset, header, sizeof(header)) != sizeof(header))
+		throw Exception(kReadError);
+
+	uint32_t tag = READ_LE_UINT32(header);
 	if (tag != 0x04034B50)
 		throw Exception("Unknown ZIP record %08X", tag);
 
-	zip.skip(4);
-
-	compMethod = zip.readUint16LE();
+	compMethod = READ_LE_UINT16(header + 8);
 
-	zip.skip(8);
+	compSize = READ_LE_UINT32(header + 18);
+	realSize = READ_LE_UINT32(header + 22);
 
-	compSize = zip.readUint32LE();
-	realSize = zip.readUint32LE();
+	uint16_t nameLength  = READ_LE_UINT16(header + 26);
+	uint16_t extraLength = READ_LE_UINT16(header + 28);
 
-	uint16_t nameLength  = zip.readUint16LE();
-	uint16_t extraLength = zip.readUint16LE();
-
-	zip.skip(nameLength);
-	zip.skip(extraLength);
+	return file.offset + sizeof(header) + nameLength + extraLength;
 }
 
 size_t ZipFile::getFileSize(uint32_t index) const {
@@ -165,27 +169,45 @@ SeekableReadStream *ZipFile::getFile(uint32_t index, bool tryNoCopy) const {
 	uint32_t compSize;
 	uint32_t realSize;
 
-	getFileProperties(*_zip, file, compMethod, compSize, realSize);
+	const size_t offset = getFileProperties(*_zip, file, compMethod, compSize, realSize);
+
+	const MappedFileReadStream *mapped = dynamic_cast<const MappedFileReadStream *>(_zip.get());
+	if (mapped) {
+		// Return a view of stored files, and inflate deflated ones directly out of the mapping
+
+		if (compMethod == 0)
+			return mapped->createView(offset, offset + compSize);
+
+		if ((compMethod == 8) && (offset <= mapped->size()) && (compSize <= (mapped->size() - offset))) {
+			const byte *data = decompressDeflate(mapped->getData() + offset, compSize, realSize, kWindowBitsMaxRaw);
+
+			return new MemoryReadStream(data, realSize, true);
+		}
+	}
 
 	if (tryNoCopy && (compMethod == 0))
-		return new SeekableSubReadStream(_zip.get(), _zip->pos(), _zip->pos() + compSize);
+		return new SeekableSubReadStream(_zip.get(), offset, offset + compSize);
 
-	return decompressFile(*_zip, compMethod, compSize, realSize);
+	return decompressFile(*_zip, offset, compMethod, compSize, realSize);
 }
 
-SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, uint32_t method,
+SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, size_t offset, uint32_t method,
 		uint32_t compSize, uint32_t realSize) {
 
 	if (method == 0) {
 		// Uncompressed
 
-		return zip.readStream(compSize);
+		return zip.readStreamAt(offset, compSize);
 	}
 
 	if (method != 8)
 		throw Exception("Unhandled Zip compression %d", method);
 
-	return decompressDeflate(zip, compSize, realSize, kWindowBitsMaxRaw);
+	std::unique_ptr<MemoryReadStream> compData(zip.readStreamAt(offset, compSize));
+
+	const byte *data = decompressDeflate(compData->getData(), compSize, realSize, kWindowBitsMaxRaw);
+
+	return new MemoryReadStream(data, realSize, true);
 }
 
 } // End of namespace Common
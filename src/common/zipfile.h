@@ -81,11 +81,13 @@ private:
 
 	void load(SeekableReadStream &zip);
 
-	static SeekableReadStream *decompressFile(SeekableReadStream &zip, uint32_t method,
+	static SeekableReadStream *decompressFile(SeekableReadStream &zip, size_t offset, uint32_t method,
 			uint32_t compSize, uint32_t realSize);
 
 	const IFile &getIFile(uint32_t index) const;
-	void getFileProperties(SeekableReadStream &zip, const IFile &file,
+
+	/** Read the local file header of a file and return the offset of the file's data. */
+	size_t getFileProperties(SeekableReadStream &zip, const IFile &file,
 			uint16_t &compMethod, uint32_t &compSize, uint32_t &realSize) const;
 };
 
@@ -22,6 +22,8 @@
  *  A* algorithm is used to find paths as fast as possible and as short as possible.
  */
 
+#include <cmath>
+
 #include <algorithm>
 
 #include "src/common/util.h"
@@ -31,7 +33,7 @@
 
 namespace Engines {
 
-AStar::AStar(Engines::Pathfinding* pathfinding) : _pathfinding(pathfinding) {
+AStar::AStar(Engines::Pathfinding* pathfinding) : _pathfinding(pathfinding), _generation(0) {
 }
 
 AStar::~AStar() {
@@ -48,6 +50,9 @@ bool AStar::Node::operator<(const Node &node) const {
 	return G + H < node.G + node.H;
 }
 
+AStar::FaceState::FaceState() : generation(0), heapIndex(0) {
+}
+
 bool AStar::findPath(float startX, float startY, float endX, float endY,
                      std::vector<uint32_t> &facePath, float width, uint32_t maxIteration) {
 
@@ -69,74 +74,79 @@ bool AStar::findPath(float startX, float startY, float endX, float endY,
 	}
 
 	// Init nodes and lists.
-	Node startNode = Node(startFace, startX, startY);
-	Node endNode   = Node(endFace, endX, endY);
+	startSearch(_pathfinding->_facesCount);
+	ensureFace(startFace);
+
+	Node endNode = Node(endFace, endX, endY);
 
+	Node &startNode = _nodes[startFace];
+	startNode = Node(startFace, startX, startY);
 	startNode.G = 0.f;
 	startNode.H = getHeuristic(startNode, endNode);
+
 	// Get track of the closest node near the end in case of the unavailable path.
-	Node closestToEnd = startNode;
+	uint32_t closestToEnd = startFace;
 
-	std::vector<Node> openList;
-	std::vector<Node> closedList;
-	openList.push_back(startNode);
+	pushOpen(startFace);
 
 	// Searching...
 	for (uint32_t it = 0; it < maxIteration; ++it) {
-		if (openList.empty())
+		if (_openHeap.empty())
 			break;
 
-		Node current = openList.front();
-
-		if (current.face == endNode.face) {
-			reconstructPath(current, closedList, facePath);
+		if (_openHeap.front() == endFace) {
+			reconstructPath(endFace, facePath);
 			return true;
 		}
 
-		openList.erase(openList.begin());
-		closedList.push_back(current);
+		const uint32_t currentFace = popOpen();
+
+		_pathfinding->getAdjacentFaces(currentFace, _nodes[currentFace].parent, _adjacentFaces);
+		for (std::vector<uint32_t>::const_iterator a = _adjacentFaces.begin(); a != _adjacentFaces.end(); ++a) {
+			ensureFace(*a);
 
-		std::vector<uint32_t> adjFaces;
-		_pathfinding->getAdjacentFaces(current.face, current.parent, adjFaces);
-		for (std::vector<uint32_t>::iterator a = adjFaces.begin(); a != adjFaces.end(); ++a) {
 			// Check if it has been already evaluated.
-			if (hasNode(*a, closedList))
+			if (isClosed(*a))
+				continue;
+
+			// Check if the search is restricted to a corridor of regions.
+			if (!_pathfinding->inCorridor(*a))
 				continue;
 
 			// Check if the creature can go through to the adjacent face.
-			if (width > 0.f && !_pathfinding->goThrough(current.face, *a, width))
+			if (width > 0.f && !_pathfinding->goThrough(currentFace, *a, width))
 				continue;
 
 			// Distance from start point to this node.
+			Node &current = _nodes[currentFace];
+
 			float x, y;
 			float gScore = current.G + getGValue(current, *a, x, y);
 
 			// Check if it is a new node.
-			Node *adjNode = getNode(*a, openList);
-			bool isThere = adjNode != 0;
-			if (!isThere) {
-				adjNode = new Node(*a, x, y);
-				adjNode->parent = current.face;
-			} else if (gScore >= adjNode->G) {
+			const bool isThere = isVisited(*a);
+
+			Node &adjNode = _nodes[*a];
+			if (!isThere)
+				adjNode = Node(*a, x, y);
+			else if (gScore >= adjNode.G)
 				continue;
-			}
 
 			// adjNode is the best node up to now, update/add.
-			adjNode->parent = current.face;
-			adjNode->G = gScore;
-			adjNode->H = getHeuristic(*adjNode, endNode);
-			if (adjNode->H < closestToEnd.H)
-				closestToEnd = *adjNode;
-			if (!isThere) {
-				openList.push_back(*adjNode);
-				delete adjNode;
-			}
-
-			std::sort(openList.begin(), openList.end());
+			adjNode.parent = currentFace;
+			adjNode.G = gScore;
+			adjNode.H = getHeuristic(adjNode, endNode);
+			if (adjNode.H < _nodes[closestToEnd].H)
+				closestToEnd = *a;
+
+			if (!isThere)
+				pushOpen(*a);
+			else
+				siftUp(_faceStates[*a].heapIndex);
 		}
 	}
 
-	reconstructPath(closestToEnd, closedList, facePath);
+	reconstructPath(closestToEnd, facePath);
 	return false;
 }
 
@@ -150,47 +160,127 @@ float AStar::getHeuristic(Node &node, Node &endNode) const {
 	return getEuclideanDistance(node.x,node.y, endNode.x,endNode.y);
 }
 
-AStar::Node *AStar::getNode(uint32_t face, std::vector<Node> &nodes) const {
-	for (std::vector<Node>::iterator n = nodes.begin(); n != nodes.end(); ++n) {
-		if ((*n).face == face) {
-			return &(*n);
-		}
+float AStar::getEuclideanDistance(float xA, float yA, float xB, float yB) const {
+	const float dX = xA - xB;
+	const float dY = yA - yB;
+
+	return std::sqrt(dX * dX + dY * dY);
+}
+
+void AStar::startSearch(uint32_t facesCount) {
+	if (_faceStates.size() < facesCount) {
+		_faceStates.resize(facesCount);
+		_nodes.resize(facesCount);
 	}
 
-	return 0;
+	_openHeap.clear();
+
+	// On wrap-around, old states could look current again. Reset them all.
+	if (++_generation == 0) {
+		std::fill(_faceStates.begin(), _faceStates.end(), FaceState());
+		_generation = 1;
+	}
 }
 
-bool AStar::hasNode(uint32_t face, std::vector<Node> &nodes) const {
-	for (std::vector<Node>::iterator n = nodes.begin(); n != nodes.end(); ++n) {
-		if ((*n).face == face) {
-			return true;
-		}
+void AStar::ensureFace(uint32_t face) {
+	if (face < _faceStates.size())
+		return;
+
+	_faceStates.resize(face + 1);
+	_nodes.resize(face + 1);
+}
+
+bool AStar::isVisited(uint32_t face) const {
+	return _faceStates[face].generation == _generation;
+}
+
+bool AStar::isClosed(uint32_t face) const {
+	return isVisited(face) && (_faceStates[face].heapIndex == kClosed);
+}
+
+bool AStar::isBetter(uint32_t faceA, uint32_t faceB) const {
+	const Node &nodeA = _nodes[faceA];
+	const Node &nodeB = _nodes[faceB];
+
+	const float fA = nodeA.G + nodeA.H;
+	const float fB = nodeB.G + nodeB.H;
+	if (fA != fB)
+		return fA < fB;
+
+	// Prefer the node closer to the end on ties, it's more likely to lead there
+	return nodeA.H < nodeB.H;
+}
+
+void AStar::pushOpen(uint32_t face) {
+	_faceStates[face].generation = _generation;
+
+	_openHeap.push_back(face);
+	_faceStates[face].heapIndex = _openHeap.size() - 1;
+
+	siftUp(_openHeap.size() - 1);
+}
+
+uint32_t AStar::popOpen() {
+	const uint32_t face = _openHeap.front();
+
+	const uint32_t last = _openHeap.back();
+	_openHeap.pop_back();
+
+	if (!_openHeap.empty()) {
+		placeOpen(last, 0);
+		siftDown(0);
 	}
 
-	return false;
+	_faceStates[face].heapIndex = kClosed;
+	return face;
 }
 
-float AStar::getEuclideanDistance(float xA, float yA, float xB, float yB) const {
-	return sqrt(pow(xA - xB, 2.f) + pow(yA - yB, 2.f));
+void AStar::placeOpen(uint32_t face, uint32_t index) {
+	_openHeap[index] = face;
+	_faceStates[face].heapIndex = index;
 }
 
-void AStar::reconstructPath(Node &endNode, std::vector<Node> &closedList, std::vector<uint32_t> &path) {
-	Node &cNode = endNode;
-	path.push_back(endNode.face);
-	path.push_back(endNode.parent);
+void AStar::siftUp(uint32_t index) {
+	const uint32_t face = _openHeap[index];
 
-	while (cNode.parent != UINT32_MAX) {
-		for (std::vector<Node>::iterator n = closedList.begin(); n != closedList.end(); ++n) {
-			if (cNode.parent != (*n).face)
-				continue;
+	while (index > 0) {
+		const uint32_t parent = (index - 1) / 2;
+		if (!isBetter(face, _openHeap[parent]))
+			break;
 
-			cNode = (*n);
-			if (cNode.parent != UINT32_MAX)
-				path.push_back(cNode.parent);
+		placeOpen(_openHeap[parent], index);
+		index = parent;
+	}
+
+	placeOpen(face, index);
+}
+
+void AStar::siftDown(uint32_t index) {
+	const uint32_t face = _openHeap[index];
+	const uint32_t size = _openHeap.size();
 
+	while (true) {
+		uint32_t child = 2 * index + 1;
+		if (child >= size)
 			break;
-		}
+
+		if ((child + 1 < size) && isBetter(_openHeap[child + 1], _openHeap[child]))
+			child++;
+
+		if (!isBetter(_openHeap[child], face))
+			break;
+
+		placeOpen(_openHeap[child], index);
+		index = child;
 	}
+
+	placeOpen(face, index);
+}
+
+void AStar::reconstructPath(uint32_t endFace, std::vector<uint32_t> &path) const {
+	for (uint32_t face = endFace; face != UINT32_MAX; face = _nodes[face].parent)
+		path.push_back(face);
+
 	std::reverse(path.begin(), path.end());
 }
 
@@ -93,16 +93,59 @@ protected:
 	/** Compute the euclidean distance (usual distance) between two points in th XY plan. */
 	float getEuclideanDistance(float xA, float yA, float xB, float yB) const;
 
-	/** Find a node in a vector of nodes. */
-	Node *getNode(uint32_t face, std::vector<Node> &nodes) const;
-	/** Check if a vector of nodes contains a specific node. */
-	bool hasNode(uint32_t face, std::vector<Node> &nodes) const;
-
 	Pathfinding *_pathfinding; ///< Pathfinding object that contains the walkmesh.
 
 private:
-	/** Reconstruct the path of faces from the closed list and the end node. */
-	void reconstructPath(Node &endNode, std::vector<Node> &closedList, std::vector<uint32_t> &path);
+	/** The search state of a face.
+	 *
+	 *  A state is only valid if its generation matches the generation of the
+	 *  current search. That way, the states don't need to be cleared between
+	 *  two searches.
+	 */
+	struct FaceState {
+		uint32_t generation; ///< The search this state belongs to.
+		uint32_t heapIndex;  ///< Position in the open heap, or kClosed.
+
+		FaceState();
+	};
+
+	static const uint32_t kClosed = UINT32_MAX;
+
+	std::vector<Node>      _nodes;      ///< The nodes of the current search, indexed by face.
+	std::vector<FaceState> _faceStates; ///< The state of each face, indexed by face.
+
+	uint32_t _generation; ///< The generation of the current search.
+
+	/** The open list, a binary min-heap of faces ordered by F = G + H. */
+	std::vector<uint32_t> _openHeap;
+
+	/** Scratch buffer for the faces adjacent to the current node. */
+	std::vector<uint32_t> _adjacentFaces;
+
+	/** Start a new search over a walkmesh of this many faces. */
+	void startSearch(uint32_t facesCount);
+	/** Make sure there's a state for this face. */
+	void ensureFace(uint32_t face);
+
+	/** Was this face reached in the current search? */
+	bool isVisited(uint32_t face) const;
+	/** Was this face already evaluated in the current search? */
+	bool isClosed(uint32_t face) const;
+
+	/** Should this face be evaluated before that face? */
+	bool isBetter(uint32_t faceA, uint32_t faceB) const;
+
+	/** Add a face to the open heap. */
+	void pushOpen(uint32_t face);
+	/** Remove the best face from the open heap and close it. */
+	uint32_t popOpen();
+
+	void placeOpen(uint32_t face, uint32_t index);
+	void siftUp(uint32_t index);
+	void siftDown(uint32_t index);
+
+	/** Reconstruct the path of faces leading to this face. */
+	void reconstructPath(uint32_t endFace, std::vector<uint32_t> &path) const;
 };
 
 } // End of namespace Engines
@@ -40,6 +40,8 @@
 #include "src/aurora/resman.h"
 #include "src/aurora/talkman.h"
 
+#include "src/aurora/nwscript/ncsprofiler.h"
+
 #include "src/graphics/graphics.h"
 #include "src/graphics/font.h"
 #include "src/graphics/camera.h"
@@ -802,6 +804,17 @@ Console::Console(Engine &engine, const Common::UString &font, int fontHeight) :
 			"Usage: setoption <option> <value>\nSet the value of a config option for this session");
 	registerCommand("showfps"    , std::bind(&Console::cmdShowFPS    , this, std::placeholders::_1),
 			"Usage: showfps <true/false>\nShow/Hide the frames-per-second display");
+	registerCommand("culling"    , std::bind(&Console::cmdCulling    , this, std::placeholders::_1),
+			"Usage: culling [<true/false>]\nPrint how many world objects were culled in the last frame,\n"
+			"or enable/disable the culling of world objects outside the view");
+	registerCommand("framelocks" , std::bind(&Console::cmdFrameLocks , this, std::placeholders::_1),
+			"Usage: framelocks\nPrint how often and how long threads waited for a frame to end");
+	registerCommand("textures"   , std::bind(&Console::cmdTextures   , this, std::placeholders::_1),
+			"Usage: textures [<budget>]\nPrint how much memory the textures take up,\n"
+			"or set the texture memory budget in MiB (0 for none)");
+	registerCommand("scriptstats", std::bind(&Console::cmdScriptStats, this, std::placeholders::_1),
+			"Usage: scriptstats [<true/false>|clear]\nPrint how often and how long the slowest scripts ran,\n"
+			"enable/disable the timing of scripts, or forget all script timings");
 	registerCommand("listlangs"  , std::bind(&Console::cmdListLangs  , this, std::placeholders::_1),
 			"Usage: listlangs\nLists all languages supported by this game version");
 	registerCommand("getlang"    , std::bind(&Console::cmdGetLang    , this, std::placeholders::_1),
@@ -1382,6 +1395,111 @@ void Console::cmdShowFPS(const CommandLine &cl) {
 	_engine->showFPS();
 }
 
+void Console::cmdCulling(const CommandLine &cl) {
+	if (!cl.args.empty()) {
+		bool enabled = true;
+
+		try {
+			Common::parseString(cl.args, enabled);
+		} catch (...) {
+			printCommandHelp(cl.cmd);
+			return;
+		}
+
+		GfxMan.setFrustumCulling(enabled);
+	}
+
+	size_t visible = 0, culled = 0;
+	GfxMan.getCullingStats(visible, culled);
+
+	printf("Culling %s: %u world objects rendered, %u culled",
+	       GfxMan.getFrustumCulling() ? "enabled" : "disabled", (uint)visible, (uint)culled);
+}
+
+void Console::cmdFrameLocks(const CommandLine &UNUSED(cl)) {
+	const Graphics::FrameFence::Stats stats = GfxMan.getFrameLockStats();
+
+	const double average = (stats.waits > 0) ? ((double) stats.totalTime / stats.waits) : 0.0;
+
+	printf("%u waits, %u of them sleeping: %.3f ms total, %.3f ms average, %.3f ms longest",
+	       (uint)stats.waits, (uint)stats.sleeps, stats.totalTime / 1000.0, average / 1000.0, stats.maxTime / 1000.0);
+}
+
+void Console::cmdTextures(const CommandLine &cl) {
+	if (!cl.args.empty()) {
+		int budget = 0;
+
+		try {
+			Common::parseString(cl.args, budget);
+		} catch (...) {
+			printCommandHelp(cl.cmd);
+			return;
+		}
+
+		TextureMan.setMemoryBudget(MAX(budget, 0) * (size_t) 1024 * 1024);
+	}
+
+	const Graphics::Aurora::TextureManager::MemoryStats stats = TextureMan.getMemoryStats();
+
+	const double kMiB = 1024.0 * 1024.0;
+
+	printf("%u textures, %u of them evicted: %.2f MiB of %.2f MiB budget, %u evictions, %u uploaded again",
+	       (uint)stats.textureCount, (uint)stats.evictedCount, stats.memorySize / kMiB, stats.budget / kMiB,
+	       (uint)stats.evictions, (uint)stats.reuploads);
+}
+
+void Console::cmdScriptStats(const CommandLine &cl) {
+	static const size_t kMaxScripts = 20;
+
+	if (cl.args == "clear") {
+		NCSProfilerMan.clear();
+		return;
+	}
+
+	if (!cl.args.empty()) {
+		bool enabled = true;
+
+		try {
+			Common::parseString(cl.args, enabled);
+		} catch (...) {
+			printCommandHelp(cl.cmd);
+			return;
+		}
+
+		NCSProfilerMan.setEnabled(enabled);
+
+		printf("Script timing %s", enabled ? "enabled" : "disabled");
+		return;
+	}
+
+	const std::vector<Aurora::NWScript::NCSProfiler::ScriptStats> stats = NCSProfilerMan.getStats();
+	if (stats.empty()) {
+		if (NCSProfilerMan.isEnabled())
+			printf("No scripts were run yet");
+		else
+			printf("Script timing is disabled, enable it with \"scriptstats true\"");
+
+		return;
+	}
+
+	const double kMS = 1000000.0;
+
+	printf("%-16s %8s %8s %12s %10s %10s %10s", "Script", "Runs", "Slices", "Instructions",
+	       "Total ms", "Avg ms", "Max ms");
+
+	for (size_t i = 0; i < MIN(stats.size(), kMaxScripts); i++) {
+		const Aurora::NWScript::NCSProfiler::ScriptStats &s = stats[i];
+
+		const double average = (s.runs > 0) ? (s.time / kMS / s.runs) : 0.0;
+
+		printf("%-16s %8u %8u %12llu %10.3f %10.3f %10.3f", s.name.c_str(), (uint)s.runs, (uint)s.slices,
+		       (unsigned long long)s.instructions, s.time / kMS, average, s.maxSliceTime / kMS);
+	}
+
+	if (stats.size() > kMaxScripts)
+		printf("...and %u more", (uint)(stats.size() - kMaxScripts));
+}
+
 void Console::cmdListLangs(const CommandLine &UNUSED(cl)) {
 	std::vector<Aurora::Language> langs;
 	if (_engine->detectLanguages(langs)) {
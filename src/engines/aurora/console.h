@@ -309,6 +309,10 @@ private:
 	void cmdGetOption  (const CommandLine &cl);
 	void cmdSetOption  (const CommandLine &cl);
 	void cmdShowFPS    (const CommandLine &cl);
+	void cmdCulling    (const CommandLine &cl);
+	void cmdFrameLocks (const CommandLine &cl);
+	void cmdTextures   (const CommandLine &cl);
+	void cmdScriptStats(const CommandLine &cl);
 	void cmdListLangs  (const CommandLine &cl);
 	void cmdGetLang    (const CommandLine &cl);
 	void cmdSetLang    (const CommandLine &cl);
@@ -22,7 +22,13 @@
  *  Base class for pathfinding
  */
 
+#include <cmath>
+
 #include <algorithm>
+#include <queue>
+#include <deque>
+#include <limits>
+#include <functional>
 
 #include "external/glm/gtx/intersect.hpp"
 
@@ -43,7 +49,8 @@ namespace Engines {
 Pathfinding::Pathfinding(std::vector<bool> walkableProperties, uint32_t polygonEdges) :
                          _polygonEdges(polygonEdges), _verticesCount(0), _facesCount(0),
                          _epsilon(0.f), _pathVisible(false), _walkmeshVisible(false),
-                         _walkableProperties(walkableProperties), _aStarAlgorithm(0) {
+                         _walkableProperties(walkableProperties), _aStarAlgorithm(0),
+                         _corridorGeneration(0), _corridorActive(false), _pathCacheSize(64) {
 
 	_pathDrawing = new Graphics::Aurora::Line();
 	_walkmeshDrawing = new Graphics::Aurora::Walkmesh(this);
@@ -88,11 +95,43 @@ bool Pathfinding::findPath(float startX, float startY, float endX, float endY,
 		return false;
 	}
 
-	bool result = _aStarAlgorithm->findPath(startX, startY, endX, endY, facePath, width, nbrIt);
+	bool result = findRegionPath(startX, startY, endX, endY, facePath, width, nbrIt);
+	if (!result)
+		result = _aStarAlgorithm->findPath(startX, startY, endX, endY, facePath, width, nbrIt);
+
 	_walkmeshDrawing->setFaces(facePath);
 	return result;
 }
 
+bool Pathfinding::findSmoothPath(float startX, float startY, float endX, float endY,
+                                 std::vector<glm::vec3> &path, float width, uint32_t nbrIt) {
+	path.clear();
+
+	const glm::vec3 start(startX, startY, 0.f);
+	const glm::vec3 end(endX, endY, 0.f);
+
+	// Paths within a single region are short enough to not bother caching them.
+	const PathCacheKey key(getRegion(startX, startY), getRegion(endX, endY), width);
+	const bool cacheable = (_pathCacheSize > 0) && (key.startRegion != UINT32_MAX) &&
+	                       (key.endRegion != UINT32_MAX) && (key.startRegion != key.endRegion);
+
+	if (cacheable && findCachedPath(key, start, end, path)) {
+		setPathDrawing(path);
+		return true;
+	}
+
+	std::vector<uint32_t> facePath;
+	if (!findPath(startX, startY, endX, endY, facePath, width, nbrIt))
+		return false;
+
+	smoothPath(startX, startY, endX, endY, facePath, path);
+
+	if (cacheable)
+		addCachedPath(key, path);
+
+	return true;
+}
+
 bool Pathfinding::isToTheLeft(glm::vec3 startSegment, glm::vec3 endSegment, glm::vec3 point) const {
 	return glm::cross((endSegment - startSegment), point - startSegment)[2] > 0;
 }
@@ -183,10 +222,11 @@ void Pathfinding::smoothPath(float startX, float startY, float endX, float endY,
 	// Assume end path is walkable.
 	path.push_back(end);
 
-	// Drawing part.
-	std::vector<glm::vec3> pathToDraw;
-	for (std::vector<glm::vec3>::iterator f = path.begin(); f != path.end(); ++f)
-		pathToDraw.push_back(*f);
+	setPathDrawing(path);
+}
+
+void Pathfinding::setPathDrawing(const std::vector<glm::vec3> &path) {
+	std::vector<glm::vec3> pathToDraw = path;
 
 	for (std::vector<glm::vec3>::iterator it = pathToDraw.begin(); it != pathToDraw.end(); ++it) {
 		(*it)[2] = getHeight((*it)[0], (*it)[1], true);
@@ -325,7 +365,15 @@ bool Pathfinding::walkableAASquare(glm::vec3 center, float halfWidth) {
 	return true;
 }
 
-bool Pathfinding::walkableSegment(glm::vec3 start, glm::vec3 end) {
+bool Pathfinding::walkableSegment(glm::vec3 start, glm::vec3 end, float width) {
+	// A wide creature needs both edges of its swept path to be walkable as well
+	if ((width > 0.f) && ((start[0] != end[0]) || (start[1] != end[1]))) {
+		const glm::vec3 side = getOrthonormalVec(end - start, true) * (width / 2);
+
+		if (!walkableSegment(start + side, end + side) || !walkableSegment(start - side, end - side))
+			return false;
+	}
+
 	std::vector<Common::AABBNode *> nodesIn;
 
 	for (std::vector<Common::AABBNode *>::iterator n = _aabbTrees.begin(); n != _aabbTrees.end(); ++n) {
@@ -595,4 +643,332 @@ bool Pathfinding::surfaceWalkable(uint32_t surfaceID) const {
 	return _walkableProperties[surfaceID];
 }
 
+Pathfinding::Region::Region() : x(0.f), y(0.f), component(UINT32_MAX) {
+}
+
+Pathfinding::PathCacheKey::PathCacheKey(uint32_t start, uint32_t end, float w) :
+	startRegion(start), endRegion(end), width(w) {
+}
+
+bool Pathfinding::PathCacheKey::operator<(const PathCacheKey &key) const {
+	if (startRegion != key.startRegion)
+		return startRegion < key.startRegion;
+	if (endRegion != key.endRegion)
+		return endRegion < key.endRegion;
+
+	return width < key.width;
+}
+
+Pathfinding::CachedPath::CachedPath(const PathCacheKey &k) : key(k) {
+}
+
+void Pathfinding::buildRegions(uint32_t maxRegionFaces) {
+	clearRegions();
+
+	maxRegionFaces = MAX<uint32_t>(maxRegionFaces, 1);
+
+	_faceRegion.resize(_facesCount, UINT32_MAX);
+
+	std::vector<uint32_t> adjFaces;
+
+	// Grow regions breadth-first from each walkable face not yet in a region
+	std::deque<uint32_t> queue;
+	for (uint32_t face = 0; face < _facesCount; ++face) {
+		if ((_faceRegion[face] != UINT32_MAX) || !faceWalkable(face))
+			continue;
+
+		const uint32_t region = _regions.size();
+		_regions.push_back(Region());
+
+		uint32_t regionFaces = 1;
+		_faceRegion[face] = region;
+		queue.push_back(face);
+
+		while (!queue.empty()) {
+			const uint32_t current = queue.front();
+			queue.pop_front();
+
+			// Add the center of the face to the center of the region.
+			float x = 0.f, y = 0.f;
+			for (uint32_t v = 0; v < _polygonEdges; ++v) {
+				const uint32_t vertex = _faces[current * _polygonEdges + v];
+
+				x += _vertices[vertex * 3 + 0];
+				y += _vertices[vertex * 3 + 1];
+			}
+
+			_regions[region].x += x / _polygonEdges;
+			_regions[region].y += y / _polygonEdges;
+
+			Pathfinding::getAdjacentFaces(current, UINT32_MAX, adjFaces);
+			for (std::vector<uint32_t>::const_iterator a = adjFaces.begin(); a != adjFaces.end(); ++a) {
+				if ((regionFaces >= maxRegionFaces) || (*a >= _facesCount) || (_faceRegion[*a] != UINT32_MAX))
+					continue;
+
+				regionFaces++;
+				_faceRegion[*a] = region;
+				queue.push_back(*a);
+			}
+		}
+
+		_regions[region].x /= regionFaces;
+		_regions[region].y /= regionFaces;
+	}
+
+	// Connect the regions with shared edges
+	for (uint32_t face = 0; face < _facesCount; ++face) {
+		const uint32_t region = _faceRegion[face];
+		if (region == UINT32_MAX)
+			continue;
+
+		Pathfinding::getAdjacentFaces(face, UINT32_MAX, adjFaces);
+		for (std::vector<uint32_t>::const_iterator a = adjFaces.begin(); a != adjFaces.end(); ++a) {
+			if ((*a >= _facesCount) || (_faceRegion[*a] == region))
+				continue;
+
+			_regions[region].neighbours.push_back(_faceRegion[*a]);
+		}
+	}
+
+	for (std::vector<Region>::iterator r = _regions.begin(); r != _regions.end(); ++r) {
+		std::sort(r->neighbours.begin(), r->neighbours.end());
+		r->neighbours.erase(std::unique(r->neighbours.begin(), r->neighbours.end()), r->neighbours.end());
+	}
+
+	// Find the sets of connected regions, so we know which regions can't reach each other
+	uint32_t component = 0;
+	std::vector<uint32_t> stack;
+	for (uint32_t region = 0; region < _regions.size(); ++region) {
+		if (_regions[region].component != UINT32_MAX)
+			continue;
+
+		_regions[region].component = component;
+		stack.push_back(region);
+
+		while (!stack.empty()) {
+			const Region &current = _regions[stack.back()];
+			stack.pop_back();
+
+			for (std::vector<uint32_t>::const_iterator n = current.neighbours.begin();
+			     n != current.neighbours.end(); ++n) {
+
+				if (_regions[*n].component != UINT32_MAX)
+					continue;
+
+				_regions[*n].component = component;
+				stack.push_back(*n);
+			}
+		}
+
+		component++;
+	}
+
+	_corridorStamp.resize(_regions.size(), 0);
+}
+
+void Pathfinding::clearRegions() {
+	_regions.clear();
+	_faceRegion.clear();
+
+	_corridorStamp.clear();
+	_corridorGeneration = 0;
+
+	_pathCache.clear();
+	_pathCacheMap.clear();
+}
+
+void Pathfinding::setPathCacheSize(size_t size) {
+	_pathCacheSize = size;
+
+	trimPathCache();
+}
+
+uint32_t Pathfinding::getRegion(float x, float y) {
+	if (_regions.empty())
+		return UINT32_MAX;
+
+	const uint32_t face = findFace(x, y);
+	if (face >= _faceRegion.size())
+		return UINT32_MAX;
+
+	return _faceRegion[face];
+}
+
+bool Pathfinding::inCorridor(uint32_t face) const {
+	if (!_corridorActive)
+		return true;
+
+	if ((face >= _faceRegion.size()) || (_faceRegion[face] == UINT32_MAX))
+		return false;
+
+	return _corridorStamp[_faceRegion[face]] == _corridorGeneration;
+}
+
+bool Pathfinding::findRegionPath(float startX, float startY, float endX, float endY,
+                                 std::vector<uint32_t> &facePath, float width, uint32_t nbrIt) {
+
+	const uint32_t startRegion = getRegion(startX, startY);
+	const uint32_t endRegion   = getRegion(endX, endY);
+
+	if ((startRegion == UINT32_MAX) || (endRegion == UINT32_MAX) || (startRegion == endRegion))
+		return false;
+
+	// Unreachable. Let the full search find the closest path.
+	if (_regions[startRegion].component != _regions[endRegion].component)
+		return false;
+
+	std::vector<uint32_t> corridor;
+	if (!findRegionCorridor(startRegion, endRegion, corridor))
+		return false;
+
+	// Stamp the regions of the corridor. On wrap-around, reset all old stamps.
+	if (++_corridorGeneration == 0) {
+		std::fill(_corridorStamp.begin(), _corridorStamp.end(), 0);
+		_corridorGeneration = 1;
+	}
+
+	for (std::vector<uint32_t>::const_iterator r = corridor.begin(); r != corridor.end(); ++r)
+		_corridorStamp[*r] = _corridorGeneration;
+
+	// If the corridor is too narrow for the creature, the full search will find a way around.
+	bool found = false;
+
+	_corridorActive = true;
+	try {
+		found = _aStarAlgorithm->findPath(startX, startY, endX, endY, facePath, width, nbrIt);
+	} catch (...) {
+		_corridorActive = false;
+		throw;
+	}
+	_corridorActive = false;
+
+	return found;
+}
+
+static float getDistance(float xA, float yA, float xB, float yB) {
+	const float dX = xA - xB;
+	const float dY = yA - yB;
+
+	return std::sqrt(dX * dX + dY * dY);
+}
+
+bool Pathfinding::findRegionCorridor(uint32_t startRegion, uint32_t endRegion,
+                                     std::vector<uint32_t> &corridor) const {
+
+	typedef std::pair<float, uint32_t> OpenRegion;
+
+	std::vector<float>    cost(_regions.size(), std::numeric_limits<float>::max());
+	std::vector<uint32_t> parent(_regions.size(), UINT32_MAX);
+	std::vector<bool>     closed(_regions.size(), false);
+
+	std::priority_queue<OpenRegion, std::vector<OpenRegion>, std::greater<OpenRegion>> open;
+
+	const Region &end = _regions[endRegion];
+
+	cost[startRegion] = 0.f;
+	open.push(OpenRegion(getDistance(_regions[startRegion].x, _regions[startRegion].y, end.x, end.y), startRegion));
+
+	while (!open.empty()) {
+		const uint32_t current = open.top().second;
+		open.pop();
+
+		// Regions are queued again when we find a cheaper way to them, skip the stale entries
+		if (closed[current])
+			continue;
+
+		closed[current] = true;
+
+		if (current == endRegion) {
+			for (uint32_t r = endRegion; r != UINT32_MAX; r = parent[r])
+				corridor.push_back(r);
+
+			std::reverse(corridor.begin(), corridor.end());
+			return true;
+		}
+
+		const Region &region = _regions[current];
+		for (std::vector<uint32_t>::const_iterator n = region.neighbours.begin(); n != region.neighbours.end(); ++n) {
+			const Region &neighbour = _regions[*n];
+
+			const float nCost = cost[current] + getDistance(region.x, region.y, neighbour.x, neighbour.y);
+			if (nCost >= cost[*n])
+				continue;
+
+			cost[*n]   = nCost;
+			parent[*n] = current;
+
+			open.push(OpenRegion(nCost + getDistance(neighbour.x, neighbour.y, end.x, end.y), *n));
+		}
+	}
+
+	return false;
+}
+
+/** A point on the segment between two points, just before the end.
+ *
+ *  The corners of a smoothed path touch unwalkable faces, which makes
+ *  walkableSegment() fail for any segment ending there.
+ */
+static glm::vec3 stopShort(const glm::vec3 &from, const glm::vec3 &to) {
+	static const float kDistance = 0.01f;
+
+	const float length = glm::length(to - from);
+	if (length <= (2 * kDistance))
+		return from + (to - from) * 0.5f;
+
+	return to - (to - from) * (kDistance / length);
+}
+
+bool Pathfinding::findCachedPath(const PathCacheKey &key, const glm::vec3 &start, const glm::vec3 &end,
+                                 std::vector<glm::vec3> &path) {
+
+	PathCacheMap::iterator c = _pathCacheMap.find(key);
+	if (c == _pathCacheMap.end())
+		return false;
+
+	const std::vector<glm::vec3> &cached = c->second->path;
+	if (cached.size() < 2)
+		return false;
+
+	// Swap in our start and end points, and make sure we can still walk to the rest of the path
+	const glm::vec3 &first = (cached.size() > 2) ? cached[1] : end;
+	const glm::vec3 &last  = (cached.size() > 2) ? cached[cached.size() - 2] : start;
+
+	if (!walkableSegment(start, stopShort(start, first), key.width) ||
+	    !walkableSegment(end, stopShort(end, last), key.width))
+		return false;
+
+	path.push_back(start);
+	path.insert(path.end(), cached.begin() + 1, cached.end() - 1);
+	path.push_back(end);
+
+	_pathCache.splice(_pathCache.begin(), _pathCache, c->second);
+
+	return true;
+}
+
+void Pathfinding::addCachedPath(const PathCacheKey &key, const std::vector<glm::vec3> &path) {
+	PathCacheMap::iterator c = _pathCacheMap.find(key);
+	if (c != _pathCacheMap.end()) {
+		c->second->path = path;
+		_pathCache.splice(_pathCache.begin(), _pathCache, c->second);
+
+		return;
+	}
+
+	_pathCache.push_front(CachedPath(key));
+	_pathCache.front().path = path;
+
+	_pathCacheMap.insert(std::make_pair(key, _pathCache.begin()));
+
+	trimPathCache();
+}
+
+void Pathfinding::trimPathCache() {
+	while (_pathCache.size() > _pathCacheSize) {
+		_pathCacheMap.erase(_pathCache.back().key);
+		_pathCache.pop_back();
+	}
+}
+
 } // End of namespace Engines
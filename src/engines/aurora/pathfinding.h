@@ -25,6 +25,10 @@
 #ifndef ENGINES_PATHFINDING_H
 #define ENGINES_PATHFINDING_H
 
+#include <vector>
+#include <list>
+#include <map>
+
 #include "external/glm/vec3.hpp"
 
 #include "src/common/ustring.h"
@@ -72,6 +76,31 @@ public:
 	 */
 	void smoothPath(float startX, float startY, float endX, float endY,
 	                std::vector<uint32_t> &facePath, std::vector<glm::vec3> &path);
+	/** Find a smooth path between two points.
+	 *
+	 *  This combines findPath() and smoothPath(). If the walkmesh regions have
+	 *  been built, smoothed paths are cached by the regions of their start and
+	 *  end points, and reused for later searches between the same regions.
+	 *
+	 *  Unlike findPath(), no path is returned if the end point can't be reached.
+	 */
+	bool findSmoothPath(float startX, float startY, float endX, float endY,
+	                    std::vector<glm::vec3> &path, float width = 0.f, uint32_t nbrIt = 10000);
+
+	/** Cluster the walkable faces of the walkmesh into regions.
+	 *
+	 *  This is an optional precomputation step, to be done once the walkmesh is
+	 *  complete. Paths between two regions are then first searched on the graph
+	 *  of regions, and the faces are only searched within the regions along
+	 *  that rough path.
+	 *
+	 *  @param maxRegionFaces The maximum number of faces in a region.
+	 */
+	void buildRegions(uint32_t maxRegionFaces = 64);
+	/** Remove the walkmesh regions and all cached paths. */
+	void clearRegions();
+	/** Set the number of smoothed paths kept in the path cache. 0 disables the cache. */
+	void setPathCacheSize(size_t size);
 
 	/** Get the intersection between a line and the walkmesh.
 	 *
@@ -118,8 +147,8 @@ protected:
 	                       std::vector<bool> &tunnelLeftRight);
 	/** Check if a given align-axis square is walkable. */
 	virtual bool walkableAASquare(glm::vec3 center, float halfWidth);
-	/** Check if a given segment is walkable. */
-	virtual bool walkableSegment(glm::vec3 start, glm::vec3 end);
+	/** Check if a given segment is walkable, for a creature of the given width. */
+	virtual bool walkableSegment(glm::vec3 start, glm::vec3 end, float width = 0.f);
 	/** Find the rough center of the polygon (simple mean). */
 	virtual void findCenter(std::vector<glm::vec3> &vertices, float &centerX, float &centerY) const;
 	/** Are two points close? Use the _epsilon value to evaluate the proximity.*/
@@ -158,12 +187,80 @@ private:
 	/** Get the center of the adjacency edge from two faces. */
 	void getAdjacencyCenter(uint32_t faceA, uint32_t faceB, float &x, float &y) const;
 
+	/** A cluster of connected walkable faces. */
+	struct Region {
+		float x; ///< The x position of the center of the region.
+		float y; ///< The y position of the center of the region.
+
+		uint32_t component; ///< The set of connected regions this region belongs to.
+
+		std::vector<uint32_t> neighbours; ///< The regions adjacent to this region.
+
+		Region();
+	};
+
+	/** The key of a cached path. */
+	struct PathCacheKey {
+		uint32_t startRegion;
+		uint32_t endRegion;
+		float width;
+
+		PathCacheKey(uint32_t start, uint32_t end, float w);
+
+		bool operator<(const PathCacheKey &key) const;
+	};
+
+	/** A smoothed path, between two regions. */
+	struct CachedPath {
+		PathCacheKey key;
+		std::vector<glm::vec3> path;
+
+		CachedPath(const PathCacheKey &k);
+	};
+
+	typedef std::list<CachedPath> PathCache;
+	typedef std::map<PathCacheKey, PathCache::iterator> PathCacheMap;
+
+	/** Find a path of faces, only searching the faces along a path of regions. */
+	bool findRegionPath(float startX, float startY, float endX, float endY,
+	                    std::vector<uint32_t> &facePath, float width, uint32_t nbrIt);
+	/** Find the path of regions between two regions. */
+	bool findRegionCorridor(uint32_t startRegion, uint32_t endRegion, std::vector<uint32_t> &corridor) const;
+	/** Get the region of the walkable face at a point, or UINT32_MAX. */
+	uint32_t getRegion(float x, float y);
+	/** Is the face part of the regions the current path search is restricted to? */
+	bool inCorridor(uint32_t face) const;
+
+	/** Try to build a path out of a cached path. */
+	bool findCachedPath(const PathCacheKey &key, const glm::vec3 &start, const glm::vec3 &end,
+	                    std::vector<glm::vec3> &path);
+	/** Add a path to the path cache. */
+	void addCachedPath(const PathCacheKey &key, const std::vector<glm::vec3> &path);
+	/** Remove the least recently used paths until the cache fits its size. */
+	void trimPathCache();
+
+	/** Show a path. */
+	void setPathDrawing(const std::vector<glm::vec3> &path);
+
 	Graphics::Aurora::Line *_pathDrawing;
 	Graphics::Aurora::Walkmesh *_walkmeshDrawing;
 
 	std::vector<bool> _walkableProperties; ///< Mapping between surface property and walkability.
 	AStar *_aStarAlgorithm; ///< A* algorithm used.
 
+	std::vector<Region>   _regions;    ///< The regions of the walkmesh.
+	std::vector<uint32_t> _faceRegion; ///< The region of each face, UINT32_MAX if unwalkable.
+
+	/** The corridor stamp of each region. A region is part of the current
+	 *  search corridor if its stamp matches _corridorGeneration. */
+	std::vector<uint32_t> _corridorStamp;
+	uint32_t _corridorGeneration;
+	bool _corridorActive; ///< Is the current path search restricted to a corridor?
+
+	PathCache    _pathCache;    ///< The cached paths, most recently used first.
+	PathCacheMap _pathCacheMap; ///< The cached paths, by key.
+	size_t _pathCacheSize;      ///< The maximum number of cached paths.
+
 friend class AStar;
 friend class Graphics::Aurora::Walkmesh;
 friend class LocalPathfinding;
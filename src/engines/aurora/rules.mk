@@ -38,6 +38,8 @@ src_engines_aurora_libaurora_la_SOURCES += \
     src/engines/aurora/astar.h \
     src/engines/aurora/localpathfinding.h \
     src/engines/aurora/objectwalkmesh.h \
+    src/engines/aurora/scriptscheduler.h \
+    src/engines/aurora/scriptqueue.h \
     $(EMPTY)
 
 src_engines_aurora_libaurora_la_SOURCES += \
@@ -55,4 +57,6 @@ src_engines_aurora_libaurora_la_SOURCES += \
     src/engines/aurora/pathfinding.cpp \
     src/engines/aurora/astar.cpp \
     src/engines/aurora/localpathfinding.cpp \
+    src/engines/aurora/scriptscheduler.cpp \
+    src/engines/aurora/scriptqueue.cpp \
     $(EMPTY)
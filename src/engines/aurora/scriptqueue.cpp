@@ -0,0 +1,190 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Running scripts spread over several frames.
+ */
+
+#include <cassert>
+
+#include <chrono>
+#include <utility>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/debug.h"
+#include "src/common/configman.h"
+
+#include "src/aurora/nwscript/ncsfile.h"
+
+#include "src/engines/aurora/scriptqueue.h"
+
+namespace Engines {
+
+/** The default time budget per frame, in milliseconds. */
+static const double kDefaultBudget = 4.0;
+
+
+ScriptQueue::Task::Task() {
+}
+
+ScriptQueue::Task::Task(Task &&task) = default;
+
+ScriptQueue::Task::~Task() {
+}
+
+ScriptQueue::Task &ScriptQueue::Task::operator=(Task &&task) = default;
+
+
+const size_t ScriptQueue::kSliceInstructions;
+
+ScriptQueue::ScriptQueue() : _lastSlices(0), _lastFinished(0), _lastTime(0.0) {
+	setBudget(ConfigMan.getDouble("scriptbudget", kDefaultBudget));
+}
+
+ScriptQueue::~ScriptQueue() {
+}
+
+double ScriptQueue::getBudget() const {
+	return _budget;
+}
+
+void ScriptQueue::setBudget(double budget) {
+	_budget = MAX(budget, 0.0);
+}
+
+void ScriptQueue::add(Priority priority, const Common::UString &script, Aurora::NWScript::ScriptState &&state,
+                      const Aurora::NWScript::ObjectReference &owner,
+                      const Aurora::NWScript::ObjectReference &triggerer) {
+
+	assert((priority >= 0) && (priority < kPriorityMAX));
+
+	if (script.empty())
+		return;
+
+	_tasks[priority].push_back(Task());
+
+	Task &task = _tasks[priority].back();
+
+	task.script    = script;
+	task.state     = std::move(state);
+	task.owner     = owner;
+	task.triggerer = triggerer;
+}
+
+void ScriptQueue::run() {
+	typedef std::chrono::steady_clock Clock;
+
+	const Clock::time_point start = Clock::now();
+	const Clock::duration budget =
+		std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(_budget));
+
+	// Without a budget, there's no need to ever interrupt a script
+	const size_t instructions = (_budget > 0.0) ? kSliceInstructions : 0;
+
+	_lastSlices   = 0;
+	_lastFinished = 0;
+
+	for (size_t priority = 0; priority < kPriorityMAX; priority++) {
+		std::deque<Task> &tasks = _tasks[priority];
+
+		while (!tasks.empty()) {
+			if ((_lastSlices > 0) && (instructions > 0) && ((Clock::now() - start) >= budget))
+				break;
+
+			_lastSlices++;
+
+			// A suspended script stays in front and is resumed until it's done
+			if (runSlice(tasks.front(), instructions)) {
+				tasks.pop_front();
+				_lastFinished++;
+			}
+		}
+	}
+
+	_lastTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	if (_lastSlices > 0)
+		debugC(Common::kDebugEngineScripts, 3, "Script queue: %u slices, %u scripts finished, %u waiting, %.3f ms",
+		       (uint)_lastSlices, (uint)_lastFinished, (uint)size(), _lastTime);
+}
+
+bool ScriptQueue::runSlice(Task &task, size_t instructions) {
+	try {
+		if (!task.ncs) {
+			task.ncs = std::make_unique<Aurora::NWScript::NCSFile>(task.script);
+
+			task.ncs->setInstructionBudget(instructions);
+			task.ncs->run(task.state, task.owner, task.triggerer);
+
+			// The script has its own stack now
+			task.state.globals.clear();
+			task.state.locals.clear();
+
+		} else {
+			task.ncs->setInstructionBudget(instructions);
+			task.ncs->resume();
+		}
+
+		return !task.ncs->isSuspended();
+
+	} catch (...) {
+		Common::exceptionDispatcherWarning("Failed running script \"%s\"", task.script.c_str());
+	}
+
+	return true;
+}
+
+void ScriptQueue::clear() {
+	for (size_t i = 0; i < kPriorityMAX; i++)
+		_tasks[i].clear();
+}
+
+bool ScriptQueue::empty() const {
+	return size() == 0;
+}
+
+size_t ScriptQueue::size() const {
+	size_t size = 0;
+	for (size_t i = 0; i < kPriorityMAX; i++)
+		size += _tasks[i].size();
+
+	return size;
+}
+
+ScriptQueue::Stats ScriptQueue::getStats() const {
+	Stats stats;
+
+	stats.queued    = size();
+	stats.suspended = 0;
+
+	for (size_t i = 0; i < kPriorityMAX; i++)
+		for (std::deque<Task>::const_iterator t = _tasks[i].begin(); t != _tasks[i].end(); ++t)
+			if (t->ncs)
+				stats.suspended++;
+
+	stats.slices   = _lastSlices;
+	stats.finished = _lastFinished;
+	stats.time     = _lastTime;
+
+	return stats;
+}
+
+} // End of namespace Engines
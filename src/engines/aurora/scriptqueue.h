@@ -0,0 +1,146 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Running scripts spread over several frames.
+ */
+
+#ifndef ENGINES_AURORA_SCRIPTQUEUE_H
+#define ENGINES_AURORA_SCRIPTQUEUE_H
+
+#include <deque>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/nwscript/variable.h"
+#include "src/aurora/nwscript/objectref.h"
+
+namespace Aurora {
+	namespace NWScript {
+		class NCSFile;
+	}
+}
+
+namespace Engines {
+
+/** Runs scripts that don't need to finish right away, within a time budget per frame.
+ *
+ *  Scripts are run in slices of a fixed number of instructions. Between
+ *  slices, the queue checks how much of the frame's budget is left. A
+ *  script that didn't finish within its slice is suspended and resumed
+ *  with the next slice, until it's done. Once the budget is spent, the
+ *  script is continued in the next frame, where it left off.
+ *
+ *  Scripts triggered by the player run before all ambient scripts. Within
+ *  a priority, scripts run one after the other, in the order they were
+ *  queued.
+ *
+ *  The budget is read from the "scriptbudget" config option, in
+ *  milliseconds. With a budget of 0, all scripts always run to their end
+ *  within the same frame.
+ */
+class ScriptQueue : boost::noncopyable {
+public:
+	enum Priority {
+		kPriorityPlayer  = 0, ///< A script triggered by the player.
+		kPriorityAmbient = 1, ///< Any other script.
+		kPriorityMAX
+	};
+
+	struct Stats {
+		size_t queued;    ///< The number of scripts currently waiting.
+		size_t suspended; ///< The number of waiting scripts that ran out of their slice.
+
+		size_t slices;   ///< The number of slices run in the last frame.
+		size_t finished; ///< The number of scripts that finished in the last frame.
+
+		double time; ///< The time spent running scripts in the last frame, in milliseconds.
+	};
+
+	/** The number of instructions a script may run before the queue checks the time. */
+	static const size_t kSliceInstructions = 10000;
+
+	ScriptQueue();
+	~ScriptQueue();
+
+	/** Return the time budget per frame, in milliseconds. */
+	double getBudget() const;
+	/** Set the time budget per frame, in milliseconds. 0 means no limit. */
+	void setBudget(double budget);
+
+	/** Queue a script to run, starting from this state. */
+	void add(Priority priority, const Common::UString &script, Aurora::NWScript::ScriptState &&state,
+	         const Aurora::NWScript::ObjectReference &owner, const Aurora::NWScript::ObjectReference &triggerer);
+
+	/** Run queued scripts, until all are done or this frame's budget is spent.
+	 *
+	 *  At least one slice is run in every frame, so that the scripts always
+	 *  make progress.
+	 */
+	void run();
+
+	/** Drop all waiting scripts, including the suspended ones. */
+	void clear();
+
+	bool empty() const;
+	/** Return the number of scripts currently waiting. */
+	size_t size() const;
+
+	Stats getStats() const;
+
+private:
+	/** A waiting script. */
+	struct Task {
+		Common::UString script;
+
+		Aurora::NWScript::ScriptState state;
+
+		Aurora::NWScript::ObjectReference owner;
+		Aurora::NWScript::ObjectReference triggerer;
+
+		/** The script's execution state, once it was started. */
+		std::unique_ptr<Aurora::NWScript::NCSFile> ncs;
+
+		Task();
+		Task(Task &&task);
+		~Task();
+
+		Task &operator=(Task &&task);
+	};
+
+	std::deque<Task> _tasks[kPriorityMAX];
+
+	double _budget;
+
+	size_t _lastSlices;
+	size_t _lastFinished;
+	double _lastTime;
+
+	/** Run the next slice of this script. Return true if the script is done. */
+	bool runSlice(Task &task, size_t instructions);
+};
+
+} // End of namespace Engines
+
+#endif // ENGINES_AURORA_SCRIPTQUEUE_H
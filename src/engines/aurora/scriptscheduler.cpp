@@ -0,0 +1,314 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Scheduling delayed script actions.
+ */
+
+#include <cassert>
+
+#include <utility>
+#include <algorithm>
+
+#include "src/common/util.h"
+#include "src/common/debug.h"
+
+#include "src/engines/aurora/scriptscheduler.h"
+
+namespace Engines {
+
+/** The number of bits of the timestamp the first level covers. */
+static const uint32_t kFirstLevelBits = 8;
+/** The number of bits of the timestamp each further level covers. */
+static const uint32_t kLevelBits      = 6;
+
+static const uint32_t kFirstLevelMask = (1 << kFirstLevelBits) - 1;
+
+/** Return the lowest bit of the timestamp that selects a slot within this level. */
+static inline uint32_t getLevelShift(size_t level) {
+	return (level == 0) ? 0 : (kFirstLevelBits + kLevelBits * (level - 1));
+}
+
+/** Return the number of slots of this level. */
+static inline size_t getLevelSize(size_t level) {
+	return (level == 0) ? ((size_t) 1 << kFirstLevelBits) : ((size_t) 1 << kLevelBits);
+}
+
+static inline size_t getSlot(size_t level, uint32_t timestamp) {
+	return (timestamp >> getLevelShift(level)) & (getLevelSize(level) - 1);
+}
+
+/** Are these two timestamps within the same span covered by all slots of this level? */
+static inline bool isSameSpan(size_t level, uint32_t a, uint32_t b) {
+	const uint32_t shift = getLevelShift(level + 1);
+
+	return ((uint64_t) a >> shift) == ((uint64_t) b >> shift);
+}
+
+
+ScriptScheduler::Slot::Slot() : head(kInvalidRecord), tail(kInvalidRecord) {
+}
+
+
+const size_t ScriptScheduler::kLevelCount;
+const uint32_t ScriptScheduler::kInvalidRecord;
+
+ScriptScheduler::ScriptScheduler() : _current(0), _pending(0), _pendingFirstLevel(0), _peak(0),
+	_added(0), _lastAdded(0), _lastFired(0), _totalAdded(0), _totalFired(0) {
+
+	for (size_t i = 0; i < kLevelCount; i++)
+		_levels[i].resize(getLevelSize(i));
+}
+
+ScriptScheduler::~ScriptScheduler() {
+}
+
+void ScriptScheduler::add(uint32_t timestamp, const Common::UString &script, Aurora::NWScript::ScriptState &&state,
+                          const Aurora::NWScript::ObjectReference &owner,
+                          const Aurora::NWScript::ObjectReference &triggerer) {
+
+	const uint32_t record = allocateRecord();
+
+	Action &action = _records[record].action;
+
+	action.timestamp = timestamp;
+	action.script    = script;
+	action.state     = std::move(state);
+	action.owner     = owner;
+	action.triggerer = triggerer;
+
+	insert(record);
+
+	_pending++;
+	_peak = MAX(_peak, _pending);
+
+	_added++;
+	_totalAdded++;
+}
+
+void ScriptScheduler::update(uint32_t now, const Runner &runner) {
+	_lastAdded = _added;
+	_lastFired = 0;
+
+	_added = 0;
+
+	while (_current <= now) {
+		if (_pending == 0) {
+			// Nothing to do at all. Jump straight to the end
+			_current = now + 1;
+			break;
+		}
+
+		if (_pendingFirstLevel == 0) {
+			// Nothing to do within this slot of the second level. Skip to the next one
+			const uint32_t next = (_current | kFirstLevelMask) + 1;
+			if ((next == 0) || (next > now)) {
+				setCurrent(now + 1);
+				break;
+			}
+
+			setCurrent(next);
+			continue;
+		}
+
+		fire(runner);
+
+		if (_current == 0xFFFFFFFF)
+			break;
+
+		setCurrent(_current + 1);
+	}
+
+	if ((_lastAdded > 0) || (_lastFired > 0))
+		debugC(Common::kDebugEngineScripts, 3, "Delayed actions: %u added, %u fired, %u pending",
+		       (uint)_lastAdded, (uint)_lastFired, (uint)_pending);
+}
+
+void ScriptScheduler::clear() {
+	_records.clear();
+	_freeRecords.clear();
+
+	for (size_t i = 0; i < kLevelCount; i++)
+		std::fill(_levels[i].begin(), _levels[i].end(), Slot());
+
+	_pending           = 0;
+	_pendingFirstLevel = 0;
+}
+
+bool ScriptScheduler::empty() const {
+	return _pending == 0;
+}
+
+size_t ScriptScheduler::size() const {
+	return _pending;
+}
+
+ScriptScheduler::Stats ScriptScheduler::getStats() const {
+	Stats stats;
+
+	stats.pending    = _pending;
+	stats.peak       = _peak;
+	stats.added      = _lastAdded;
+	stats.fired      = _lastFired;
+	stats.totalAdded = _totalAdded;
+	stats.totalFired = _totalFired;
+
+	return stats;
+}
+
+void ScriptScheduler::insert(uint32_t record) {
+	// Actions that are already overdue are fired with the next batch
+	const uint32_t timestamp = MAX(_records[record].action.timestamp, _current);
+
+	size_t level = 0;
+	while ((level < (kLevelCount - 1)) && !isSameSpan(level, timestamp, _current))
+		level++;
+
+	Slot &slot = _levels[level][getSlot(level, timestamp)];
+
+	_records[record].next = kInvalidRecord;
+
+	if (slot.tail == kInvalidRecord)
+		slot.head = record;
+	else
+		_records[slot.tail].next = record;
+
+	slot.tail = record;
+
+	if (level == 0)
+		_pendingFirstLevel++;
+}
+
+void ScriptScheduler::cascade(size_t level, size_t slot) {
+	assert(level > 0);
+
+	uint32_t record = _levels[level][slot].head;
+
+	_levels[level][slot] = Slot();
+
+	// Re-inserting in order keeps the order of actions with the same timestamp
+	while (record != kInvalidRecord) {
+		const uint32_t next = _records[record].next;
+
+		insert(record);
+
+		record = next;
+	}
+}
+
+void ScriptScheduler::setCurrent(uint32_t current) {
+	const bool newSpan = !isSameSpan(0, current, _current);
+
+	_current = current;
+
+	if (!newSpan || (_pending == 0))
+		return;
+
+	/* We entered a new slot of the second level, and maybe of further levels.
+	 * Those records now belong into the lower levels. Start from the highest
+	 * level, so that the records trickle all the way down. */
+
+	size_t top = 1;
+	while (((top + 1) < kLevelCount) && ((_current & ((1 << getLevelShift(top + 1)) - 1)) == 0))
+		top++;
+
+	for (size_t level = top; level > 0; level--)
+		cascade(level, getSlot(level, _current));
+}
+
+void ScriptScheduler::fire(const Runner &runner) {
+	Slot &slot = _levels[0][getSlot(0, _current)];
+
+	// The runner might add more actions for right now, so we check again until there are none
+	while (slot.head != kInvalidRecord) {
+		uint32_t record = slot.head;
+
+		slot = Slot();
+
+		while (record != kInvalidRecord) {
+			const uint32_t next = _records[record].next;
+
+			_pending--;
+			_pendingFirstLevel--;
+
+			_lastFired++;
+			_totalFired++;
+
+			/* Take the action out of its record before running it. The runner
+			 * might add new actions, which can reuse the record right away. */
+			Action action = std::move(_records[record].action);
+			freeRecord(record);
+
+			try {
+				runner(action);
+			} catch (...) {
+				requeue(next);
+				throw;
+			}
+
+			record = next;
+		}
+	}
+}
+
+void ScriptScheduler::requeue(uint32_t record) {
+	if (record == kInvalidRecord)
+		return;
+
+	Slot &slot = _levels[0][getSlot(0, _current)];
+
+	uint32_t last = record;
+	while (_records[last].next != kInvalidRecord)
+		last = _records[last].next;
+
+	_records[last].next = slot.head;
+	if (slot.tail == kInvalidRecord)
+		slot.tail = last;
+
+	slot.head = record;
+}
+
+uint32_t ScriptScheduler::allocateRecord() {
+	if (!_freeRecords.empty()) {
+		const uint32_t record = _freeRecords.back();
+		_freeRecords.pop_back();
+
+		return record;
+	}
+
+	_records.push_back(Record());
+
+	return _records.size() - 1;
+}
+
+void ScriptScheduler::freeRecord(uint32_t record) {
+	Action &action = _records[record].action;
+
+	// Let go of the script state right away, the variables might hold on to objects and arrays
+	action.state.globals.clear();
+	action.state.locals.clear();
+
+	action.owner     = Aurora::NWScript::ObjectReference();
+	action.triggerer = Aurora::NWScript::ObjectReference();
+
+	_freeRecords.push_back(record);
+}
+
+} // End of namespace Engines
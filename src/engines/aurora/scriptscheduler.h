@@ -0,0 +1,165 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Scheduling delayed script actions.
+ */
+
+#ifndef ENGINES_AURORA_SCRIPTSCHEDULER_H
+#define ENGINES_AURORA_SCRIPTSCHEDULER_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/nwscript/variable.h"
+#include "src/aurora/nwscript/objectref.h"
+
+namespace Engines {
+
+/** Keeps script actions, like those created by DelayCommand(), until they're due.
+ *
+ *  The actions are sorted into a hierarchical timer wheel: the first level
+ *  has one slot for every millisecond of the next 256 milliseconds, and
+ *  every further level has 64 slots, each as long as the whole level below.
+ *  Adding an action and firing it are constant-time, no matter how many
+ *  actions are pending. Actions far in the future are moved down a level
+ *  whenever time reaches their slot.
+ *
+ *  The action records are pooled and reused, and the script states are
+ *  moved in and out of them instead of being copied.
+ *
+ *  Actions with the same timestamp are fired in the order they were added.
+ */
+class ScriptScheduler : boost::noncopyable {
+public:
+	/** A script to run after a delay. */
+	struct Action {
+		uint32_t timestamp; ///< When to run the script.
+
+		Common::UString script;              ///< The script's name.
+		Aurora::NWScript::ScriptState state; ///< Where to resume the script.
+
+		Aurora::NWScript::ObjectReference owner;
+		Aurora::NWScript::ObjectReference triggerer;
+	};
+
+	typedef std::function<void(Action &)> Runner;
+
+	struct Stats {
+		size_t pending; ///< The number of actions currently waiting.
+		size_t peak;    ///< The highest number of actions ever waiting at once.
+
+		size_t added; ///< The number of actions added between the last two updates.
+		size_t fired; ///< The number of actions fired in the last update.
+
+		uint64_t totalAdded; ///< The number of actions ever added.
+		uint64_t totalFired; ///< The number of actions ever fired.
+	};
+
+	ScriptScheduler();
+	~ScriptScheduler();
+
+	/** Schedule a script to run at this timestamp. */
+	void add(uint32_t timestamp, const Common::UString &script, Aurora::NWScript::ScriptState &&state,
+	         const Aurora::NWScript::ObjectReference &owner, const Aurora::NWScript::ObjectReference &triggerer);
+
+	/** Fire all actions due until this timestamp, in order.
+	 *
+	 *  The runner is handed an action that's no longer part of the scheduler,
+	 *  so it's free to add new actions while it runs. Actions added by the
+	 *  runner that are due already are fired within the same update.
+	 */
+	void update(uint32_t now, const Runner &runner);
+
+	/** Drop all pending actions. */
+	void clear();
+
+	bool empty() const;
+	/** Return the number of actions currently waiting. */
+	size_t size() const;
+
+	Stats getStats() const;
+
+private:
+	static const size_t kLevelCount = 5;
+
+	static const uint32_t kInvalidRecord = 0xFFFFFFFF;
+
+	/** A pooled action, part of a slot's linked list. */
+	struct Record {
+		Action action;
+
+		uint32_t next; ///< The next record in the same slot.
+	};
+
+	/** A list of records in the order they were added to the slot. */
+	struct Slot {
+		uint32_t head;
+		uint32_t tail;
+
+		Slot();
+	};
+
+	/** All records. A deque, so that adding records doesn't move the others. */
+	std::deque<Record> _records;
+	std::vector<uint32_t> _freeRecords;
+
+	std::vector<Slot> _levels[kLevelCount];
+
+	/** The next timestamp to handle. Everything before has been fired. */
+	uint32_t _current;
+
+	size_t _pending;
+	size_t _pendingFirstLevel; ///< The number of actions waiting in the first level.
+	size_t _peak;
+
+	size_t _added;     ///< The number of actions added since the last update.
+	size_t _lastAdded; ///< The number of actions added before the last update.
+	size_t _lastFired; ///< The number of actions fired in the last update.
+
+	uint64_t _totalAdded;
+	uint64_t _totalFired;
+
+	/** Sort the record into the slot matching its timestamp. */
+	void insert(uint32_t record);
+
+	/** Move the records of this slot down to the lower levels. */
+	void cascade(size_t level, size_t slot);
+	/** Set the current timestamp, cascading the records if we entered a new slot of the second level. */
+	void setCurrent(uint32_t current);
+
+	/** Fire all records in the slot of the current timestamp. */
+	void fire(const Runner &runner);
+	/** Put this list of records back in front of the current slot. */
+	void requeue(uint32_t record);
+
+	uint32_t allocateRecord();
+	void freeRecord(uint32_t record);
+};
+
+} // End of namespace Engines
+
+#endif // ENGINES_AURORA_SCRIPTSCHEDULER_H
@@ -250,6 +250,19 @@ void EngineManager::run(GameInstance &game) const {
 	GameInstanceEngine *gameEngine = dynamic_cast<GameInstanceEngine *>(&game);
 	assert(gameEngine);
 
+	/* Cache the resource lists of the game's archives between runs, so that
+	 * we don't have to parse all of them again every start. */
+	Common::UString indexCache = Common::FilePath::getUserDataFile("resindex.cache");
+	if (ConfigMan.hasKey("indexcache"))
+		indexCache = ConfigMan.getString("indexcache", "");
+	if (ConfigMan.getBool("noindexcache", false))
+		indexCache.clear();
+
+	if (!indexCache.empty())
+		indexCache = Common::FilePath::getUserDataFile(indexCache);
+
+	ResMan.setIndexCache(indexCache);
+
 	gameEngine->run();
 
 	GfxMan.lockFrame();
@@ -278,6 +291,8 @@ void EngineManager::cleanup() const {
 		LangMan.clear();
 		TalkMan.clear();
 		TwoDAReg.clear();
+
+		ResMan.saveIndexCache();
 		ResMan.clear();
 
 		ConfigMan.setGame();
@@ -43,11 +43,6 @@ namespace Engines {
 
 namespace Jade {
 
-bool Module::Action::operator<(const Action &s) const {
-	return timestamp < s.timestamp;
-}
-
-
 Module::Module(::Engines::Console &console) : _console(&console), _hasModule(false),
 	_running(false), _exit(false) {
 
@@ -158,6 +153,7 @@ void Module::unload(bool completeUnload) {
 
 	_eventQueue.clear();
 	_delayedActions.clear();
+	_scriptQueue.clear();
 
 	_newModule.clear();
 	_hasModule = false;
@@ -298,20 +294,15 @@ void Module::handleEvents() {
 }
 
 void Module::handleActions() {
-	uint32_t now = EventMan.getTimestamp();
-
-	while (!_delayedActions.empty()) {
-		ActionQueue::iterator action = _delayedActions.begin();
+	// Scripts triggered by the player go first, the others might have to wait for a later frame
+	_delayedActions.update(EventMan.getTimestamp(), [this](::Engines::ScriptScheduler::Action &action) {
+		const ::Engines::ScriptQueue::Priority priority = (_pc && (*action.triggerer == _pc.get())) ?
+			::Engines::ScriptQueue::kPriorityPlayer : ::Engines::ScriptQueue::kPriorityAmbient;
 
-		if (now < action->timestamp)
-			break;
+		_scriptQueue.add(priority, action.script, std::move(action.state), action.owner, action.triggerer);
+	});
 
-		if (action->type == kActionScript)
-			ScriptContainer::runScript(action->script, action->state,
-			                           action->owner, action->triggerer);
-
-		_delayedActions.erase(action);
-	}
+	_scriptQueue.run();
 }
 
 void Module::movePC(float x, float y, float z) {
@@ -350,19 +341,10 @@ Area *Module::getCurrentArea() {
 }
 
 void Module::delayScript(const Common::UString &script,
-                         const Aurora::NWScript::ScriptState &state,
+                         Aurora::NWScript::ScriptState &&state,
                          Aurora::NWScript::Object *owner,
                          Aurora::NWScript::Object *triggerer, uint32_t delay) {
-	Action action;
-
-	action.type      = kActionScript;
-	action.script    = script;
-	action.state     = state;
-	action.owner     = owner;
-	action.triggerer = triggerer;
-	action.timestamp = EventMan.getTimestamp() + delay;
-
-	_delayedActions.insert(action);
+	_delayedActions.add(EventMan.getTimestamp() + delay, script, std::move(state), owner, triggerer);
 }
 
 } // End of namespace Jade
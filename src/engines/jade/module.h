@@ -26,7 +26,6 @@
 #define ENGINES_JADE_MODULE_H
 
 #include <list>
-#include <set>
 
 #include <memory>
 #include "src/common/ustring.h"
@@ -38,6 +37,9 @@
 
 #include "src/events/types.h"
 
+#include "src/engines/aurora/scriptscheduler.h"
+#include "src/engines/aurora/scriptqueue.h"
+
 #include "src/engines/jade/objectcontainer.h"
 
 namespace Engines {
@@ -107,7 +109,7 @@ public:
 	// '---
 
 	void delayScript(const Common::UString &script,
-	                 const Aurora::NWScript::ScriptState &state,
+	                 Aurora::NWScript::ScriptState &&state,
 	                 Aurora::NWScript::Object *owner, Aurora::NWScript::Object *triggerer,
 	                 uint32_t delay);
 
@@ -133,27 +135,7 @@ public:
 	// '---
 
 private:
-	enum ActionType {
-		kActionNone   = 0,
-		kActionScript = 1
-	};
-
-	struct Action {
-		ActionType type;
-
-		Common::UString script;
-
-		Aurora::NWScript::ScriptState state;
-		Aurora::NWScript::ObjectReference owner;
-		Aurora::NWScript::ObjectReference triggerer;
-
-		uint32_t timestamp;
-
-		bool operator<(const Action &s) const;
-	};
-
 	typedef std::list<Events::Event> EventQueue;
-	typedef std::multiset<Action> ActionQueue;
 
 
 	::Engines::Console *_console;
@@ -174,7 +156,8 @@ private:
 	std::unique_ptr<Area> _area; ///< The current module's area.
 
 	EventQueue  _eventQueue;
-	ActionQueue _delayedActions;
+	::Engines::ScriptScheduler _delayedActions;
+	::Engines::ScriptQueue     _scriptQueue;
 
 
 	// .--- Unloading
@@ -420,6 +420,17 @@ void Area::loadProperties(const Aurora::GFF3Struct &props) {
 
 void Area::loadRooms() {
 	const Aurora::LYTFile::RoomArray &rooms = _lyt.getRooms();
+
+	// Read all room models and walkmeshes in the background, while we're still constructing the first rooms
+	for (Aurora::LYTFile::RoomArray::const_iterator r = rooms.begin(); r != rooms.end(); ++r) {
+		if (r->model == "****")
+			continue;
+
+		ResMan.prefetch(r->model, Aurora::kFileTypeMDL);
+		ResMan.prefetch(r->model, Aurora::kFileTypeMDX);
+		ResMan.prefetch(r->model, Aurora::kFileTypeWOK);
+	}
+
 	for (Aurora::LYTFile::RoomArray::const_iterator r = rooms.begin(); r != rooms.end(); ++r) {
 		_rooms.emplace_back(std::make_unique<Room>(r->model, r->x, r->y, r->z));
 		_pathfinding->addRoom(_rooms.back().get());
@@ -72,10 +72,6 @@ namespace Engines {
 
 namespace KotORBase {
 
-bool Module::Action::operator<(const Action &s) const {
-	return timestamp < s.timestamp;
-}
-
 Module::DelayedConversation::DelayedConversation(const Common::UString &_name, Aurora::NWScript::Object *_owner) :
 		name(_name),
 		owner(_owner) {
@@ -369,6 +365,7 @@ void Module::unload(bool completeUnload) {
 
 	_eventQueue.clear();
 	_delayedActions.clear();
+	_scriptQueue.clear();
 
 	_newModule.clear();
 	_hasModule = false;
@@ -757,20 +754,15 @@ void Module::notifyCombatRoundEnded(int UNUSED(round)) {
 }
 
 void Module::handleActions() {
-	uint32_t now = EventMan.getTimestamp();
-
-	while (!_delayedActions.empty()) {
-		ActionQueue::iterator action = _delayedActions.begin();
-
-		if (now < action->timestamp)
-			break;
+	// Scripts triggered by the player go first, the others might have to wait for a later frame
+	_delayedActions.update(EventMan.getTimestamp(), [this](::Engines::ScriptScheduler::Action &action) {
+		const ::Engines::ScriptQueue::Priority priority = (_pc && (*action.triggerer == _pc)) ?
+			::Engines::ScriptQueue::kPriorityPlayer : ::Engines::ScriptQueue::kPriorityAmbient;
 
-		if (action->type == kActionScript)
-			ScriptContainer::runScript(action->script, action->state,
-			                           action->owner, action->triggerer);
+		_scriptQueue.add(priority, action.script, std::move(action.state), action.owner, action.triggerer);
+	});
 
-		_delayedActions.erase(action);
-	}
+	_scriptQueue.run();
 }
 
 void Module::moveParty(float x, float y, float z) {
@@ -975,19 +967,10 @@ void Module::setRunScriptVar(int runScriptVar) {
 }
 
 void Module::delayScript(const Common::UString &script,
-                         const Aurora::NWScript::ScriptState &state,
+                         Aurora::NWScript::ScriptState &&state,
                          Aurora::NWScript::Object *owner,
                          Aurora::NWScript::Object *triggerer, uint32_t delay) {
-	Action action;
-
-	action.type      = kActionScript;
-	action.script    = script;
-	action.state     = state;
-	action.owner     = owner;
-	action.triggerer = triggerer;
-	action.timestamp = EventMan.getTimestamp() + delay;
-
-	_delayedActions.insert(action);
+	_delayedActions.add(EventMan.getTimestamp() + delay, script, std::move(state), owner, triggerer);
 }
 
 void Module::signalUserDefinedEvent(Object *owner, int number) {
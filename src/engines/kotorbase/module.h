@@ -26,7 +26,6 @@
 #define ENGINES_KOTORBASE_MODULE_H
 
 #include <list>
-#include <set>
 
 #include <memory>
 #include "src/common/ustring.h"
@@ -41,6 +40,9 @@
 
 #include "src/events/types.h"
 
+#include "src/engines/aurora/scriptscheduler.h"
+#include "src/engines/aurora/scriptqueue.h"
+
 #include "src/engines/kotorbase/object.h"
 #include "src/engines/kotorbase/objectcontainer.h"
 #include "src/engines/kotorbase/savedgame.h"
@@ -124,7 +126,7 @@ public:
 	void setRunScriptVar(int runScriptVar);
 
 	void delayScript(const Common::UString &script,
-	                 const Aurora::NWScript::ScriptState &state,
+	                 Aurora::NWScript::ScriptState &&state,
 	                 Aurora::NWScript::Object *owner, Aurora::NWScript::Object *triggerer,
 	                 uint32_t delay);
 
@@ -265,27 +267,7 @@ protected:
 	virtual KotORBase::Creature *createCreature(const Common::UString &resRef) const = 0;
 
 private:
-	enum ActionType {
-		kActionNone   = 0,
-		kActionScript = 1
-	};
-
-	struct Action {
-		ActionType type;
-
-		Common::UString script;
-
-		Aurora::NWScript::ScriptState state;
-		Aurora::NWScript::ObjectReference owner;
-		Aurora::NWScript::ObjectReference triggerer;
-
-		uint32_t timestamp;
-
-		bool operator<(const Action &s) const;
-	};
-
 	typedef std::list<Events::Event> EventQueue;
-	typedef std::multiset<Action> ActionQueue;
 
 	// Global values
 
@@ -339,7 +321,8 @@ private:
 	std::unique_ptr<Graphics::Aurora::FadeQuad> _fade;
 
 	EventQueue  _eventQueue;
-	ActionQueue _delayedActions;
+	::Engines::ScriptScheduler _delayedActions;
+	::Engines::ScriptQueue     _scriptQueue;
 
 	PartyLeaderController _partyLeaderController;
 	PartyController _partyController;
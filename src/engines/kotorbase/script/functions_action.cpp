@@ -59,9 +59,9 @@ void Functions::assignCommand(Aurora::NWScript::FunctionContext &ctx) {
 	if (script.empty())
 		throw Common::Exception("Functions::assignCommand(): Script needed");
 
-	const Aurora::NWScript::ScriptState &state = ctx.getParams()[1].getScriptState();
+	Aurora::NWScript::ScriptState &state = ctx.getParams()[1].getScriptState();
 
-	_game->getModule().delayScript(script, state, getParamObject(ctx, 0), ctx.getTriggerer(), 0);
+	_game->getModule().delayScript(script, std::move(state), getParamObject(ctx, 0), ctx.getTriggerer(), 0);
 }
 
 void Functions::delayCommand(Aurora::NWScript::FunctionContext &ctx) {
@@ -71,9 +71,9 @@ void Functions::delayCommand(Aurora::NWScript::FunctionContext &ctx) {
 
 	uint32_t delay = ctx.getParams()[0].getFloat() * 1000;
 
-	const Aurora::NWScript::ScriptState &state = ctx.getParams()[1].getScriptState();
+	Aurora::NWScript::ScriptState &state = ctx.getParams()[1].getScriptState();
 
-	_game->getModule().delayScript(script, state, ctx.getCaller(), ctx.getTriggerer(), delay);
+	_game->getModule().delayScript(script, std::move(state), ctx.getCaller(), ctx.getTriggerer(), delay);
 }
 
 void Functions::actionStartConversation(Aurora::NWScript::FunctionContext &ctx) {
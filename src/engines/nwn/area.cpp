@@ -23,11 +23,13 @@
  */
 
 #include <cassert>
+#include <set>
 
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/maths.h"
 
+#include "src/aurora/resman.h"
 #include "src/aurora/gff3file.h"
 #include "src/aurora/2dafile.h"
 #include "src/aurora/2dareg.h"
@@ -459,6 +461,14 @@ void Area::unloadTileset() {
 }
 
 void Area::loadTiles() {
+	// Read all tile models in the background, while we're still constructing the first tiles
+	std::set<Common::UString> tileModels;
+	for (uint32_t i = 0; i < _tiles.size(); i++)
+		tileModels.insert(_tileset->getTile(_tiles[i].tileID).model);
+
+	for (std::set<Common::UString>::const_iterator m = tileModels.begin(); m != tileModels.end(); ++m)
+		ResMan.prefetch(*m, Aurora::kFileTypeMDL);
+
 	for (uint32_t y = 0; y < _height; y++) {
 		for (uint32_t x = 0; x < _width; x++) {
 			uint32_t n = y * _width + x;
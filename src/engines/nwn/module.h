@@ -27,7 +27,6 @@
 
 #include <list>
 #include <map>
-#include <set>
 #include <memory>
 
 #include "src/common/ustring.h"
@@ -42,6 +41,8 @@
 #include "src/events/types.h"
 
 #include "src/engines/aurora/resources.h"
+#include "src/engines/aurora/scriptscheduler.h"
+#include "src/engines/aurora/scriptqueue.h"
 
 #include "src/engines/nwn/objectcontainer.h"
 #include "src/engines/nwn/object.h"
@@ -116,7 +117,7 @@ public:
 	// '---
 
 	void delayScript(const Common::UString &script,
-	                 const Aurora::NWScript::ScriptState &state,
+	                 Aurora::NWScript::ScriptState &&state,
 	                 Aurora::NWScript::Object *owner, Aurora::NWScript::Object *triggerer,
 	                 uint32_t delay);
 
@@ -152,29 +153,9 @@ public:
 	void toggleWalkmesh();
 
 private:
-	enum ActionType {
-		kActionNone   = 0,
-		kActionScript = 1
-	};
-
-	struct Action {
-		ActionType type;
-
-		Common::UString script;
-
-		Aurora::NWScript::ScriptState state;
-		Aurora::NWScript::ObjectReference owner;
-		Aurora::NWScript::ObjectReference triggerer;
-
-		uint32_t timestamp;
-
-		bool operator<(const Action &s) const;
-	};
-
 	typedef std::map<Common::UString, std::unique_ptr<Area>> AreaMap;
 
 	typedef std::list<Events::Event> EventQueue;
-	typedef std::multiset<Action> ActionQueue;
 
 
 	::Engines::Console *_console { nullptr };
@@ -211,7 +192,8 @@ private:
 	Common::UString _newModule; ///< The module we should change to.
 
 	EventQueue  _eventQueue;
-	ActionQueue _delayedActions;
+	::Engines::ScriptScheduler _delayedActions;
+	::Engines::ScriptQueue     _scriptQueue;
 
 	// Surface types
 	/** A map between surface type and walkability. */
@@ -173,6 +173,8 @@ void Pathfinding::finalize() {
 		}
 	}
 
+	buildRegions();
+
 	_loaded = true;
 }
 
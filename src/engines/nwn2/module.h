@@ -28,7 +28,6 @@
 #include <vector>
 #include <list>
 #include <map>
-#include <set>
 #include <memory>
 
 #include "src/common/ustring.h"
@@ -41,6 +40,9 @@
 
 #include "src/events/types.h"
 
+#include "src/engines/aurora/scriptscheduler.h"
+#include "src/engines/aurora/scriptqueue.h"
+
 #include "src/engines/nwn2/objectcontainer.h"
 #include "src/engines/nwn2/object.h"
 
@@ -95,7 +97,7 @@ public:
 	// '---
 
 	void delayScript(const Common::UString &script,
-	                 const Aurora::NWScript::ScriptState &state,
+	                 Aurora::NWScript::ScriptState &&state,
 	                 Aurora::NWScript::Object *owner, Aurora::NWScript::Object *triggerer,
 	                 uint32_t delay);
 
@@ -138,29 +140,9 @@ public:
 	// '---
 
 private:
-	enum ActionType {
-		kActionNone   = 0,
-		kActionScript = 1
-	};
-
-	struct Action {
-		ActionType type;
-
-		Common::UString script;
-
-		Aurora::NWScript::ScriptState state;
-		Aurora::NWScript::ObjectReference owner;
-		Aurora::NWScript::ObjectReference triggerer;
-
-		uint32_t timestamp;
-
-		bool operator<(const Action &s) const;
-	};
-
 	typedef std::map<Common::UString, std::unique_ptr<Area>> AreaMap;
 
 	typedef std::list<Events::Event> EventQueue;
-	typedef std::multiset<Action> ActionQueue;
 
 
 	::Engines::Console *_console { nullptr};
@@ -197,7 +179,8 @@ private:
 	Common::UString _newModule; ///< The module we should change to.
 
 	EventQueue  _eventQueue;
-	ActionQueue _delayedActions;
+	::Engines::ScriptScheduler _delayedActions;
+	::Engines::ScriptQueue     _scriptQueue;
 
 
 	// .--- Unloading
@@ -27,7 +27,6 @@
 
 #include <list>
 #include <map>
-#include <set>
 #include <memory>
 
 #include "src/common/ustring.h"
@@ -39,6 +38,9 @@
 
 #include "src/events/types.h"
 
+#include "src/engines/aurora/scriptscheduler.h"
+#include "src/engines/aurora/scriptqueue.h"
+
 #include "src/engines/witcher/objectcontainer.h"
 #include "src/engines/witcher/object.h"
 
@@ -86,7 +88,7 @@ public:
 	// '---
 
 	void delayScript(const Common::UString &script,
-	                 const Aurora::NWScript::ScriptState &state,
+	                 Aurora::NWScript::ScriptState &&state,
 	                 Aurora::NWScript::Object *owner, Aurora::NWScript::Object *triggerer,
 	                 uint32_t delay);
 
@@ -133,29 +135,9 @@ public:
 	// '---
 
 private:
-	enum ActionType {
-		kActionNone   = 0,
-		kActionScript = 1
-	};
-
-	struct Action {
-		ActionType type;
-
-		Common::UString script;
-
-		Aurora::NWScript::ScriptState state;
-		Aurora::NWScript::ObjectReference owner;
-		Aurora::NWScript::ObjectReference triggerer;
-
-		uint32_t timestamp;
-
-		bool operator<(const Action &s) const;
-	};
-
 	typedef std::map<Common::UString, std::unique_ptr<Area>> AreaMap;
 
 	typedef std::list<Events::Event> EventQueue;
-	typedef std::multiset<Action> ActionQueue;
 
 
 	::Engines::Console  *_console;
@@ -183,7 +165,8 @@ private:
 	Common::UString _entryLocation;
 
 	EventQueue  _eventQueue;
-	ActionQueue _delayedActions;
+	::Engines::ScriptScheduler _delayedActions;
+	::Engines::ScriptQueue     _scriptQueue;
 
 
 	// .--- Unloading
@@ -0,0 +1,423 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A dynamic bounding volume hierarchy of axis-aligned boxes.
+ */
+
+#include <cassert>
+#include <cmath>
+
+#include <utility>
+
+#include "external/glm/common.hpp"
+#include "external/glm/geometric.hpp"
+#include "external/glm/vector_relational.hpp"
+
+#include "src/common/util.h"
+
+#include "src/graphics/aabbtree.h"
+
+namespace Graphics {
+
+/** Half the surface area of a box, the cost of walking into it. */
+static float getCost(const glm::vec3 &min, const glm::vec3 &max) {
+	const glm::vec3 size = max - min;
+
+	return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+static float getCombinedCost(const glm::vec3 &minA, const glm::vec3 &maxA,
+                             const glm::vec3 &minB, const glm::vec3 &maxB) {
+
+	return getCost(glm::min(minA, minB), glm::max(maxA, maxB));
+}
+
+/** Does the segment start + t * direction, t in [0, 1], go through the box? */
+static bool intersectSegment(const glm::vec3 &start, const glm::vec3 &direction,
+                             const glm::vec3 &min, const glm::vec3 &max, float &t) {
+
+	float tMin = 0.0f, tMax = 1.0f;
+
+	for (int i = 0; i < 3; i++) {
+		if (std::fabs(direction[i]) < 1e-9f) {
+			// Parallel to the slab, so it has to start within
+			if ((start[i] < min[i]) || (start[i] > max[i]))
+				return false;
+
+			continue;
+		}
+
+		float t1 = (min[i] - start[i]) / direction[i];
+		float t2 = (max[i] - start[i]) / direction[i];
+		if (t1 > t2)
+			std::swap(t1, t2);
+
+		tMin = MAX(tMin, t1);
+		tMax = MIN(tMax, t2);
+
+		if (tMin > tMax)
+			return false;
+	}
+
+	t = tMin;
+	return true;
+}
+
+
+AABBTree::AABBTree(float margin) : _margin(margin), _root(kNull), _freeList(kNull), _count(0) {
+}
+
+AABBTree::~AABBTree() {
+}
+
+void AABBTree::clear() {
+	_nodes.clear();
+
+	_root     = kNull;
+	_freeList = kNull;
+	_count    = 0;
+}
+
+size_t AABBTree::getCount() const {
+	return _count;
+}
+
+size_t AABBTree::getHeight() const {
+	if (_root == kNull)
+		return 0;
+
+	return _nodes[_root].height + 1;
+}
+
+void *AABBTree::getData(uint32_t leaf) const {
+	assert((leaf < _nodes.size()) && _nodes[leaf].isLeaf());
+
+	return _nodes[leaf].data;
+}
+
+uint32_t AABBTree::insert(const float min[3], const float max[3], void *data) {
+	const uint32_t leaf = allocateNode();
+	Node &node = _nodes[leaf];
+
+	node.boxMin = glm::vec3(min[0], min[1], min[2]);
+	node.boxMax = glm::vec3(max[0], max[1], max[2]);
+	node.min    = node.boxMin - glm::vec3(_margin);
+	node.max    = node.boxMax + glm::vec3(_margin);
+	node.data   = data;
+	node.height = 0;
+
+	insertLeaf(leaf);
+
+	_count++;
+	return leaf;
+}
+
+void AABBTree::remove(uint32_t leaf) {
+	assert((leaf < _nodes.size()) && _nodes[leaf].isLeaf() && (_nodes[leaf].height == 0));
+
+	removeLeaf(leaf);
+	freeNode(leaf);
+
+	_count--;
+}
+
+bool AABBTree::move(uint32_t leaf, const float min[3], const float max[3]) {
+	assert((leaf < _nodes.size()) && _nodes[leaf].isLeaf() && (_nodes[leaf].height == 0));
+
+	Node &node = _nodes[leaf];
+
+	node.boxMin = glm::vec3(min[0], min[1], min[2]);
+	node.boxMax = glm::vec3(max[0], max[1], max[2]);
+
+	// Still within the fattened box, nothing to do
+	if (glm::all(glm::greaterThanEqual(node.boxMin, node.min)) &&
+	    glm::all(glm::lessThanEqual   (node.boxMax, node.max)))
+		return false;
+
+	removeLeaf(leaf);
+
+	node.min = node.boxMin - glm::vec3(_margin);
+	node.max = node.boxMax + glm::vec3(_margin);
+
+	insertLeaf(leaf);
+	return true;
+}
+
+void *AABBTree::rayCast(const glm::vec3 &start, const glm::vec3 &end, const RayTest &test) const {
+	if (_root == kNull)
+		return 0;
+
+	const glm::vec3 direction = end - start;
+
+	void *hit = 0;
+	float hitT = 2.0f;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(_root);
+
+	while (!stack.empty()) {
+		const Node &node = _nodes[stack.back()];
+		stack.pop_back();
+
+		float t;
+		if (!intersectSegment(start, direction, node.min, node.max, t) || (t >= hitT))
+			continue;
+
+		if (node.isLeaf()) {
+			if (!intersectSegment(start, direction, node.boxMin, node.boxMax, t) || (t >= hitT))
+				continue;
+
+			if (test(node.data)) {
+				hit  = node.data;
+				hitT = t;
+			}
+
+			continue;
+		}
+
+		// Visit the child closer to the start first, so that we can skip more
+		const Node &left  = _nodes[node.left];
+		const Node &right = _nodes[node.right];
+
+		const float distLeft  = glm::length((left.min  + left.max ) * 0.5f - start);
+		const float distRight = glm::length((right.min + right.max) * 0.5f - start);
+
+		if (distLeft < distRight) {
+			stack.push_back(node.right);
+			stack.push_back(node.left);
+		} else {
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+
+	return hit;
+}
+
+uint32_t AABBTree::allocateNode() {
+	uint32_t node = _freeList;
+
+	if (node != kNull) {
+		_freeList = _nodes[node].parent;
+	} else {
+		node = _nodes.size();
+		_nodes.push_back(Node());
+	}
+
+	_nodes[node].data   = 0;
+	_nodes[node].parent = kNull;
+	_nodes[node].left   = kNull;
+	_nodes[node].right  = kNull;
+	_nodes[node].height = 0;
+
+	return node;
+}
+
+void AABBTree::freeNode(uint32_t node) {
+	_nodes[node].data   = 0;
+	_nodes[node].parent = _freeList;
+	_nodes[node].left   = kNull;
+	_nodes[node].height = -1;
+
+	_freeList = node;
+}
+
+void AABBTree::insertLeaf(uint32_t leaf) {
+	if (_root == kNull) {
+		_root = leaf;
+		_nodes[leaf].parent = kNull;
+		return;
+	}
+
+	const glm::vec3 leafMin = _nodes[leaf].min;
+	const glm::vec3 leafMax = _nodes[leaf].max;
+
+	/* Walk down to the sibling that grows the tree's total surface the least.
+	 * Every step down also grows the node we step through by the inherited cost. */
+	uint32_t sibling = _root;
+	while (!_nodes[sibling].isLeaf()) {
+		const Node &node = _nodes[sibling];
+
+		const float combined    = getCombinedCost(node.min, node.max, leafMin, leafMax);
+		const float inheritance = combined - getCost(node.min, node.max);
+
+		// Cost of making a new parent for this node and the leaf
+		const float cost = combined;
+
+		float childCost[2];
+		const uint32_t children[2] = { node.left, node.right };
+
+		for (int i = 0; i < 2; i++) {
+			const Node &child = _nodes[children[i]];
+
+			childCost[i] = getCombinedCost(child.min, child.max, leafMin, leafMax) + inheritance;
+			if (!child.isLeaf())
+				childCost[i] -= getCost(child.min, child.max);
+		}
+
+		if ((cost < childCost[0]) && (cost < childCost[1]))
+			break;
+
+		sibling = (childCost[0] < childCost[1]) ? children[0] : children[1];
+	}
+
+	const uint32_t oldParent = _nodes[sibling].parent;
+	const uint32_t newParent = allocateNode();
+
+	Node &parent = _nodes[newParent];
+
+	parent.parent = oldParent;
+	parent.left   = sibling;
+	parent.right  = leaf;
+	parent.min    = glm::min(_nodes[sibling].min, leafMin);
+	parent.max    = glm::max(_nodes[sibling].max, leafMax);
+	parent.height = _nodes[sibling].height + 1;
+
+	if (oldParent != kNull) {
+		if (_nodes[oldParent].left == sibling)
+			_nodes[oldParent].left  = newParent;
+		else
+			_nodes[oldParent].right = newParent;
+	} else
+		_root = newParent;
+
+	_nodes[sibling].parent = newParent;
+	_nodes[leaf   ].parent = newParent;
+
+	refit(newParent);
+}
+
+void AABBTree::removeLeaf(uint32_t leaf) {
+	if (leaf == _root) {
+		_root = kNull;
+		return;
+	}
+
+	const uint32_t parent      = _nodes[leaf].parent;
+	const uint32_t grandParent = _nodes[parent].parent;
+	const uint32_t sibling     = (_nodes[parent].left == leaf) ? _nodes[parent].right : _nodes[parent].left;
+
+	_nodes[leaf].parent = kNull;
+
+	if (grandParent == kNull) {
+		_root = sibling;
+		_nodes[sibling].parent = kNull;
+
+		freeNode(parent);
+		return;
+	}
+
+	if (_nodes[grandParent].left == parent)
+		_nodes[grandParent].left  = sibling;
+	else
+		_nodes[grandParent].right = sibling;
+
+	_nodes[sibling].parent = grandParent;
+	freeNode(parent);
+
+	refit(grandParent);
+}
+
+void AABBTree::refit(uint32_t node) {
+	while (node != kNull) {
+		node = balance(node);
+
+		Node &n = _nodes[node];
+		const Node &left  = _nodes[n.left];
+		const Node &right = _nodes[n.right];
+
+		n.height = 1 + MAX(left.height, right.height);
+		n.min    = glm::min(left.min, right.min);
+		n.max    = glm::max(left.max, right.max);
+
+		node = n.parent;
+	}
+}
+
+uint32_t AABBTree::balance(uint32_t a) {
+	Node &nodeA = _nodes[a];
+	if (nodeA.isLeaf() || (nodeA.height < 2))
+		return a;
+
+	const uint32_t b = nodeA.left;
+	const uint32_t c = nodeA.right;
+
+	const int32_t diff = _nodes[c].height - _nodes[b].height;
+	if ((diff >= -1) && (diff <= 1))
+		return a;
+
+	/* Rotate the higher child up into A's place. A takes the lower of
+	 * the higher child's children, which keeps its other child. */
+
+	const bool rotateRight = diff > 1;
+
+	const uint32_t up    = rotateRight ? c : b;
+	const uint32_t other = rotateRight ? b : c;
+
+	Node &nodeUp = _nodes[up];
+
+	const uint32_t upLeft  = nodeUp.left;
+	const uint32_t upRight = nodeUp.right;
+
+	// The higher grandchild stays with the node moving up, the lower one goes to A
+	const bool     keepLeft = _nodes[upLeft].height > _nodes[upRight].height;
+	const uint32_t keep     = keepLeft ? upLeft  : upRight;
+	const uint32_t give     = keepLeft ? upRight : upLeft;
+
+	// Put the node moving up into A's place
+	nodeUp.parent = nodeA.parent;
+	if (nodeUp.parent != kNull) {
+		if (_nodes[nodeUp.parent].left == a)
+			_nodes[nodeUp.parent].left  = up;
+		else
+			_nodes[nodeUp.parent].right = up;
+	} else
+		_root = up;
+
+	nodeA.parent = up;
+
+	nodeUp.left  = a;
+	nodeUp.right = keep;
+
+	if (rotateRight)
+		nodeA.right = give;
+	else
+		nodeA.left  = give;
+
+	_nodes[give].parent = a;
+
+	const Node &nodeOther = _nodes[other];
+	const Node &nodeGive  = _nodes[give];
+	const Node &nodeKeep  = _nodes[keep];
+
+	nodeA.min    = glm::min(nodeOther.min, nodeGive.min);
+	nodeA.max    = glm::max(nodeOther.max, nodeGive.max);
+	nodeA.height = 1 + MAX(nodeOther.height, nodeGive.height);
+
+	nodeUp.min    = glm::min(nodeA.min, nodeKeep.min);
+	nodeUp.max    = glm::max(nodeA.max, nodeKeep.max);
+	nodeUp.height = 1 + MAX(nodeA.height, nodeKeep.height);
+
+	return up;
+}
+
+} // End of namespace Graphics
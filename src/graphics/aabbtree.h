@@ -0,0 +1,134 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A dynamic bounding volume hierarchy of axis-aligned boxes.
+ */
+
+#ifndef GRAPHICS_AABBTREE_H
+#define GRAPHICS_AABBTREE_H
+
+#include <vector>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "external/glm/vec3.hpp"
+
+#include "src/common/types.h"
+
+namespace Graphics {
+
+/** A dynamic bounding volume hierarchy of axis-aligned boxes.
+ *
+ *  Every box is stored in a leaf, together with an arbitrary pointer.
+ *  The leaves are fattened by a margin, so that small movements don't
+ *  need to touch the tree at all. Otherwise, a moving box is taken out
+ *  and reinserted, and the tree is rebalanced on the way back up, so
+ *  it stays logarithmic in height.
+ *
+ *  Unlike Common::AABBNode, which holds a static tree built once, the
+ *  nodes live in a pool and are addressed by index. The index of a
+ *  leaf stays valid until it's removed.
+ */
+class AABBTree : boost::noncopyable {
+public:
+	static const uint32_t kInvalidLeaf = 0xFFFFFFFF;
+
+	/** Decide whether the data of a leaf hit by a ray is a real hit. */
+	typedef std::function<bool(void *data)> RayTest;
+
+	/** Create a tree, fattening all boxes by this margin. */
+	AABBTree(float margin = 0.5f);
+	~AABBTree();
+
+	/** Remove all leaves. */
+	void clear();
+
+	/** Return the number of leaves. */
+	size_t getCount() const;
+	/** Return the height of the tree, 0 for an empty tree. */
+	size_t getHeight() const;
+
+	/** Add a box with a data pointer and return its leaf index. */
+	uint32_t insert(const float min[3], const float max[3], void *data);
+	/** Remove a leaf. */
+	void remove(uint32_t leaf);
+	/** Update the box of a leaf. Return true if the tree had to change. */
+	bool move(uint32_t leaf, const float min[3], const float max[3]);
+
+	/** Return the data pointer of a leaf. */
+	void *getData(uint32_t leaf) const;
+
+	/** Find the leaf closest to the start of the segment from start to end.
+	 *
+	 *  Leaves whose box the segment goes through are handed to the test,
+	 *  which decides whether the leaf's data is really hit. Only leaves
+	 *  closer than the closest hit found so far are tested.
+	 *
+	 *  @return The data pointer of the closest hit leaf, or 0 if there was none.
+	 */
+	void *rayCast(const glm::vec3 &start, const glm::vec3 &end, const RayTest &test) const;
+
+private:
+	static const uint32_t kNull = 0xFFFFFFFF;
+
+	struct Node {
+		glm::vec3 min; ///< Bounds, fattened for leaves.
+		glm::vec3 max; ///< Bounds, fattened for leaves.
+
+		glm::vec3 boxMin; ///< The real box of a leaf.
+		glm::vec3 boxMax; ///< The real box of a leaf.
+
+		void *data;
+
+		uint32_t parent; ///< The parent node, or the next free node.
+		uint32_t left;
+		uint32_t right;
+
+		int32_t height; ///< 0 for leaves, -1 for free nodes.
+
+		bool isLeaf() const { return left == kNull; }
+	};
+
+	float _margin;
+
+	std::vector<Node> _nodes;
+
+	uint32_t _root;
+	uint32_t _freeList;
+
+	size_t _count;
+
+	uint32_t allocateNode();
+	void freeNode(uint32_t node);
+
+	void insertLeaf(uint32_t leaf);
+	void removeLeaf(uint32_t leaf);
+
+	/** Refit and rebalance the ancestors of a node. */
+	void refit(uint32_t node);
+	/** Rotate the subtree under a node if it's unbalanced, and return its new root. */
+	uint32_t balance(uint32_t node);
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_AABBTREE_H
@@ -22,6 +22,8 @@
  *  An animation to be applied to a model.
  */
 
+#include <algorithm>
+
 #include "external/glm/gtc/type_ptr.hpp"
 #include "external/glm/gtc/matrix_transform.hpp"
 
@@ -74,21 +76,19 @@ void Animation::setTransTime(float transtime) {
 void Animation::update(Model *model,
                        float UNUSED(lastFrame),
                        float nextFrame,
-                       const std::vector<ModelNode *> &modelNodeMap) {
+                       NodeCursors &nodes) {
 	// TODO: Also need to fire off associated events
 	//       for event in _events event->fire()
 
 
 	float scale = model->getAnimationScale(_name);
-	for (NodeList::iterator n = nodeList.begin(); n != nodeList.end(); ++n) {
-		ModelNode *animNode = (*n)->_nodedata;
-		ModelNode *target = modelNodeMap[animNode->_nodeNumber];
-		if (!target)
-			continue;
+	for (NodeCursors::iterator n = nodes.begin(); n != nodes.end(); ++n) {
+		ModelNode *animNode = n->animNode;
+		ModelNode *target   = n->target;
 
 		// Update position and orientation based on time
 		if (!animNode->_positionFrames.empty()) {
-			glm::vec3 pos(interpolatePosition(animNode, nextFrame));
+			glm::vec3 pos(interpolatePosition(animNode->_positionFrames, nextFrame, n->positionFrame));
 
 			if (model->arePositionFramesRelative())
 				pos += target->getBasePosition();
@@ -99,7 +99,7 @@ void Animation::update(Model *model,
 		}
 
 		if (!animNode->_orientationFrames.empty()) {
-			glm::quat ori(interpolateOrientation(animNode, nextFrame));
+			glm::quat ori(interpolateOrientation(animNode->_orientationFrames, nextFrame, n->orientationFrame));
 			target->setBufferedOrientation(ori.x, ori.y, ori.z, Common::rad2deg(acosf(ori.w) * 2.0f));
 		}
 	}
@@ -153,27 +153,44 @@ static void normQuaternion(float  xIn , float  yIn , float  zIn , float  qIn,
 	qOut = qIn / magnitude;
 }
 
-glm::vec3 Animation::interpolatePosition(ModelNode *animNode, float time) const {
-	// If only one keyframe, don't interpolate, just set the only position
-	if (animNode->_positionFrames.size() == 1) {
-		const PositionKeyFrame &pos = animNode->_positionFrames[0];
-		return glm::vec3(pos.x, pos.y, pos.z);
+/** The number of keyframes we step forward from the cursor before giving up and searching. */
+static const size_t kMaxCursorSteps = 4;
+
+/** Find the keyframe to interpolate from: the last one before time, or the first one.
+ *
+ *  Starts from the keyframe played last, which is usually the right one or close
+ *  to it. If the time jumped backwards or too far ahead, search for the keyframe.
+ */
+template<typename KeyFrame>
+static size_t findKeyFrame(const std::vector<KeyFrame> &frames, float time, size_t &frame) {
+	if ((frame < frames.size()) && ((frame == 0) || (frames[frame].time < time))) {
+		for (size_t i = 0; i < kMaxCursorSteps; i++, frame++)
+			if (((frame + 1) >= frames.size()) || (frames[frame + 1].time >= time))
+				return frame;
 	}
 
-	size_t lastFrame = 0;
-	for (size_t i = 0; i < animNode->_positionFrames.size(); i++) {
-		const PositionKeyFrame &pos = animNode->_positionFrames[i];
-		if (pos.time >= time)
-			break;
+	typename std::vector<KeyFrame>::const_iterator next =
+		std::lower_bound(frames.begin(), frames.end(), time,
+		                 [](const KeyFrame &f, float t) { return f.time < t; });
 
-		lastFrame = i;
+	frame = (next == frames.begin()) ? 0 : ((next - frames.begin()) - 1);
+	return frame;
+}
+
+glm::vec3 Animation::interpolatePosition(const std::vector<PositionKeyFrame> &frames, float time, size_t &frame) {
+	// If only one keyframe, don't interpolate, just set the only position
+	if (frames.size() == 1) {
+		const PositionKeyFrame &pos = frames[0];
+		return glm::vec3(pos.x, pos.y, pos.z);
 	}
 
-	const PositionKeyFrame &last = animNode->_positionFrames[lastFrame];
-	if (lastFrame + 1 >= animNode->_positionFrames.size() || last.time >= time)
+	const size_t lastFrame = findKeyFrame(frames, time, frame);
+
+	const PositionKeyFrame &last = frames[lastFrame];
+	if (lastFrame + 1 >= frames.size() || last.time >= time)
 		return glm::vec3(last.x, last.y, last.z);
 
-	const PositionKeyFrame &next = animNode->_positionFrames[lastFrame + 1];
+	const PositionKeyFrame &next = frames[lastFrame + 1];
 
 	const float f = (time - last.time) / (next.time - last.time);
 	const float x = f * next.x + (1.0f - f) * last.x;
@@ -183,35 +200,29 @@ glm::vec3 Animation::interpolatePosition(ModelNode *animNode, float time) const
 	return glm::vec3(x, y, z);
 }
 
-glm::quat Animation::interpolateOrientation(ModelNode *animNode, float time) const {
+glm::quat Animation::interpolateOrientation(const std::vector<QuaternionKeyFrame> &frames, float time, size_t &frame) {
 	// If only one keyframe, don't interpolate just set the only orientation
-	if (animNode->_orientationFrames.size() == 1) {
-		const QuaternionKeyFrame &ori = animNode->_orientationFrames[0];
+	if (frames.size() == 1) {
+		const QuaternionKeyFrame &ori = frames[0];
 		return glm::quat(ori.q, ori.x, ori.y, ori.z);
 	}
 
-	size_t lastFrame = 0;
-	for (size_t i = 0; i < animNode->_orientationFrames.size(); i++) {
-		const QuaternionKeyFrame &ori = animNode->_orientationFrames[i];
-		if (ori.time >= time)
-			break;
-
-		lastFrame = i;
-	}
+	const size_t lastFrame = findKeyFrame(frames, time, frame);
 
-	const QuaternionKeyFrame &last = animNode->_orientationFrames[lastFrame];
-	if (lastFrame + 1 >= animNode->_orientationFrames.size() || last.time >= time) {
+	const QuaternionKeyFrame &last = frames[lastFrame];
+	if (lastFrame + 1 >= frames.size() || last.time >= time) {
 		return glm::quat(last.q, last.x, last.y, last.z);
 	}
 
-	const QuaternionKeyFrame &next = animNode->_orientationFrames[lastFrame + 1];
+	const QuaternionKeyFrame &next = frames[lastFrame + 1];
 
 	const float f = (time - last.time) / (next.time - last.time);
 
-	/* If the angle is > 90°, we need to flip the direction of one quaternion to
-	   get a smooth transition instead of wild jumps. */
-	const float angle = acos(dotQuaternion(last.x, last.y, last.z, last.q, next.x, next.y, next.z, next.q));
-	const float dir   = (angle >= (M_PI / 2)) ? -1.0f : 1.0f;
+	/* If the angle is >= 90°, we need to flip the direction of one quaternion to
+	   get a smooth transition instead of wild jumps. That's the case exactly when
+	   the dot product isn't positive, so we don't need the angle itself. */
+	const float dot = dotQuaternion(last.x, last.y, last.z, last.q, next.x, next.y, next.z, next.q);
+	const float dir = (dot <= 0.0f) ? -1.0f : 1.0f;
 
 	float x = f * dir * next.x + (1.0f - f) * last.x;
 	float y = f * dir * next.y + (1.0f - f) * last.y;
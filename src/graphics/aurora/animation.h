@@ -27,6 +27,7 @@
 
 #include <list>
 #include <map>
+#include <vector>
 
 #include "external/glm/ext/quaternion_float.hpp"
 
@@ -49,8 +50,31 @@ namespace Aurora {
 
 class AnimNode;
 
+struct PositionKeyFrame;
+struct QuaternionKeyFrame;
+
 class Animation {
 public:
+	/** The playback state of one animated node, kept by the animation channel.
+	 *
+	 *  The keyframe indices are hints: when the playback time moves forward,
+	 *  the next keyframe is found by stepping from the hint. After a seek or
+	 *  a loop, the keyframe is found with a binary search.
+	 */
+	struct NodeCursor {
+		ModelNode *animNode; ///< The animation node holding the keyframes.
+		ModelNode *target;   ///< The model node that's animated.
+
+		size_t positionFrame;    ///< The position keyframe played last.
+		size_t orientationFrame; ///< The orientation keyframe played last.
+
+		NodeCursor(ModelNode *a = 0, ModelNode *t = 0) : animNode(a), target(t),
+			positionFrame(0), orientationFrame(0) {
+		}
+	};
+
+	typedef std::vector<NodeCursor> NodeCursors;
+
 	Animation();
 	virtual ~Animation();
 
@@ -64,8 +88,11 @@ public:
 
 	void setTransTime(float transtime);
 
-	/** Update the model position and orientation */
-	virtual void update(Model *model, float lastFrame, float nextFrame, const std::vector<ModelNode *> &modelNodeMap);
+	/** Update the model position and orientation.
+	 *
+	 *  Evaluates all animated nodes in one pass, advancing their cursors.
+	 */
+	virtual void update(Model *model, float lastFrame, float nextFrame, NodeCursors &nodes);
 
 	// Nodes
 
@@ -81,6 +108,25 @@ public:
 	/** Get all animation nodes. */
 	const std::list<AnimNode *> &getNodes() const;
 
+	// Keyframes
+
+	/** Interpolate the position at this time.
+	 *
+	 *  @param frames The position keyframes, sorted by time. Must not be empty.
+	 *  @param time   The playback time.
+	 *  @param frame  The keyframe played last, updated to the keyframe at or before time.
+	 */
+	static glm::vec3 interpolatePosition(const std::vector<PositionKeyFrame> &frames,
+	                                     float time, size_t &frame);
+	/** Interpolate the orientation at this time.
+	 *
+	 *  @param frames The orientation keyframes, sorted by time. Must not be empty.
+	 *  @param time   The playback time.
+	 *  @param frame  The keyframe played last, updated to the keyframe at or before time.
+	 */
+	static glm::quat interpolateOrientation(const std::vector<QuaternionKeyFrame> &frames,
+	                                        float time, size_t &frame);
+
 protected:
 	typedef std::list<AnimNode *> NodeList;
 	typedef std::map<Common::UString, AnimNode *, Common::UString::iless> NodeMap;
@@ -93,9 +139,6 @@ protected:
 	Common::UString _name; ///< The model's name.
 	float _length;
 	float _transtime;
-
-	glm::vec3 interpolatePosition(ModelNode *animNode, float time) const;
-	glm::quat interpolateOrientation(ModelNode *animNode, float time) const;
 };
 
 } // End of namespace Aurora
@@ -131,7 +131,7 @@ void AnimationChannel::manageAnimations(float dt) {
 
 	// The loop of the animation ended: make sure to play the last frame
 	if (lastFrame < _animationLoopLength && nextFrame >= _animationLoopLength) {
-		_currentAnimation->update(_model, lastFrame, _animationLoopLength, _modelNodeMap);
+		_currentAnimation->update(_model, lastFrame, _animationLoopLength, _nodeCursors);
 
 		_animationTime += dt;
 		_animationLoopTime = _animationLoopLength;
@@ -146,7 +146,7 @@ void AnimationChannel::manageAnimations(float dt) {
 		_nextAnimation = 0;
 
 		if (_currentAnimation)
-			_currentAnimation->update(_model, 0.0f, 0.0f, _modelNodeMap);
+			_currentAnimation->update(_model, 0.0f, 0.0f, _nodeCursors);
 
 		_model->createBound();
 		_manageMutex.unlock();
@@ -155,7 +155,7 @@ void AnimationChannel::manageAnimations(float dt) {
 
 	// Start the next loop of the animation
 	if (lastFrame >= _animationLoopLength) {
-		_currentAnimation->update(_model, 0.0f, 0.0f, _modelNodeMap);
+		_currentAnimation->update(_model, 0.0f, 0.0f, _nodeCursors);
 
 		lastFrame = 0.0f;
 		nextFrame = _animationSpeed * dt;
@@ -164,7 +164,7 @@ void AnimationChannel::manageAnimations(float dt) {
 	}
 
 	// Update the animation
-	_currentAnimation->update(_model, lastFrame, nextFrame, _modelNodeMap);
+	_currentAnimation->update(_model, lastFrame, nextFrame, _nodeCursors);
 
 	_animationTime += dt;
 	_animationLoopTime = nextFrame;
@@ -214,57 +214,44 @@ void AnimationChannel::setCurrentAnimation(Animation *anim) {
 	_animationLoopTime = 0.0f;
 
 	if (_currentAnimation)
-		makeModelNodeMap();
+		makeNodeCursors();
 }
 
-void AnimationChannel::makeModelNodeMap() {
+void AnimationChannel::makeNodeCursors() {
 	const std::list<AnimNode *> &animNodes = _currentAnimation->getNodes();
-	int maxNodeNumber = -1;
 
-	for (std::list<AnimNode *>::const_iterator n = animNodes.begin();
-			n != animNodes.end(); ++n) {
-		int nodeNumber = (*n)->getNodeData()->getNodeNumber();
-		if (nodeNumber > maxNodeNumber)
-			maxNodeNumber = nodeNumber;
-	}
-
-	_modelNodeMap.clear();
-
-	if (maxNodeNumber == -1)
-		return;
-
-	_modelNodeMap.resize(maxNodeNumber + 1, 0);
+	_nodeCursors.clear();
+	_nodeCursors.reserve(animNodes.size());
 
 	for (std::list<AnimNode *>::const_iterator an = animNodes.begin();
 			an != animNodes.end(); ++an) {
 		ModelNode *animNode = (*an)->getNodeData();
-		int nodeNumber = animNode->getNodeNumber();
 		const Common::UString &animNodeName = animNode->getName();
 
+		ModelNode *target = 0;
+
 		// Search for the corresponding node in this model
 		Model::NodeMap::iterator n = _model->_currentState->nodeMap.find(animNodeName);
-		if (n != _model->_currentState->nodeMap.end()) {
-			_modelNodeMap[nodeNumber] = n->second;
-			continue;
-		}
+		if (n != _model->_currentState->nodeMap.end())
+			target = n->second;
 
 		// Search for the corresponding node in this model's attached models
 		for (std::map<Common::UString, Model *>::iterator m = _model->_attachedModels.begin();
-				m != _model->_attachedModels.end(); ++m) {
+				!target && (m != _model->_attachedModels.end()); ++m) {
 			Model::State *state = m->second->_currentState;
 			if (!state)
 				continue;
 
 			n = state->nodeMap.find(animNodeName);
-			if (n != state->nodeMap.end()) {
-				_modelNodeMap[nodeNumber] = n->second;
-				break;
-			}
+			if (n != state->nodeMap.end())
+				target = n->second;
 		}
 
-		// Search for the corresponding node in this model's super model
-		if (_model->_superModel && !_modelNodeMap[nodeNumber])
-			_modelNodeMap[nodeNumber] = _model->_superModel->getNode(animNodeName);
+		/* We don't animate nodes only found in the super model: the super model
+		   is shared between all models inheriting from it, and its nodes are
+		   never flushed. Animating them would only race with other models. */
+		if (target)
+			_nodeCursors.push_back(Animation::NodeCursor(animNode, target));
 	}
 }
 
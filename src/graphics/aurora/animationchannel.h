@@ -30,13 +30,13 @@
 
 #include "src/common/mutex.h"
 
+#include "src/graphics/aurora/animation.h"
+
 namespace Graphics {
 
 namespace Aurora {
 
 class Model;
-class ModelNode;
-class Animation;
 
 class AnimationChannel {
 public:
@@ -91,13 +91,13 @@ private:
 	float _animationLoopLength; ///< The length of one loop of the current animation.
 	float _animationLoopTime; ///< The time the current loop of the current animation has played.
 	DefaultAnimations _defaultAnimations;
-	std::vector<ModelNode *> _modelNodeMap;
+	Animation::NodeCursors _nodeCursors; ///< The nodes of the current animation, and where they are in it.
 	std::recursive_mutex _manageMutex;
 
 	void playDefaultAnimationInternal();
 	Animation *selectDefaultAnimation();
 	void setCurrentAnimation(Animation *anim);
-	void makeModelNodeMap();
+	void makeNodeCursors();
 };
 
 } // End of namespace Aurora
@@ -22,12 +22,11 @@
  *  Dedicated animation thread.
  */
 
-#include "external/glm/gtc/type_ptr.hpp"
+#include "src/common/util.h"
+#include "src/common/threadpool.h"
 
 #include "src/events/events.h"
 
-#include "src/graphics/camera.h"
-
 #include "src/graphics/aurora/animationthread.h"
 #include "src/graphics/aurora/model.h"
 
@@ -38,9 +37,22 @@ namespace Aurora {
 const int kPauseDuration = 10;
 const int kYieldDuration = 1;
 
+/** The number of models each thread updates per batch.
+ *
+ *  The renderer waits for the current batch to finish before it can flush,
+ *  so a batch should be small.
+ */
+const size_t kModelsPerThread = 4;
+
 AnimationThread::PoolModel::PoolModel(Model *m) : model(m) {
 }
 
+AnimationThread::AnimationThread() {
+}
+
+AnimationThread::~AnimationThread() {
+}
+
 void AnimationThread::pause() {
 	PauseStatus expected = kPauseResumed;
 	if (!_pause.compare_exchange_strong(expected, kPauseRequested, std::memory_order_seq_cst))
@@ -90,6 +102,11 @@ void AnimationThread::flush() {
 }
 
 void AnimationThread::threadMethod() {
+	// This thread updates models as well, so we need one worker less than there are cores
+	const size_t workerCount = Common::ThreadPool::getHardwareThreadCount() - 1;
+	if (workerCount > 0)
+		_workers = std::make_unique<Common::ThreadPool>(workerCount, "Animations");
+
 	while (!_killThread.load(std::memory_order_relaxed)) {
 		if (EventMan.quitRequested())
 			break;
@@ -108,31 +125,52 @@ void AnimationThread::threadMethod() {
 			continue;
 		}
 
-		for (auto &m : _models) {
-			if (EventMan.quitRequested() || (_pause.load(std::memory_order_seq_cst) == kPausePaused))
-				break;
+		updateModels();
+	}
 
-			if (m.second.skippedCount < getNumIterationsToSkip(m.second.model)) {
-				++m.second.skippedCount;
-				continue;
-			} else {
-				m.second.skippedCount = 0;
-			}
+	_workers.reset();
+}
 
-			handleFlush();
+void AnimationThread::updateModels() {
+	_updates.clear();
+	for (auto &m : _models)
+		_updates.push_back(&m.second);
 
-			uint32_t now = EventMan.getTimestamp();
-			float dt = 0;
-			if (m.second.lastChanged > 0) {
-				dt = (now - m.second.lastChanged) / 1000.0f;
-			}
-			m.second.lastChanged = now;
+	const size_t threadCount = (_workers ? _workers->getThreadCount() : 0) + 1;
+	const size_t batchSize   = threadCount * kModelsPerThread;
 
-			m.second.model->manageAnimations(dt);
+	for (size_t start = 0; start < _updates.size(); start += batchSize) {
+		if (EventMan.quitRequested() || (_pause.load(std::memory_order_seq_cst) == kPausePaused))
+			break;
+
+		// No model is being updated between batches, so this is where we let the renderer flush
+		handleFlush();
+
+		const size_t end = MIN(start + batchSize, _updates.size());
+
+		/* Each thread takes the next model nobody has taken yet, so a thread
+		 * stuck with a model that takes long to update doesn't hold up the
+		 * others. An exception thrown while updating a model is rethrown here. */
+		if (_workers && ((end - start) > 1)) {
+			_workers->parallelFor(end - start, [this, start](size_t i) { updateModel(*_updates[start + i]); });
+		} else {
+			for (size_t i = start; i < end; i++)
+				updateModel(*_updates[i]);
 		}
 	}
 }
 
+void AnimationThread::updateModel(PoolModel &m) {
+	uint32_t now = EventMan.getTimestamp();
+	float dt = 0;
+	if (m.lastChanged > 0) {
+		dt = (now - m.lastChanged) / 1000.0f;
+	}
+	m.lastChanged = now;
+
+	m.model->manageAnimations(dt);
+}
+
 void AnimationThread::registerQueuedModels() {
 	std::unique_lock<std::recursive_mutex> lock(_registerMutex, std::try_to_lock);
 	if (!lock.owns_lock())
@@ -156,16 +194,6 @@ void AnimationThread::unregisterModelInternal(Model *model) {
 	_models.erase(model->getID());
 }
 
-uint8_t AnimationThread::getNumIterationsToSkip(Model *model) const {
-	const float *campos = CameraMan.getPosition();
-
-	float x, y, z;
-	model->getPosition(x, y, z);
-
-	float dist = glm::distance(glm::make_vec3(campos), glm::vec3(x, y, z));
-	return roundf(dist) / 8.0f;
-}
-
 bool AnimationThread::handlePause() {
 	if (_pause.load(std::memory_order_seq_cst) == kPausePaused) {
 		EventMan.delay(kPauseDuration);
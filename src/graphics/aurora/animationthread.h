@@ -27,22 +27,34 @@
 
 #include <map>
 #include <queue>
+#include <vector>
+#include <memory>
 #include <atomic>
 
-#include "external/glm/vec3.hpp"
-#include "external/glm/vec4.hpp"
-
 #include "src/common/thread.h"
 #include "src/common/mutex.h"
 
+namespace Common {
+	class ThreadPool;
+}
+
 namespace Graphics {
 
 namespace Aurora {
 
 class Model;
 
+/** The thread updating the animations of all visible models.
+ *
+ *  The models are updated in small batches. Within a batch, this thread and
+ *  a pool of worker threads each take the next model not yet updated, until
+ *  none are left. Buffered changes are flushed between batches.
+ */
 class AnimationThread : public Common::Thread {
 public:
+	AnimationThread();
+	~AnimationThread();
+
 	void pause();
 	void resume();
 
@@ -72,7 +84,6 @@ private:
 	struct PoolModel {
 		Model *model;
 		uint32_t lastChanged { 0 };
-		uint8_t skippedCount { 0 }; ///< Number of skipped loop iterations.
 
 		PoolModel(Model *m);
 	};
@@ -89,6 +100,10 @@ private:
 	std::recursive_mutex _modelsMutex;   ///< Mutex protecting access to the model map.
 	std::recursive_mutex _registerMutex; ///< Mutex protecting access to the registration queue.
 
+	std::unique_ptr<Common::ThreadPool> _workers; ///< Threads helping to update the models.
+
+	std::vector<PoolModel *> _updates; ///< All models to update in this pass.
+
 	// Model registration
 
 	void registerQueuedModels();
@@ -97,7 +112,8 @@ private:
 
 
 	void threadMethod();
-	uint8_t getNumIterationsToSkip(Model *model) const;
+	void updateModels();
+	void updateModel(PoolModel &m);
 	bool handlePause();
 	void handleFlush();
 };
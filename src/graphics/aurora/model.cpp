@@ -159,6 +159,16 @@ bool Model::isIn(float x1, float y1, float z1, float x2, float y2, float z2) con
 	return _absoluteBoundBox.isIn(x1, y1, z1, x2, y2, z2);
 }
 
+bool Model::getWorldBound(float min[3], float max[3]) const {
+	if ((_type != kModelTypeObject) || _absoluteBoundBox.empty())
+		return false;
+
+	_absoluteBoundBox.getMin(min[0], min[1], min[2]);
+	_absoluteBoundBox.getMax(max[0], max[1], max[2]);
+
+	return true;
+}
+
 float Model::getWidth() const {
 	return _boundBox.getWidth() * _scale[0];
 }
@@ -315,6 +325,8 @@ void Model::createAbsolutePosition() {
 	_absoluteBoundBox = _boundBox;
 	_absoluteBoundBox.transform(_absolutePosition);
 	_absoluteBoundBox.absolutize();
+
+	updatePickable();
 }
 
 const std::list<Common::UString> &Model::getStates() const {
@@ -894,6 +906,8 @@ void Model::createBound() {
 	_absoluteBoundBox = _boundBox;
 	_absoluteBoundBox.transform(_absolutePosition);
 	_absoluteBoundBox.absolutize();
+
+	updatePickable();
 }
 
 void Model::readValue(Common::SeekableReadStream &stream, uint32_t &value) {
@@ -93,6 +93,9 @@ public:
 	/** Does the line from x1.y1.z1 to x2.y2.z2 intersect with model's bounding box? */
 	bool isIn(float x1, float y1, float z1, float x2, float y2, float z2) const;
 
+	/** Get the model's absolute bounding box in world space. */
+	bool getWorldBound(float min[3], float max[3]) const;
+
 	// Positioning
 
 	/** Get the current scale of the model. */
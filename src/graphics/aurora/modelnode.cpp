@@ -457,15 +457,26 @@ void ModelNode::loadTextures(const std::vector<Common::UString> &textures) {
 
 	Common::UString envMap;
 
+	/* Request all textures first, before looking at any of them. If the
+	 * textures are decoded in the background, they're all decoded at once. */
 	for (size_t t = 0; t != textures.size(); t++) {
 
 		try {
 
-			if (!textures[t].empty() && (textures[t] != "NULL")) {
+			if (!textures[t].empty() && (textures[t] != "NULL"))
 				_mesh->data->textures[t] = TextureMan.get(textures[t]);
-				if (_mesh->data->textures[t].empty())
-					continue;
 
+		} catch (...) {
+			Common::exceptionDispatcherWarning();
+		}
+
+	}
+
+	for (size_t t = 0; t != textures.size(); t++) {
+
+		try {
+
+			if (!_mesh->data->textures[t].empty()) {
 				hasTexture = true;
 
 				if (!_mesh->data->textures[t].getTexture().hasAlpha())
@@ -1176,6 +1187,35 @@ TextureHandle *ModelNode::getEnvironmentMap(EnvironmentMapMode &mode) {
 	return rval;
 }
 
+/** Create the instanced variant of a model's shader program, for drawing
+ *  many copies of the same mesh at once. */
+static void setupInstancing(Shader::ShaderDescriptor &cripter, Shader::ShaderProgram *program) {
+	if (!program || program->instanced || !GfxMan.supportInstancing())
+		return;
+
+	cripter.declareInput(Shader::ShaderDescriptor::INPUT_INSTANCE);
+
+	Common::UString vertexShaderName;
+	Common::UString fragmentShaderName;
+	cripter.genName(vertexShaderName);
+	fragmentShaderName = vertexShaderName + ".frag";
+	vertexShaderName += ".vert";
+
+	Shader::ShaderObject *vertexObject = ShaderMan.getShaderObject(vertexShaderName, Shader::SHADER_VERTEX);
+	Shader::ShaderObject *fragmentObject = ShaderMan.getShaderObject(fragmentShaderName, Shader::SHADER_FRAGMENT);
+
+	if (!vertexObject) {
+		Common::UString vertexStringFinal;
+		Common::UString fragmentStringFinal;
+
+		cripter.build(true, vertexStringFinal, fragmentStringFinal);
+		vertexObject = ShaderMan.getShaderObject(vertexShaderName, vertexStringFinal, Shader::SHADER_VERTEX);
+		fragmentObject = ShaderMan.getShaderObject(fragmentShaderName, fragmentStringFinal, Shader::SHADER_FRAGMENT);
+	}
+
+	program->instanced = ShaderMan.registerShaderProgram(vertexObject, fragmentObject);
+}
+
 void ModelNode::buildMaterial() {
 	_renderableArray.clear();
 
@@ -1251,6 +1291,7 @@ void ModelNode::buildMaterial() {
 	if (config.material) {
 		surface = SurfaceMan.getSurface(config.materialName);
 		_renderableArray.push_back(Shader::ShaderRenderable(surface, config.material, _mesh->data->rawMesh));
+		setupInstancing(cripter, _renderableArray.back().getProgram());
 		return;
 	}
 
@@ -1298,6 +1339,7 @@ void ModelNode::buildMaterial() {
 	bindTexturesToSamplers(config, cripter);
 
 	_renderableArray.push_back(Shader::ShaderRenderable(surface, config.material, _mesh->data->rawMesh));
+	setupInstancing(cripter, _renderableArray.back().getProgram());
 }
 
 void ModelNode::declareShaderInputs(MaterialConfiguration &UNUSED(config), Shader::ShaderDescriptor &cripter) {
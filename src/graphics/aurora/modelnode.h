@@ -36,6 +36,7 @@
 #include "src/graphics/types.h"
 #include "src/graphics/indexbuffer.h"
 #include "src/graphics/vertexbuffer.h"
+#include "src/graphics/skinning.h"
 
 #include "src/graphics/aurora/types.h"
 #include "src/graphics/aurora/texturehandle.h"
@@ -190,6 +191,11 @@ public:
 		std::vector<float>       boneMappingId;
 		std::vector<ModelNode *> boneNodeMap;
 
+		/** The vertices, prepared for skinning on the CPU. */
+		SkinningVertices vertices;
+		/** Scratch space for the combined skinning matrix of each bone. */
+		std::vector<glm::mat4> boneMatrices;
+
 		Skin();
 	};
 
@@ -25,6 +25,8 @@
 #include "external/glm/gtc/type_ptr.hpp"
 #include "external/glm/gtc/matrix_transform.hpp"
 
+#include "src/graphics/skinning.h"
+
 #include "src/graphics/aurora/skeletalanimation.h"
 #include "src/graphics/aurora/model.h"
 #include "src/graphics/aurora/animnode.h"
@@ -41,9 +43,9 @@ SkeletalAnimation::SkeletalAnimation(int bonesPerVertex) :
 void SkeletalAnimation::update(Model *model,
                                float lastFrame,
                                float nextFrame,
-                               const std::vector<ModelNode *> &modelNodeMap) {
+                               NodeCursors &nodes) {
 
-	Animation::update(model, lastFrame, nextFrame, modelNodeMap);
+	Animation::update(model, lastFrame, nextFrame, nodes);
 	updateModel(model, lastFrame);
 }
 
@@ -51,23 +53,18 @@ void SkeletalAnimation::updateModel(Model *model, float time) {
 	if (!model->hasSkinNodes())
 		return;
 
+	model->computeNodeTransforms();
+
 	for (const auto &n : model->getNodes()) {
 		if (!n->hasSkinNode())
 			continue;
 
-		model->computeNodeTransforms();
-
 		if (GfxMan.isRendererExperimental()) {
 			fillBoneTransforms(n);
 			continue;
 		}
 
-		const std::vector<float> &vertsIn = n->getInitialVertexCoords();
-		const std::vector<float> &boneIndices = n->getBoneIndices();
-		const std::vector<float> &boneWeights = n->getBoneWeights();
-		VertexBuffer *vertexBuffer = n->getMesh()->data->rawMesh->getVertexBuffer();
-
-		transform(n, vertsIn, boneIndices, boneWeights, vertexBuffer);
+		transform(n, n->getMesh()->data->rawMesh->getVertexBuffer());
 
 		n->notifyVertexCoordsBuffered();
 	}
@@ -93,61 +90,36 @@ void SkeletalAnimation::fillBoneTransforms(ModelNode *node) {
 	}
 }
 
-void SkeletalAnimation::transform(ModelNode *node,
-                                  const std::vector<float> &vertsIn,
-                                  const std::vector<float> &boneIndices,
-                                  const std::vector<float> &boneWeights,
-                                  VertexBuffer *vertexBuffer) {
-
-	const int vertexCount = static_cast<int>(vertsIn.size()) / 3;
-	const float *vertsInData = vertsIn.data();
-
-	const float *boneIndicesData = boneIndices.data();
-	const float *boneWeightsData = boneWeights.data();
-	const int boneStride = _bonesPerVertex;
+void SkeletalAnimation::transform(ModelNode *node, VertexBuffer *vertexBuffer) {
+	ModelNode::Skin *skin = node->getMesh()->skin;
 
-	float *bufferData = static_cast<float *>(vertexBuffer->getData());
-	const int bufferStride = static_cast<int>(vertexBuffer->getVertexDecl()[0].stride) / sizeof(float);
-
-	for (int i = 0; i < vertexCount; ++i) {
-		bufferData[0] = 0.0f;
-		bufferData[1] = 0.0f;
-		bufferData[2] = 0.0f;
-
-		for (int j = 0; j < _bonesPerVertex; ++j) {
-			const int boneIndex = static_cast<int>(boneIndicesData[j]);
-			if (boneIndex == -1)
-				continue;
+	SkinningVertices &vertices = skin->vertices;
+	if (vertices.empty())
+		vertices.set(node->getInitialVertexCoords(), node->getBoneIndices(), node->getBoneWeights(), _bonesPerVertex);
 
-			const glm::mat4 &boneTransform = node->getBoneNode(boneIndex)->getBoneTransform();
-			const float boneWeight = boneWeightsData[j];
-			float v0[3], v1[3];
+	// Combine the transformations of each bone: into the base space, by the bone, and back
+	const glm::mat4 &baseTransform = node->getAbsoluteBaseTransform();
+	const glm::mat4 &baseTransformInverse = node->getAbsoluteBaseTransformInverse();
 
-			multiply(vertsInData, node->getAbsoluteBaseTransform(), v0);
-			multiply(v0, boneTransform, v1);
-			multiply(v1, node->getAbsoluteBaseTransformInverse(), v0);
+	/* The animation is shared by all models using it, through the supermodel cache.
+	   The scratch space for the bones belongs to the model's node. */
+	std::vector<glm::mat4> &boneMatrices = skin->boneMatrices;
 
-			bufferData[0] += v0[0] * boneWeight;
-			bufferData[1] += v0[1] * boneWeight;
-			bufferData[2] += v0[2] * boneWeight;
+	boneMatrices.resize(vertices.getBoneCount());
+	for (size_t i = 0; i < boneMatrices.size(); ++i) {
+		ModelNode *boneNode = (i < skin->boneNodeMap.size()) ? skin->boneNodeMap[i] : nullptr;
+		if (!boneNode) {
+			boneMatrices[i] = glm::mat4(1.0f);
+			continue;
 		}
 
-		vertsInData += 3;
-		boneIndicesData += boneStride;
-		boneWeightsData += boneStride;
-		bufferData += bufferStride;
+		boneMatrices[i] = baseTransformInverse * boneNode->getBoneTransform() * baseTransform;
 	}
-}
 
-void SkeletalAnimation::multiply(const float *v, const glm::mat4 &m, float *vOut) {
-	float x = v[0] * m[0][0] + v[1] * m[1][0] + v[2] * m[2][0] + m[3][0];
-	float y = v[0] * m[0][1] + v[1] * m[1][1] + v[2] * m[2][1] + m[3][1];
-	float z = v[0] * m[0][2] + v[1] * m[1][2] + v[2] * m[2][2] + m[3][2];
-	float w = v[0] * m[0][3] + v[1] * m[1][3] + v[2] * m[2][3] + m[3][3];
+	float *bufferData = static_cast<float *>(vertexBuffer->getData());
+	const size_t bufferStride = vertexBuffer->getVertexDecl()[0].stride / sizeof(float);
 
-	vOut[0] = x / w;
-	vOut[1] = y / w;
-	vOut[2] = z / w;
+	vertices.skin(boneMatrices.empty() ? nullptr : glm::value_ptr(boneMatrices[0]), bufferData, bufferStride);
 }
 
 } // End of namespace Aurora
@@ -47,7 +47,7 @@ public:
 	void update(Model *model,
 	            float lastFrame,
 	            float nextFrame,
-	            const std::vector<ModelNode *> &modelNodeMap);
+	            NodeCursors &nodes);
 
 private:
 	int _bonesPerVertex;
@@ -58,19 +58,9 @@ private:
 	/** Transform vertex coordinates.
 	 *
 	 *  @param node         Model node whose vertices are being transformed.
-	 *  @param vertsIn      Input array of vertex coordinates.
-	 *  @param boneIndices  Array of bone indices.
-	 *  @param boneWeights  Array of bone weights.
 	 *  @param vertexBuffer Vertex buffer to receive transformed vertex coordinates.
 	 */
-	void transform(ModelNode *node,
-	               const std::vector<float> &vertsIn,
-	               const std::vector<float> &boneIndices,
-	               const std::vector<float> &boneWeights,
-	               VertexBuffer *vertexBuffer);
-
-	/** Multiply a specified vector by a specified matrix. */
-	static void multiply(const float *v, const glm::mat4 &m, float *vOut);
+	void transform(ModelNode *node, VertexBuffer *vertexBuffer);
 };
 
 } // End of namespace Aurora
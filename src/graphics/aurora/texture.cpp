@@ -24,11 +24,16 @@
 
 #include <cassert>
 
+#include <atomic>
+#include <exception>
+
 #include "src/common/types.h"
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
 #include "src/common/readstream.h"
+#include "src/common/mutex.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/aurora/texture.h"
 #include "src/graphics/aurora/pltfile.h"
@@ -44,6 +49,7 @@
 #include "src/graphics/images/txb.h"
 #include "src/graphics/images/sbm.h"
 #include "src/graphics/images/xoreositex.h"
+#include "src/graphics/images/surface.h"
 
 #include "src/events/requests.h"
 
@@ -55,64 +61,248 @@ namespace Graphics {
 
 namespace Aurora {
 
-Texture::Texture() : _type(::Aurora::kFileTypeNone), _width(0), _height(0), _deswizzle(false) {
+/** The number of bytes all textures currently take up in OpenGL. */
+static std::atomic<size_t> totalMemorySize(0);
+
+size_t Texture::estimateMemorySize(const ImageDecoder &image) {
+	size_t size = 0;
+
+	for (size_t layer = 0; layer < image.getLayerCount(); layer++)
+		for (size_t mipMap = 0; mipMap < image.getMipMapCount(); mipMap++)
+			size += image.getMipMap(mipMap, layer).size;
+
+	// OpenGL generates the missing mip maps, which add about a third
+	if (image.getMipMapCount() == 1)
+		size += size / 3;
+
+	return size;
+}
+
+/** An image decoded in the background. */
+struct Texture::AsyncImage {
+	Common::UString    name;
+	::Aurora::FileType type;
+
+	bool deswizzle;
+
+	std::unique_ptr<Common::SeekableReadStream> stream; ///< The image data still to decode.
+	std::unique_ptr<TXI> txi;                           ///< A copy of the texture's TXI.
+
+	std::unique_ptr<ImageDecoder> image; ///< The decoded image, or 0 if decoding failed.
+	std::atomic<bool> done;              ///< Has the decoding finished?
+
+	std::exception_ptr error;    ///< Why decoding failed.
+	std::atomic<bool> reported; ///< Has the failure been reported already?
+
+	Texture *texture; ///< The texture waiting for the image, or 0 if it's gone.
+	bool queueing;    ///< Is the worker queueing the texture for its upload right now?
+
+	std::mutex mutex;
+	std::condition_variable finished;
+
+	AsyncImage() : type(::Aurora::kFileTypeNone), deswizzle(false), done(false), reported(false), texture(0),
+		queueing(false) {
+	}
+
+	void decode() {
+		ImageDecoder *decoded = 0;
+		std::exception_ptr exception;
+
+		try {
+			decoded = loadImage(stream.release(), type, txi.get(), deswizzle);
+		} catch (...) {
+			exception = std::current_exception();
+		}
+
+		Texture *waiting = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			image.reset(decoded);
+			error = exception;
+			done.store(true);
+
+			waiting  = texture;
+			queueing = waiting != 0;
+
+			finished.notify_all();
+		}
+
+		/* Let the texture upload the full image with the next frame. Building a
+		 * frame holds the queue's lock, so we must not hold ours while we wait
+		 * for it. The texture stays around until we say we're done with it. */
+		if (!waiting)
+			return;
+
+		waiting->addToQueue(kQueueNewTexture);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		queueing = false;
+		finished.notify_all();
+	}
+
+	/** If decoding failed, warn about it, once. */
+	void reportFailure() {
+		if (!done.load() || image || reported.exchange(true))
+			return;
+
+		try {
+			std::rethrow_exception(error);
+		} catch (...) {
+			Common::exceptionDispatcherWarning("Failed to decode texture \"%s\" (%d), keeping the placeholder",
+			                                   name.c_str(), type);
+		}
+	}
+};
+
+Texture::Texture() : _type(::Aurora::kFileTypeNone), _width(0), _height(0), _deswizzle(false),
+	_uploadedAsCubeMap(false), _memorySize(0) {
 }
 
 Texture::Texture(const Common::UString &name, ImageDecoder *image,
                  ::Aurora::FileType type, TXI *txi, bool deswizzle) :
-	_name(name), _type(type), _width(0), _height(0), _deswizzle(deswizzle) {
+	_name(name), _type(type), _width(0), _height(0), _deswizzle(deswizzle), _uploadedAsCubeMap(false),
+	_memorySize(0) {
 
 	set(name, image, type, txi, deswizzle);
 	addToQueues();
 }
 
 Texture::~Texture() {
+	detachAsyncImage();
 	removeFromQueues();
 
 	if (_textureID != 0)
 		GfxMan.abandon(&_textureID, 1);
+
+	setMemorySize(0);
 }
 
 uint32_t Texture::getWidth() const {
+	if (_asyncImage)
+		return getLoadedImage()->getMipMap(0).width;
+
 	return _width;
 }
 
 uint32_t Texture::getHeight() const {
+	if (_asyncImage)
+		return getLoadedImage()->getMipMap(0).height;
+
 	return _height;
 }
 
 bool Texture::hasAlpha() const {
-	if (!_image)
+	const ImageDecoder *image = getLoadedImage();
+	if (!image)
 		return false;
 
-	return _image->hasAlpha();
+	return image->hasAlpha();
 }
 
 bool Texture::isDynamic() const {
 	return false;
 }
 
+bool Texture::isLoading() const {
+	return _asyncImage && !_asyncImage->done.load();
+}
+
+bool Texture::hasLoadingFailed() const {
+	return _asyncImage && _asyncImage->done.load() && !_asyncImage->image;
+}
+
+bool Texture::isUploadedAsCubeMap() const {
+	return _uploadedAsCubeMap;
+}
+
+size_t Texture::getMemorySize() const {
+	return _memorySize;
+}
+
+size_t Texture::getTotalMemorySize() {
+	return totalMemorySize.load(std::memory_order_relaxed);
+}
+
+void Texture::setMemorySize(size_t size) {
+	totalMemorySize.fetch_sub(_memorySize, std::memory_order_relaxed);
+	totalMemorySize.fetch_add(size, std::memory_order_relaxed);
+
+	_memorySize = size;
+}
+
 static const TXI kEmptyTXI;
 const TXI &Texture::getTXI() const {
 	if (_txi)
 		return *_txi;
 
-	if (_image)
-		return _image->getTXI();
+	const ImageDecoder *image = getLoadedImage();
+	if (image)
+		return image->getTXI();
 
 	return kEmptyTXI;
 }
 
 const ImageDecoder &Texture::getImage() const {
-	assert(_image);
+	const ImageDecoder *image = getLoadedImage();
+	assert(image);
+
+	return *image;
+}
+
+const ImageDecoder *Texture::getLoadedImage() const {
+	if (_asyncImage) {
+		if (!_asyncImage->done.load()) {
+			std::unique_lock<std::mutex> lock(_asyncImage->mutex);
+			_asyncImage->finished.wait(lock, [this]() { return _asyncImage->done.load(); });
+		}
+
+		// If decoding failed, we're stuck with the placeholder
+		if (_asyncImage->image)
+			return _asyncImage->image.get();
+
+		_asyncImage->reportFailure();
+	}
+
+	return _image.get();
+}
+
+const ImageDecoder *Texture::getUploadImage() const {
+	if (_asyncImage && _asyncImage->done.load()) {
+		if (_asyncImage->image)
+			return _asyncImage->image.get();
+
+		_asyncImage->reportFailure();
+	}
+
+	return _image.get();
+}
+
+void Texture::detachAsyncImage() {
+	if (!_asyncImage)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(_asyncImage->mutex);
+		_asyncImage->texture = 0;
 
-	return *_image;
+		// The worker might just be putting us into the upload queue
+		_asyncImage->finished.wait(lock, [this]() { return !_asyncImage->queueing; });
+	}
+
+	_asyncImage.reset();
 }
 
 bool Texture::reload() {
 	if (_name.empty())
 		return false;
 
+	// Finish the background decoding first, we're going to replace the image anyway
+	getLoadedImage();
+	detachAsyncImage();
+
 	::Aurora::FileType type = ::Aurora::kFileTypeNone;
 	ImageDecoder *image = 0;
 	TXI *txi = 0;
@@ -137,10 +327,11 @@ bool Texture::reload() {
 }
 
 bool Texture::dumpTGA(const Common::UString &fileName) const {
-	if (!_image)
+	const ImageDecoder *image = getLoadedImage();
+	if (!image)
 		return false;
 
-	return _image->dumpTGA(fileName);
+	return image->dumpTGA(fileName);
 }
 
 void Texture::doDestroy() {
@@ -150,10 +341,14 @@ void Texture::doDestroy() {
 	glDeleteTextures(1, &_textureID);
 
 	_textureID = 0;
+
+	setMemorySize(0);
 }
 
 void Texture::doRebuild() {
-	if (!_image)
+	// Take one look, so that we don't switch images halfway through
+	const ImageDecoder *image = getUploadImage();
+	if (!image)
 		// No image
 		return;
 
@@ -161,12 +356,14 @@ void Texture::doRebuild() {
 	if (_textureID == 0)
 		glGenTextures(1, &_textureID);
 
-	if (_image->isCubeMap()) {
-		createCubeMapTexture();
-		return;
-	}
+	_uploadedAsCubeMap = image->isCubeMap();
+
+	if (_uploadedAsCubeMap)
+		createCubeMapTexture(*image);
+	else
+		create2DTexture(*image);
 
-	create2DTexture();
+	setMemorySize(estimateMemorySize(*image));
 }
 
 void Texture::setWrap(GLenum target, GLint wrapModeX, GLint wrapModeY) {
@@ -174,13 +371,13 @@ void Texture::setWrap(GLenum target, GLint wrapModeX, GLint wrapModeY) {
 	glTexParameteri(target, GL_TEXTURE_WRAP_T, wrapModeY);
 }
 
-void Texture::setAlign() {
+void Texture::setAlign(const ImageDecoder &image) {
 	/* Set the correct alignment depending on the texture data we have.
 	   Can be used for optimized reading of texture data by the driver. */
 
 	int alignment = 1;
 
-	switch (_image->getFormatRaw()) {
+	switch (image.getFormatRaw()) {
 		// 4 byte per texel, so always neatly 4-byte aligned
 		case kPixelFormatRGBA8:
 			alignment = 4;
@@ -213,8 +410,10 @@ void Texture::setAlign() {
 	glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
 }
 
-void Texture::setFilter(GLenum target) {
-	const TXI::Features &features = getTXI().getFeatures();
+void Texture::setFilter(GLenum target, const ImageDecoder &image) {
+	/* Only look at the TXI of the image we're uploading. getTXI() might wait for
+	 * the background decoding, and we're called while the frame is being built. */
+	const TXI::Features &features = (_txi ? *_txi : image.getTXI()).getFeatures();
 
 	if (features.filter) {
 		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -225,8 +424,8 @@ void Texture::setFilter(GLenum target) {
 	}
 }
 
-void Texture::setMipMaps(GLenum target) {
-	if (_image->getMipMapCount() == 1) {
+void Texture::setMipMaps(GLenum target, const ImageDecoder &image) {
+	if (image.getMipMapCount() == 1) {
 		// Texture doesn't specify any mip maps, generate our own
 
 		glTexParameteri(target, GL_GENERATE_MIPMAP, GL_TRUE);
@@ -237,23 +436,23 @@ void Texture::setMipMaps(GLenum target) {
 
 		glTexParameteri(target, GL_GENERATE_MIPMAP, GL_FALSE);
 		glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
-		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, _image->getMipMapCount() - 1);
+		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, image.getMipMapCount() - 1);
 	}
 }
 
-void Texture::setMipMapData(GLenum target, size_t layer, size_t mipMap) {
-	const ImageDecoder::MipMap &m = _image->getMipMap(mipMap, layer);
+void Texture::setMipMapData(GLenum target, const ImageDecoder &image, size_t layer, size_t mipMap) {
+	const ImageDecoder::MipMap &m = image.getMipMap(mipMap, layer);
 
-	if (_image->isCompressed()) {
-		glCompressedTexImage2D(target, mipMap, _image->getFormatRaw(),
+	if (image.isCompressed()) {
+		glCompressedTexImage2D(target, mipMap, image.getFormatRaw(),
 		                       m.width, m.height, 0, m.size, m.data.get());
 	} else {
-		glTexImage2D(target, mipMap, _image->getFormatRaw(),
-		             m.width, m.height, 0, _image->getFormat(), _image->getDataType(), m.data.get());
+		glTexImage2D(target, mipMap, image.getFormatRaw(),
+		             m.width, m.height, 0, image.getFormat(), image.getDataType(), m.data.get());
 	}
 }
 
-void Texture::create2DTexture() {
+void Texture::create2DTexture(const ImageDecoder &image) {
 	// Bind the texture
 	glBindTexture(GL_TEXTURE_2D, _textureID);
 
@@ -261,20 +460,20 @@ void Texture::create2DTexture() {
 	setWrap(GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT);
 
 	// Pixel row alignment
-	setAlign();
+	setAlign(image);
 
 	// Filter method
-	setFilter(GL_TEXTURE_2D);
+	setFilter(GL_TEXTURE_2D, image);
 
 	// Mip map parameters
-	setMipMaps(GL_TEXTURE_2D);
+	setMipMaps(GL_TEXTURE_2D, image);
 
 	// Texture image data
-	for (size_t i = 0; i < _image->getMipMapCount(); i++)
-		setMipMapData(GL_TEXTURE_2D, 0, i);
+	for (size_t i = 0; i < image.getMipMapCount(); i++)
+		setMipMapData(GL_TEXTURE_2D, image, 0, i);
 }
 
-void Texture::createCubeMapTexture() {
+void Texture::createCubeMapTexture(const ImageDecoder &image) {
 	// Bind the texture
 	glBindTexture(GL_TEXTURE_CUBE_MAP, _textureID);
 
@@ -282,15 +481,15 @@ void Texture::createCubeMapTexture() {
 	setWrap(GL_TEXTURE_CUBE_MAP, GL_REPEAT, GL_REPEAT);
 
 	// Pixel row alignment
-	setAlign();
+	setAlign(image);
 
 	// Filter method
-	setFilter(GL_TEXTURE_CUBE_MAP);
+	setFilter(GL_TEXTURE_CUBE_MAP, image);
 
 	// Mip map parameters
-	setMipMaps(GL_TEXTURE_CUBE_MAP);
+	setMipMaps(GL_TEXTURE_CUBE_MAP, image);
 
-	assert(_image->getLayerCount() == 6);
+	assert(image.getLayerCount() == 6);
 
 	static const GLenum faceTarget[6] = {
 		GL_TEXTURE_CUBE_MAP_POSITIVE_X,
@@ -302,9 +501,9 @@ void Texture::createCubeMapTexture() {
 	};
 
 	// Texture image data
-	for (size_t i = 0; i < _image->getLayerCount(); i++)
-		for (size_t j = 0; j < _image->getMipMapCount(); j++)
-			setMipMapData(faceTarget[i], i, j);
+	for (size_t i = 0; i < image.getLayerCount(); i++)
+		for (size_t j = 0; j < image.getMipMapCount(); j++)
+			setMipMapData(faceTarget[i], image, i, j);
 }
 
 Texture *Texture::createPLT(const Common::UString &name, Common::SeekableReadStream *imageStream) {
@@ -373,6 +572,64 @@ Texture *Texture::create(const Common::UString &name, bool deswizzle) {
 	return new Texture(name, image, type, txi, deswizzle);
 }
 
+Texture *Texture::createAsync(const Common::UString &name, Common::ThreadPool &pool, bool deswizzle) {
+	std::shared_ptr<AsyncImage> asyncImage = std::make_shared<AsyncImage>();
+
+	asyncImage->name      = name;
+	asyncImage->deswizzle = deswizzle;
+
+	TXI *txi = 0;
+
+	try {
+		txi = loadTXI(name);
+
+		// A cube map with each side a separate image file is rare enough to not bother
+		const bool isFileCubeMap = txi && txi->getFeatures().cube && (txi->getFeatures().fileRange == 6);
+		if (isFileCubeMap) {
+			delete txi;
+
+			return create(name, deswizzle);
+		}
+
+		/* Only the decoding happens in the background. We need to know the type
+		 * of the image right away, and ResMan can prefetch the data for us. */
+		asyncImage->stream.reset(ResMan.getResource(::Aurora::kResourceImage, name, &asyncImage->type));
+		if (!asyncImage->stream)
+			throw Common::Exception("No such image resource \"%s\"", name.c_str());
+
+		// PLT needs extra handling, since they're their own Texture class
+		if (asyncImage->type == ::Aurora::kFileTypePLT) {
+			delete txi;
+
+			return createPLT(name, asyncImage->stream.release());
+		}
+
+		if (txi)
+			asyncImage->txi = std::make_unique<TXI>(*txi);
+
+	} catch (Common::Exception &e) {
+		delete txi;
+
+		e.add("Failed to create texture \"%s\" (%d)", name.c_str(), asyncImage->type);
+		throw;
+	}
+
+	std::unique_ptr<Surface> placeholder = std::make_unique<Surface>(1, 1);
+	placeholder->fill(0x80, 0x80, 0x80, 0xFF);
+
+	Texture *texture = new Texture;
+
+	texture->_asyncImage = asyncImage;
+	asyncImage->texture  = texture;
+
+	texture->set(name, placeholder.release(), asyncImage->type, txi, deswizzle);
+	texture->addToQueues();
+
+	pool.submit([asyncImage]() { asyncImage->decode(); });
+
+	return texture;
+}
+
 Texture *Texture::create(ImageDecoder *image, ::Aurora::FileType type, TXI *txi, bool deswizzle) {
 	if (!image)
 		throw Common::Exception("Can't create a texture from an empty image");
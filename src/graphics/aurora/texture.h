@@ -36,6 +36,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class ThreadPool;
 }
 
 namespace Graphics {
@@ -58,6 +59,20 @@ public:
 	/** Is this a dynamic texture, or a shared static one? */
 	virtual bool isDynamic() const;
 
+	/** Is the image of this texture still being decoded in the background? */
+	bool isLoading() const;
+	/** Did decoding the image in the background fail, leaving the placeholder in its place? */
+	bool hasLoadingFailed() const;
+	/** Is the texture currently uploaded to OpenGL as a cube map? */
+	bool isUploadedAsCubeMap() const;
+
+	/** Return roughly how many bytes the texture currently takes up in OpenGL. */
+	size_t getMemorySize() const;
+	/** Return roughly how many bytes all textures currently take up in OpenGL. */
+	static size_t getTotalMemorySize();
+	/** Roughly estimate the number of bytes an image takes up in OpenGL. */
+	static size_t estimateMemorySize(const ImageDecoder &image);
+
 	/** Return the TXI. */
 	const TXI &getTXI() const;
 	/** Return the image. */
@@ -82,6 +97,14 @@ public:
 	static Texture *create(ImageDecoder *image, ::Aurora::FileType type = ::Aurora::kFileTypeNone,
 	                       TXI *txi = 0, bool deswizzle = false);
 
+	/** Create a texture from this image resource, decoding the image in the background.
+	 *
+	 *  Until the image is decoded, the texture shows a flat gray placeholder.
+	 *  Asking for the image or its properties waits for the decoding to finish.
+	 *  If the decoding fails, a warning is printed and the placeholder stays.
+	 */
+	static Texture *createAsync(const Common::UString &name, Common::ThreadPool &pool, bool deswizzle = false);
+
 
 protected:
 	Common::UString    _name; ///< The name of the texture's image's file.
@@ -95,6 +118,10 @@ protected:
 
 	bool _deswizzle;
 
+	bool _uploadedAsCubeMap;
+
+	size_t _memorySize; ///< The number of bytes the texture takes up in OpenGL.
+
 
 	Texture();
 	Texture(const Common::UString &name, ImageDecoder *image, ::Aurora::FileType type, TXI *txi = 0,
@@ -113,14 +140,14 @@ protected:
 	void doDestroy();
 
 
-	void create2DTexture();
-	void createCubeMapTexture();
+	void create2DTexture(const ImageDecoder &image);
+	void createCubeMapTexture(const ImageDecoder &image);
 
 	void setWrap(GLenum target, GLint wrapModeX, GLint wrapModeY);
-	void setAlign();
-	void setFilter(GLenum target);
-	void setMipMaps(GLenum target);
-	void setMipMapData(GLenum target, size_t layer, size_t mipMap);
+	void setAlign(const ImageDecoder &image);
+	void setFilter(GLenum target, const ImageDecoder &image);
+	void setMipMaps(GLenum target, const ImageDecoder &image);
+	void setMipMapData(GLenum target, const ImageDecoder &image, size_t layer, size_t mipMap);
 
 	static TXI *loadTXI(const Common::UString &name);
 	static ImageDecoder *loadImage(Common::SeekableReadStream *imageStream, ::Aurora::FileType type,
@@ -130,6 +157,23 @@ protected:
 	                               bool deswizzle = false);
 
 	static Texture *createPLT(const Common::UString &name, Common::SeekableReadStream *imageStream);
+
+	/** Update the number of bytes the texture takes up in OpenGL. */
+	void setMemorySize(size_t size);
+
+private:
+	struct AsyncImage;
+
+	/** The image decoded in the background, shared with the thread decoding it. */
+	std::shared_ptr<AsyncImage> _asyncImage;
+
+	/** Return the full image, waiting for it to be decoded if necessary. */
+	const ImageDecoder *getLoadedImage() const;
+	/** Return the image to upload right now: the full image if it's ready, the placeholder otherwise. */
+	const ImageDecoder *getUploadImage() const;
+
+	/** Stop waiting for the image decoded in the background. */
+	void detachAsyncImage();
 };
 
 } // End of namespace Aurora
@@ -26,6 +26,7 @@
 #define GRAPHICS_AURORA_TEXTUREHANDLE_H
 
 #include <map>
+#include <atomic>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
@@ -36,11 +37,14 @@ namespace Aurora {
 
 class Texture;
 
-/** A managed texture, storing how often it's referenced. */
+/** A managed texture, storing how often and when it's referenced. */
 struct ManagedTexture {
 	Texture *texture;
 	uint32_t referenceCount;
 
+	std::atomic<uint64_t> lastUsed; ///< The frame the texture was last asked for or bound in.
+	std::atomic<bool> evicted;      ///< Was the texture removed from OpenGL to save memory?
+
 	ManagedTexture(Texture *t);
 	~ManagedTexture();
 };
@@ -23,10 +23,14 @@
  */
 
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/uuid.h"
+#include "src/common/configman.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/aurora/textureman.h"
 #include "src/graphics/aurora/texture.h"
@@ -80,12 +84,27 @@ static GLenum kTextureUnit[] = {
 
 static const size_t kTextureUnitCount = ARRAYSIZE(kTextureUnit);
 
+/** The maximum number of threads decoding textures in the background. */
+static const size_t kLoadThreadCount = 4;
 
-TextureManager::TextureManager() : _deswizzleSBM(false), _recordNewTextures(false) {
+/** Only evict textures that haven't been used for that many frames. */
+static const uint64_t kEvictionFrames = 300;
+/** Only look for textures to evict every that many frames. */
+static const uint64_t kEvictionInterval = 30;
+
+
+TextureManager::TextureManager() : _deswizzleSBM(false), _lastEvictionFrame(0),
+	_evictions(0), _reuploads(0), _recordNewTextures(false) {
+
+	_asyncLoading = ConfigMan.getBool("texturestreaming", false);
+	_memoryBudget = MAX(ConfigMan.getInt("texturebudget", 0), 0) * (size_t) 1024 * 1024;
 }
 
 TextureManager::~TextureManager() {
 	clear();
+
+	// Images still being decoded are thrown away with their textures
+	_loadPool.reset();
 }
 
 void TextureManager::clear() {
@@ -99,6 +118,8 @@ void TextureManager::clear() {
 
 	_deswizzleSBM = false;
 
+	_lastEvictionFrame.store(0);
+
 	_recordNewTextures = false;
 	_newTextureNames.clear();
 }
@@ -113,6 +134,39 @@ void TextureManager::setDeswizzleSBM(bool deswizzle) {
 	_deswizzleSBM = deswizzle;
 }
 
+void TextureManager::setAsyncLoading(bool async) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	_asyncLoading = async;
+}
+
+bool TextureManager::getAsyncLoading() const {
+	return _asyncLoading;
+}
+
+void TextureManager::waitForTextures() {
+	std::unique_lock<std::recursive_mutex> lock(_mutex);
+
+	if (!_loadPool)
+		return;
+
+	Common::ThreadPool &pool = *_loadPool;
+
+	// The workers don't need us, so don't block everybody else while waiting
+	lock.unlock();
+	pool.wait();
+}
+
+Common::ThreadPool &TextureManager::getLoadPool() {
+	if (!_loadPool) {
+		const size_t threadCount = MIN(Common::ThreadPool::getHardwareThreadCount(), kLoadThreadCount);
+
+		_loadPool = std::make_unique<Common::ThreadPool>(threadCount, "textures");
+	}
+
+	return *_loadPool;
+}
+
 bool TextureManager::hasTexture(const Common::UString &name) {
 	std::lock_guard<std::recursive_mutex> lock(_mutex);
 
@@ -144,6 +198,8 @@ TextureHandle TextureManager::add(Texture *texture, Common::UString name) {
 	managedTexture.release();
 	TextureMap::iterator textureIterator = result.first;
 
+	textureIterator->second->lastUsed.store(GfxMan.getFrameCount(), std::memory_order_relaxed);
+
 	if (_recordNewTextures)
 		_newTextureNames.push_back(name);
 
@@ -160,7 +216,10 @@ TextureHandle TextureManager::get(Common::UString name) {
 	if (texture == _textures.end()) {
 		std::pair<TextureMap::iterator, bool> result;
 
-		ManagedTexture *managedTexture = new ManagedTexture(Texture::create(name, _deswizzleSBM));
+		Texture *newTexture = _asyncLoading ? Texture::createAsync(name, getLoadPool(), _deswizzleSBM) :
+		                                      Texture::create(name, _deswizzleSBM);
+
+		ManagedTexture *managedTexture = new ManagedTexture(newTexture);
 
 		if (managedTexture->texture->isDynamic())
 			name = name + "#" + Common::generateIDRandomString();
@@ -170,6 +229,8 @@ TextureHandle TextureManager::get(Common::UString name) {
 		texture = result.first;
 	}
 
+	texture->second->lastUsed.store(GfxMan.getFrameCount(), std::memory_order_relaxed);
+
 	if (_recordNewTextures)
 		_newTextureNames.push_back(name);
 
@@ -246,6 +307,104 @@ void TextureManager::reloadAll() {
 	GfxMan.unlockFrame();
 }
 
+void TextureManager::setMemoryBudget(size_t budget) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	_memoryBudget = budget;
+}
+
+size_t TextureManager::getMemoryBudget() const {
+	return _memoryBudget;
+}
+
+TextureManager::MemoryStats TextureManager::getMemoryStats() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	MemoryStats stats;
+
+	stats.textureCount = _textures.size();
+	stats.evictedCount = 0;
+	stats.memorySize   = Texture::getTotalMemorySize();
+	stats.budget       = _memoryBudget;
+	stats.evictions    = _evictions;
+	stats.reuploads    = _reuploads;
+
+	for (TextureMap::const_iterator t = _textures.begin(); t != _textures.end(); ++t)
+		if (t->second->evicted)
+			stats.evictedCount++;
+
+	return stats;
+}
+
+void TextureManager::touch(const TextureHandle &handle) {
+	touch(handle, GfxMan.getFrameCount());
+}
+
+void TextureManager::touch(const TextureHandle &handle, uint64_t frame) {
+	if (handle.empty())
+		return;
+
+	ManagedTexture &texture = *handle._it->second;
+
+	texture.lastUsed.store(frame, std::memory_order_relaxed);
+
+	if (texture.evicted.exchange(false)) {
+		// Rebuilding all textures might have already brought it back
+		if (texture.texture->getID() == 0) {
+			texture.texture->rebuild();
+			_reuploads++;
+		}
+	}
+
+	// Only one caller gets to look for textures to evict
+	uint64_t lastEvictionFrame = _lastEvictionFrame.load();
+	if ((frame >= (lastEvictionFrame + kEvictionInterval)) &&
+	    _lastEvictionFrame.compare_exchange_strong(lastEvictionFrame, frame))
+		evictTextures(frame);
+}
+
+void TextureManager::evictTextures(uint64_t frame) {
+	if ((_memoryBudget == 0) || (Texture::getTotalMemorySize() <= _memoryBudget))
+		return;
+
+	// Don't hold up the rendering while textures are being loaded, just try again later
+	std::unique_lock<std::recursive_mutex> lock(_mutex, std::try_to_lock);
+	if (!lock.owns_lock())
+		return;
+
+	if (frame < kEvictionFrames)
+		return;
+
+	std::vector<ManagedTexture *> candidates;
+	for (TextureMap::iterator t = _textures.begin(); t != _textures.end(); ++t) {
+		ManagedTexture &texture = *t->second;
+
+		// Dynamic textures change their image on the fly, so leave them alone
+		if (texture.evicted || texture.texture->isDynamic() || (texture.texture->getMemorySize() == 0))
+			continue;
+
+		if (texture.lastUsed.load(std::memory_order_relaxed) > (frame - kEvictionFrames))
+			continue;
+
+		candidates.push_back(&texture);
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const ManagedTexture *a, const ManagedTexture *b) {
+		return a->lastUsed.load(std::memory_order_relaxed) < b->lastUsed.load(std::memory_order_relaxed);
+	});
+
+	for (std::vector<ManagedTexture *>::iterator t = candidates.begin(); t != candidates.end(); ++t) {
+		if (Texture::getTotalMemorySize() <= _memoryBudget)
+			break;
+
+		// The image stays around, so the texture can be uploaded again when it's needed
+		(*t)->texture->destroy();
+		(*t)->evicted.store(true);
+
+		_evictions++;
+	}
+}
+
 void TextureManager::reset() {
 	for (size_t i = 0; i < kTextureUnitCount; i++) {
 		activeTexture(i);
@@ -280,11 +439,16 @@ void TextureManager::set(const TextureHandle &handle, TextureMode mode) {
 		return;
 	}
 
+	touch(handle);
+
 	TextureID id = handle._it->second->texture->getID();
 	if (id == 0)
 		warning("Empty texture ID for texture \"%s\"", handle._it->first.c_str());
 
-	if (handle._it->second->texture->getImage().isCubeMap()) {
+	// Go by what's uploaded, so that we don't wait for textures still being decoded
+	const bool isCubeMap = handle._it->second->texture->isUploadedAsCubeMap();
+
+	if (isCubeMap) {
 		glBindTexture(GL_TEXTURE_CUBE_MAP, id);
 
 		glDisable(GL_TEXTURE_2D);
@@ -298,7 +462,7 @@ void TextureManager::set(const TextureHandle &handle, TextureMode mode) {
 
 	switch (mode) {
 		case kModeEnvironmentMapReflective:
-			if (handle._it->second->texture->getImage().isCubeMap()) {
+			if (isCubeMap) {
 				glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
 				glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
 				glTexGeni(GL_R, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
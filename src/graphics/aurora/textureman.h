@@ -27,6 +27,8 @@
 
 #include <set>
 #include <list>
+#include <memory>
+#include <atomic>
 
 #include "src/common/types.h"
 #include "src/common/singleton.h"
@@ -35,6 +37,10 @@
 
 #include "src/graphics/aurora/texturehandle.h"
 
+namespace Common {
+	class ThreadPool;
+}
+
 namespace Graphics {
 
 namespace Aurora {
@@ -42,6 +48,17 @@ namespace Aurora {
 /** The global Aurora texture manager. */
 class TextureManager : public Common::Singleton<TextureManager> {
 public:
+	/** Statistics over the memory the managed textures take up in OpenGL. */
+	struct MemoryStats {
+		size_t textureCount; ///< Number of managed textures.
+		size_t evictedCount; ///< Number of textures currently evicted from OpenGL.
+		size_t memorySize;   ///< Bytes all textures take up in OpenGL, roughly.
+		size_t budget;       ///< The memory budget in bytes, or 0 if there is none.
+
+		uint64_t evictions; ///< Number of times a texture was evicted so far.
+		uint64_t reuploads; ///< Number of times an evicted texture was uploaded again so far.
+	};
+
 	/** The mode/usage of a specific texture. */
 	enum TextureMode {
 		kModeDiffuse,                 ///< A standard diffuse texture.
@@ -71,6 +88,21 @@ public:
 	 */
 	void setDeswizzleSBM(bool deswizzle);
 
+	/** Decode newly loaded textures in the background?
+	 *
+	 *  If enabled, get() returns right away with a texture showing a flat
+	 *  placeholder, while the image is decoded by a worker thread. The full
+	 *  image is uploaded with the next frame after it's finished.
+	 *
+	 *  This is initialized from the "texturestreaming" config option.
+	 */
+	void setAsyncLoading(bool async);
+	/** Are newly loaded textures decoded in the background? */
+	bool getAsyncLoading() const;
+
+	/** Wait until all textures decoded in the background are finished. */
+	void waitForTextures();
+
 	/** Does this named managed texture exist? */
 	bool hasTexture(const Common::UString &name);
 
@@ -90,6 +122,34 @@ public:
 	void reloadAll();
 	// '---
 
+	// .--- Texture memory
+	/** Set the budget for the memory all textures take up in OpenGL, in bytes.
+	 *
+	 *  While the textures take up more, the ones that haven't been used for
+	 *  a while are removed from OpenGL, least recently used first. Their
+	 *  handles stay valid, and they're uploaded again the next time they're
+	 *  used. A budget of 0 means textures are never evicted.
+	 *
+	 *  This is initialized from the "texturebudget" config option, in MiB.
+	 */
+	void setMemoryBudget(size_t budget);
+	/** Return the budget for the memory all textures take up in OpenGL, in bytes. */
+	size_t getMemoryBudget() const;
+
+	/** Return statistics over the memory the textures take up. */
+	MemoryStats getMemoryStats();
+
+	/** Mark this texture as used in the current frame.
+	 *
+	 *  If it has been evicted from OpenGL, it is uploaded again. This is done
+	 *  by set() automatically, and only needs to be called when binding the
+	 *  texture by other means.
+	 */
+	void touch(const TextureHandle &handle);
+	/** Mark this texture as used in this frame. */
+	void touch(const TextureHandle &handle, uint64_t frame);
+	// '---
+
 	// .--- Texture rendering
 	/** Bind this texture to the current texture unit. */
 	void set(const TextureHandle &handle, TextureMode mode = kModeDiffuse);
@@ -106,6 +166,18 @@ private:
 	bool _deswizzleSBM;
 	TextureMap _textures;
 
+	bool _asyncLoading;
+	std::unique_ptr<Common::ThreadPool> _loadPool; ///< Threads decoding textures in the background.
+
+	size_t _memoryBudget; ///< Maximum number of bytes the textures should take up in OpenGL.
+
+	/* These are used by touch(), which is called for every texture bound.
+	 * So they're atomic instead of guarded by the mutex. */
+	std::atomic<uint64_t> _lastEvictionFrame; ///< The frame we last looked for textures to evict in.
+
+	std::atomic<uint64_t> _evictions;
+	std::atomic<uint64_t> _reuploads;
+
 	std::set<Common::UString> _bogusTextures;
 
 	std::recursive_mutex _mutex;
@@ -113,6 +185,11 @@ private:
 	bool _recordNewTextures;
 	std::list<Common::UString> _newTextureNames;
 
+	Common::ThreadPool &getLoadPool();
+
+	/** Evict the least recently used textures until we're within the memory budget. */
+	void evictTextures(uint64_t frame);
+
 	void assign(TextureHandle &texture, const TextureHandle &from);
 	void release(TextureHandle &texture);
 
@@ -0,0 +1,142 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A fence other threads can wait on until the current frame has ended.
+ */
+
+#include <chrono>
+#include <thread>
+
+#include "src/common/util.h"
+
+#include "src/graphics/framefence.h"
+
+namespace Graphics {
+
+static const uint32_t kSpinLimitMin     =    16; ///< Shortest spin before sleeping.
+static const uint32_t kSpinLimitMax     =  4096; ///< Longest spin before sleeping.
+static const uint32_t kSpinLimitDefault =   256;
+
+/** How often a sleeping thread wakes up to poll the abort check. */
+static const std::chrono::milliseconds kAbortPollInterval(10);
+
+FrameFence::FrameFence() : _frame(0), _waiters(0), _spinLimit(kSpinLimitDefault) {
+	resetStats();
+}
+
+FrameFence::~FrameFence() {
+}
+
+void FrameFence::signal() {
+	_frame.fetch_add(1);
+
+	/* Only bother with the mutex if anybody is sleeping. Taking the mutex
+	 * makes sure a thread that just checked the frame counter has gone to
+	 * sleep before we wake it up. */
+	if (_waiters.load() == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+	}
+
+	_frameEnded.notify_all();
+}
+
+bool FrameFence::wait(const AbortCheck &abort) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	const uint64_t target = _frame.load() + 1;
+
+	// Spin a bit first, most frames end soon
+	const uint32_t spinLimit = _spinLimit.load(std::memory_order_relaxed);
+	for (uint32_t i = 0; i < spinLimit; i++) {
+		if (_frame.load(std::memory_order_acquire) >= target) {
+			_spinLimit.store(MIN(spinLimit * 2, kSpinLimitMax), std::memory_order_relaxed);
+
+			addStat(std::chrono::duration_cast<std::chrono::microseconds>(
+			        std::chrono::steady_clock::now() - start).count(), false);
+			return true;
+		}
+
+		std::this_thread::yield();
+	}
+
+	_spinLimit.store(MAX(spinLimit / 2, kSpinLimitMin), std::memory_order_relaxed);
+
+	bool ended = true;
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_waiters.fetch_add(1);
+
+		while (_frame.load() < target) {
+			if (abort && abort()) {
+				ended = false;
+				break;
+			}
+
+			_frameEnded.wait_for(lock, kAbortPollInterval);
+		}
+
+		_waiters.fetch_sub(1);
+	}
+
+	addStat(std::chrono::duration_cast<std::chrono::microseconds>(
+	        std::chrono::steady_clock::now() - start).count(), true);
+
+	return ended;
+}
+
+uint64_t FrameFence::getFrame() const {
+	return _frame.load(std::memory_order_relaxed);
+}
+
+FrameFence::Stats FrameFence::getStats() const {
+	Stats stats;
+
+	stats.waits     = _statWaits.load(std::memory_order_relaxed);
+	stats.sleeps    = _statSleeps.load(std::memory_order_relaxed);
+	stats.totalTime = _statTotalTime.load(std::memory_order_relaxed);
+	stats.maxTime   = _statMaxTime.load(std::memory_order_relaxed);
+
+	return stats;
+}
+
+void FrameFence::resetStats() {
+	_statWaits.store(0, std::memory_order_relaxed);
+	_statSleeps.store(0, std::memory_order_relaxed);
+	_statTotalTime.store(0, std::memory_order_relaxed);
+	_statMaxTime.store(0, std::memory_order_relaxed);
+}
+
+void FrameFence::addStat(uint64_t time, bool slept) {
+	_statWaits.fetch_add(1, std::memory_order_relaxed);
+	_statTotalTime.fetch_add(time, std::memory_order_relaxed);
+
+	if (slept)
+		_statSleeps.fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t maxTime = _statMaxTime.load(std::memory_order_relaxed);
+	while ((time > maxTime) && !_statMaxTime.compare_exchange_weak(maxTime, time, std::memory_order_relaxed));
+}
+
+} // End of namespace Graphics
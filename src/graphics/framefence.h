@@ -0,0 +1,102 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A fence other threads can wait on until the current frame has ended.
+ */
+
+#ifndef GRAPHICS_FRAMEFENCE_H
+#define GRAPHICS_FRAMEFENCE_H
+
+#include <atomic>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/mutex.h"
+
+namespace Graphics {
+
+/** A fence other threads can wait on until the current frame has ended.
+ *
+ *  The render thread signals the fence at the end of every frame. A
+ *  waiting thread first spins for a short while, since frames are
+ *  usually short, and then goes to sleep on a condition variable.
+ *
+ *  The spin adapts: it's lengthened while waits tend to end within it,
+ *  and shortened while they tend to need the sleep anyway.
+ */
+class FrameFence : boost::noncopyable {
+public:
+	/** Statistics over all waits on the fence. */
+	struct Stats {
+		uint64_t waits;        ///< Number of waits.
+		uint64_t sleeps;       ///< Number of waits that had to sleep.
+		uint64_t totalTime;    ///< Total time spent waiting, in microseconds.
+		uint64_t maxTime;      ///< Longest wait, in microseconds.
+	};
+
+	/** Returns true if a waiting thread should give up waiting. */
+	typedef std::function<bool()> AbortCheck;
+
+	FrameFence();
+	~FrameFence();
+
+	/** Signal the end of a frame, waking up all waiting threads. */
+	void signal();
+
+	/** Wait until the end of the frame currently rendered, or the next
+	 *  one if none is being rendered right now.
+	 *
+	 *  The abort check is polled regularly while sleeping.
+	 *
+	 *  @return false if the wait was aborted.
+	 */
+	bool wait(const AbortCheck &abort = AbortCheck());
+
+	/** Return the number of frames signaled so far. */
+	uint64_t getFrame() const;
+
+	/** Return the statistics over all waits so far. */
+	Stats getStats() const;
+	/** Reset the statistics. */
+	void resetStats();
+
+private:
+	std::atomic<uint64_t> _frame;   ///< Number of frames signaled so far.
+	std::atomic<uint32_t> _waiters; ///< Number of threads sleeping on the condition.
+
+	std::atomic<uint32_t> _spinLimit; ///< Current number of spins before sleeping.
+
+	std::mutex _mutex;
+	std::condition_variable _frameEnded;
+
+	std::atomic<uint64_t> _statWaits;
+	std::atomic<uint64_t> _statSleeps;
+	std::atomic<uint64_t> _statTotalTime;
+	std::atomic<uint64_t> _statMaxTime;
+
+	void addStat(uint64_t time, bool slept);
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_FRAMEFENCE_H
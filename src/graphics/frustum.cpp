@@ -0,0 +1,90 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A view frustum, for culling objects outside the view.
+ */
+
+#include "external/glm/geometric.hpp"
+
+#include "src/common/boundingbox.h"
+
+#include "src/graphics/frustum.h"
+
+namespace Graphics {
+
+Frustum::Frustum() {
+	// Without any planes set, everything is visible
+	for (size_t i = 0; i < kPlaneMAX; i++)
+		_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+void Frustum::set(const glm::mat4 &projectionView) {
+	/* Each plane is the sum or difference of the fourth row and one of the
+	 * other rows of the matrix. glm matrices are column-major, so "row i"
+	 * is element [i] of each column. */
+
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i]);
+
+	_planes[kPlaneLeft  ] = rows[3] + rows[0];
+	_planes[kPlaneRight ] = rows[3] - rows[0];
+	_planes[kPlaneBottom] = rows[3] + rows[1];
+	_planes[kPlaneTop   ] = rows[3] - rows[1];
+	_planes[kPlaneNear  ] = rows[3] + rows[2];
+	_planes[kPlaneFar   ] = rows[3] - rows[2];
+
+	for (size_t i = 0; i < kPlaneMAX; i++) {
+		const float length = glm::length(glm::vec3(_planes[i]));
+		if (length > 0.0f)
+			_planes[i] /= length;
+	}
+}
+
+bool Frustum::isVisible(const float min[3], const float max[3]) const {
+	for (size_t i = 0; i < kPlaneMAX; i++) {
+		const glm::vec4 &plane = _planes[i];
+
+		// The corner of the box furthest along the plane normal
+		const float x = (plane.x >= 0.0f) ? max[0] : min[0];
+		const float y = (plane.y >= 0.0f) ? max[1] : min[1];
+		const float z = (plane.z >= 0.0f) ? max[2] : min[2];
+
+		// If even that one is behind the plane, the whole box is outside
+		if ((plane.x * x + plane.y * y + plane.z * z + plane.w) < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+bool Frustum::isVisible(const Common::BoundingBox &box) const {
+	if (box.empty())
+		return true;
+
+	float min[3], max[3];
+	box.getMin(min[0], min[1], min[2]);
+	box.getMax(max[0], max[1], max[2]);
+
+	return isVisible(min, max);
+}
+
+} // End of namespace Graphics
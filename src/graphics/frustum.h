@@ -0,0 +1,77 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A view frustum, for culling objects outside the view.
+ */
+
+#ifndef GRAPHICS_FRUSTUM_H
+#define GRAPHICS_FRUSTUM_H
+
+#include "external/glm/vec4.hpp"
+#include "external/glm/mat4x4.hpp"
+
+#include "src/common/types.h"
+
+namespace Common {
+	class BoundingBox;
+}
+
+namespace Graphics {
+
+/** A view frustum, made up of the six planes bounding the visible space.
+ *
+ *  The planes are extracted from a combined projection and view matrix,
+ *  so the far plane also culls everything beyond the view distance.
+ */
+class Frustum {
+public:
+	Frustum();
+
+	/** Extract the frustum planes out of a projection * view matrix. */
+	void set(const glm::mat4 &projectionView);
+
+	/** Is any part of that axis-aligned box inside the frustum?
+	 *
+	 *  This is conservative: a box close to a corner of the frustum
+	 *  might be reported as visible even though it's just outside.
+	 */
+	bool isVisible(const float min[3], const float max[3]) const;
+	/** Is any part of that bounding box inside the frustum? */
+	bool isVisible(const Common::BoundingBox &box) const;
+
+private:
+	enum Plane {
+		kPlaneLeft = 0,
+		kPlaneRight,
+		kPlaneBottom,
+		kPlaneTop,
+		kPlaneNear,
+		kPlaneFar,
+		kPlaneMAX
+	};
+
+	/** The planes, as normal and distance, with the normal pointing inwards. */
+	glm::vec4 _planes[kPlaneMAX];
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_FRUSTUM_H
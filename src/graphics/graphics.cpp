@@ -85,6 +85,7 @@ GraphicsManager::GraphicsManager() : Events::Notifyable() {
 	_needManualDeS3TC        = false;
 	_supportMultipleTextures = false;
 	_multipleTextureCount    = 0;
+	_supportInstancing       = false;
 
 	// Default to an OpenGL 3.2 compatibility context. GL3.x will be available on most modern systems.
 	_renderType = WindowManager::kOpenGL32Compat;
@@ -93,6 +94,11 @@ GraphicsManager::GraphicsManager() : Events::Notifyable() {
 	_cullFaceEnabled = true;
 	_cullFaceMode    = GL_BACK;
 
+	_frustumCulling.store(true);
+
+	_worldObjectsVisible.store(0);
+	_worldObjectsCulled.store(0);
+
 	_projectType = kProjectTypePerspective;
 
 	_viewAngle = 60.0f;
@@ -216,6 +222,7 @@ void GraphicsManager::deinit() {
 	_needManualDeS3TC        = false;
 	_supportMultipleTextures = false;
 	_multipleTextureCount    = 0;
+	_supportInstancing       = false;
 }
 
 bool GraphicsManager::ready() const {
@@ -234,6 +241,10 @@ size_t GraphicsManager::getMultipleTextureCount() const {
 	return _multipleTextureCount;
 }
 
+bool GraphicsManager::supportInstancing() const {
+	return _supportInstancing;
+}
+
 int GraphicsManager::getCurrentFSAA() const {
 	return _fsaa;
 }
@@ -391,6 +402,16 @@ void GraphicsManager::checkGLExtensions() {
 		warning("xoreos will only use one texture. Certain surfaces may look weird");
 	}
 
+	// Instanced arrays are core since OpenGL 3.3, but our GL3.x context is only 3.2
+	_supportInstancing = false;
+	if (isGL3() && (GLEW_VERSION_3_3 || GLEW_ARB_instanced_arrays)) {
+		glVertexAttribDivisor = GLEW_GET_FUN(__glewVertexAttribDivisor) ?
+			(PFNGLVERTEXATTRIBDIVISORPROC)GLEW_GET_FUN(__glewVertexAttribDivisor) :
+			(PFNGLVERTEXATTRIBDIVISORPROC)GLEW_GET_FUN(__glewVertexAttribDivisorARB);
+
+		_supportInstancing = glVertexAttribDivisor && glDrawElementsInstanced && glDrawArraysInstanced;
+	}
+
 	if (_debugGL && GLEW_ARB_debug_output) {
 		warning("Enabled OpenGL debug output");
 
@@ -480,6 +501,19 @@ void GraphicsManager::setCullFace(bool enabled, GLenum mode) {
 	_cullFaceMode    = mode;
 }
 
+void GraphicsManager::setFrustumCulling(bool enabled) {
+	_frustumCulling.store(enabled, std::memory_order_relaxed);
+}
+
+bool GraphicsManager::getFrustumCulling() const {
+	return _frustumCulling.load(std::memory_order_relaxed);
+}
+
+void GraphicsManager::getCullingStats(size_t &visible, size_t &culled) const {
+	visible = _worldObjectsVisible.load(std::memory_order_relaxed);
+	culled  = _worldObjectsCulled.load(std::memory_order_relaxed);
+}
+
 void GraphicsManager::setGUIScale(ScalingType scaling) {
 	_scalingType = scaling;
 
@@ -802,8 +836,7 @@ void GraphicsManager::lockFrame() {
 	if (Common::isMainThread() || EventMan.quitRequested() || (lock > 0))
 		return;
 
-	_frameEndSignal.store(false, std::memory_order_release);
-	while (!_frameEndSignal.load(std::memory_order_acquire));
+	_frameEnd.wait([]() { return EventMan.quitRequested(); });
 }
 
 void GraphicsManager::unlockFrame() {
@@ -812,13 +845,22 @@ void GraphicsManager::unlockFrame() {
 	assert(lock != 0);
 }
 
+FrameFence::Stats GraphicsManager::getFrameLockStats() const {
+	return _frameEnd.getStats();
+}
+
+uint64_t GraphicsManager::getFrameCount() const {
+	return _frameEnd.getFrame();
+}
+
 void GraphicsManager::recalculateObjectDistances() {
 	// World objects
 	QueueMan.lockQueue(kQueueVisibleWorldObject);
 
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
-	for (std::list<Queueable *>::const_iterator o = objects.begin(); o != objects.end(); ++o)
-		static_cast<Renderable *>(*o)->calculateDistance();
+	const std::vector<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
+	for (size_t i = 0; i < objects.size(); i++)
+		if (objects[i])
+			static_cast<Renderable *>(objects[i])->calculateDistance();
 
 	QueueMan.sortQueue(kQueueVisibleWorldObject);
 	QueueMan.unlockQueue(kQueueVisibleWorldObject);
@@ -826,9 +868,10 @@ void GraphicsManager::recalculateObjectDistances() {
 	// GUI front objects
 	QueueMan.lockQueue(kQueueVisibleGUIFrontObject);
 
-	const std::list<Queueable *> &guiFront = QueueMan.getQueue(kQueueVisibleGUIFrontObject);
-	for (std::list<Queueable *>::const_iterator g = guiFront.begin(); g != guiFront.end(); ++g)
-		static_cast<Renderable *>(*g)->calculateDistance();
+	const std::vector<Queueable *> &guiFront = QueueMan.getQueue(kQueueVisibleGUIFrontObject);
+	for (size_t i = 0; i < guiFront.size(); i++)
+		if (guiFront[i])
+			static_cast<Renderable *>(guiFront[i])->calculateDistance();
 
 	QueueMan.sortQueue(kQueueVisibleGUIFrontObject);
 	QueueMan.unlockQueue(kQueueVisibleGUIFrontObject);
@@ -836,9 +879,10 @@ void GraphicsManager::recalculateObjectDistances() {
 	// GUI back objects
 	QueueMan.lockQueue(kQueueVisibleGUIBackObject);
 
-	const std::list<Queueable *> &guiBack = QueueMan.getQueue(kQueueVisibleGUIBackObject);
-	for (std::list<Queueable *>::const_iterator g = guiBack.begin(); g != guiBack.end(); ++g)
-		static_cast<Renderable *>(*g)->calculateDistance();
+	const std::vector<Queueable *> &guiBack = QueueMan.getQueue(kQueueVisibleGUIBackObject);
+	for (size_t i = 0; i < guiBack.size(); i++)
+		if (guiBack[i])
+			static_cast<Renderable *>(guiBack[i])->calculateDistance();
 
 	QueueMan.sortQueue(kQueueVisibleGUIBackObject);
 	QueueMan.unlockQueue(kQueueVisibleGUIBackObject);
@@ -907,11 +951,14 @@ Renderable *GraphicsManager::getGUIObjectAt(float x, float y) const {
 	Renderable *object = 0;
 
 	QueueMan.lockQueue(kQueueVisibleGUIFrontObject);
-	const std::list<Queueable *> &gui = QueueMan.getQueue(kQueueVisibleGUIFrontObject);
+	const std::vector<Queueable *> &gui = QueueMan.getQueue(kQueueVisibleGUIFrontObject);
 
 	// Go through the GUI elements, from nearest to furthest
-	for (std::list<Queueable *>::const_iterator g = gui.begin(); g != gui.end(); ++g) {
-		Renderable &r = static_cast<Renderable &>(**g);
+	for (size_t i = 0; i < gui.size(); i++) {
+		if (!gui[i])
+			continue;
+
+		Renderable &r = static_cast<Renderable &>(*gui[i]);
 
 		if (!r.isClickable())
 			// Object isn't clickable, don't check
@@ -929,34 +976,18 @@ Renderable *GraphicsManager::getGUIObjectAt(float x, float y) const {
 }
 
 Renderable *GraphicsManager::getWorldObjectAt(float x, float y) const {
-	if (QueueMan.isQueueEmpty(kQueueVisibleWorldObject))
-		return 0;
-
 	float x1, y1, z1, x2, y2, z2;
 	if (!unproject(x, y, x1, y1, z1, x2, y2, z2))
 		return 0;
 
-	Renderable *object = 0;
-
-	QueueMan.lockQueue(kQueueVisibleWorldObject);
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
-
-	for (std::list<Queueable *>::const_iterator o = objects.begin(); o != objects.end(); ++o) {
-		Renderable &r = static_cast<Renderable &>(**o);
-
-		if (!r.isClickable())
-			// Object isn't clickable, don't check
-			continue;
+	// The tree only knows the bounds, the objects themselves decide whether they're hit
+	const AABBTree::RayTest isHit = [&](void *object) {
+		return static_cast<Renderable *>(object)->isIn(x1, y1, z1, x2, y2, z2);
+	};
 
-		// If the line intersects with the object, return it
-		if (r.isIn(x1, y1, z1, x2, y2, z2)) {
-			object = &r;
-			break;
-		}
-	}
+	std::lock_guard<std::mutex> lock(_pickMutex);
 
-	QueueMan.unlockQueue(kQueueVisibleWorldObject);
-	return object;
+	return static_cast<Renderable *>(_pickTree.rayCast(glm::vec3(x1, y1, z1), glm::vec3(x2, y2, z2), isHit));
 }
 
 Renderable *GraphicsManager::getObjectAt(float x, float y) {
@@ -971,28 +1002,49 @@ Renderable *GraphicsManager::getObjectAt(float x, float y) {
 	return 0;
 }
 
+void GraphicsManager::updatePickable(Renderable &object) {
+	// Decide and update under the lock, or two threads could undo each other's changes
+	std::lock_guard<std::mutex> lock(_pickMutex);
+
+	float min[3], max[3];
+	if (!object.getPickBound(min, max)) {
+		if (object._pickLeaf != AABBTree::kInvalidLeaf)
+			_pickTree.remove(object._pickLeaf);
+
+		object._pickLeaf = AABBTree::kInvalidLeaf;
+		return;
+	}
+
+	if (object._pickLeaf == AABBTree::kInvalidLeaf)
+		object._pickLeaf = _pickTree.insert(min, max, &object);
+	else
+		_pickTree.move(object._pickLeaf, min, max);
+}
+
 void GraphicsManager::buildNewTextures() {
 	QueueMan.lockQueue(kQueueNewShader);
-	const std::list<Queueable *> &shadq = QueueMan.getQueue(kQueueNewShader);
+	const std::vector<Queueable *> &shadq = QueueMan.getQueue(kQueueNewShader);
 	if (shadq.empty()) {
 		QueueMan.unlockQueue(kQueueNewShader);
 	} else {
-		for (std::list<Queueable *>::const_iterator t = shadq.begin(); t != shadq.end(); ++t)
-			static_cast<GLContainer *>(*t)->rebuild();
+		for (size_t i = 0; i < shadq.size(); i++)
+			if (shadq[i])
+				static_cast<GLContainer *>(shadq[i])->rebuild();
 
 		QueueMan.clearQueue(kQueueNewShader);
 		QueueMan.unlockQueue(kQueueNewShader);
 	}
 
 	QueueMan.lockQueue(kQueueNewTexture);
-	const std::list<Queueable *> &text = QueueMan.getQueue(kQueueNewTexture);
+	const std::vector<Queueable *> &text = QueueMan.getQueue(kQueueNewTexture);
 	if (text.empty()) {
 		QueueMan.unlockQueue(kQueueNewTexture);
 		return;
 	}
 
-	for (std::list<Queueable *>::const_iterator t = text.begin(); t != text.end(); ++t)
-		static_cast<GLContainer *>(*t)->rebuild();
+	for (size_t i = 0; i < text.size(); i++)
+		if (text[i])
+			static_cast<GLContainer *>(text[i])->rebuild();
 
 	QueueMan.clearQueue(kQueueNewTexture);
 	QueueMan.unlockQueue(kQueueNewTexture);
@@ -1034,11 +1086,14 @@ bool GraphicsManager::playVideo() {
 	glLoadIdentity();
 
 	QueueMan.lockQueue(kQueueVisibleVideo);
-	const std::list<Queueable *> &videos = QueueMan.getQueue(kQueueVisibleVideo);
+	const std::vector<Queueable *> &videos = QueueMan.getQueue(kQueueVisibleVideo);
+
+	for (size_t i = 0; i < videos.size(); i++) {
+		if (!videos[i])
+			continue;
 
-	for (std::list<Queueable *>::const_iterator v = videos.begin(); v != videos.end(); ++v) {
 		glPushMatrix();
-		static_cast<Renderable *>(*v)->render(kRenderPassAll);
+		static_cast<Renderable *>(videos[i])->render(kRenderPassAll);
 		glPopMatrix();
 	}
 
@@ -1081,27 +1136,33 @@ bool GraphicsManager::renderWorld() {
 	_modelview = glm::translate(_modelview, glm::vec3(-cPos[0], -cPos[1], -cPos[2]));
 
 	QueueMan.lockQueue(kQueueVisibleWorldObject);
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
+	const std::vector<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
 
 	buildNewTextures();
 
 	_animationThread.flush();
 
+	cullWorldObjects(objects);
+
 	// Draw opaque objects
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
-	     o != objects.rend(); ++o) {
+	for (size_t i = _visibleWorldObjects.size(); i-- > 0; ) {
+		Queueable *object = objects[_visibleWorldObjects[i]];
+		if (!object)
+			continue;
 
 		glPushMatrix();
-		static_cast<Renderable *>(*o)->render(kRenderPassOpaque);
+		static_cast<Renderable *>(object)->render(kRenderPassOpaque);
 		glPopMatrix();
 	}
 
 	// Draw transparent objects
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
-	     o != objects.rend(); ++o) {
+	for (size_t i = _visibleWorldObjects.size(); i-- > 0; ) {
+		Queueable *object = objects[_visibleWorldObjects[i]];
+		if (!object)
+			continue;
 
 		glPushMatrix();
-		static_cast<Renderable *>(*o)->render(kRenderPassTransparent);
+		static_cast<Renderable *>(object)->render(kRenderPassTransparent);
 		glPopMatrix();
 	}
 
@@ -1109,6 +1170,34 @@ bool GraphicsManager::renderWorld() {
 	return true;
 }
 
+void GraphicsManager::cullWorldObjects(const std::vector<Queueable *> &objects) {
+	_frustum.set(_perspective * _modelview);
+
+	const bool culling = _frustumCulling.load(std::memory_order_relaxed);
+
+	_visibleWorldObjects.clear();
+	_visibleWorldObjects.reserve(objects.size());
+
+	size_t culled = 0;
+	for (size_t i = 0; i < objects.size(); i++) {
+		if (!objects[i])
+			continue;
+
+		float min[3], max[3];
+		if (culling && static_cast<Renderable *>(objects[i])->getWorldBound(min, max) &&
+		    !_frustum.isVisible(min, max)) {
+
+			culled++;
+			continue;
+		}
+
+		_visibleWorldObjects.push_back(i);
+	}
+
+	_worldObjectsVisible.store(_visibleWorldObjects.size(), std::memory_order_relaxed);
+	_worldObjectsCulled.store(culled, std::memory_order_relaxed);
+}
+
 bool GraphicsManager::renderGUIFront() {
 	return renderGUI(_scalingType, kQueueVisibleGUIFrontObject, false);
 }
@@ -1145,15 +1234,16 @@ bool GraphicsManager::renderGUI(ScalingType scalingType, QueueType guiQueue, boo
 	glLoadIdentity();
 
 	QueueMan.lockQueue(guiQueue);
-	const std::list<Queueable *> &gui = QueueMan.getQueue(guiQueue);
+	const std::vector<Queueable *> &gui = QueueMan.getQueue(guiQueue);
 
 	buildNewTextures();
 
-	for (std::list<Queueable *>::const_reverse_iterator g = gui.rbegin();
-	     g != gui.rend(); ++g) {
+	for (size_t i = gui.size(); i-- > 0; ) {
+		if (!gui[i])
+			continue;
 
 		glPushMatrix();
-		static_cast<Renderable *>(*g)->render(kRenderPassAll);
+		static_cast<Renderable *>(gui[i])->render(kRenderPassAll);
 		glPopMatrix();
 	}
 
@@ -1225,17 +1315,22 @@ bool GraphicsManager::renderWorldShader() {
 	_modelview = glm::translate(_modelview, glm::vec3(-cPos[0], -cPos[1], -cPos[2]));
 
 	QueueMan.lockQueue(kQueueVisibleWorldObject);
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
+	const std::vector<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
 
 	buildNewTextures();
 
 	_animationThread.flush();
 
+	cullWorldObjects(objects);
+
 	glm::mat4 ident;
 	RenderMan.clear();
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
-	     o != objects.rend(); ++o) {
-		static_cast<Renderable *>(*o)->queueRender(ident);
+	for (size_t i = _visibleWorldObjects.size(); i-- > 0; ) {
+		Queueable *object = objects[_visibleWorldObjects[i]];
+		if (!object)
+			continue;
+
+		static_cast<Renderable *>(object)->queueRender(ident);
 	}
 	RenderMan.sort();
 	RenderMan.render();
@@ -1268,15 +1363,17 @@ bool GraphicsManager::renderGUIShader(ScalingType UNUSED(scalingType), QueueType
 	_projectionInv = _orthoInv;
 
 	QueueMan.lockQueue(guiQueue);
-	const std::list<Queueable *> &gui = QueueMan.getQueue(guiQueue);
+	const std::vector<Queueable *> &gui = QueueMan.getQueue(guiQueue);
 	_modelview = glm::mat4();
 
 	buildNewTextures();
 
 	glm::mat4 ident;
-	for (std::list<Queueable *>::const_reverse_iterator g = gui.rbegin();
-	     g != gui.rend(); ++g) {
-		static_cast<Renderable *>(*g)->renderImmediate(ident);
+	for (size_t i = gui.size(); i-- > 0; ) {
+		if (!gui[i])
+			continue;
+
+		static_cast<Renderable *>(gui[i])->renderImmediate(ident);
 	}
 
 	QueueMan.unlockQueue(guiQueue);
@@ -1330,7 +1427,7 @@ void GraphicsManager::renderScene() {
 	cleanupAbandoned();
 
 	if (EventMan.quitRequested() || (_frameLock.load(std::memory_order_acquire) > 0)) {
-		_frameEndSignal.store(true, std::memory_order_release);
+		_frameEnd.signal();
 
 		return;
 	}
@@ -1362,7 +1459,7 @@ void GraphicsManager::renderScene() {
 
 	endScene();
 
-	_frameEndSignal.store(true, std::memory_order_release);
+	_frameEnd.signal();
 }
 
 const glm::mat4 &GraphicsManager::getProjectionMatrix() const {
@@ -1412,9 +1509,10 @@ bool GraphicsManager::isGL3() const {
 void GraphicsManager::rebuildGLContainers() {
 	QueueMan.lockQueue(kQueueGLContainer);
 
-	const std::list<Queueable *> &cont = QueueMan.getQueue(kQueueGLContainer);
-	for (std::list<Queueable *>::const_iterator c = cont.begin(); c != cont.end(); ++c)
-		static_cast<GLContainer *>(*c)->rebuild();
+	const std::vector<Queueable *> &cont = QueueMan.getQueue(kQueueGLContainer);
+	for (size_t i = 0; i < cont.size(); i++)
+		if (cont[i])
+			static_cast<GLContainer *>(cont[i])->rebuild();
 
 	QueueMan.unlockQueue(kQueueGLContainer);
 }
@@ -1422,9 +1520,10 @@ void GraphicsManager::rebuildGLContainers() {
 void GraphicsManager::destroyGLContainers() {
 	QueueMan.lockQueue(kQueueGLContainer);
 
-	const std::list<Queueable *> &cont = QueueMan.getQueue(kQueueGLContainer);
-	for (std::list<Queueable *>::const_iterator c = cont.begin(); c != cont.end(); ++c)
-		static_cast<GLContainer *>(*c)->destroy();
+	const std::vector<Queueable *> &cont = QueueMan.getQueue(kQueueGLContainer);
+	for (size_t i = 0; i < cont.size(); i++)
+		if (cont[i])
+			static_cast<GLContainer *>(cont[i])->destroy();
 
 	QueueMan.unlockQueue(kQueueGLContainer);
 }
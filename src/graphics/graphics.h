@@ -39,6 +39,9 @@
 
 #include "src/graphics/types.h"
 #include "src/graphics/windowman.h"
+#include "src/graphics/frustum.h"
+#include "src/graphics/aabbtree.h"
+#include "src/graphics/framefence.h"
 
 #include "src/graphics/aurora/animationthread.h"
 
@@ -52,6 +55,7 @@ namespace Aurora {
 
 class FPSCounter;
 class Cursor;
+class Queueable;
 class Renderable;
 
 /** The graphics manager. */
@@ -79,6 +83,8 @@ public:
 	bool supportMultipleTextures() const;
 	/** Return the number of texture units for multiple textures. */
 	size_t getMultipleTextureCount() const;
+	/** Do we have support for instanced rendering? */
+	bool supportInstancing() const;
 
 	/** Are we currently running an OpenGL 3.x context? */
 	bool isGL3() const;
@@ -97,6 +103,13 @@ public:
 	/** Enable/Disable face culling. */
 	void setCullFace(bool enabled, GLenum mode = GL_BACK);
 
+	/** Enable/Disable skipping world objects outside the view frustum. */
+	void setFrustumCulling(bool enabled);
+	/** Are world objects outside the view frustum skipped? */
+	bool getFrustumCulling() const;
+	/** Return the number of world objects rendered and culled in the last frame. */
+	void getCullingStats(size_t &visible, size_t &culled) const;
+
 	/** Configure scaling type for the GUI. */
 	void setGUIScale(ScalingType scaling);
 	/** Configure the original size of the GUI. */
@@ -124,6 +137,10 @@ public:
 	/** Get the object at this screen position. */
 	Renderable *getObjectAt(float x, float y);
 
+	/** Add, move or remove this object in the picking tree, depending on
+	 *  whether it's a visible, clickable world object and where it is. */
+	void updatePickable(Renderable &object);
+
 	/** Recalculate all object distances to the camera and resort the objects. */
 	void recalculateObjectDistances();
 
@@ -147,6 +164,12 @@ public:
 	 */
 	void unlockFrame();
 
+	/** Return how often and how long other threads waited in lockFrame(). */
+	FrameFence::Stats getFrameLockStats() const;
+
+	/** Return the number of frames that have ended so far. */
+	uint64_t getFrameCount() const;
+
 	/** Create a new unique renderable ID. */
 	uint32_t createRenderableID();
 
@@ -198,6 +221,7 @@ private:
 	bool   _needManualDeS3TC;        ///< Do we need to do manual S3TC DXTn decompression?
 	bool   _supportMultipleTextures; ///< Do we have support for multiple textures?
 	size_t _multipleTextureCount;    ///< The number of texture units for multiple textures.
+	bool   _supportInstancing;       ///< Do we have support for instanced rendering?
 
 	WindowManager::RenderType _renderType;
 
@@ -206,6 +230,19 @@ private:
 	bool   _cullFaceEnabled;
 	GLenum _cullFaceMode;
 
+	std::atomic<bool> _frustumCulling; ///< Skip world objects outside the view frustum?
+
+	Frustum _frustum; ///< The view frustum of the current frame.
+
+	/** Indices into the world object queue of the objects inside the view frustum. */
+	std::vector<size_t> _visibleWorldObjects;
+
+	std::atomic<size_t> _worldObjectsVisible; ///< World objects rendered in the last frame.
+	std::atomic<size_t> _worldObjectsCulled;  ///< World objects culled in the last frame.
+
+	AABBTree _pickTree; ///< The bounds of all visible, clickable world objects.
+	mutable std::mutex _pickMutex; ///< A mutex protecting the picking tree.
+
 	ProjectType _projectType;
 
 	float _viewAngle;
@@ -230,7 +267,7 @@ private:
 	glm::mat4 _modelviewInv;   ///< The inverse of our modelview matrix.
 
 	std::atomic<uint32_t> _frameLock;
-	std::atomic<bool>   _frameEndSignal;
+	FrameFence            _frameEnd; ///< Signaled at the end of every frame.
 
 	Cursor     *_cursor;       ///< The current cursor.
 
@@ -273,6 +310,9 @@ private:
 
 	void buildNewTextures();
 
+	/** Collect the world objects inside the current view frustum. */
+	void cullWorldObjects(const std::vector<Queueable *> &objects);
+
 	void beginScene();
 	bool playVideo();
 	bool renderWorld();
@@ -28,7 +28,7 @@
 
 #include "src/common/util.h"
 #include "src/common/error.h"
-#include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/graphics.h"
 
@@ -227,27 +227,28 @@ void ImageDecoder::decompress(MipMap &out, const MipMap &in, PixelFormatRaw form
 
 	out.data = std::make_unique<byte[]>(out.size);
 
-	std::unique_ptr<Common::MemoryReadStream> stream = std::make_unique<Common::MemoryReadStream>(in.data.get(), in.size);
+	Common::ThreadPool &pool = getThreadPool();
 
 	if      (format == kPixelFormatDXT1)
-		decompressDXT1(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT1(out.data.get(), in.data.get(), in.size, out.width, out.height, out.width * 4, &pool);
 	else if (format == kPixelFormatDXT3)
-		decompressDXT3(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT3(out.data.get(), in.data.get(), in.size, out.width, out.height, out.width * 4, &pool);
 	else if (format == kPixelFormatDXT5)
-		decompressDXT5(out.data.get(), *stream, out.width, out.height, out.width * 4);
+		decompressDXT5(out.data.get(), in.data.get(), in.size, out.width, out.height, out.width * 4, &pool);
 }
 
 void ImageDecoder::decompress() {
 	if (!_compressed)
 		return;
 
-	for (MipMaps::iterator m = _mipMaps.begin(); m != _mipMaps.end(); ++m) {
+	// All mip maps and layers are independent of each other
+	getThreadPool().parallelFor(_mipMaps.size(), [this](size_t i) {
 		MipMap decompressed(this);
 
-		decompress(decompressed, **m, _formatRaw);
+		decompress(decompressed, *_mipMaps[i], _formatRaw);
 
-		decompressed.swap(**m);
-	}
+		decompressed.swap(*_mipMaps[i]);
+	});
 
 	_format     = kPixelFormatRGBA;
 	_formatRaw  = kPixelFormatRGBA8;
@@ -255,6 +256,13 @@ void ImageDecoder::decompress() {
 	_compressed = false;
 }
 
+Common::ThreadPool &ImageDecoder::getThreadPool() {
+	// The thread decoding an image helps out, so one thread less will do
+	static Common::ThreadPool pool(MAX<size_t>(Common::ThreadPool::getHardwareThreadCount() - 1, 1), "images");
+
+	return pool;
+}
+
 bool ImageDecoder::dumpTGA(const Common::UString &fileName) const {
 	if (_mipMaps.size() < 1)
 		return false;
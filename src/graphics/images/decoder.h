@@ -39,6 +39,7 @@
 namespace Common {
 	class SeekableReadStream;
 	class UString;
+	class ThreadPool;
 }
 
 namespace Graphics {
@@ -133,6 +134,9 @@ protected:
 	TXI _txi;
 
 	static void decompress(MipMap &out, const MipMap &in, PixelFormatRaw format);
+
+	/** Return the worker threads shared by all images, for processing mip maps and layers in parallel. */
+	static Common::ThreadPool &getThreadPool();
 };
 
 } // End of namespace Graphics
@@ -22,198 +22,282 @@
  *  Manual S3TC DXTn decompression methods.
  */
 
+#include <cstring>
+
+#include <memory>
+
 #include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/endianness.h"
 #include "src/common/readstream.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/images/s3tc.h"
 
 namespace Graphics {
 
-static inline uint32_t convert565To8888(uint16_t color) {
-	return ((color & 0x1F) << 11) | ((color & 0x7E0) << 13) | ((color & 0xF800) << 16) | 0xFF;
-}
-
-static inline uint32_t interpolate32(double weight, uint32_t color_0, uint32_t color_1) {
-	byte r[3], g[3], b[3], a[3];
-	r[0] = color_0 >> 24;
-	r[1] = color_1 >> 24;
-	r[2] = (byte)((1.0f - weight) * (double)r[0] + weight * (double)r[1]);
-	g[0] = (color_0 >> 16) & 0xFF;
-	g[1] = (color_1 >> 16) & 0xFF;
-	g[2] = (byte)((1.0f - weight) * (double)g[0] + weight * (double)g[1]);
-	b[0] = (color_0 >> 8) & 0xFF;
-	b[1] = (color_1 >> 8) & 0xFF;
-	b[2] = (byte)((1.0f - weight) * (double)b[0] + weight * (double)b[1]);
-	a[0] = color_0 & 0xFF;
-	a[1] = color_1 & 0xFF;
-	a[2] = (byte)((1.0f - weight) * (double)a[0] + weight * (double)a[1]);
-	return r[2] << 24 | g[2] << 16 | b[2] << 8 | a[2];
-}
-
-struct DXT1Texel {
-	uint16_t color_0;
-	uint16_t color_1;
-	uint32_t pixels;
+/** Only spread images with at least that many block rows over the thread pool. */
+static const uint32_t kParallelBlockRows = 64;
+/** The number of block rows one thread decodes in one go. */
+static const uint32_t kBlockRowsPerJob   = 16;
+
+/** The weights of the interpolated colors. */
+enum Blend {
+	kBlendThird     = 0, ///< 2/3 of the first color, 1/3 of the second.
+	kBlendTwoThirds = 1, ///< 1/3 of the first color, 2/3 of the second.
+	kBlendHalf      = 2, ///< Half of each.
+	kBlendMAX
 };
 
-#define READ_DXT1_TEXEL(x) \
-	x.color_0 = src.readUint16LE(); \
-	x.color_1 = src.readUint16LE(); \
-	x.pixels = src.readUint32BE()
+/** Tables with all interpolations of the 5- and 6-bit color channels.
+ *
+ *  These are calculated exactly like the old per-block floating point
+ *  interpolation, so that the results stay the same down to the bit.
+ */
+struct BlendTables {
+	byte channel5[kBlendMAX][32][32];
+	byte channel6[kBlendMAX][64][64];
+
+	byte alpha[kBlendMAX]; ///< Interpolation of two fully opaque alpha values.
 
-void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
-	for (int32_t ty = height; ty > 0; ty -= 4) {
-		for (uint32_t tx = 0; tx < width; tx += 4) {
-			DXT1Texel tex;
-			READ_DXT1_TEXEL(tex);
-			uint32_t blended[4];
-
-			blended[0] = convert565To8888(tex.color_0);
-			blended[1] = convert565To8888(tex.color_1);
-
-			if (tex.color_0 > tex.color_1) {
-				blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-				blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-			} else {
-				blended[2] = interpolate32(0.5f, blended[0], blended[1]);
-				blended[3] = 0;
-			}
-
-			uint32_t cpx = tex.pixels;
-			uint32_t blockWidth = MIN<uint32_t>(width, 4);
-			uint32_t blockHeight = MIN<uint32_t>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32_t destX = tx + x;
-					const uint32_t destY = height - 1 - (ty - blockHeight + y);
-
-					const uint32_t pixel =  blended[cpx & 3];
-
-					cpx >>= 2;
-
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
-				}
-			}
+	BlendTables() {
+		static const double kWeights[kBlendMAX] = { 0.333333f, 0.666666f, 0.5f };
+
+		for (int w = 0; w < kBlendMAX; w++) {
+			for (int i = 0; i < 32; i++)
+				for (int j = 0; j < 32; j++)
+					channel5[w][i][j] = interpolate(kWeights[w], i << 3, j << 3);
+
+			for (int i = 0; i < 64; i++)
+				for (int j = 0; j < 64; j++)
+					channel6[w][i][j] = interpolate(kWeights[w], i << 2, j << 2);
+
+			alpha[w] = interpolate(kWeights[w], 0xFF, 0xFF);
 		}
 	}
-}
 
-struct DXT23Texel : public DXT1Texel {
-	uint16_t alpha[4];
+	static byte interpolate(double weight, byte a, byte b) {
+		return (byte)((1.0f - weight) * (double)a + weight * (double)b);
+	}
 };
 
-#define READ_DXT3_TEXEL(x) \
-	x.alpha[0] = src.readUint16LE(); \
-	x.alpha[1] = src.readUint16LE(); \
-	x.alpha[2] = src.readUint16LE(); \
-	x.alpha[3] = src.readUint16LE(); \
-	READ_DXT1_TEXEL(x)
+static const BlendTables &getBlendTables() {
+	static const BlendTables tables;
 
-void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
-	for (int32_t ty = height; ty > 0; ty -= 4) {
-		for (uint32_t tx = 0; tx < width; tx += 4) {
-			DXT23Texel tex;
-			uint32_t blended[4];
-			READ_DXT3_TEXEL(tex);
-
-			blended[0] = convert565To8888(tex.color_0) & 0xFFFFFF00;
-			blended[1] = convert565To8888(tex.color_1) & 0xFFFFFF00;
-			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-
-			uint32_t cpx = tex.pixels;
-			uint32_t blockWidth = MIN<uint32_t>(width, 4);
-			uint32_t blockHeight = MIN<uint32_t>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32_t destX = tx + x;
-					const uint32_t destY = height - 1 - (ty - blockHeight + y);
-
-					const uint32_t alpha = (tex.alpha[y] >> (x * 4)) & 0xF;
-					const uint32_t pixel = blended[cpx & 3] | alpha << 4;
-
-					cpx >>= 2;
-
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
-				}
-			}
-		}
+	return tables;
+}
+
+/** Where the alpha byte of a pixel in memory order lives within a native uint32_t. */
+#if defined(XOREOS_LITTLE_ENDIAN)
+static const uint32_t kAlphaShift = 24;
+#else
+static const uint32_t kAlphaShift =  0;
+#endif
+
+/** A pixel in memory order: red, green, blue, alpha. */
+static inline uint32_t makePixel(byte r, byte g, byte b, byte a) {
+	const byte pixel[4] = { r, g, b, a };
+
+	uint32_t value;
+	std::memcpy(&value, pixel, 4);
+
+	return value;
+}
+
+/** Build the four colors of a block.
+ *
+ *  @param hasAlpha If true, this is a DXT3/5 block, where the alpha is
+ *                  stored separately and there's no 3-color mode.
+ */
+static inline void buildPalette(uint32_t *palette, const byte *block, bool hasAlpha) {
+	const BlendTables &tables = getBlendTables();
+
+	const uint16_t color0 = READ_LE_UINT16(block);
+	const uint16_t color1 = READ_LE_UINT16(block + 2);
+
+	const uint32_t r0 = color0 >> 11, g0 = (color0 >> 5) & 0x3F, b0 = color0 & 0x1F;
+	const uint32_t r1 = color1 >> 11, g1 = (color1 >> 5) & 0x3F, b1 = color1 & 0x1F;
+
+	const byte alpha = hasAlpha ? 0x00 : 0xFF;
+
+	palette[0] = makePixel(r0 << 3, g0 << 2, b0 << 3, alpha);
+	palette[1] = makePixel(r1 << 3, g1 << 2, b1 << 3, alpha);
+
+	if (hasAlpha || (color0 > color1)) {
+		const byte alpha2 = hasAlpha ? 0x00 : tables.alpha[kBlendThird];
+		const byte alpha3 = hasAlpha ? 0x00 : tables.alpha[kBlendTwoThirds];
+
+		palette[2] = makePixel(tables.channel5[kBlendThird][r0][r1],
+		                       tables.channel6[kBlendThird][g0][g1],
+		                       tables.channel5[kBlendThird][b0][b1], alpha2);
+		palette[3] = makePixel(tables.channel5[kBlendTwoThirds][r0][r1],
+		                       tables.channel6[kBlendTwoThirds][g0][g1],
+		                       tables.channel5[kBlendTwoThirds][b0][b1], alpha3);
+	} else {
+		palette[2] = makePixel(tables.channel5[kBlendHalf][r0][r1],
+		                       tables.channel6[kBlendHalf][g0][g1],
+		                       tables.channel5[kBlendHalf][b0][b1], tables.alpha[kBlendHalf]);
+		palette[3] = 0;
 	}
 }
 
-struct DXT45Texel : public DXT1Texel {
-	byte alpha_0;
-	byte alpha_1;
-	uint64_t alphabl;
-};
+/** Build the eight alpha values of a DXT5 block. */
+static inline void buildAlphaPalette(byte *alpha, const byte *block) {
+	const uint32_t a0 = alpha[0] = block[0];
+	const uint32_t a1 = alpha[1] = block[1];
+
+	if (a0 > a1) {
+		for (uint32_t i = 1; i < 7; i++)
+			alpha[1 + i] = ((7 - i) * a0 + i * a1 + 3) / 7;
+	} else {
+		for (uint32_t i = 1; i < 5; i++)
+			alpha[1 + i] = ((5 - i) * a0 + i * a1 + 2) / 5;
 
-static uint64_t readUint48LE(Common::SeekableReadStream &src) {
-	uint64_t output = src.readUint32LE();
-	return output | ((uint64_t)src.readUint16LE() << 32);
+		alpha[6] = 0;
+		alpha[7] = 255;
+	}
 }
 
-#define READ_DXT5_TEXEL(x) \
-	x.alpha_0 = src.readByte(); \
-	x.alpha_1 = src.readByte(); \
-	x.alphabl = readUint48LE(src); \
-	READ_DXT1_TEXEL(x)
+/** The 16 pixels of a decoded block, row by row. */
+typedef uint32_t BlockPixels[16];
 
-void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
-	for (int32_t ty = height; ty > 0; ty -= 4) {
-		for (uint32_t tx = 0; tx < width; tx += 4) {
-			uint32_t blended[4];
-			byte alphab[8];
-			DXT45Texel tex;
-			READ_DXT5_TEXEL(tex);
-
-			alphab[0] = tex.alpha_0;
-			alphab[1] = tex.alpha_1;
-
-			if (tex.alpha_0 > tex.alpha_1) {
-				alphab[2] = (byte)((6.0f * (double)alphab[0] + 1.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[3] = (byte)((5.0f * (double)alphab[0] + 2.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[4] = (byte)((4.0f * (double)alphab[0] + 3.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[5] = (byte)((3.0f * (double)alphab[0] + 4.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[6] = (byte)((2.0f * (double)alphab[0] + 5.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[7] = (byte)((1.0f * (double)alphab[0] + 6.0f * (double)alphab[1] + 3.0f) / 7.0f);
-			} else {
-				alphab[2] = (byte)((4.0f * (double)alphab[0] + 1.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[3] = (byte)((3.0f * (double)alphab[0] + 2.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[4] = (byte)((2.0f * (double)alphab[0] + 3.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[5] = (byte)((1.0f * (double)alphab[0] + 4.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[6] = 0;
-				alphab[7] = 255;
-			}
-
-			blended[0] = convert565To8888(tex.color_0) & 0xFFFFFF00;
-			blended[1] = convert565To8888(tex.color_1) & 0xFFFFFF00;
-			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-
-			uint32_t cpx = tex.pixels;
-			uint32_t blockWidth = MIN<uint32_t>(width, 4);
-			uint32_t blockHeight = MIN<uint32_t>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					const uint32_t destX = tx + x;
-					const uint32_t destY = height - 1 - (ty - blockHeight + y);
-
-					const uint32_t alpha = alphab[(tex.alphabl >> (3 * (4 * (3 - y) + x))) & 7];
-					const uint32_t pixel = blended[cpx & 3] | alpha;
-
-					cpx >>= 2;
-
-					if ((destX < width) && (destY < height))
-						WRITE_BE_UINT32(dest + destY * pitch + destX * 4, pixel);
-				}
-			}
+static inline void decodeDXT1Block(BlockPixels &pixels, const byte *block) {
+	uint32_t palette[4];
+	buildPalette(palette, block, false);
+
+	const uint32_t indices = READ_LE_UINT32(block + 4);
+	for (int i = 0; i < 16; i++)
+		pixels[i] = palette[(indices >> (2 * i)) & 3];
+}
+
+static inline void decodeDXT3Block(BlockPixels &pixels, const byte *block) {
+	uint32_t palette[4];
+	buildPalette(palette, block + 8, true);
+
+	const uint64_t alphas  = READ_LE_UINT64(block);
+	const uint32_t indices = READ_LE_UINT32(block + 12);
+
+	for (int i = 0; i < 16; i++) {
+		const uint32_t alpha = ((alphas >> (4 * i)) & 0xF) << 4;
+
+		pixels[i] = palette[(indices >> (2 * i)) & 3] | (alpha << kAlphaShift);
+	}
+}
+
+static inline void decodeDXT5Block(BlockPixels &pixels, const byte *block) {
+	uint32_t palette[4];
+	buildPalette(palette, block + 8, true);
+
+	byte alpha[8];
+	buildAlphaPalette(alpha, block);
+
+	const uint64_t alphas  = READ_LE_UINT64(block) >> 16;
+	const uint32_t indices = READ_LE_UINT32(block + 12);
+
+	for (int i = 0; i < 16; i++) {
+		const uint32_t a = alpha[(alphas >> (3 * i)) & 7];
+
+		pixels[i] = palette[(indices >> (2 * i)) & 3] | (a << kAlphaShift);
+	}
+}
+
+typedef void (*BlockDecoder)(BlockPixels &pixels, const byte *block);
+
+/** Decode the block rows [rowStart, rowEnd) of an image. */
+static void decodeBlockRows(BlockDecoder decodeBlock, uint32_t blockSize, byte *dest, const byte *src,
+                            uint32_t width, uint32_t height, uint32_t pitch, uint32_t rowStart, uint32_t rowEnd) {
+
+	const uint32_t blocksPerRow = (width + 3) / 4;
+
+	BlockPixels pixels;
+
+	for (uint32_t by = rowStart; by < rowEnd; by++) {
+		const byte *block = src + (size_t)by * blocksPerRow * blockSize;
+		byte *destRow = dest + (size_t)by * 4 * pitch;
+
+		// The last row and column of blocks stick out of images not a multiple of 4 in size
+		const uint32_t blockHeight = MIN<uint32_t>(height - by * 4, 4);
+
+		for (uint32_t bx = 0; bx < blocksPerRow; bx++, block += blockSize) {
+			const uint32_t blockWidth = MIN<uint32_t>(width - bx * 4, 4);
+
+			decodeBlock(pixels, block);
+
+			byte *destBlock = destRow + bx * 4 * 4;
+
+			for (uint32_t y = 0; y < blockHeight; y++)
+				std::memcpy(destBlock + y * pitch, pixels + y * 4, blockWidth * 4);
 		}
 	}
 }
 
+static void decompressDXT(BlockDecoder decodeBlock, uint32_t blockSize, byte *dest, const byte *src, size_t size,
+                       uint32_t width, uint32_t height, uint32_t pitch, Common::ThreadPool *pool) {
+
+	const uint32_t blockRows = (height + 3) / 4;
+	const size_t   dataSize  = (size_t)((width + 3) / 4) * blockRows * blockSize;
+
+	if (size < dataSize)
+		throw Common::Exception(Common::kReadError);
+
+	// Make sure the tables exist before the threads go at them
+	getBlendTables();
+
+	if (!pool || (blockRows < kParallelBlockRows)) {
+		decodeBlockRows(decodeBlock, blockSize, dest, src, width, height, pitch, 0, blockRows);
+		return;
+	}
+
+	const size_t jobCount = (blockRows + kBlockRowsPerJob - 1) / kBlockRowsPerJob;
+
+	pool->parallelFor(jobCount, [&](size_t job) {
+		const uint32_t rowStart = job * kBlockRowsPerJob;
+		const uint32_t rowEnd   = MIN<uint32_t>(rowStart + kBlockRowsPerJob, blockRows);
+
+		decodeBlockRows(decodeBlock, blockSize, dest, src, width, height, pitch, rowStart, rowEnd);
+	});
+}
+
+static void decompressDXT(BlockDecoder decodeBlock, uint32_t blockSize, byte *dest,
+                       Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
+
+	const size_t dataSize = (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+
+	std::unique_ptr<byte[]> data = std::make_unique<byte[]>(dataSize);
+	if (src.read(data.get(), dataSize) != dataSize)
+		throw Common::Exception(Common::kReadError);
+
+	decompressDXT(decodeBlock, blockSize, dest, data.get(), dataSize, width, height, pitch, 0);
+}
+
+void decompressDXT1(byte *dest, const byte *src, size_t size, uint32_t width, uint32_t height, uint32_t pitch,
+                    Common::ThreadPool *pool) {
+
+	decompressDXT(decodeDXT1Block, 8, dest, src, size, width, height, pitch, pool);
+}
+
+void decompressDXT3(byte *dest, const byte *src, size_t size, uint32_t width, uint32_t height, uint32_t pitch,
+                    Common::ThreadPool *pool) {
+
+	decompressDXT(decodeDXT3Block, 16, dest, src, size, width, height, pitch, pool);
+}
+
+void decompressDXT5(byte *dest, const byte *src, size_t size, uint32_t width, uint32_t height, uint32_t pitch,
+                    Common::ThreadPool *pool) {
+
+	decompressDXT(decodeDXT5Block, 16, dest, src, size, width, height, pitch, pool);
+}
+
+void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
+	decompressDXT(decodeDXT1Block, 8, dest, src, width, height, pitch);
+}
+
+void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
+	decompressDXT(decodeDXT3Block, 16, dest, src, width, height, pitch);
+}
+
+void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
+	decompressDXT(decodeDXT5Block, 16, dest, src, width, height, pitch);
+}
+
 } // End of namespace Graphics
@@ -29,10 +29,25 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class ThreadPool;
 }
 
 namespace Graphics {
 
+/** Decompress S3TC DXTn data into RGBA8 pixels.
+ *
+ *  src has to hold all blocks of the image, otherwise an exception is
+ *  thrown. If a thread pool is given, large images are decoded by several
+ *  threads at once.
+ */
+void decompressDXT1(byte *dest, const byte *src, size_t size, uint32_t width, uint32_t height, uint32_t pitch,
+                    Common::ThreadPool *pool = 0);
+void decompressDXT3(byte *dest, const byte *src, size_t size, uint32_t width, uint32_t height, uint32_t pitch,
+                    Common::ThreadPool *pool = 0);
+void decompressDXT5(byte *dest, const byte *src, size_t size, uint32_t width, uint32_t height, uint32_t pitch,
+                    Common::ThreadPool *pool = 0);
+
+/** Decompress S3TC DXTn data read from a stream into RGBA8 pixels. */
 void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch);
 void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch);
 void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch);
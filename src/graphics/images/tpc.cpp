@@ -26,11 +26,13 @@
 #include <cstring>
 
 #include <memory>
+#include <vector>
 
 #include "src/common/util.h"
 #include "src/common/maths.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/images/tpc.h"
 #include "src/graphics/images/util.h"
@@ -310,20 +312,10 @@ bool TPC::checkAnimated(uint32_t &width, uint32_t &height, uint32_t &dataSize) {
 	return true;
 }
 
-void TPC::deSwizzle(byte *dst, const byte *src, uint32_t width, uint32_t height) {
-	for (uint32_t y = 0; y < height; y++) {
-		for (uint32_t x = 0; x < width; x++) {
-			const uint32_t offset = deSwizzleOffset(x, y, width, height) * 4;
-
-			*dst++ = src[offset + 0];
-			*dst++ = src[offset + 1];
-			*dst++ = src[offset + 2];
-			*dst++ = src[offset + 3];
-		}
-	}
-}
-
 void TPC::readData(Common::SeekableReadStream &tpc, byte encoding) {
+	// The mip maps needing to be de-swizzled, which we do in parallel after reading
+	std::vector<size_t> swizzledMipMaps;
+
 	for (MipMaps::iterator mipMap = _mipMaps.begin(); mipMap != _mipMaps.end(); ++mipMap) {
 
 		// If the texture width is a power of two, the texture memory layout is "swizzled"
@@ -332,31 +324,33 @@ void TPC::readData(Common::SeekableReadStream &tpc, byte encoding) {
 
 		(*mipMap)->data = std::make_unique<byte[]>((*mipMap)->size);
 
-		if (swizzled) {
-			std::vector<byte> tmp((*mipMap)->size);
-
-			if (tpc.read(&tmp[0], (*mipMap)->size) != (*mipMap)->size)
-				throw Common::Exception(Common::kReadError);
-
-			deSwizzle((*mipMap)->data.get(), &tmp[0], (*mipMap)->width, (*mipMap)->height);
+		if (tpc.read((*mipMap)->data.get(), (*mipMap)->size) != (*mipMap)->size)
+			throw Common::Exception(Common::kReadError);
 
-		} else {
-			if (tpc.read((*mipMap)->data.get(), (*mipMap)->size) != (*mipMap)->size)
-				throw Common::Exception(Common::kReadError);
+		if (swizzled) {
+			swizzledMipMaps.push_back(mipMap - _mipMaps.begin());
 
+		} else if (encoding == kEncodingGray) {
 			// Unpacking 8bpp grayscale data into RGB
-			if (encoding == kEncodingGray) {
-				std::unique_ptr<byte[]> dataGray((*mipMap)->data.release());
+			std::unique_ptr<byte[]> dataGray((*mipMap)->data.release());
 
-				(*mipMap)->size = (*mipMap)->width * (*mipMap)->height * 3;
-				(*mipMap)->data = std::make_unique<byte[]>((*mipMap)->size);
+			(*mipMap)->size = (*mipMap)->width * (*mipMap)->height * 3;
+			(*mipMap)->data = std::make_unique<byte[]>((*mipMap)->size);
 
-				for (int i = 0; i < ((*mipMap)->width * (*mipMap)->height); i++)
-					std::memset((*mipMap)->data.get() + i * 3, dataGray[i], 3);
-			}
+			for (int i = 0; i < ((*mipMap)->width * (*mipMap)->height); i++)
+				std::memset((*mipMap)->data.get() + i * 3, dataGray[i], 3);
 		}
 
 	}
+
+	getThreadPool().parallelFor(swizzledMipMaps.size(), [this, &swizzledMipMaps](size_t i) {
+		MipMap &mipMap = *_mipMaps[swizzledMipMaps[i]];
+
+		std::unique_ptr<byte[]> tmp = std::make_unique<byte[]>(mipMap.size);
+		deSwizzle(tmp.get(), mipMap.data.get(), mipMap.width, mipMap.height, 4);
+
+		mipMap.data.swap(tmp);
+	});
 }
 
 void TPC::readTXI(Common::SeekableReadStream &tpc) {
@@ -465,19 +459,18 @@ void TPC::fixupCubeMap() {
 	if (bpp == 0)
 		return;
 
-	// Rotate the cube sides so that they're all oriented correctly
-	for (size_t i = 0; i < getLayerCount(); i++) {
-		for (size_t j = 0; j < getMipMapCount(); j++) {
-			const size_t index = i * getMipMapCount() + j;
-			assert(index < _mipMaps.size());
+	// Rotate the cube sides so that they're all oriented correctly, all mip maps of all sides at once
+	const size_t mipMapCount = getMipMapCount();
 
-			MipMap &mipMap = *_mipMaps[index];
+	getThreadPool().parallelFor(getLayerCount() * mipMapCount, [this, mipMapCount, bpp](size_t index) {
+		assert(index < _mipMaps.size());
 
-			static const int rotation[6] = { 1, 3, 0, 2, 2, 0 };
+		MipMap &mipMap = *_mipMaps[index];
 
-			rotate90(mipMap.data.get(), mipMap.width, mipMap.height, bpp, rotation[i]);
-		}
-	}
+		static const int rotation[6] = { 1, 3, 0, 2, 2, 0 };
+
+		rotate90(mipMap.data.get(), mipMap.width, mipMap.height, bpp, rotation[index / mipMapCount]);
+	});
 
 }
 
@@ -59,8 +59,6 @@ private:
 	bool checkCubeMap(uint32_t &width, uint32_t &height);
 	bool checkAnimated(uint32_t &width, uint32_t &height, uint32_t &dataSize);
 	void fixupCubeMap();
-
-	static void deSwizzle(byte *dst, const byte *src, uint32_t width, uint32_t height);
 };
 
 } // End of namespace Graphics
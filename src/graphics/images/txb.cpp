@@ -23,10 +23,12 @@
  */
 
 #include <memory>
+#include <vector>
 
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/images/txb.h"
 #include "src/graphics/images/util.h"
@@ -164,18 +166,10 @@ void TXB::readHeader(Common::SeekableReadStream &txb, byte &encoding, uint32_t &
 
 }
 
-void TXB::deSwizzle(byte *dst, const byte *src, uint32_t width, uint32_t height, uint8_t bpp) {
-	for (uint32_t y = 0; y < height; y++) {
-		for (uint32_t x = 0; x < width; x++) {
-			const uint32_t offset = deSwizzleOffset(x, y, width, height) * bpp;
-
-			for (uint8_t p = 0; p < bpp; p++)
-				*dst++ = src[offset + p];
-		}
-	}
-}
-
 void TXB::readData(Common::SeekableReadStream &txb, byte encoding) {
+	// The mip maps needing to be de-swizzled, which we do in parallel after reading
+	std::vector<size_t> swizzledMipMaps;
+
 	for (MipMaps::iterator mipMap = _mipMaps.begin(); mipMap != _mipMaps.end(); ++mipMap) {
 		const bool needDeSwizzle = (encoding == kEncodingBGRA) || (encoding == kEncodingGray);
 
@@ -193,29 +187,29 @@ void TXB::readData(Common::SeekableReadStream &txb, byte encoding) {
 			const uint32_t oldSize = (*mipMap)->size;
 			const uint32_t newSize = (*mipMap)->size * 3;
 
-			std::unique_ptr<byte[]> tmp1 = std::make_unique<byte[]>(newSize);
+			std::unique_ptr<byte[]> tmp = std::make_unique<byte[]>(newSize);
 			for (uint32_t i = 0; i < oldSize; i++)
-				tmp1[i * 3 + 0] = tmp1[i * 3 + 1] = tmp1[i * 3 + 2] = (*mipMap)->data[i];
+				tmp[i * 3 + 0] = tmp[i * 3 + 1] = tmp[i * 3 + 2] = (*mipMap)->data[i];
 
-			if (swizzled) {
-				std::unique_ptr<byte[]> tmp2 = std::make_unique<byte[]>(newSize);
-				deSwizzle(tmp2.get(), tmp1.get(), (*mipMap)->width, (*mipMap)->height, 3);
+			(*mipMap)->data.swap(tmp);
+			(*mipMap)->size = newSize;
+		}
 
-				tmp1.swap(tmp2);
-			}
+		if (swizzled)
+			swizzledMipMaps.push_back(mipMap - _mipMaps.begin());
 
-			(*mipMap)->data.swap(tmp1);
-			(*mipMap)->size = newSize;
+	}
 
-		} else if (swizzled) {
-			std::unique_ptr<byte[]> tmp = std::make_unique<byte[]>((*mipMap)->size);
+	const uint32_t bpp = (encoding == kEncodingGray) ? 3 : 4;
 
-			deSwizzle(tmp.get(), (*mipMap)->data.get(), (*mipMap)->width, (*mipMap)->height, 4);
+	getThreadPool().parallelFor(swizzledMipMaps.size(), [this, &swizzledMipMaps, bpp](size_t i) {
+		MipMap &mipMap = *_mipMaps[swizzledMipMaps[i]];
 
-			(*mipMap)->data.swap(tmp);
-		}
+		std::unique_ptr<byte[]> tmp = std::make_unique<byte[]>(mipMap.size);
+		deSwizzle(tmp.get(), mipMap.data.get(), mipMap.width, mipMap.height, bpp);
 
-	}
+		mipMap.data.swap(tmp);
+	});
 }
 
 void TXB::readTXI(Common::SeekableReadStream &txb) {
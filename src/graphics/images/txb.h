@@ -52,8 +52,6 @@ private:
 	void readHeader(Common::SeekableReadStream &txb, byte &encoding, uint32_t &dataSize);
 	void readData(Common::SeekableReadStream &txb, byte encoding);
 	void readTXI(Common::SeekableReadStream &txb);
-
-	static void deSwizzle(byte *dst, const byte *src, uint32_t width, uint32_t height, uint8_t bpp);
 };
 
 } // End of namespace Graphics
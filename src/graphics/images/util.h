@@ -29,6 +29,8 @@
 #include <cstring>
 
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 #include "src/common/types.h"
 #include "src/common/util.h"
@@ -92,6 +94,9 @@ static inline bool hasValidDimensions(PixelFormatRaw format, int32_t width, int3
 	return false;
 }
 
+/** The size of the square tiles images are worked through in, to stay within the cache. */
+static const size_t kImageTileSize = 16;
+
 /** Flip an image horizontally. */
 static inline void flipHorizontally(byte *data, int width, int height, int bpp) {
 	if ((width <= 0) || (height <= 0) || (bpp <= 0))
@@ -100,16 +105,12 @@ static inline void flipHorizontally(byte *data, int width, int height, int bpp)
 	const size_t halfWidth = width / 2;
 	const size_t pitch     = bpp * width;
 
-	std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(bpp);
-
 	while (height-- > 0) {
 		byte *dataStart = data;
 		byte *dataEnd   = data + pitch - bpp;
 
 		for (size_t j = 0; j < halfWidth; j++) {
-			memcpy(buffer.get(), dataStart   , bpp);
-			memcpy(dataStart   , dataEnd     , bpp);
-			memcpy(dataEnd     , buffer.get(), bpp);
+			std::swap_ranges(dataStart, dataStart + bpp, dataEnd);
 
 			dataStart += bpp;
 			dataEnd   -= bpp;
@@ -129,13 +130,9 @@ static inline void flipVertically(byte *data, int width, int height, int bpp) {
 	byte *dataStart = data;
 	byte *dataEnd   = data + (pitch * height) - pitch;
 
-	std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(pitch);
-
 	size_t halfHeight = height / 2;
 	while (halfHeight--) {
-		memcpy(buffer.get(), dataStart   , pitch);
-		memcpy(dataStart   , dataEnd     , pitch);
-		memcpy(dataEnd     , buffer.get(), pitch);
+		std::swap_ranges(dataStart, dataStart + pitch, dataEnd);
 
 		dataStart += pitch;
 		dataEnd   -= pitch;
@@ -144,35 +141,63 @@ static inline void flipVertically(byte *data, int width, int height, int bpp) {
 
 /** Rotate a square image in 90° steps, clock-wise. */
 static inline void rotate90(byte *data, int width, int height, int bpp, int steps) {
-	if ((width <= 0) || (height <= 0) || (bpp <= 0))
+	if ((width <= 0) || (height <= 0) || (bpp <= 0) || (steps <= 0))
 		return;
 
 	assert(width == height);
 
-	while (steps-- > 0) {
-		const size_t n = width;
+	steps %= 4;
+	if (steps == 0)
+		return;
+
+	const size_t n = width;
 
-		const size_t w =  n      / 2;
-		const size_t h = (n + 1) / 2;
+	if (steps == 2) {
+		// Rotating by 180° reverses the order of the pixels
+		byte *dataStart = data;
+		byte *dataEnd   = data + (n * n - 1) * bpp;
 
-		for (size_t x = 0; x < w; x++) {
-			for (size_t y = 0; y < h; y++) {
-				const size_t d0 = ( y          * n +  x         ) * bpp;
-				const size_t d1 = ((n - 1 - x) * n +  y         ) * bpp;
-				const size_t d2 = ((n - 1 - y) * n + (n - 1 - x)) * bpp;
-				const size_t d3 = ( x          * n + (n - 1 - y)) * bpp;
+		for (size_t i = 0; i < ((n * n) / 2); i++) {
+			std::swap_ranges(dataStart, dataStart + bpp, dataEnd);
 
-				for (size_t p = 0; p < (size_t) bpp; p++) {
-					const byte tmp = data[d0 + p];
+			dataStart += bpp;
+			dataEnd   -= bpp;
+		}
+
+		return;
+	}
 
-					data[d0 + p] = data[d1 + p];
-					data[d1 + p] = data[d2 + p];
-					data[d2 + p] = data[d3 + p];
-					data[d3 + p] = tmp;
+	/* Cycle groups of four pixels, one in each quadrant. The quadrant is
+	 * worked through in tiles, so that the four rows and columns touched
+	 * stay in the cache. */
+
+	const size_t w =  n      / 2;
+	const size_t h = (n + 1) / 2;
+
+	for (size_t tileX = 0; tileX < w; tileX += kImageTileSize) {
+		for (size_t tileY = 0; tileY < h; tileY += kImageTileSize) {
+			const size_t endX = MIN(tileX + kImageTileSize, w);
+			const size_t endY = MIN(tileY + kImageTileSize, h);
+
+			for (size_t x = tileX; x < endX; x++) {
+				for (size_t y = tileY; y < endY; y++) {
+					byte *d0 = data + ( y          * n +  x         ) * bpp;
+					byte *d1 = data + ((n - 1 - x) * n +  y         ) * bpp;
+					byte *d2 = data + ((n - 1 - y) * n + (n - 1 - x)) * bpp;
+					byte *d3 = data + ( x          * n + (n - 1 - y)) * bpp;
+
+					if (steps == 1) {
+						std::swap_ranges(d0, d0 + bpp, d1);
+						std::swap_ranges(d1, d1 + bpp, d2);
+						std::swap_ranges(d2, d2 + bpp, d3);
+					} else {
+						std::swap_ranges(d0, d0 + bpp, d3);
+						std::swap_ranges(d3, d3 + bpp, d2);
+						std::swap_ranges(d2, d2 + bpp, d1);
+					}
 				}
 			}
 		}
-
 	}
 }
 
@@ -207,6 +232,39 @@ static inline uint32_t deSwizzleOffset(uint32_t x, uint32_t y, uint32_t width, u
 	return offset;
 }
 
+/** De-"swizzle" a whole image.
+ *
+ *  The swizzled offset of a pixel is the sum of an offset depending only
+ *  on x and one depending only on y, so these are calculated once per row
+ *  and column. The image is written in tiles, which are read from small,
+ *  contiguous parts of the swizzled data.
+ */
+static inline void deSwizzle(byte *dst, const byte *src, uint32_t width, uint32_t height, uint32_t bpp) {
+	std::vector<size_t> offsetX(width), offsetY(height);
+
+	for (uint32_t x = 0; x < width; x++)
+		offsetX[x] = deSwizzleOffset(x, 0, width, height) * bpp;
+	for (uint32_t y = 0; y < height; y++)
+		offsetY[y] = deSwizzleOffset(0, y, width, height) * bpp;
+
+	const size_t pitch = width * bpp;
+
+	for (uint32_t tileY = 0; tileY < height; tileY += kImageTileSize) {
+		for (uint32_t tileX = 0; tileX < width; tileX += kImageTileSize) {
+			const uint32_t endX = MIN<uint32_t>(tileX + kImageTileSize, width);
+			const uint32_t endY = MIN<uint32_t>(tileY + kImageTileSize, height);
+
+			for (uint32_t y = tileY; y < endY; y++) {
+				const byte *srcRow = src + offsetY[y];
+				byte *dstRow = dst + y * pitch;
+
+				for (uint32_t x = tileX; x < endX; x++)
+					std::memcpy(dstRow + x * bpp, srcRow + offsetX[x], bpp);
+			}
+		}
+	}
+}
+
 } // End of namespace Graphics
 
 #endif // GRAPHICS_IMAGES_UTIL_H
@@ -0,0 +1,134 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A streaming buffer of per-instance data, for instanced mesh rendering.
+ */
+
+#include <cstddef>
+
+#include "src/common/util.h"
+
+#include "src/graphics/vertexbuffer.h"
+
+#include "src/graphics/mesh/instancebuffer.h"
+
+namespace Graphics {
+
+namespace Mesh {
+
+InstanceBuffer::InstanceBuffer() : _vbo(0), _capacity(0) {
+}
+
+InstanceBuffer::~InstanceBuffer() {
+	destroyGL(); // Dangerous if GL components not already freed and we're not in the GL context thread.
+}
+
+void InstanceBuffer::clear() {
+	_instances.clear();
+}
+
+void InstanceBuffer::add(const glm::mat4 &transform, float alpha) {
+	_instances.emplace_back();
+
+	Instance &instance = _instances.back();
+
+	// glm matrices are column-major, so this transposes the upper three rows
+	for (int row = 0; row < 3; row++)
+		for (int column = 0; column < 4; column++)
+			instance.transform[row][column] = transform[column][row];
+
+	instance.alpha = alpha;
+}
+
+uint32_t InstanceBuffer::getCount() const {
+	return _instances.size();
+}
+
+void InstanceBuffer::updateGL() {
+	if (_instances.empty())
+		return;
+
+	const size_t size = _instances.size() * sizeof(Instance);
+
+	if (_vbo == 0)
+		glGenBuffers(1, &_vbo);
+
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+	/* Orphan the old storage every time, so that the driver doesn't
+	 * have to wait for the draws of the last frame still reading it. */
+	_capacity = MAX(_capacity, size);
+	glBufferData(GL_ARRAY_BUFFER, _capacity, 0, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, size, _instances.data());
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::bindAttributes(uint32_t first) const {
+	const intptr_t offset = first * sizeof(Instance);
+
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+	for (GLuint i = 0; i < 3; i++) {
+		const intptr_t rowOffset = offset + offsetof(Instance, transform) + i * sizeof(Instance::transform[0]);
+
+		glVertexAttribPointer(VINSTANCEROW + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<void *>(rowOffset));
+		glVertexAttribDivisor(VINSTANCEROW + i, 1);
+		glEnableVertexAttribArray(VINSTANCEROW + i);
+	}
+
+	const intptr_t alphaOffset = offset + offsetof(Instance, alpha);
+
+	glVertexAttribPointer(VINSTANCEALPHA, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<void *>(alphaOffset));
+	glVertexAttribDivisor(VINSTANCEALPHA, 1);
+	glEnableVertexAttribArray(VINSTANCEALPHA);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::unbindAttributes() const {
+	for (GLuint i = 0; i < 3; i++)
+		glDisableVertexAttribArray(VINSTANCEROW + i);
+
+	glDisableVertexAttribArray(VINSTANCEALPHA);
+}
+
+void InstanceBuffer::destroyGL() {
+	if (_vbo != 0) {
+		glDeleteBuffers(1, &_vbo);
+		_vbo = 0;
+	}
+
+	_capacity = 0;
+}
+
+void InstanceBuffer::doRebuild() {
+	// The instances are uploaded anew every frame anyway
+	destroyGL();
+}
+
+void InstanceBuffer::doDestroy() {
+	destroyGL();
+}
+
+} // End of namespace Mesh
+
+} // End of namespace Graphics
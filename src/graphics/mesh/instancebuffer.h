@@ -0,0 +1,91 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A streaming buffer of per-instance data, for instanced mesh rendering.
+ */
+
+#ifndef GRAPHICS_MESH_INSTANCEBUFFER_H
+#define GRAPHICS_MESH_INSTANCEBUFFER_H
+
+#include <vector>
+
+#include "external/glm/mat4x4.hpp"
+
+#include "src/graphics/types.h"
+#include "src/graphics/glcontainer.h"
+
+namespace Graphics {
+
+namespace Mesh {
+
+/** Per-instance data for drawing many copies of a mesh in one call.
+ *
+ *  The instances are collected anew every frame, uploaded in one go, and
+ *  then drawn in ranges by Mesh::renderInstanced(). GL3.x only.
+ */
+class InstanceBuffer : public GLContainer {
+public:
+	/** The data of one instance: the upper three rows of an affine object
+	 *  transform, and an alpha value. */
+	struct Instance {
+		float transform[3][4];
+		float alpha;
+	};
+
+	InstanceBuffer();
+	~InstanceBuffer();
+
+	/** Remove all instances. */
+	void clear();
+
+	/** Add an instance. */
+	void add(const glm::mat4 &transform, float alpha);
+
+	/** Return the number of instances. */
+	uint32_t getCount() const;
+
+	/** Upload the instances into the GL buffer object. Must be called from the main thread. */
+	void updateGL();
+
+	/** Point the instance attributes of the bound vertex array object at the
+	 *  instances, starting with the instance of this index. */
+	void bindAttributes(uint32_t first) const;
+	/** Disable the instance attributes of the bound vertex array object again. */
+	void unbindAttributes() const;
+
+protected:
+	void doRebuild();
+	void doDestroy();
+
+private:
+	std::vector<Instance> _instances;
+
+	GLuint _vbo;      ///< Vertex Buffer Object.
+	size_t _capacity; ///< Size of the buffer object in bytes.
+
+	void destroyGL();
+};
+
+} // End of namespace Mesh
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_MESH_INSTANCEBUFFER_H
@@ -22,7 +22,10 @@
  *  Generic mesh handling class.
  */
 
+#include <cassert>
+
 #include "src/graphics/mesh/mesh.h"
+#include "src/graphics/mesh/instancebuffer.h"
 
 namespace Graphics {
 
@@ -228,6 +231,20 @@ void Mesh::render() {
 	}
 }
 
+void Mesh::renderInstanced(const InstanceBuffer &instances, uint32_t first, uint32_t count) {
+	assert(GfxMan.isGL3());
+
+	instances.bindAttributes(first);
+
+	if (_indexBuffer.getCount()) {
+		glDrawElementsInstanced(_type, _indexBuffer.getCount(), _indexBuffer.getType(), 0, count);
+	} else {
+		glDrawArraysInstanced(_type, 0, _vertexBuffer.getCount(), count);
+	}
+
+	instances.unbindAttributes();
+}
+
 void Mesh::renderUnbind() {
 	if (GfxMan.isGL3()) {
 		// So long as each mesh rebinds what it needs, there's actually no need to bind 0 here.
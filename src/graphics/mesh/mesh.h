@@ -38,6 +38,8 @@ namespace Graphics {
 
 namespace Mesh {
 
+class InstanceBuffer;
+
 class Mesh : public GLContainer {
 public:
 	Mesh(GLuint type = GL_TRIANGLES, GLuint hint = GL_STATIC_DRAW);
@@ -69,6 +71,11 @@ public:
 	void render();
 	void renderUnbind();
 
+	/** Render count instances of the mesh in one call, taking their data from an
+	 *  instance buffer, starting with the instance at first. GL3.x only, and the
+	 *  mesh has to be bound with renderBind(). */
+	void renderInstanced(const InstanceBuffer &instances, uint32_t first, uint32_t count);
+
 	void useIncrement();
 	void useDecrement();
 	uint32_t useCount() const;
@@ -28,6 +28,7 @@ src_graphics_mesh_libmesh_la_SOURCES += \
     src/graphics/mesh/meshwirebox.h \
     src/graphics/mesh/meshfont.h \
     src/graphics/mesh/meshquad.h \
+    src/graphics/mesh/instancebuffer.h \
     $(EMPTY)
 
 src_graphics_mesh_libmesh_la_SOURCES += \
@@ -36,4 +37,5 @@ src_graphics_mesh_libmesh_la_SOURCES += \
     src/graphics/mesh/meshwirebox.cpp \
     src/graphics/mesh/meshfont.cpp \
     src/graphics/mesh/meshquad.cpp \
+    src/graphics/mesh/instancebuffer.cpp \
     $(EMPTY)
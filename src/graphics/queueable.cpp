@@ -30,8 +30,10 @@
 namespace Graphics {
 
 Queueable::Queueable() {
-	for (int i = 0; i < kQueueMAX; i++)
+	for (int i = 0; i < kQueueMAX; i++) {
 		_isInQueue[i] = false;
+		_queueRef[i]  = 0;
+	}
 }
 
 Queueable::~Queueable() {
@@ -25,8 +25,6 @@
 #ifndef GRAPHICS_QUEUEABLE_H
 #define GRAPHICS_QUEUEABLE_H
 
-#include <list>
-
 #include "src/graphics/types.h"
 
 namespace Graphics {
@@ -52,7 +50,7 @@ protected:
 
 private:
 	bool _isInQueue[kQueueMAX];
-	std::list<Queueable *>::iterator _queueRef[kQueueMAX];
+	size_t _queueRef[kQueueMAX]; ///< Our slot in each queue we're in.
 
 	void removeFromAll();
 	void kickedOut(QueueType queue);
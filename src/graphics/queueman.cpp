@@ -22,6 +22,10 @@
  *  The graphics queue manager.
  */
 
+#include <cassert>
+
+#include <algorithm>
+
 #include "src/graphics/queueman.h"
 #include "src/graphics/queueable.h"
 
@@ -29,7 +33,17 @@ DECLARE_SINGLETON(Graphics::QueueManager)
 
 namespace Graphics {
 
-static bool queueComp(Queueable *a, Queueable *b) {
+/** How far, on average, sortQueue() moves objects before it stops
+ *  relying on the queue being nearly sorted. */
+static const size_t kMaxSortShifts = 8;
+
+/** Compare two objects in a queue, with empty slots sorted to the back. */
+static bool queueComp(const Queueable *a, const Queueable *b) {
+	if (!a)
+		return false;
+	if (!b)
+		return true;
+
 	return *a < *b;
 }
 
@@ -43,47 +57,90 @@ QueueManager::~QueueManager() {
 
 void QueueManager::lockQueue(QueueType queue) {
 	_queueMutex[queue].lock();
+
+	_queue[queue].lockDepth++;
 }
 
 void QueueManager::unlockQueue(QueueType queue) {
+	Queue &q = _queue[queue];
+
+	assert(q.lockDepth > 0);
+
+	/* Nobody can be iterating over the queue anymore once the outermost
+	 * lock is gone, so this is the time to clean up the empty slots.
+	 * Wait until there are a few of them, to keep removals cheap. */
+	if ((--q.lockDepth == 0) && ((q.removed * 4) > q.objects.size()))
+		compactQueue(queue);
+
 	_queueMutex[queue].unlock();
 }
 
 bool QueueManager::isQueueEmpty(QueueType queue) {
-	std::lock_guard<std::recursive_mutex> lock(_queueMutex[queue]);
+	lockQueue(queue);
 
-	return _queue[queue].empty();
+	const bool empty = _queue[queue].objects.size() == _queue[queue].removed;
+
+	unlockQueue(queue);
+
+	return empty;
 }
 
-const std::list<Queueable *> &QueueManager::getQueue(QueueType queue) const {
-	return _queue[queue];
+const std::vector<Queueable *> &QueueManager::getQueue(QueueType queue) const {
+	return _queue[queue].objects;
 }
 
 void QueueManager::sortQueue(QueueType queue) {
 	lockQueue(queue);
 
-	_queue[queue].sort(queueComp);
+	std::vector<Queueable *> &objects = _queue[queue].objects;
+
+	/* An insertion sort only has to do a single pass over a nearly sorted queue.
+	 * If it has to move the objects too far, the queue was shuffled too much,
+	 * and we finish with a full sort instead. Both keep equal objects in order.
+	 *
+	 * The empty slots are sorted to the back, so that the queue keeps its size
+	 * while somebody might still be iterating over it. */
+	const size_t maxShifts = objects.size() * kMaxSortShifts;
+
+	size_t shifts = 0;
+	for (size_t i = 1; (i < objects.size()) && (shifts <= maxShifts); i++) {
+		Queueable *object = objects[i];
+
+		size_t j = i;
+		for (; (j > 0) && queueComp(object, objects[j - 1]); j--)
+			objects[j] = objects[j - 1];
+
+		objects[j] = object;
+		shifts += i - j;
+	}
+
+	if (shifts > maxShifts)
+		std::stable_sort(objects.begin(), objects.end(), queueComp);
+
+	updateQueueRefs(queue);
 
 	unlockQueue(queue);
 }
 
-std::list<Queueable *>::iterator QueueManager::addToQueue(QueueType queue, Queueable &q) {
+size_t QueueManager::addToQueue(QueueType queue, Queueable &q) {
 	lockQueue(queue);
 
-	_queue[queue].push_back(&q);
-	std::list<Queueable *>::iterator ref = --_queue[queue].end();
+	_queue[queue].objects.push_back(&q);
+	const size_t ref = _queue[queue].objects.size() - 1;
 
 	unlockQueue(queue);
 
 	return ref;
 }
 
-void QueueManager::removeFromQueue(QueueType queue,
-		const std::list<Queueable *>::iterator &ref) {
-
+void QueueManager::removeFromQueue(QueueType queue, size_t ref) {
 	lockQueue(queue);
 
-	_queue[queue].erase(ref);
+	assert(ref < _queue[queue].objects.size());
+	assert(_queue[queue].objects[ref]);
+
+	_queue[queue].objects[ref] = 0;
+	_queue[queue].removed++;
 
 	unlockQueue(queue);
 }
@@ -91,11 +148,13 @@ void QueueManager::removeFromQueue(QueueType queue,
 void QueueManager::clearQueue(QueueType queue) {
 	lockQueue(queue);
 
-	for (std::list<Queueable *>::iterator q = _queue[queue].begin();
-	     q != _queue[queue].end(); ++q)
-		(*q)->kickedOut(queue);
+	std::vector<Queueable *> &objects = _queue[queue].objects;
+	for (size_t i = 0; i < objects.size(); i++)
+		if (objects[i])
+			objects[i]->kickedOut(queue);
 
-	_queue[queue].clear();
+	objects.clear();
+	_queue[queue].removed = 0;
 
 	unlockQueue(queue);
 }
@@ -105,4 +164,21 @@ void QueueManager::clearAllQueues() {
 		clearQueue((QueueType) i);
 }
 
+void QueueManager::compactQueue(QueueType queue) {
+	std::vector<Queueable *> &objects = _queue[queue].objects;
+
+	objects.erase(std::remove(objects.begin(), objects.end(), (Queueable *) 0), objects.end());
+	_queue[queue].removed = 0;
+
+	updateQueueRefs(queue);
+}
+
+void QueueManager::updateQueueRefs(QueueType queue) {
+	std::vector<Queueable *> &objects = _queue[queue].objects;
+
+	for (size_t i = 0; i < objects.size(); i++)
+		if (objects[i])
+			objects[i]->_queueRef[queue] = i;
+}
+
 } // End of namespace Graphics
@@ -25,7 +25,7 @@
 #ifndef GRAPHICS_QUEUEMAN_H
 #define GRAPHICS_QUEUEMAN_H
 
-#include <list>
+#include <vector>
 
 #include "src/common/types.h"
 #include "src/common/singleton.h"
@@ -48,19 +48,44 @@ public:
 	void lockQueue(QueueType queue);
 	void unlockQueue(QueueType queue);
 
-	const std::list<Queueable *> &getQueue(QueueType queue) const;
-
+	/** Return the objects in a queue.
+	 *
+	 *  Objects removed while the queue is locked leave an empty slot (0)
+	 *  behind, so that iterating over the queue stays safe. These slots
+	 *  are only cleaned up after the queue has been unlocked again.
+	 */
+	const std::vector<Queueable *> &getQueue(QueueType queue) const;
+
+	/** Sort a queue, from nearest to furthest.
+	 *
+	 *  The queue is expected to already be nearly sorted, since objects
+	 *  only move a bit between frames.
+	 */
 	void sortQueue(QueueType queue);
 	void clearQueue(QueueType queue);
 
 	void clearAllQueues();
 
 private:
+	struct Queue {
+		std::vector<Queueable *> objects;
+
+		size_t removed;     ///< Number of empty slots left behind by removed objects.
+		uint32_t lockDepth; ///< How often the queue is currently locked.
+
+		Queue() : removed(0), lockDepth(0) { }
+	};
+
 	std::recursive_mutex _queueMutex[kQueueMAX];
-	std::list<Queueable *> _queue[kQueueMAX];
+	Queue _queue[kQueueMAX];
+
+	size_t addToQueue(QueueType queue, Queueable &q);
+	void removeFromQueue(QueueType queue, size_t ref);
 
-	std::list<Queueable *>::iterator addToQueue(QueueType queue, Queueable &q);
-	void removeFromQueue(QueueType queue, const std::list<Queueable *>::iterator &ref);
+	/** Remove the empty slots from a queue. */
+	void compactQueue(QueueType queue);
+	/** Tell the objects in a queue where they are now. */
+	void updateQueueRefs(QueueType queue);
 
 	friend class Queueable;
 };
@@ -23,40 +23,115 @@
  */
 
 #include <cassert>
+#include <cstring>
+
+#include <algorithm>
 
 #include "external/glm/gtc/type_ptr.hpp"
 
 #include "src/graphics/render/renderqueue.h"
 #include "src/common/util.h"
 
-#include <algorithm>
-
 namespace Graphics {
 
 namespace Render {
 
-bool compareShader(const RenderQueue::RenderQueueNode &a, const RenderQueue::RenderQueueNode &b)
-{
-	if (a.program < b.program)
-		return false;
-	else if (a.program > b.program)
-		return true;
-	if (a.material < b.material)  // node_program values are equal.
-		return false;
-	else if (a.material > b.material)
-		return true;
-	else  // node material values are equal, compare mesh values next.
-		return (a.mesh <= b.mesh ? false : true);
-	// No, surfaces are not compared here.
+/* The sort keys. When sorting by shader, the objects are ordered by how
+ * expensive it is to switch them. The quantized depth sorts items with
+ * the same state front to back.
+ *
+ * The ids are dense per queue, so they only overflow with thousands of
+ * objects in one queue. Then, items of different objects might get mixed,
+ * costing a few state changes, but render() still binds the right state. */
+
+static const uint32_t kShaderKeyProgramBits  = 12;
+static const uint32_t kShaderKeyMaterialBits = 14;
+static const uint32_t kShaderKeySurfaceBits  = 14;
+static const uint32_t kShaderKeyMeshBits     = 14;
+static const uint32_t kShaderKeyDepthBits    = 10;
+
+static const uint32_t kDepthKeyProgramBits  = 10;
+static const uint32_t kDepthKeyMaterialBits = 11;
+static const uint32_t kDepthKeyMeshBits     = 11;
+
+/** The minimum length of a run of identical items to be drawn instanced.
+ *  For shorter runs, switching over to the instanced program costs more
+ *  than the separate draws. */
+static const size_t kMinInstancedRun = 4;
+
+/** Append the lowest bits of a value to a key. */
+static inline uint64_t appendKey(uint64_t key, uint32_t value, uint32_t bits) {
+	return (key << bits) | (value & ((UINT64_C(1) << bits) - 1));
 }
 
-bool compareDepth(const RenderQueue::RenderQueueNode &a, const RenderQueue::RenderQueueNode &b) {
-	return (a.reference <= b.reference);
-	//return (a.reference.lengthSquared() <= b.reference.lengthSquared());
+/** Return the bits of a depth value, ordered like the value itself.
+ *
+ *  The depth values are squared distances, so they're positive or 0.
+ *  The bits of positive floats sort like the floats.
+ */
+static inline uint32_t getDepthBits(float depth) {
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+
+	return (bits & 0x80000000) ? 0 : bits;
+}
+
+RenderQueue::ObjectIDs::ObjectIDs() : _objects(64, nullptr), _ids(64, 0), _count(0) {
+}
+
+uint32_t RenderQueue::ObjectIDs::get(const void *object) {
+	if (!object)
+		return 0;
+
+	// Keep the hash table at most half full
+	if (((_count + 1) * 2) > _objects.size())
+		grow();
+
+	const size_t mask = _objects.size() - 1;
+
+	size_t slot = (((uintptr_t) object) * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+	for (slot &= mask; _objects[slot]; slot = (slot + 1) & mask)
+		if (_objects[slot] == object)
+			return _ids[slot];
+
+	_objects[slot] = object;
+	_ids[slot]     = ++_count;
+
+	return _count;
+}
+
+void RenderQueue::ObjectIDs::clear() {
+	if (_count == 0)
+		return;
+
+	std::fill(_objects.begin(), _objects.end(), nullptr);
+	_count = 0;
+}
+
+void RenderQueue::ObjectIDs::grow() {
+	std::vector<const void *> objects(_objects.size() * 2, nullptr);
+	std::vector<uint32_t> ids(_ids.size() * 2, 0);
+
+	const size_t mask = objects.size() - 1;
+
+	for (size_t i = 0; i < _objects.size(); i++) {
+		if (!_objects[i])
+			continue;
+
+		size_t slot = (((uintptr_t) _objects[i]) * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+		for (slot &= mask; objects[slot]; slot = (slot + 1) & mask)
+			;
+
+		objects[slot] = _objects[i];
+		ids[slot]     = _ids[i];
+	}
+
+	_objects.swap(objects);
+	_ids.swap(ids);
 }
 
-RenderQueue::RenderQueue(uint32_t precache) : _nodeArray(precache), _cameraReference(0.0f, 0.0f, 0.0f) {
-//	_nodeArray.reserve(1000);
+RenderQueue::RenderQueue(uint32_t precache) : _cameraReference(0.0f, 0.0f, 0.0f) {
+	_nodeArray.reserve(precache);
 }
 
 RenderQueue::~RenderQueue()
@@ -90,15 +165,141 @@ void RenderQueue::queueItem(Shader::ShaderRenderable *renderable, const glm::mat
 }
 
 void RenderQueue::sortShader() {
-	if (_nodeArray.size() > 1) {
-		std::sort(_nodeArray.begin(), _nodeArray.end(), compareShader);
+	if (_nodeArray.size() <= 1)
+		return;
+
+	clearObjectIDs();
+
+	_sortItems.resize(_nodeArray.size());
+	for (size_t i = 0; i < _nodeArray.size(); i++) {
+		const RenderQueueNode &node = _nodeArray[i];
+
+		uint64_t key = 0;
+		key = appendKey(key, _programIDs.get(node.program)  , kShaderKeyProgramBits);
+		key = appendKey(key, _materialIDs.get(node.material), kShaderKeyMaterialBits);
+		key = appendKey(key, _surfaceIDs.get(node.surface)  , kShaderKeySurfaceBits);
+		key = appendKey(key, _meshIDs.get(node.mesh)        , kShaderKeyMeshBits);
+		key = appendKey(key, getDepthBits(node.reference) >> (32 - kShaderKeyDepthBits), kShaderKeyDepthBits);
+
+		_sortItems[i].key   = key;
+		_sortItems[i].index = i;
 	}
+
+	sortItems();
 }
 
 void RenderQueue::sortDepth() {
-	if (_nodeArray.size() > 1) {
-		std::sort(_nodeArray.begin(), _nodeArray.end(), compareDepth);
+	if (_nodeArray.size() <= 1)
+		return;
+
+	clearObjectIDs();
+
+	_sortItems.resize(_nodeArray.size());
+	for (size_t i = 0; i < _nodeArray.size(); i++) {
+		const RenderQueueNode &node = _nodeArray[i];
+
+		// Items at the same depth are ordered by state, to save a few state changes
+		uint64_t key = getDepthBits(node.reference);
+		key = appendKey(key, _programIDs.get(node.program)  , kDepthKeyProgramBits);
+		key = appendKey(key, _materialIDs.get(node.material), kDepthKeyMaterialBits);
+		key = appendKey(key, _meshIDs.get(node.mesh)        , kDepthKeyMeshBits);
+
+		_sortItems[i].key   = key;
+		_sortItems[i].index = i;
+	}
+
+	sortItems();
+}
+
+void RenderQueue::clearObjectIDs() {
+	_programIDs.clear();
+	_materialIDs.clear();
+	_surfaceIDs.clear();
+	_meshIDs.clear();
+}
+
+void RenderQueue::sortItems() {
+	/* An LSD radix sort over the keys, one byte at a time. It's stable, so
+	 * items with the same key stay in the order they were queued in. */
+
+	const size_t count = _sortItems.size();
+
+	// Count the values of all bytes in one go
+	size_t histograms[8][256];
+	std::memset(histograms, 0, sizeof(histograms));
+
+	for (size_t i = 0; i < count; i++) {
+		const uint64_t key = _sortItems[i].key;
+
+		for (size_t byte = 0; byte < 8; byte++)
+			histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+	}
+
+	_sortBuffer.resize(count);
+
+	for (size_t byte = 0; byte < 8; byte++) {
+		size_t *histogram = histograms[byte];
+
+		// All keys have the same value in this byte, so there's nothing to sort
+		if (histogram[(_sortItems[0].key >> (byte * 8)) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for (size_t i = 0; i < 256; i++) {
+			const size_t bucketSize = histogram[i];
+
+			histogram[i] = offset;
+			offset += bucketSize;
+		}
+
+		for (size_t i = 0; i < count; i++)
+			_sortBuffer[histogram[(_sortItems[i].key >> (byte * 8)) & 0xFF]++] = _sortItems[i];
+
+		_sortItems.swap(_sortBuffer);
 	}
+
+	_sortedNodes.clear();
+	for (size_t i = 0; i < count; i++)
+		_sortedNodes.push_back(_nodeArray[_sortItems[i].index]);
+
+	_nodeArray.swap(_sortedNodes);
+}
+
+size_t RenderQueue::getRunEnd(size_t start) const {
+	const RenderQueueNode &node = _nodeArray[start];
+
+	size_t end = start + 1;
+	while ((end < _nodeArray.size()) && (_nodeArray[end].mesh == node.mesh) && (_nodeArray[end].material == node.material) &&
+	       (_nodeArray[end].surface == node.surface) && (_nodeArray[end].program == node.program))
+		end++;
+
+	return end;
+}
+
+bool RenderQueue::isInstancedRun(size_t start, size_t end) const {
+	if ((end - start) < kMinInstancedRun)
+		return false;
+
+	// Only available on GL3.x, and the program might not be linked yet
+	const Shader::ShaderProgram *instanced = _nodeArray[start].program->instanced;
+
+	return instanced && (instanced->glid != 0);
+}
+
+void RenderQueue::collectInstances() {
+	_instances.clear();
+
+	for (size_t i = 0; i < _nodeArray.size(); ) {
+		const size_t end = getRunEnd(i);
+
+		if (isInstancedRun(i, end))
+			for (size_t j = i; j < end; j++)
+				_instances.add(*_nodeArray[j].transform, _nodeArray[j].alpha);
+
+		i = end;
+	}
+
+	_instances.updateGL();
 }
 
 void RenderQueue::render() {
@@ -106,6 +307,10 @@ void RenderQueue::render() {
 		return;
 	}
 
+	// Upload the data of all instanced draws at once
+	collectInstances();
+	uint32_t instance = 0;
+
 	Shader::ShaderProgram *currentProgram = 0;
 	Shader::ShaderMaterial *currentMaterial = 0;
 	Shader::ShaderSurface *currentSurface = 0;
@@ -159,21 +364,41 @@ void RenderQueue::render() {
 		assert(currentSurface);
 		assert(currentMaterial);
 
-		currentSurface->bindProgram(currentProgram, _nodeArray[i].transform);
-		//currentSurface->bindObjectModelview(currentProgram, _nodeArray[i].transform);
-		bindBoneUniforms(currentProgram, currentSurface, currentMesh);
-		currentMaterial->bindFade(currentProgram, _nodeArray[i].alpha);
-		currentMesh->render();
-
-		++i;  // Move to next object.
-		while ((i < limit) && (_nodeArray[i].mesh == currentMesh) && (_nodeArray[i].material == currentMaterial) && (_nodeArray[i].surface == currentSurface)) {
-			// Next object is basically the same, but will have a different object modelview transform. So rebind that, and render again.
-			assert(_nodeArray[i].transform);
-			currentSurface->bindObjectModelview(currentProgram, _nodeArray[i].transform);
+		const size_t runEnd = getRunEnd(i);
+		if (isInstancedRun(i, runEnd)) {
+			/* Draw the whole run in one go, with the instanced variant of the program.
+			 * It takes the transforms and alpha values from the instance buffer, but
+			 * otherwise has the same uniforms, so bind them all again for it. */
+			Shader::ShaderProgram *instancedProgram = currentProgram->instanced;
+			glUseProgram(instancedProgram->glid);
+
+			currentSurface->bindProgram(instancedProgram, _nodeArray[i].transform);
+			currentMaterial->bindProgram(instancedProgram, 1.0f);
+			bindBoneUniforms(instancedProgram, currentSurface, currentMesh);
+			currentMesh->renderInstanced(_instances, instance, runEnd - i);
+
+			glUseProgram(currentProgram->glid);
+
+			instance += runEnd - i;
+			i = runEnd;
+
+		} else {
+			currentSurface->bindProgram(currentProgram, _nodeArray[i].transform);
+			//currentSurface->bindObjectModelview(currentProgram, _nodeArray[i].transform);
 			bindBoneUniforms(currentProgram, currentSurface, currentMesh);
 			currentMaterial->bindFade(currentProgram, _nodeArray[i].alpha);
 			currentMesh->render();
-			++i;
+
+			++i;  // Move to next object.
+			while (i < runEnd) {
+				// Next object is basically the same, but will have a different object modelview transform. So rebind that, and render again.
+				assert(_nodeArray[i].transform);
+				currentSurface->bindObjectModelview(currentProgram, _nodeArray[i].transform);
+				bindBoneUniforms(currentProgram, currentSurface, currentMesh);
+				currentMaterial->bindFade(currentProgram, _nodeArray[i].alpha);
+				currentMesh->render();
+				++i;
+			}
 		}
 		// Done rendering, unbind the mesh, and onwards into the queue.
 		currentMesh->renderUnbind();
@@ -193,6 +418,46 @@ void RenderQueue::clear() {
 	_nodeArray.clear();
 }
 
+uint32_t RenderQueue::getStateChanges() const {
+	// Follows the binding logic of render()
+
+	Shader::ShaderProgram *currentProgram = 0;
+	Shader::ShaderMaterial *currentMaterial = 0;
+	Shader::ShaderSurface *currentSurface = 0;
+	Mesh::Mesh *currentMesh = 0;
+
+	uint32_t changes = 0;
+	for (size_t i = 0; i < _nodeArray.size(); i++) {
+		const RenderQueueNode &node = _nodeArray[i];
+
+		if (currentProgram != node.program) {
+			currentProgram  = node.program;
+			currentMaterial = 0;
+			currentSurface  = 0;
+			changes++;
+		}
+
+		if (currentMaterial != node.material) {
+			currentMaterial = node.material;
+			changes++;
+		}
+
+		if (currentSurface != node.surface) {
+			currentSurface = node.surface;
+			changes++;
+		}
+
+		if ((i == 0) || (currentMesh != node.mesh) || (node.material != _nodeArray[i - 1].material) ||
+		    (node.surface != _nodeArray[i - 1].surface) || (node.program != _nodeArray[i - 1].program)) {
+
+			currentMesh = node.mesh;
+			changes++;
+		}
+	}
+
+	return changes;
+}
+
 void RenderQueue::bindBoneUniforms(Shader::ShaderProgram *program, Shader::ShaderSurface *surface, Mesh::Mesh *mesh) {
 	surface->bindBindPose(program, mesh->getBindPosePtr());
 
@@ -31,6 +31,8 @@
 #include "src/graphics/graphics.h"
 #include "src/graphics/shader/shaderrenderable.h"
 
+#include "src/graphics/mesh/instancebuffer.h"
+
 #include <vector>
 
 namespace Graphics {
@@ -63,18 +65,69 @@ public:
 	void queueItem(Shader::ShaderProgram *program, Shader::ShaderSurface *surface, Shader::ShaderMaterial *material, Mesh::Mesh *mesh, const glm::mat4 *transform, float alpha);
 	void queueItem(Shader::ShaderRenderable *renderable, const glm::mat4 *transform, float alpha);
 
-	void sortShader(); ///< Sort queue elements by shader program.
+	void sortShader(); ///< Sort queue elements by shader program, material, surface and mesh.
 	void sortDepth();  ///< Sort queue elements by depth.
 
 	void render();  ///< Render all queued items.
 
 	void clear();  ///< Clear the queue of all items.
 
+	/** Return the number of program, material, surface and mesh bindings
+	 *  render() would make for the queue in its current order. */
+	uint32_t getStateChanges() const;
+
 private:
+	/** Maps the objects in a queue to small ids, in the order they were first seen. */
+	class ObjectIDs {
+	public:
+		ObjectIDs();
+
+		/** Return the id of this object. 0 is the id of a null object. */
+		uint32_t get(const void *object);
+
+		void clear();
+
+	private:
+		std::vector<const void *> _objects; ///< Open addressing hash table of objects.
+		std::vector<uint32_t> _ids;         ///< The ids of the objects in the hash table.
+
+		uint32_t _count;
+
+		void grow();
+	};
+
+	/** A 64-bit sort key of a queued item, and the item's index in the queue. */
+	struct SortItem {
+		uint64_t key;
+		uint32_t index;
+	};
 
 	std::vector<RenderQueueNode>_nodeArray;
 	glm::vec3 _cameraReference;
 
+	ObjectIDs _programIDs;
+	ObjectIDs _materialIDs;
+	ObjectIDs _surfaceIDs;
+	ObjectIDs _meshIDs;
+
+	// Scratch space for sorting
+	std::vector<SortItem> _sortItems;
+	std::vector<SortItem> _sortBuffer;
+	std::vector<RenderQueueNode> _sortedNodes;
+
+	/** The per-instance data of the items drawn with instancing. */
+	Mesh::InstanceBuffer _instances;
+
+	void clearObjectIDs();
+	void sortItems();
+
+	/** Return the end of the run of items sharing all state with the item at start. */
+	size_t getRunEnd(size_t start) const;
+	/** Should this run of items be drawn with a single instanced draw call? */
+	bool isInstancedRun(size_t start, size_t end) const;
+	/** Collect the instances of all instanced runs into the instance buffer. */
+	void collectInstances();
+
 	void bindBoneUniforms(Shader::ShaderProgram *program, Shader::ShaderSurface *surface, Mesh::Mesh *mesh);
 };
 
@@ -27,10 +27,12 @@
 
 #include "src/graphics/renderable.h"
 #include "src/graphics/graphics.h"
+#include "src/graphics/aabbtree.h"
 
 namespace Graphics {
 
-Renderable::Renderable(RenderableType type) : _clickable(false), _distance(0.0f) {
+Renderable::Renderable(RenderableType type) : _clickable(false), _distance(0.0f),
+	_pickLeaf(AABBTree::kInvalidLeaf) {
 	switch (type) {
 		case kRenderableTypeVideo:
 			_queueExists  = kQueueVideo;
@@ -93,6 +95,8 @@ bool Renderable::isClickable() const {
 
 void Renderable::setClickable(bool clickable) {
 	_clickable = clickable;
+
+	updatePickable();
 }
 
 const Common::UString &Renderable::getTag() const {
@@ -118,10 +122,14 @@ void Renderable::show() {
 	sortQueue(_queueVisible);
 
 	unlockQueue(_queueVisible);
+
+	updatePickable();
 }
 
 void Renderable::hide() {
 	removeFromQueue(_queueVisible);
+
+	updatePickable();
 }
 
 bool Renderable::isIn(float UNUSED(x), float UNUSED(y)) const {
@@ -138,6 +146,18 @@ bool Renderable::isIn(float UNUSED(x1), float UNUSED(y1), float UNUSED(z1),
 	return false;
 }
 
+bool Renderable::getWorldBound(float UNUSED(min)[3], float UNUSED(max)[3]) const {
+	return false;
+}
+
+void Renderable::updatePickable() {
+	GfxMan.updatePickable(*this);
+}
+
+bool Renderable::getPickBound(float min[3], float max[3]) const {
+	return _clickable && (_queueVisible == kQueueVisibleWorldObject) && isVisible() && getWorldBound(min, max);
+}
+
 void Renderable::lockFrame() {
 	GfxMan.lockFrame();
 }
@@ -89,6 +89,13 @@ public:
 	/** Does the line from x1.y1.z1 to x2.y2.z2 intersect with the object? */
 	virtual bool isIn(float x1, float y1, float z1, float x2, float y2, float z2) const;
 
+	/** Get the object's axis-aligned bounds in world space.
+	 *
+	 *  Used to cull objects outside the view. Returns false if the object
+	 *  has no bounds, in which case it's never culled.
+	 */
+	virtual bool getWorldBound(float min[3], float max[3]) const;
+
 protected:
 	QueueType _queueExists;
 	QueueType _queueVisible;
@@ -100,13 +107,24 @@ protected:
 
 	double _distance; ///< The distance of the object from the viewer.
 
+	uint32_t _pickLeaf; ///< Our leaf in the graphics manager's picking tree, guarded by its lock.
+
 	void resort();
 
+	/** Add, move or remove the object in the picking tree, after its
+	 *  visibility, clickability or world bounds changed. */
+	void updatePickable();
+
+	/** Is this a visible, clickable world object? If so, get its world bounds. */
+	bool getPickBound(float min[3], float max[3]) const;
+
 	void lockFrame();
 	void unlockFrame();
 
 	void lockFrameIfVisible();
 	void unlockFrameIfVisible();
+
+	friend class GraphicsManager;
 };
 
 } // End of namespace Graphics
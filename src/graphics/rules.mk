@@ -43,6 +43,10 @@ src_graphics_libgraphics_la_SOURCES += \
     src/graphics/ttf.h \
     src/graphics/indexbuffer.h \
     src/graphics/vertexbuffer.h \
+    src/graphics/skinning.h \
+    src/graphics/frustum.h \
+    src/graphics/aabbtree.h \
+    src/graphics/framefence.h \
     src/graphics/imguiwrapper.h \
     src/graphics/imguidemo.h \
     $(EMPTY)
@@ -64,6 +68,10 @@ src_graphics_libgraphics_la_SOURCES += \
     src/graphics/ttf.cpp \
     src/graphics/indexbuffer.cpp \
     src/graphics/vertexbuffer.cpp \
+    src/graphics/skinning.cpp \
+    src/graphics/frustum.cpp \
+    src/graphics/aabbtree.cpp \
+    src/graphics/framefence.cpp \
     src/graphics/imguiwrapper.cpp \
     src/graphics/imguidemo.cpp \
     $(EMPTY)
@@ -35,6 +35,7 @@
 #include "src/graphics/shader/shaderbuilder.h"
 
 #include "src/graphics/aurora/texture.h"
+#include "src/graphics/aurora/textureman.h"
 
 /*--------------------------------------------------------------------*/
 
@@ -226,6 +227,10 @@ ShaderObject *ShaderManager::getShaderObject(const Common::UString &name, const
 }
 
 void ShaderManager::bindShaderVariable(ShaderObject::ShaderObjectVariable &var, GLint loc, const void *data) {
+	// Bring back textures evicted from OpenGL
+	if ((var.type >= SHADER_SAMPLER1D) && (var.type <= SHADER_SAMPLERBUFFER))
+		TextureMan.touch(static_cast<const ShaderSampler *>(data)->handle);
+
 	switch (var.type) {
 		case SHADER_FLOAT: glUniform1fv(loc, var.count, static_cast<const float *>(data)); break;
 		case SHADER_VEC2:  glUniform2fv(loc, var.count, static_cast<const float *>(data)); break;
@@ -591,6 +596,13 @@ void ShaderManager::genGLProgram(ShaderProgram *program) {
 	glBindAttribLocation(glid, (GLuint)(VERTEX_BONEINDICES), "inputBoneIndices");
 	glBindAttribLocation(glid, (GLuint)(VERTEX_BONEWEIGHTS), "inputBoneWeights");
 
+	if (GfxMan.supportInstancing()) {
+		glBindAttribLocation(glid, (GLuint)(VERTEX_INSTANCE_ROW0), "inputInstanceRow0");
+		glBindAttribLocation(glid, (GLuint)(VERTEX_INSTANCE_ROW1), "inputInstanceRow1");
+		glBindAttribLocation(glid, (GLuint)(VERTEX_INSTANCE_ROW2), "inputInstanceRow2");
+		glBindAttribLocation(glid, (GLuint)(VERTEX_INSTANCE_ALPHA), "inputInstanceAlpha");
+	}
+
 	glLinkProgram(glid);
 
 	GLint linkStatus;
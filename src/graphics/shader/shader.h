@@ -150,7 +150,13 @@ enum ShaderVertexAttrib {
 	VERTEX_BONEINDICES = 3,
 	VERTEX_BONEWEIGHTS = 4,
 	VERTEX_TEXCOORD0   = 5,
-	VERTEX_TEXCOORD1   = 6
+	VERTEX_TEXCOORD1   = 6,
+
+	// Per-instance attributes, placed behind the texture coordinates
+	VERTEX_INSTANCE_ROW0  = 12,
+	VERTEX_INSTANCE_ROW1  = 13,
+	VERTEX_INSTANCE_ROW2  = 14,
+	VERTEX_INSTANCE_ALPHA = 15
 };
 
 enum ShaderUBOIndex {
@@ -225,6 +231,9 @@ public:
 	GLuint glid { 0 };
 	uint32_t usageCount { 0 };
 
+	/** A variant of this program taking the object transform and alpha per instance, if any. */
+	ShaderProgram *instanced { nullptr };
+
 	void bindAttribute(ShaderVertexAttrib attrib, const Common::UString &name) {
 		glBindAttribLocation(glid, (GLuint)(attrib), name.c_str());
 	}
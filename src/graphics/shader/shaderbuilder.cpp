@@ -27,6 +27,8 @@
  *  parameter configuration.
  */
 
+#include <algorithm>
+
 #include "src/common/strutil.h"
 
 #include "src/graphics/shader/shaderbuilder.h"
@@ -85,14 +87,27 @@ void ShaderDescriptor::build(bool isGL3, Common::UString &v_string, Common::UStr
 	 * Fragment shaders have an alpha value and fraggle/froggle for building the
 	 * final colour output.
 	 */
+	/**
+	 * Instanced shaders take the object transform and alpha from per-instance
+	 * attributes instead. They still declare the same uniforms as their
+	 * non-instanced counterparts, so that both can share surfaces and materials.
+	 */
+	const bool instanced = isGL3 &&
+		(std::find(_inputDescriptors.begin(), _inputDescriptors.end(), INPUT_INSTANCE) != _inputDescriptors.end());
+
 	if (isGL3) {
 		v_header = "#version 150\n\n"
 		           "uniform mat4 _objectModelviewMatrix;\n"
 		           "uniform mat4 _projectionMatrix;\n"
 		           "uniform mat4 _modelviewMatrix;\n";
 
-		v_body =   "void main(void) {\n"
-		           "	mat4 mo = (_modelviewMatrix * _objectModelviewMatrix);\n";
+		if (instanced) {
+			v_body = "void main(void) {\n"
+			         "	mat4 mo = (_modelviewMatrix * transpose(mat4(inputInstanceRow0, inputInstanceRow1, inputInstanceRow2, vec4(0.0, 0.0, 0.0, 1.0))));\n";
+		} else {
+			v_body = "void main(void) {\n"
+			         "	mat4 mo = (_modelviewMatrix * _objectModelviewMatrix);\n";
+		}
 
 
 		f_header = "#version 150\n\n"
@@ -412,6 +427,17 @@ void ShaderDescriptor::build(bool isGL3, Common::UString &v_string, Common::UStr
 			}
 			body_desc_string = "boneWeights = inputBoneWeights;\n";
 			break;
+		case INPUT_INSTANCE:
+			if (instanced) {
+				input_desc_string = "in vec4 inputInstanceRow0;\n"
+				                    "in vec4 inputInstanceRow1;\n"
+				                    "in vec4 inputInstanceRow2;\n"
+				                    "in float inputInstanceAlpha;\n";
+				output_desc_string = "out float instanceAlpha;\n";
+				f_desc_string = "in float instanceAlpha;\n";
+				body_desc_string = "instanceAlpha = inputInstanceAlpha;\n";
+			}
+			break;
 		}
 		v_header += input_desc_string;
 		v_header += output_desc_string;
@@ -631,8 +657,12 @@ void ShaderDescriptor::build(bool isGL3, Common::UString &v_string, Common::UStr
 	if (isGL3) {
 		v_body += "}\n";
 
-		f_body += "fraggle.a = fraggle.a * _alpha;\n"
-		          "outColor = fraggle;\n"
+		if (instanced)
+			f_body += "fraggle.a = fraggle.a * _alpha * instanceAlpha;\n";
+		else
+			f_body += "fraggle.a = fraggle.a * _alpha;\n";
+
+		f_body += "outColor = fraggle;\n"
 		          "}\n";
 	} else {
 		v_body += "}\n";
@@ -692,6 +722,7 @@ void ShaderDescriptor::genName(Common::UString &n_string) {
 		case INPUT_COLOUR: n_string += "input_colour"; break;
 		case INPUT_BONE_INDICES: n_string += "input_boneindices"; break;
 		case INPUT_BONE_WEIGHTS: n_string += "input_boneweights"; break;
+		case INPUT_INSTANCE: n_string += "input_instance"; break;
 		}
 	}
 
@@ -752,6 +783,7 @@ void ShaderDescriptor::genName(Common::UString &n_string) {
 		case INPUT_COLOUR: n_string += "input_colour"; break;
 		case INPUT_BONE_INDICES: n_string += "input_boneindices"; break;
 		case INPUT_BONE_WEIGHTS: n_string += "input_boneweights"; break;
+		case INPUT_INSTANCE: n_string += "input_instance"; break;
 		}
 
 		n_string += "-";
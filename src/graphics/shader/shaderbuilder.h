@@ -63,7 +63,8 @@ public:
 		INPUT_UV_SPHERE,  ///< Not strictly speaking an input, but generated for an output.
 		INPUT_COLOUR,
 		INPUT_BONE_INDICES,
-		INPUT_BONE_WEIGHTS
+		INPUT_BONE_WEIGHTS,
+		INPUT_INSTANCE    ///< Per-instance transform and alpha, replacing the uniforms. GL3.x only.
 	};
 
 	///< Sampler definitions. Limit to the OpenGL minimum requirement.
@@ -0,0 +1,189 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Linear blend skinning of vertex coordinates.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define XOREOS_SKINNING_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+#include "src/common/util.h"
+
+#include "src/graphics/skinning.h"
+
+namespace Graphics {
+
+SkinningVertices::SkinningVertices() : _boneCount(0) {
+}
+
+void SkinningVertices::set(const std::vector<float> &coords, const std::vector<float> &boneIndices,
+                           const std::vector<float> &boneWeights, size_t bonesPerVertex) {
+
+	clear();
+
+	const size_t vertexCount = coords.size() / 3;
+
+	_x.resize(vertexCount);
+	_y.resize(vertexCount);
+	_z.resize(vertexCount);
+
+	_influenceStart.reserve(vertexCount + 1);
+
+	for (size_t i = 0; i < vertexCount; i++) {
+		_x[i] = coords[i * 3 + 0];
+		_y[i] = coords[i * 3 + 1];
+		_z[i] = coords[i * 3 + 2];
+
+		_influenceStart.push_back(_influenceBone.size());
+
+		for (size_t j = 0; j < bonesPerVertex; j++) {
+			const size_t n = i * bonesPerVertex + j;
+			if ((n >= boneIndices.size()) || (n >= boneWeights.size()))
+				break;
+
+			const int boneIndex = static_cast<int>(boneIndices[n]);
+			if (boneIndex < 0)
+				continue;
+
+			_influenceBone.push_back(boneIndex);
+			_influenceWeight.push_back(boneWeights[n]);
+
+			_boneCount = MAX<size_t>(_boneCount, boneIndex + 1);
+		}
+	}
+
+	_influenceStart.push_back(_influenceBone.size());
+}
+
+void SkinningVertices::clear() {
+	_x.clear();
+	_y.clear();
+	_z.clear();
+
+	_influenceStart.clear();
+	_influenceBone.clear();
+	_influenceWeight.clear();
+
+	_boneCount = 0;
+}
+
+bool SkinningVertices::empty() const {
+	return _x.empty();
+}
+
+size_t SkinningVertices::getVertexCount() const {
+	return _x.size();
+}
+
+size_t SkinningVertices::getBoneCount() const {
+	return _boneCount;
+}
+
+bool SkinningVertices::isVectorized() {
+#ifdef XOREOS_SKINNING_SSE2
+	return true;
+#else
+	return false;
+#endif
+}
+
+void SkinningVertices::skin(const float *boneMatrices, float *out, size_t outStride) const {
+#ifdef XOREOS_SKINNING_SSE2
+	skinSSE2(boneMatrices, out, outStride);
+#else
+	skinScalar(boneMatrices, out, outStride);
+#endif
+}
+
+void SkinningVertices::skinScalar(const float *boneMatrices, float *out, size_t outStride) const {
+	const size_t vertexCount = _x.size();
+
+	for (size_t i = 0; i < vertexCount; i++, out += outStride) {
+		// Blend the first three rows of the bone matrices
+		float m[12] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+		for (uint32_t k = _influenceStart[i]; k < _influenceStart[i + 1]; k++) {
+			const float *bone   = boneMatrices + 16 * _influenceBone[k];
+			const float  weight = _influenceWeight[k];
+
+			for (int c = 0; c < 4; c++) {
+				m[c * 3 + 0] += bone[c * 4 + 0] * weight;
+				m[c * 3 + 1] += bone[c * 4 + 1] * weight;
+				m[c * 3 + 2] += bone[c * 4 + 2] * weight;
+			}
+		}
+
+		const float x = _x[i], y = _y[i], z = _z[i];
+
+		out[0] = m[0] * x + m[3] * y + m[6] * z + m[ 9];
+		out[1] = m[1] * x + m[4] * y + m[7] * z + m[10];
+		out[2] = m[2] * x + m[5] * y + m[8] * z + m[11];
+	}
+}
+
+#ifdef XOREOS_SKINNING_SSE2
+
+void SkinningVertices::skinSSE2(const float *boneMatrices, float *out, size_t outStride) const {
+	const size_t vertexCount = _x.size();
+
+	const uint32_t *influenceStart  = _influenceStart.data();
+	const uint32_t *influenceBone   = _influenceBone.data();
+	const float    *influenceWeight = _influenceWeight.data();
+
+	for (size_t i = 0; i < vertexCount; i++, out += outStride) {
+		// Blend the columns of the bone matrices, one column per register
+		__m128 c0 = _mm_setzero_ps();
+		__m128 c1 = _mm_setzero_ps();
+		__m128 c2 = _mm_setzero_ps();
+		__m128 c3 = _mm_setzero_ps();
+
+		for (uint32_t k = influenceStart[i]; k < influenceStart[i + 1]; k++) {
+			const float  *bone   = boneMatrices + 16 * influenceBone[k];
+			const __m128  weight = _mm_set1_ps(influenceWeight[k]);
+
+			c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(bone +  0), weight));
+			c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(bone +  4), weight));
+			c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(bone +  8), weight));
+			c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(bone + 12), weight));
+		}
+
+		__m128 v = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(_x[i])), c3);
+		v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_set1_ps(_y[i])));
+		v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_set1_ps(_z[i])));
+
+		// Only write x, y and z. What follows is the next vertex attribute
+		_mm_store_ss(out + 0, v);
+		_mm_store_ss(out + 1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+		_mm_store_ss(out + 2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)));
+	}
+}
+
+#else
+
+void SkinningVertices::skinSSE2(const float *boneMatrices, float *out, size_t outStride) const {
+	skinScalar(boneMatrices, out, outStride);
+}
+
+#endif
+
+} // End of namespace Graphics
@@ -0,0 +1,101 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Linear blend skinning of vertex coordinates.
+ */
+
+#ifndef GRAPHICS_SKINNING_H
+#define GRAPHICS_SKINNING_H
+
+#include <vector>
+
+#include "src/common/types.h"
+
+namespace Graphics {
+
+/** Vertex coordinates and bone influences, prepared for skinning.
+ *
+ *  The coordinates are kept as a structure of arrays. The bone influences
+ *  of all vertices are packed into one list, without the unused ones, so
+ *  that a vertex only pays for the bones it actually has.
+ *
+ *  Skinning blends the matrices of the bones influencing a vertex by their
+ *  weight, and then transforms the vertex by the blended matrix. For affine
+ *  matrices, this is the same as blending the transformed vertices.
+ */
+class SkinningVertices {
+public:
+	SkinningVertices();
+
+	/** Prepare vertex data for skinning.
+	 *
+	 *  @param coords         The vertex coordinates, 3 floats per vertex.
+	 *  @param boneIndices    The bone indices, bonesPerVertex floats per vertex. -1 means no bone.
+	 *  @param boneWeights    The bone weights, bonesPerVertex floats per vertex.
+	 *  @param bonesPerVertex The maximum number of bones influencing a vertex.
+	 */
+	void set(const std::vector<float> &coords, const std::vector<float> &boneIndices,
+	         const std::vector<float> &boneWeights, size_t bonesPerVertex);
+
+	void clear();
+
+	bool empty() const;
+
+	/** Return the number of vertices. */
+	size_t getVertexCount() const;
+	/** Return the number of bone matrices needed, i.e. the highest bone index + 1. */
+	size_t getBoneCount() const;
+
+	/** Skin the vertices.
+	 *
+	 *  Uses SSE2 where available.
+	 *
+	 *  @param boneMatrices Affine matrices, 16 floats per bone, column-major like glm::mat4.
+	 *  @param out          Receives the skinned vertex coordinates, 3 floats per vertex.
+	 *  @param outStride    The distance between two vertices in out, in floats.
+	 */
+	void skin(const float *boneMatrices, float *out, size_t outStride) const;
+
+	/** Skin the vertices, without any SIMD instructions. */
+	void skinScalar(const float *boneMatrices, float *out, size_t outStride) const;
+
+	/** Does skin() use SIMD instructions? */
+	static bool isVectorized();
+
+private:
+	std::vector<float> _x;
+	std::vector<float> _y;
+	std::vector<float> _z;
+
+	/** Where the influences of each vertex start, plus the end of the last vertex's. */
+	std::vector<uint32_t> _influenceStart;
+
+	std::vector<uint32_t> _influenceBone;
+	std::vector<float>    _influenceWeight;
+
+	size_t _boneCount;
+
+	void skinSSE2(const float *boneMatrices, float *out, size_t outStride) const;
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_SKINNING_H
@@ -38,7 +38,10 @@ enum VertexAttribIdEnum {
 	VCOLOR,        ///< Vertex color.
 	VBONEINDICES,  ///< Indices of bones affecting the vertex.
 	VBONEWEIGHTS,  ///< Weights of bones affecting the vertex.
-	VTCOORD        ///< Vertex texture coordinates, VTCOORDi = VTCOORD + i.
+	VTCOORD,       ///< Vertex texture coordinates, VTCOORDi = VTCOORD + i.
+
+	VINSTANCEROW   = 12, ///< Rows of a per-instance transform, VINSTANCEROWi = VINSTANCEROW + i.
+	VINSTANCEALPHA = 15  ///< Per-instance alpha value.
 };
 
 /**  Generic vertex attribute data */
@@ -54,6 +54,8 @@
 
 #include "src/aurora/nwscript/objectman.h"
 #include "src/aurora/nwscript/functionman.h"
+#include "src/aurora/nwscript/ncscache.h"
+#include "src/aurora/nwscript/ncsprofiler.h"
 
 #include "src/graphics/queueman.h"
 #include "src/graphics/graphics.h"
@@ -346,6 +348,8 @@ static void deinit() {
 	Aurora::ResourceManager::destroy();
 	Aurora::FileTypeManager::destroy();
 
+	Aurora::NWScript::NCSCache::destroy();
+	Aurora::NWScript::NCSProfiler::destroy();
 	Aurora::NWScript::ObjectManager::destroy();
 	Aurora::NWScript::FunctionManager::destroy();
 
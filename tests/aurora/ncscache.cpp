@@ -0,0 +1,198 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for the cache of decoded NWScript programs.
+ *
+ *  The benchmark loads a script by name over and over, once directly
+ *  from the resource manager and once through the cache. It isn't part
+ *  of a regular test run.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+#include "tests/benchmark.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/writefile.h"
+#include "src/common/changeid.h"
+
+#include "src/aurora/resman.h"
+
+#include "src/aurora/nwscript/ncsfile.h"
+#include "src/aurora/nwscript/ncscache.h"
+#include "src/aurora/nwscript/ncsprogram.h"
+
+using Aurora::NWScript::NCSFile;
+using Aurora::NWScript::NCSProgram;
+
+static const uint32_t kBenchmarkLoads = 10000;
+
+static boost::filesystem::path kBasePath;
+
+/** Write a script that returns this value to dir/name.ncs. */
+static void writeScript(const Common::UString &dir, const Common::UString &name, int32_t value) {
+	static const byte kHeader[] = { 'N', 'C', 'S', ' ', 'V', '1', '.', '0', 0x42, 0, 0, 0, 21 };
+
+	std::vector<byte> data(kHeader, kHeader + sizeof(kHeader));
+
+	// CONST int value; RETN
+	data.push_back(Aurora::NWScript::kOpcodeCONST);
+	data.push_back(Aurora::NWScript::kInstTypeInt);
+	data.push_back((value >> 24) & 0xFF);
+	data.push_back((value >> 16) & 0xFF);
+	data.push_back((value >>  8) & 0xFF);
+	data.push_back( value        & 0xFF);
+	data.push_back(Aurora::NWScript::kOpcodeRETN);
+	data.push_back(Aurora::NWScript::kInstTypeNone);
+
+	boost::filesystem::create_directories((kBasePath / dir.c_str()).generic_string());
+
+	Common::WriteFile file((kBasePath / dir.c_str() / (name + ".ncs").c_str()).generic_string());
+
+	file.write(&data[0], data.size());
+
+	file.flush();
+	file.close();
+}
+
+static int32_t runScript(NCSFile &ncs) {
+	return ncs.run((Aurora::NWScript::Object *) 0).getInt();
+}
+
+static int32_t runScript(const Common::UString &name) {
+	NCSFile ncs(name);
+
+	return runScript(ncs);
+}
+
+class NCSCache : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kBasePath = boost::filesystem::temp_directory_path() /
+		            boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		writeScript("base"    , "script", 1);
+		writeScript("base"    , "other" , 3);
+		writeScript("override", "script", 2);
+	}
+
+	static void TearDownTestCase() {
+		ResMan.clear();
+		Aurora::NWScript::NCSCache::destroy();
+
+		if (!kBasePath.empty())
+			boost::filesystem::remove_all(kBasePath);
+	}
+
+	void SetUp() {
+		ResMan.clear();
+		ResMan.registerDataBase(kBasePath.generic_string());
+
+		ResMan.indexResourceDir("base", 0, 0, 100);
+	}
+};
+
+GTEST_TEST_F(NCSCache, shared) {
+	std::shared_ptr<const NCSProgram> program1 = NCSCacheMan.get("script");
+	std::shared_ptr<const NCSProgram> program2 = NCSCacheMan.get("SCRIPT");
+	std::shared_ptr<const NCSProgram> program3 = NCSCacheMan.get("other");
+
+	ASSERT_TRUE(program1);
+	ASSERT_TRUE(program3);
+
+	EXPECT_EQ(program1, program2);
+	EXPECT_NE(program1, program3);
+
+	EXPECT_EQ(runScript("script"), 1);
+	EXPECT_EQ(runScript("other") , 3);
+
+	const Aurora::NWScript::NCSCache::Stats stats = NCSCacheMan.getStats();
+	EXPECT_EQ(stats.programCount, 2);
+	EXPECT_GE(stats.hits, 3);
+}
+
+GTEST_TEST_F(NCSCache, missing) {
+	EXPECT_THROW(NCSCacheMan.get("nope"), Common::Exception);
+	EXPECT_THROW(NCSFile ncs("nope"), Common::Exception);
+}
+
+GTEST_TEST_F(NCSCache, undo) {
+	EXPECT_EQ(runScript("script"), 1);
+
+	Common::ChangeID change;
+	ResMan.indexResourceDir("override", 0, 0, 200, &change);
+
+	EXPECT_EQ(runScript("script"), 2);
+
+	// A script still running keeps its program, even if the cache is dropped
+	NCSFile ncs("script");
+
+	ResMan.undo(change);
+
+	EXPECT_EQ(runScript("script"), 1);
+	EXPECT_EQ(runScript(ncs), 2);
+
+	EXPECT_GE(NCSCacheMan.getStats().invalidations, 2);
+}
+
+GTEST_TEST_F(NCSCache, clear) {
+	std::shared_ptr<const NCSProgram> program1 = NCSCacheMan.get("script");
+
+	NCSCacheMan.clear();
+	EXPECT_EQ(NCSCacheMan.getStats().programCount, 0);
+
+	std::shared_ptr<const NCSProgram> program2 = NCSCacheMan.get("script");
+	EXPECT_NE(program1, program2);
+}
+
+static void benchmarkLoads(const char *what, bool cached) {
+	int32_t sum = 0;
+
+	const double ms = benchmarkTime([&]() {
+		for (uint32_t i = 0; i < kBenchmarkLoads; i++) {
+			if (cached) {
+				NCSFile ncs("script");
+				sum += runScript(ncs);
+			} else {
+				NCSFile ncs(ResMan.getResource("script", Aurora::kFileTypeNCS));
+				sum += runScript(ncs);
+			}
+		}
+	});
+
+	EXPECT_EQ(sum, (int32_t) kBenchmarkLoads);
+
+	benchmarkPrint("%s: %u script runs: %.2f ms (%.2f us/run)",
+	               what, kBenchmarkLoads, ms, (ms * 1000.0) / kBenchmarkLoads);
+}
+
+GTEST_TEST_F(NCSCache, DISABLED_benchmark) {
+	benchmarkLoads("Resource manager", false);
+	benchmarkLoads("Cache", true);
+}
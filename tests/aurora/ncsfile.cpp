@@ -0,0 +1,554 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for the NWScript bytecode interpreter.
+ *
+ *  All scripts are run by both the decoded and the reference interpreter,
+ *  and have to produce the same results.
+ *
+ *  The benchmarks run a loop summing up squares, and loops around single
+ *  common opcodes, to measure the cost of the dispatch and of creating,
+ *  copying and destroying the values on the stack. Like all our
+ *  benchmarks, they stay disabled unless named.
+ */
+
+#include <cstring>
+
+#include <vector>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "tests/benchmark.h"
+
+#include "src/common/util.h"
+#include "src/common/ustring.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/nwscript/ncsfile.h"
+#include "src/aurora/nwscript/ncsprogram.h"
+#include "src/aurora/nwscript/functionman.h"
+#include "src/aurora/nwscript/functioncontext.h"
+
+using Aurora::NWScript::NCSFile;
+using Aurora::NWScript::NCSProgram;
+using Aurora::NWScript::NCSInstruction;
+using Aurora::NWScript::Variable;
+using Aurora::NWScript::ScriptState;
+
+namespace NWScript = Aurora::NWScript;
+
+static const uint32_t kBenchmarkLoops = 20000;
+
+/** A tiny assembler for NWScript bytecode. */
+class Assembler {
+public:
+	Assembler() {
+		static const byte kHeader[] = { 'N', 'C', 'S', ' ', 'V', '1', '.', '0', 0x42, 0, 0, 0, 0 };
+
+		_data.assign(kHeader, kHeader + sizeof(kHeader));
+	}
+
+	uint32_t pos() const {
+		return _data.size();
+	}
+
+	void op(NWScript::Opcode opcode, NWScript::InstructionType type = NWScript::kInstTypeNone) {
+		_data.push_back(opcode);
+		_data.push_back(type);
+	}
+
+	void int16(int16_t value) {
+		_data.push_back((value >> 8) & 0xFF);
+		_data.push_back( value       & 0xFF);
+	}
+
+	void int32(int32_t value) {
+		int16((value >> 16) & 0xFFFF);
+		int16( value        & 0xFFFF);
+	}
+
+	void constInt(int32_t value) {
+		op(NWScript::kOpcodeCONST, NWScript::kInstTypeInt);
+		int32(value);
+	}
+
+	void constFloat(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, 4);
+
+		op(NWScript::kOpcodeCONST, NWScript::kInstTypeFloat);
+		int32(bits);
+	}
+
+	void constString(const char *value) {
+		op(NWScript::kOpcodeCONST, NWScript::kInstTypeString);
+		int16(std::strlen(value));
+		_data.insert(_data.end(), value, value + std::strlen(value));
+	}
+
+	void stack(NWScript::Opcode opcode, int32_t offset, int16_t size = 4) {
+		op(opcode, NWScript::kInstTypeDirect);
+		int32(offset);
+		int16(size);
+	}
+
+	void action(uint16_t routine, uint8_t argCount) {
+		op(NWScript::kOpcodeACTION);
+		int16(routine);
+		_data.push_back(argCount);
+	}
+
+	/** Write a jump and return its position, to be patched with patchJump(). */
+	uint32_t jump(NWScript::Opcode opcode, uint32_t target = 0) {
+		const uint32_t address = pos();
+
+		op(opcode);
+		int32(target - address);
+
+		return address;
+	}
+
+	/** Let the jump at this position jump to the current position. */
+	void patchJump(uint32_t jump) {
+		const int32_t offset = pos() - jump;
+
+		_data[jump + 2] = (offset >> 24) & 0xFF;
+		_data[jump + 3] = (offset >> 16) & 0xFF;
+		_data[jump + 4] = (offset >>  8) & 0xFF;
+		_data[jump + 5] =  offset        & 0xFF;
+	}
+
+	Common::SeekableReadStream *createStream() const {
+		std::vector<byte> data = _data;
+
+		const uint32_t size = data.size();
+		data[ 9] = (size >> 24) & 0xFF;
+		data[10] = (size >> 16) & 0xFF;
+		data[11] = (size >>  8) & 0xFF;
+		data[12] =  size        & 0xFF;
+
+		std::unique_ptr<byte[]> copy = std::make_unique<byte[]>(size);
+		std::memcpy(copy.get(), data.data(), size);
+
+		return new Common::MemoryReadStream(std::move(copy), size);
+	}
+
+	NCSFile *create(NCSFile::Interpreter interpreter) const {
+		NCSFile *ncs = new NCSFile(createStream());
+		ncs->setInterpreter(interpreter);
+
+		return ncs;
+	}
+
+private:
+	std::vector<byte> _data;
+};
+
+static const uint32_t kFunctionSubtract = 0;
+static const uint32_t kFunctionStore    = 1;
+
+static ScriptState storedState;
+
+static void registerFunctions() {
+	static bool registered = false;
+	if (registered)
+		return;
+
+	NWScript::Signature subtract;
+	subtract.push_back(NWScript::kTypeInt);
+	subtract.push_back(NWScript::kTypeInt);
+	subtract.push_back(NWScript::kTypeInt);
+
+	FunctionMan.registerFunction("Subtract", kFunctionSubtract, [](NWScript::FunctionContext &ctx) {
+		ctx.getReturn() = ctx.getParams()[0].getInt() - ctx.getParams()[1].getInt();
+	}, subtract);
+
+	NWScript::Signature store;
+	store.push_back(NWScript::kTypeVoid);
+	store.push_back(NWScript::kTypeScriptState);
+
+	FunctionMan.registerFunction("Store", kFunctionStore, [](NWScript::FunctionContext &ctx) {
+		storedState = ctx.getParams()[0].getScriptState();
+	}, store);
+
+	registered = true;
+}
+
+/** Sum up i * i for i from 0 to count - 1, in a loop. */
+static Assembler createLoop(int32_t count) {
+	Assembler code;
+
+	code.constInt(0); // sum
+	code.constInt(0); // i
+
+	const uint32_t loop = code.pos();
+
+	code.stack(NWScript::kOpcodeCPTOPSP, -4);
+	code.constInt(count);
+	code.op(NWScript::kOpcodeLT, NWScript::kInstTypeIntInt);
+	const uint32_t exit = code.jump(NWScript::kOpcodeJZ);
+
+	code.stack(NWScript::kOpcodeCPTOPSP, -4);
+	code.stack(NWScript::kOpcodeCPTOPSP, -8);
+	code.op(NWScript::kOpcodeMUL, NWScript::kInstTypeIntInt);
+	code.stack(NWScript::kOpcodeCPTOPSP, -12);
+	code.op(NWScript::kOpcodeADD, NWScript::kInstTypeIntInt);
+	code.stack(NWScript::kOpcodeCPDOWNSP, -12);
+	code.op(NWScript::kOpcodeMOVSP);
+	code.int32(-4);
+
+	code.op(NWScript::kOpcodeINCSP, NWScript::kInstTypeInt);
+	code.int32(-4);
+	code.jump(NWScript::kOpcodeJMP, loop);
+
+	code.patchJump(exit);
+	code.op(NWScript::kOpcodeMOVSP);
+	code.int32(-4);
+	code.op(NWScript::kOpcodeRETN);
+
+	return code;
+}
+
+static Variable run(NCSFile &ncs, const ScriptState &state = NCSFile::getEmptyState()) {
+	return ncs.run(state, NWScript::ObjectReference(), NWScript::ObjectReference());
+}
+
+/** Run the script with both interpreters and make sure they agree. */
+static Variable runBoth(const Assembler &code, const ScriptState &state = NCSFile::getEmptyState()) {
+	std::unique_ptr<NCSFile> decoded  (code.create(NCSFile::kInterpreterDecoded));
+	std::unique_ptr<NCSFile> reference(code.create(NCSFile::kInterpreterReference));
+
+	const Variable result = run(*decoded, state);
+	EXPECT_TRUE(result == run(*reference, state));
+
+	return result;
+}
+
+GTEST_TEST(NCSProgram, decode) {
+	Assembler code = createLoop(10);
+
+	std::unique_ptr<Common::SeekableReadStream> stream(code.createStream());
+	NCSProgram program(*stream);
+
+	ASSERT_TRUE(program.isDecoded());
+
+	const std::vector<NCSInstruction> &instructions = program.getInstructions();
+	ASSERT_EQ(instructions.size(), 18);
+
+	EXPECT_EQ(instructions[0].address, NCSProgram::kStartOffset);
+	EXPECT_EQ(instructions[0].opcode, NWScript::kOpcodeCONST);
+	EXPECT_EQ(instructions[2].args[0], -4);
+	EXPECT_EQ(instructions[3].args[0], 10);
+
+	// JZ to the final MOVSP, JMP back to the start of the loop
+	EXPECT_EQ(instructions[5].opcode, NWScript::kOpcodeJZ);
+	EXPECT_EQ(instructions[5].target, 15);
+	EXPECT_EQ(instructions[14].opcode, NWScript::kOpcodeJMP);
+	EXPECT_EQ(instructions[14].target, 2);
+
+	EXPECT_EQ(instructions.back().opcode, NWScript::kOpcodeEnd);
+	EXPECT_EQ(program.findInstruction(instructions[7].address), 7);
+	EXPECT_EQ(program.findInstruction(instructions[7].address + 1), NCSProgram::kInvalidInstruction);
+	EXPECT_EQ(program.findInstruction(program.getSize()), instructions.size() - 1);
+}
+
+GTEST_TEST(NCSProgram, undecodable) {
+	Assembler code;
+
+	code.constInt(1);
+	code.jump(NWScript::kOpcodeJMP, 1000);
+
+	std::unique_ptr<Common::SeekableReadStream> stream(code.createStream());
+	NCSProgram program(*stream);
+
+	EXPECT_FALSE(program.isDecoded());
+	EXPECT_EQ(program.findInstruction(NCSProgram::kStartOffset), NCSProgram::kInvalidInstruction);
+}
+
+GTEST_TEST(NCSFile, loop) {
+	const Variable result = runBoth(createLoop(100));
+
+	ASSERT_EQ(result.getType(), NWScript::kTypeInt);
+	EXPECT_EQ(result.getInt(), 328350);
+}
+
+GTEST_TEST(NCSFile, subroutine) {
+	Assembler code;
+
+	code.constString("Hello, ");
+	code.op(NWScript::kOpcodeSAVEBP);
+	const uint32_t call = code.jump(NWScript::kOpcodeJSR);
+	code.op(NWScript::kOpcodeRESTOREBP);
+	code.op(NWScript::kOpcodeRETN);
+
+	// Append to the global string
+	code.patchJump(call);
+	code.stack(NWScript::kOpcodeCPTOPBP, -4);
+	code.constString("world");
+	code.op(NWScript::kOpcodeADD, NWScript::kInstTypeStringString);
+	code.stack(NWScript::kOpcodeCPDOWNBP, -4);
+	code.op(NWScript::kOpcodeMOVSP);
+	code.int32(-4);
+	code.op(NWScript::kOpcodeRETN);
+
+	const Variable result = runBoth(code);
+
+	ASSERT_EQ(result.getType(), NWScript::kTypeString);
+	EXPECT_STREQ(result.getString().c_str(), "Hello, world");
+}
+
+GTEST_TEST(NCSFile, floats) {
+	Assembler code;
+
+	// -((1.5 * 2) - 0.25) / 2
+	code.constFloat(1.5f);
+	code.constInt(2);
+	code.op(NWScript::kOpcodeMUL, NWScript::kInstTypeFloatInt);
+	code.constFloat(0.25f);
+	code.op(NWScript::kOpcodeSUB, NWScript::kInstTypeFloatFloat);
+	code.op(NWScript::kOpcodeNEG, NWScript::kInstTypeFloat);
+	code.constFloat(2.0f);
+	code.op(NWScript::kOpcodeDIV, NWScript::kInstTypeFloatFloat);
+
+	const Variable result = runBoth(code);
+
+	ASSERT_EQ(result.getType(), NWScript::kTypeFloat);
+	EXPECT_FLOAT_EQ(result.getFloat(), -1.375f);
+}
+
+GTEST_TEST(NCSFile, action) {
+	registerFunctions();
+
+	Assembler code;
+
+	code.constInt(3);
+	code.constInt(10);
+	code.action(kFunctionSubtract, 2);
+
+	const Variable result = runBoth(code);
+
+	ASSERT_EQ(result.getType(), NWScript::kTypeInt);
+	EXPECT_EQ(result.getInt(), 7);
+}
+
+GTEST_TEST(NCSFile, storeState) {
+	registerFunctions();
+
+	Assembler code;
+
+	code.constInt(5);
+
+	// Store the state, and the code that's run with it: everything behind the JMP
+	code.op(NWScript::kOpcodeSTORESTATE, (NWScript::InstructionType) 0x10);
+	code.int32(0);
+	code.int32(4);
+	const uint32_t skip = code.jump(NWScript::kOpcodeJMP);
+
+	code.stack(NWScript::kOpcodeCPTOPSP, -4);
+	code.constInt(10);
+	code.op(NWScript::kOpcodeMUL, NWScript::kInstTypeIntInt);
+	code.op(NWScript::kOpcodeRETN);
+
+	code.patchJump(skip);
+	code.action(kFunctionStore, 1);
+	code.op(NWScript::kOpcodeRETN);
+
+	runBoth(code);
+
+	ASSERT_EQ(storedState.locals.size(), 1);
+	EXPECT_EQ(storedState.offset, NCSProgram::kStartOffset + 6 + 16);
+
+	const ScriptState state = storedState;
+	const Variable result = runBoth(code, state);
+
+	ASSERT_EQ(result.getType(), NWScript::kTypeInt);
+	EXPECT_EQ(result.getInt(), 50);
+}
+
+GTEST_TEST(NCSFile, errors) {
+	Assembler code;
+
+	code.constInt(1);
+	code.constInt(0);
+	code.op(NWScript::kOpcodeDIV, NWScript::kInstTypeIntInt);
+
+	std::unique_ptr<NCSFile> decoded  (code.create(NCSFile::kInterpreterDecoded));
+	std::unique_ptr<NCSFile> reference(code.create(NCSFile::kInterpreterReference));
+
+	EXPECT_THROW(run(*decoded), Common::Exception);
+	EXPECT_THROW(run(*reference), Common::Exception);
+
+	Assembler illegal;
+	illegal.op(NWScript::kOpcodeLOGAND, NWScript::kInstTypeFloatFloat);
+
+	std::unique_ptr<NCSFile> illegalDecoded(illegal.create(NCSFile::kInterpreterDecoded));
+	EXPECT_THROW(run(*illegalDecoded), Common::Exception);
+}
+
+GTEST_TEST(NCSFile, undecodable) {
+	Assembler code;
+
+	// A jump to outside the script, never taken
+	code.constInt(6);
+	code.constInt(1);
+	code.jump(NWScript::kOpcodeJZ, 1000);
+
+	const Variable result = runBoth(code);
+
+	ASSERT_EQ(result.getType(), NWScript::kTypeInt);
+	EXPECT_EQ(result.getInt(), 6);
+}
+
+GTEST_TEST(NCSFile, instructionBudget) {
+	const Assembler code = createLoop(100);
+
+	const NCSFile::Interpreter interpreters[] = { NCSFile::kInterpreterDecoded, NCSFile::kInterpreterReference };
+	for (size_t i = 0; i < ARRAYSIZE(interpreters); i++) {
+		std::unique_ptr<NCSFile> ncs(code.create(interpreters[i]));
+
+		ncs->setInstructionBudget(100);
+		EXPECT_EQ(ncs->getInstructionBudget(), 100U);
+
+		Variable result = run(*ncs);
+
+		size_t slices = 1;
+		while (ncs->isSuspended()) {
+			EXPECT_EQ(result.getType(), NWScript::kTypeVoid);
+
+			result = ncs->resume();
+			slices++;
+		}
+
+		// About 1300 instructions, run 100 at a time
+		EXPECT_GE(slices, 13U);
+		EXPECT_LE(slices, 14U);
+
+		ASSERT_EQ(result.getType(), NWScript::kTypeInt);
+		EXPECT_EQ(result.getInt(), 328350);
+
+		// Without a budget, the script runs in one go again
+		ncs->setInstructionBudget(0);
+
+		result = run(*ncs);
+		EXPECT_FALSE(ncs->isSuspended());
+
+		ASSERT_EQ(result.getType(), NWScript::kTypeInt);
+		EXPECT_EQ(result.getInt(), 328350);
+
+		EXPECT_THROW(ncs->resume(), Common::Exception);
+	}
+}
+
+/** Run the body count times in a loop. The body has to leave the stack like it found it. */
+template<typename Body>
+static Assembler createBenchmarkLoop(int32_t count, Body body) {
+	Assembler code;
+
+	code.constInt(0); // i
+
+	const uint32_t loop = code.pos();
+
+	code.stack(NWScript::kOpcodeCPTOPSP, -4);
+	code.constInt(count);
+	code.op(NWScript::kOpcodeLT, NWScript::kInstTypeIntInt);
+	const uint32_t exit = code.jump(NWScript::kOpcodeJZ);
+
+	body(code);
+
+	code.op(NWScript::kOpcodeINCSP, NWScript::kInstTypeInt);
+	code.int32(-4);
+	code.jump(NWScript::kOpcodeJMP, loop);
+
+	code.patchJump(exit);
+	code.op(NWScript::kOpcodeRETN);
+
+	return code;
+}
+
+/** The number of instructions the benchmark loop itself runs per iteration. */
+static const uint32_t kBenchmarkLoopInstructions = 6;
+
+static void benchmarkScript(const char *what, const Assembler &code, NCSFile::Interpreter interpreter,
+                            uint32_t instructions = 13) {
+
+	std::unique_ptr<NCSFile> ncs(code.create(interpreter));
+
+	Variable result;
+	const double ms = benchmarkTime([&]() {
+		result = run(*ncs);
+	});
+
+	EXPECT_EQ(result.getType(), NWScript::kTypeInt);
+
+	benchmarkPrint("%s: %u loop iterations: %.2f ms (%.1f ns/instruction)",
+	               what, kBenchmarkLoops, ms, (ms * 1000000.0) / (kBenchmarkLoops * (double) instructions));
+}
+
+GTEST_TEST(NCSFile, DISABLED_benchmark) {
+	const Assembler code = createLoop(kBenchmarkLoops);
+
+	benchmarkScript("Reference", code, NCSFile::kInterpreterReference);
+	benchmarkScript("Decoded"  , code, NCSFile::kInterpreterDecoded);
+}
+
+GTEST_TEST(NCSFile, DISABLED_benchmarkOpcodes) {
+	registerFunctions();
+
+	// Copy the counter and drop it again
+	const Assembler copy = createBenchmarkLoop(kBenchmarkLoops, [](Assembler &code) {
+		code.stack(NWScript::kOpcodeCPTOPSP, -4);
+		code.op(NWScript::kOpcodeMOVSP);
+		code.int32(-4);
+	});
+
+	// Add the counter to itself
+	const Assembler arithmetic = createBenchmarkLoop(kBenchmarkLoops, [](Assembler &code) {
+		code.stack(NWScript::kOpcodeCPTOPSP, -4);
+		code.stack(NWScript::kOpcodeCPTOPSP, -8);
+		code.op(NWScript::kOpcodeADD, NWScript::kInstTypeIntInt);
+		code.op(NWScript::kOpcodeMOVSP);
+		code.int32(-4);
+	});
+
+	// Push a string, copy it and compare the two
+	const Assembler strings = createBenchmarkLoop(kBenchmarkLoops, [](Assembler &code) {
+		code.constString("Hello");
+		code.stack(NWScript::kOpcodeCPTOPSP, -4);
+		code.op(NWScript::kOpcodeEQ, NWScript::kInstTypeStringString);
+		code.op(NWScript::kOpcodeMOVSP);
+		code.int32(-4);
+	});
+
+	// Call an engine function with the counter
+	const Assembler action = createBenchmarkLoop(kBenchmarkLoops, [](Assembler &code) {
+		code.stack(NWScript::kOpcodeCPTOPSP, -4);
+		code.constInt(1);
+		code.action(kFunctionSubtract, 2);
+		code.op(NWScript::kOpcodeMOVSP);
+		code.int32(-4);
+	});
+
+	benchmarkScript("CPTOPSP"   , copy      , NCSFile::kInterpreterDecoded, kBenchmarkLoopInstructions + 2);
+	benchmarkScript("Arithmetic", arithmetic, NCSFile::kInterpreterDecoded, kBenchmarkLoopInstructions + 4);
+	benchmarkScript("Strings"   , strings   , NCSFile::kInterpreterDecoded, kBenchmarkLoopInstructions + 4);
+	benchmarkScript("ACTION"    , action    , NCSFile::kInterpreterDecoded, kBenchmarkLoopInstructions + 4);
+}
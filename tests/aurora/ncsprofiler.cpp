@@ -0,0 +1,82 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the NWScript profiler.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/aurora/nwscript/ncsprofiler.h"
+
+using Aurora::NWScript::NCSProfiler;
+
+GTEST_TEST(NCSProfiler, record) {
+	NCSProfilerMan.clear();
+
+	NCSProfilerMan.record("fast", 10, 1000, true);
+	NCSProfilerMan.record("slow", 50, 4000, false);
+	NCSProfilerMan.record("SLOW", 20, 2000, true);
+	NCSProfilerMan.record("fast", 10, 1500, true);
+
+	const std::vector<NCSProfiler::ScriptStats> stats = NCSProfilerMan.getStats();
+	ASSERT_EQ(stats.size(), 2U);
+
+	// Sorted by the total time
+	EXPECT_STREQ(stats[0].name.c_str(), "slow");
+	EXPECT_EQ(stats[0].runs        , 1U);
+	EXPECT_EQ(stats[0].slices      , 2U);
+	EXPECT_EQ(stats[0].instructions, 70U);
+	EXPECT_EQ(stats[0].time        , 6000U);
+	EXPECT_EQ(stats[0].maxSliceTime, 4000U);
+
+	EXPECT_STREQ(stats[1].name.c_str(), "fast");
+	EXPECT_EQ(stats[1].runs        , 2U);
+	EXPECT_EQ(stats[1].slices      , 2U);
+	EXPECT_EQ(stats[1].instructions, 20U);
+	EXPECT_EQ(stats[1].time        , 2500U);
+	EXPECT_EQ(stats[1].maxSliceTime, 1500U);
+
+	NCSProfiler::destroy();
+}
+
+GTEST_TEST(NCSProfiler, clear) {
+	NCSProfilerMan.record("script", 10, 1000, true);
+	EXPECT_EQ(NCSProfilerMan.getStats().size(), 1U);
+
+	NCSProfilerMan.clear();
+	EXPECT_TRUE(NCSProfilerMan.getStats().empty());
+
+	NCSProfiler::destroy();
+}
+
+GTEST_TEST(NCSProfiler, enabled) {
+	EXPECT_FALSE(NCSProfilerMan.isEnabled());
+
+	NCSProfilerMan.setEnabled(true);
+	EXPECT_TRUE(NCSProfilerMan.isEnabled());
+
+	NCSProfilerMan.setEnabled(false);
+	EXPECT_FALSE(NCSProfilerMan.isEnabled());
+
+	NCSProfiler::destroy();
+}
@@ -0,0 +1,181 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our persistent cache of archive resource indices.
+ */
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/strutil.h"
+
+#include "src/aurora/resindexcache.h"
+
+boost::filesystem::path kBasePath;
+
+static Common::UString getPath(const char *file) {
+	return (kBasePath / file).generic_string();
+}
+
+static void writeFile(const Common::UString &path, const char *data) {
+	boost::filesystem::ofstream file(path.c_str(), std::ofstream::binary);
+
+	file << data;
+	file.close();
+}
+
+static Aurora::ResourceIndexCache::FileList makeFiles(const Common::UString &path) {
+	Aurora::ResourceIndexCache::FileList files(1);
+
+	files[0].path     = path;
+	files[0].hashAlgo = Common::kHashFNV64;
+
+	for (uint32_t i = 0; i < 3; i++) {
+		files[0].resources.push_back(Aurora::Archive::Resource());
+
+		files[0].resources.back().name  = Common::String::format("res%u", i);
+		files[0].resources.back().hash  = 0x1234567890ULL + i;
+		files[0].resources.back().type  = Aurora::kFileTypeTXT;
+		files[0].resources.back().index = i;
+	}
+
+	return files;
+}
+
+static void compareFiles(const Aurora::ResourceIndexCache::FileList &files) {
+	ASSERT_EQ(files.size(), 1);
+	EXPECT_EQ(files[0].hashAlgo, Common::kHashFNV64);
+
+	ASSERT_EQ(files[0].resources.size(), 3);
+
+	uint32_t i = 0;
+	for (Aurora::Archive::ResourceList::const_iterator r = files[0].resources.begin();
+	     r != files[0].resources.end(); ++r, i++) {
+
+		EXPECT_EQ(r->name, Common::String::format("res%u", i));
+		EXPECT_EQ(r->hash, 0x1234567890ULL + i);
+		EXPECT_EQ(r->type, Aurora::kFileTypeTXT);
+		EXPECT_EQ(r->index, i);
+	}
+}
+
+class ResourceIndexCache : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kBasePath = boost::filesystem::temp_directory_path() /
+		            boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directory(kBasePath);
+	}
+
+	static void TearDownTestCase() {
+		if (!kBasePath.empty())
+			boost::filesystem::remove_all(kBasePath);
+	}
+
+	void SetUp() {
+		writeFile(getPath("archive.erf"), "archive");
+	}
+};
+
+GTEST_TEST_F(ResourceIndexCache, find) {
+	Aurora::ResourceIndexCache cache;
+
+	EXPECT_FALSE(cache.isModified());
+
+	Aurora::ResourceIndexCache::FileList files = makeFiles(getPath("archive.erf"));
+	cache.add(getPath("archive.erf"), files);
+
+	EXPECT_TRUE(cache.isModified());
+
+	Aurora::ResourceIndexCache::FileList found;
+	EXPECT_FALSE(cache.find(getPath("nope.erf"), found));
+
+	ASSERT_TRUE(cache.find(getPath("archive.erf"), found));
+	compareFiles(found);
+}
+
+GTEST_TEST_F(ResourceIndexCache, missingFile) {
+	Aurora::ResourceIndexCache cache;
+
+	// Files that don't exist can't be cached
+	Aurora::ResourceIndexCache::FileList files = makeFiles(getPath("nope.erf"));
+	cache.add(getPath("nope.erf"), files);
+
+	Aurora::ResourceIndexCache::FileList found;
+	EXPECT_FALSE(cache.find(getPath("nope.erf"), found));
+}
+
+GTEST_TEST_F(ResourceIndexCache, changedFile) {
+	Aurora::ResourceIndexCache cache;
+
+	Aurora::ResourceIndexCache::FileList files = makeFiles(getPath("archive.erf"));
+	cache.add(getPath("archive.erf"), files);
+
+	writeFile(getPath("archive.erf"), "changed archive");
+
+	Aurora::ResourceIndexCache::FileList found;
+	EXPECT_FALSE(cache.find(getPath("archive.erf"), found));
+	EXPECT_TRUE(found.empty());
+}
+
+GTEST_TEST_F(ResourceIndexCache, saveLoad) {
+	{
+		Aurora::ResourceIndexCache cache;
+
+		Aurora::ResourceIndexCache::FileList files = makeFiles(getPath("archive.erf"));
+		cache.add(getPath("archive.erf"), files);
+
+		cache.save(getPath("cache"));
+		EXPECT_FALSE(cache.isModified());
+	}
+
+	Aurora::ResourceIndexCache cache;
+	cache.load(getPath("cache"));
+
+	EXPECT_FALSE(cache.isModified());
+
+	Aurora::ResourceIndexCache::FileList found;
+	ASSERT_TRUE(cache.find(getPath("archive.erf"), found));
+	compareFiles(found);
+
+	// Saving over the file we loaded from keeps the loaded entries intact
+	cache.save(getPath("cache"));
+	cache.load(getPath("cache"));
+
+	ASSERT_TRUE(cache.find(getPath("archive.erf"), found));
+	compareFiles(found);
+}
+
+GTEST_TEST_F(ResourceIndexCache, loadInvalid) {
+	writeFile(getPath("invalid"), "This is not a cache file");
+
+	Aurora::ResourceIndexCache cache;
+	EXPECT_THROW(cache.load(getPath("invalid")), Common::Exception);
+	EXPECT_THROW(cache.load(getPath("nope")), Common::Exception);
+}
@@ -0,0 +1,361 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and benchmarks for our resource manager.
+ *
+ *  The benchmarks, left out of normal runs, index a synthetic archive with
+ *  lots of resources and then look them up over and over. If the
+ *  environment variable XOREOS_BENCHMARK_GAMEDIR points to a game
+ *  installation, all KEY and ERF-like archives found there are indexed
+ *  and looked up as well.
+ */
+
+#include <cstdlib>
+
+#include <memory>
+#include <vector>
+#include <list>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+#include "tests/benchmark.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/filepath.h"
+#include "src/common/filelist.h"
+#include "src/common/strutil.h"
+#include "src/common/writefile.h"
+#include "src/common/memreadstream.h"
+#include "src/common/changeid.h"
+
+#include "src/aurora/resman.h"
+#include "src/aurora/erfwriter.h"
+
+static const uint32_t kResourceCount = 1000;
+static const uint32_t kOverrideCount = 10;
+
+static const uint32_t kBenchmarkResourceCount = 100000;
+static const uint32_t kBenchmarkLookupCount   = 1000000;
+
+boost::filesystem::path kBasePath;
+
+static Common::UString getResourceName(uint32_t i) {
+	return Common::String::format("res%06u", i);
+}
+
+/** Write an ERF with count resources, each containing a single byte. */
+static void writeERF(const Common::UString &fileName, uint32_t count, byte content) {
+	Common::WriteFile file(fileName);
+
+	Aurora::ERFWriter erf(MKTAG('E', 'R', 'F', ' '), count, file);
+
+	for (uint32_t i = 0; i < count; i++) {
+		Common::MemoryReadStream data(&content, 1);
+
+		erf.add(getResourceName(i), Aurora::kFileTypeTXT, data);
+	}
+
+	file.flush();
+	file.close();
+}
+
+static byte getResourceContent(const Common::UString &name) {
+	std::unique_ptr<Common::SeekableReadStream> stream(ResMan.getResource(name, Aurora::kFileTypeTXT));
+	if (!stream)
+		return 0;
+
+	return stream->readByte();
+}
+
+class ResourceManager : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kBasePath = boost::filesystem::temp_directory_path() /
+		            boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directory(kBasePath);
+
+		const Common::UString base = kBasePath.generic_string();
+
+		writeERF(base + "/base.erf"    , kResourceCount, 'a');
+		writeERF(base + "/override.erf", kOverrideCount, 'b');
+	}
+
+	static void TearDownTestCase() {
+		ResMan.clear();
+
+		if (!kBasePath.empty())
+			boost::filesystem::remove_all(kBasePath);
+	}
+
+	void SetUp() {
+		ResMan.clear();
+		ResMan.registerDataBase(kBasePath.generic_string());
+
+		ResMan.indexArchive("base.erf", 100);
+	}
+};
+
+GTEST_TEST_F(ResourceManager, getResource) {
+	EXPECT_TRUE(ResMan.hasResource("res000000", Aurora::kFileTypeTXT));
+	EXPECT_FALSE(ResMan.hasResource("res000000", Aurora::kFileTypeGFF));
+	EXPECT_FALSE(ResMan.hasResource("nope", Aurora::kFileTypeTXT));
+
+	EXPECT_EQ(getResourceContent("res000000"), 'a');
+	EXPECT_EQ(getResourceContent(getResourceName(kResourceCount - 1)), 'a');
+}
+
+GTEST_TEST_F(ResourceManager, priority) {
+	Common::ChangeID change;
+	ResMan.indexArchive("override.erf", 200, &change);
+
+	// The resources in the override archive take precedence
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'b');
+	EXPECT_EQ(getResourceContent(getResourceName(kOverrideCount - 1)), 'b');
+	EXPECT_EQ(getResourceContent(getResourceName(kOverrideCount)), 'a');
+
+	// Until we remove the override archive again
+	ResMan.undo(change);
+
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'a');
+	EXPECT_EQ(getResourceContent(getResourceName(kOverrideCount - 1)), 'a');
+}
+
+GTEST_TEST_F(ResourceManager, lowerPriority) {
+	ResMan.indexArchive("override.erf", 50);
+
+	// The override archive has a lower priority, so it doesn't override anything
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'a');
+}
+
+GTEST_TEST_F(ResourceManager, undo) {
+	Common::ChangeID change;
+	ResMan.indexArchive("override.erf", 200, &change);
+	ResMan.undo(change);
+
+	// Indexing the same archive again, after undoing it, works as before
+	ResMan.indexArchive("override.erf", 200, &change);
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'b');
+
+	ResMan.undo(change);
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'a');
+}
+
+GTEST_TEST_F(ResourceManager, blacklist) {
+	ResMan.blacklist(getResourceName(1), Aurora::kFileTypeTXT);
+
+	EXPECT_FALSE(ResMan.hasResource(getResourceName(1), Aurora::kFileTypeTXT));
+	EXPECT_TRUE(ResMan.hasResource(getResourceName(2), Aurora::kFileTypeTXT));
+}
+
+GTEST_TEST_F(ResourceManager, getAvailableResources) {
+	std::list<Aurora::ResourceManager::ResourceID> resources;
+	ResMan.getAvailableResources(Aurora::kFileTypeTXT, resources);
+
+	ASSERT_EQ(resources.size(), kResourceCount);
+
+	// The resources are sorted by hash
+	uint64_t lastHash = 0;
+	for (std::list<Aurora::ResourceManager::ResourceID>::const_iterator r = resources.begin();
+	     r != resources.end(); ++r) {
+
+		EXPECT_EQ(r->type, Aurora::kFileTypeTXT);
+		EXPECT_GE(r->hash, lastHash);
+
+		lastHash = r->hash;
+	}
+}
+
+GTEST_TEST_F(ResourceManager, indexCache) {
+	const Common::UString cacheFile = (kBasePath / "resindex.cache").generic_string();
+
+	// Index the archive once, to fill the cache
+	ResMan.setIndexCache(cacheFile);
+	ResMan.indexArchive("override.erf", 200);
+	ResMan.saveIndexCache();
+
+	ResMan.setIndexCache("");
+	ASSERT_TRUE(boost::filesystem::exists(cacheFile.c_str()));
+
+	// Index it again, from the cache freshly loaded
+	ResMan.setIndexCache(cacheFile);
+
+	ResMan.clear();
+	ResMan.registerDataBase(kBasePath.generic_string());
+	ResMan.indexArchive("base.erf", 100);
+
+	Common::ChangeID change;
+	ResMan.indexArchive("override.erf", 200, &change);
+
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'b');
+	EXPECT_EQ(getResourceContent(getResourceName(kOverrideCount)), 'a');
+
+	ResMan.undo(change);
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'a');
+
+	ResMan.setIndexCache("");
+}
+
+GTEST_TEST_F(ResourceManager, prefetch) {
+	Common::ChangeID change;
+	ResMan.indexArchive("override.erf", 200, &change);
+
+	for (uint32_t i = 0; i < 2 * kOverrideCount; i++)
+		ResMan.prefetch(getResourceName(i), Aurora::kFileTypeTXT);
+
+	// Prefetching resources that don't exist is fine
+	ResMan.prefetch("nope", Aurora::kFileTypeTXT);
+
+	// Whether the prefetch is done yet or not, we get the right resources
+	for (uint32_t i = 0; i < 2 * kOverrideCount; i++)
+		EXPECT_EQ(getResourceContent(getResourceName(i)), (i < kOverrideCount) ? 'b' : 'a') << "At index " << i;
+
+	// A prefetched resource is handed out only once, after that, it's read again
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'b');
+
+	// Undoing drops the prefetched resources of the archive
+	ResMan.prefetch(getResourceName(0), Aurora::kFileTypeTXT);
+	ResMan.undo(change);
+
+	EXPECT_EQ(getResourceContent(getResourceName(0)), 'a');
+}
+
+GTEST_TEST_F(ResourceManager, prefetchIndex) {
+	for (uint32_t i = 0; i < 100; i++)
+		ResMan.prefetch(getResourceName(i), Aurora::kFileTypeTXT);
+
+	// Indexing while prefetches are still running drops them, and we get the new resources
+	ResMan.indexArchive("override.erf", 200);
+
+	for (uint32_t i = 0; i < 100; i++)
+		EXPECT_EQ(getResourceContent(getResourceName(i)), (i < kOverrideCount) ? 'b' : 'a') << "At index " << i;
+}
+
+GTEST_TEST_F(ResourceManager, prefetchEvict) {
+	// With no memory for them, prefetched resources get dropped right away
+	ResMan.setPrefetchCacheSize(0);
+
+	for (uint32_t i = 0; i < 100; i++)
+		ResMan.prefetch(getResourceName(i), Aurora::kFileTypeTXT);
+
+	for (uint32_t i = 0; i < 100; i++)
+		EXPECT_EQ(getResourceContent(getResourceName(i)), 'a') << "At index " << i;
+
+	ResMan.setPrefetchCacheSize(64 * 1024 * 1024);
+}
+
+GTEST_TEST_F(ResourceManager, getResourceAsync) {
+	std::vector<std::future<std::unique_ptr<Common::SeekableReadStream>>> results;
+	for (uint32_t i = 0; i < 100; i++)
+		results.push_back(ResMan.getResourceAsync(getResourceName(i), Aurora::kFileTypeTXT));
+
+	for (uint32_t i = 0; i < 100; i++) {
+		std::unique_ptr<Common::SeekableReadStream> stream = results[i].get();
+
+		ASSERT_TRUE(stream) << "At index " << i;
+		EXPECT_EQ(stream->readByte(), 'a') << "At index " << i;
+	}
+
+	EXPECT_FALSE(ResMan.getResourceAsync("nope", Aurora::kFileTypeTXT).get());
+}
+
+static void benchmarkLookups(const char *what) {
+	// Look up resources of all the types commonly found in archives
+	std::vector<Aurora::FileType> types;
+	for (int type = 0; type < Aurora::kFileTypeMAXArchive; type++)
+		types.push_back((Aurora::FileType) type);
+
+	std::list<Aurora::ResourceManager::ResourceID> resources;
+	ResMan.getAvailableResources(types, resources);
+
+	std::vector<uint64_t> hashes;
+	hashes.reserve(resources.size());
+	for (std::list<Aurora::ResourceManager::ResourceID>::const_iterator r = resources.begin();
+	     r != resources.end(); ++r)
+		hashes.push_back(r->hash);
+
+	ASSERT_FALSE(hashes.empty());
+
+	size_t found = 0;
+	const double ms = benchmarkTime([&]() {
+		for (uint32_t i = 0; i < kBenchmarkLookupCount; i++)
+			found += ResMan.hasResource(hashes[((size_t)i * 7919) % hashes.size()]) ? 1 : 0;
+	});
+
+	EXPECT_EQ(found, kBenchmarkLookupCount);
+
+	benchmarkPrint("%s: %u lookups in %u resources: %.2f ms (%.1f ns/lookup)", what,
+	               kBenchmarkLookupCount, (uint)hashes.size(), ms, (ms * 1000000.0) / kBenchmarkLookupCount);
+}
+
+GTEST_TEST_F(ResourceManager, DISABLED_benchmarkSynthetic) {
+	// The large archive is only needed here, so we only write it here
+	const Common::UString benchmarkFile = (kBasePath / "benchmark.erf").generic_string();
+	writeERF(benchmarkFile, kBenchmarkResourceCount, 'c');
+
+	ResMan.clear();
+	ResMan.registerDataBase(kBasePath.generic_string());
+
+	ResMan.indexArchive("benchmark.erf", 100);
+
+	benchmarkLookups("Synthetic");
+}
+
+GTEST_TEST_F(ResourceManager, DISABLED_benchmarkGameInstall) {
+	const char *gameDir = std::getenv("XOREOS_BENCHMARK_GAMEDIR");
+	if (!gameDir || !*gameDir)
+		return;
+
+	ResMan.clear();
+
+	const double ms = benchmarkTime([&]() {
+		ResMan.registerDataBase(gameDir);
+
+		Common::FileList files(Common::FilePath::canonicalize(gameDir), -1);
+
+		uint32_t priority = 100;
+		for (Common::FileList::const_iterator f = files.begin(); f != files.end(); ++f) {
+			static const char * const kArchiveExtensions[] = { ".key", ".erf", ".mod", ".hak", ".rim", ".zip" };
+
+			bool isArchive = false;
+			for (size_t i = 0; i < ARRAYSIZE(kArchiveExtensions); i++)
+				isArchive |= Common::FilePath::getExtension(*f).equalsIgnoreCase(kArchiveExtensions[i]);
+
+			if (!isArchive)
+				continue;
+
+			try {
+				ResMan.indexArchive(Common::FilePath::relativize(ResMan.getDataBase(), *f), priority++);
+			} catch (...) {
+				// Not every archive in an installation is one we understand, that's fine
+			}
+		}
+	});
+
+	benchmarkPrint("Indexing \"%s\": %.2f ms", gameDir, ms);
+
+	benchmarkLookups("Game install");
+}
@@ -189,3 +189,33 @@ check_PROGRAMS                     += tests/aurora/test_xmlfixer
 tests_aurora_test_xmlfixer_SOURCES  = tests/aurora/xmlfixer.cpp
 tests_aurora_test_xmlfixer_LDADD    = $(aurora_LIBS)
 tests_aurora_test_xmlfixer_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                    += tests/aurora/test_resman
+tests_aurora_test_resman_SOURCES  = tests/aurora/resman.cpp
+tests_aurora_test_resman_LDADD    = $(aurora_LIBS)
+tests_aurora_test_resman_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                           += tests/aurora/test_resindexcache
+tests_aurora_test_resindexcache_SOURCES  = tests/aurora/resindexcache.cpp
+tests_aurora_test_resindexcache_LDADD    = $(aurora_LIBS)
+tests_aurora_test_resindexcache_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                     += tests/aurora/test_ncsfile
+tests_aurora_test_ncsfile_SOURCES  = tests/aurora/ncsfile.cpp
+tests_aurora_test_ncsfile_LDADD    = $(aurora_LIBS)
+tests_aurora_test_ncsfile_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                      += tests/aurora/test_ncscache
+tests_aurora_test_ncscache_SOURCES  = tests/aurora/ncscache.cpp
+tests_aurora_test_ncscache_LDADD    = $(aurora_LIBS)
+tests_aurora_test_ncscache_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                         += tests/aurora/test_ncsprofiler
+tests_aurora_test_ncsprofiler_SOURCES  = tests/aurora/ncsprofiler.cpp
+tests_aurora_test_ncsprofiler_LDADD    = $(aurora_LIBS)
+tests_aurora_test_ncsprofiler_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                     += tests/aurora/test_variable
+tests_aurora_test_variable_SOURCES  = tests/aurora/variable.cpp
+tests_aurora_test_variable_LDADD    = $(aurora_LIBS)
+tests_aurora_test_variable_CXXFLAGS = $(test_CXXFLAGS)
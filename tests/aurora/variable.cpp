@@ -0,0 +1,145 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the Aurora::NWScript::Variable class.
+ */
+
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "src/common/ustring.h"
+#include "src/common/error.h"
+
+#include "src/aurora/nwscript/variable.h"
+
+using Aurora::NWScript::Variable;
+
+namespace NWScript = Aurora::NWScript;
+
+GTEST_TEST(NWScriptVariable, types) {
+	const Variable i((int32_t) 23);
+	ASSERT_EQ(i.getType(), NWScript::kTypeInt);
+	EXPECT_EQ(i.getInt(), 23);
+
+	const Variable f(2.5f);
+	ASSERT_EQ(f.getType(), NWScript::kTypeFloat);
+	EXPECT_EQ(f.getFloat(), 2.5f);
+
+	const Variable s(Common::UString("Foobar"));
+	ASSERT_EQ(s.getType(), NWScript::kTypeString);
+	EXPECT_STREQ(s.getString().c_str(), "Foobar");
+
+	const Variable o(NWScript::ObjectReference(0));
+	ASSERT_EQ(o.getType(), NWScript::kTypeObject);
+	EXPECT_EQ(o.getObject(), (NWScript::Object *) 0);
+
+	const Variable v(1.0f, 2.0f, 3.0f);
+	ASSERT_EQ(v.getType(), NWScript::kTypeVector);
+
+	float x, y, z;
+	v.getVector(x, y, z);
+	EXPECT_EQ(x, 1.0f);
+	EXPECT_EQ(y, 2.0f);
+	EXPECT_EQ(z, 3.0f);
+
+	EXPECT_THROW(i.getFloat(), Common::Exception);
+	EXPECT_THROW(s.getInt(), Common::Exception);
+}
+
+GTEST_TEST(NWScriptVariable, copy) {
+	Variable s1(Common::UString("A string that's too long for any small string optimization"));
+	Variable s2(s1);
+
+	EXPECT_TRUE(s1 == s2);
+
+	// Copies of strings are independent
+	s2.getString() += "!";
+	EXPECT_FALSE(s1 == s2);
+
+	// Assigning a value of another type changes the type
+	s2 = Variable((int32_t) 5);
+	ASSERT_EQ(s2.getType(), NWScript::kTypeInt);
+	EXPECT_EQ(s2.getInt(), 5);
+
+	s2 = s1;
+	ASSERT_EQ(s2.getType(), NWScript::kTypeString);
+	EXPECT_TRUE(s1 == s2);
+}
+
+GTEST_TEST(NWScriptVariable, move) {
+	Variable s1(Common::UString("A string that's too long for any small string optimization"));
+	const char *data = s1.getString().c_str();
+
+	Variable s2(std::move(s1));
+	ASSERT_EQ(s2.getType(), NWScript::kTypeString);
+
+	// The string data was moved over, not copied
+	EXPECT_EQ(s2.getString().c_str(), data);
+
+	Variable i((int32_t) 42);
+	i = std::move(s2);
+	ASSERT_EQ(i.getType(), NWScript::kTypeString);
+	EXPECT_EQ(i.getString().c_str(), data);
+
+	s2 = Variable(2.0f);
+	ASSERT_EQ(s2.getType(), NWScript::kTypeFloat);
+	EXPECT_EQ(s2.getFloat(), 2.0f);
+}
+
+GTEST_TEST(NWScriptVariable, array) {
+	Variable a1(NWScript::kTypeArray);
+	a1.growArray(NWScript::kTypeInt, 3);
+
+	ASSERT_EQ(a1.getArraySize(), 3);
+	*a1.getArray()[1] = (int32_t) 7;
+
+	// Copies of arrays share the elements
+	Variable a2(a1);
+	ASSERT_EQ(a2.getArraySize(), 3);
+	EXPECT_EQ(a2.getArray()[1]->getInt(), 7);
+
+	*a2.getArray()[2] = (int32_t) 8;
+	EXPECT_EQ(a1.getArray()[2]->getInt(), 8);
+
+	EXPECT_TRUE(a1 == a2);
+
+	Variable a3((int32_t) 1);
+	a3 = std::move(a2);
+	ASSERT_EQ(a3.getType(), NWScript::kTypeArray);
+	EXPECT_EQ(&a3.getArray(), &a1.getArray());
+}
+
+GTEST_TEST(NWScriptVariable, scriptState) {
+	Variable s1(NWScript::kTypeScriptState);
+	s1.getScriptState().offset = 23;
+	s1.getScriptState().locals.push_back(Variable((int32_t) 5));
+
+	Variable s2(s1);
+	ASSERT_EQ(s2.getType(), NWScript::kTypeScriptState);
+	EXPECT_EQ(s2.getScriptState().offset, 23);
+	ASSERT_EQ(s2.getScriptState().locals.size(), 1);
+	EXPECT_EQ(s2.getScriptState().locals[0].getInt(), 5);
+
+	Variable s3(std::move(s2));
+	ASSERT_EQ(s3.getType(), NWScript::kTypeScriptState);
+	EXPECT_EQ(s3.getScriptState().offset, 23);
+}
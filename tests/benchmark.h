@@ -0,0 +1,63 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Utility unit test include for benchmarks.
+ *
+ *  Benchmarks sit next to the unit tests of the code they measure. Their
+ *  names start with DISABLED_, so that Google Test skips them in a normal
+ *  test run. To run them, pass --gtest_also_run_disabled_tests, optionally
+ *  together with --gtest_filter=*benchmark*.
+ */
+
+#ifndef TESTS_BENCHMARK_H
+#define TESTS_BENCHMARK_H
+
+#include <cstdio>
+#include <cstdarg>
+
+#include <chrono>
+
+#include "src/common/system.h"
+
+/** Run this function and return how long it took, in milliseconds. */
+template<typename F>
+inline double benchmarkTime(F func) {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	func();
+
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Print a line of benchmark results, marked to stand out in the Google Test output. */
+inline void benchmarkPrint(const char *s, ...) GCC_PRINTF(1, 2);
+
+inline void benchmarkPrint(const char *s, ...) {
+	std::va_list va;
+
+	va_start(va, s);
+	std::printf("[   BENCH  ] ");
+	std::vprintf(s, va);
+	std::printf("\n");
+	va_end(va);
+}
+
+#endif // TESTS_BENCHMARK_H
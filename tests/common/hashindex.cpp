@@ -0,0 +1,192 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our flat hash index.
+ */
+
+#include <set>
+
+#include "gtest/gtest.h"
+
+#include "src/common/hashindex.h"
+
+GTEST_TEST(HashIndex, empty) {
+	Common::HashIndex<int> index;
+
+	EXPECT_TRUE(index.empty());
+	EXPECT_EQ(index.size(), 0);
+
+	EXPECT_EQ(index.find(23), static_cast<int *>(0));
+	EXPECT_FALSE(index.erase(23));
+
+	EXPECT_TRUE(index.begin() == index.end());
+}
+
+GTEST_TEST(HashIndex, insert) {
+	Common::HashIndex<int> index;
+
+	index[0x1234] = 1;
+	index[0x5678] = 2;
+
+	EXPECT_FALSE(index.empty());
+	EXPECT_EQ(index.size(), 2);
+
+	ASSERT_NE(index.find(0x1234), static_cast<int *>(0));
+	ASSERT_NE(index.find(0x5678), static_cast<int *>(0));
+
+	EXPECT_EQ(*index.find(0x1234), 1);
+	EXPECT_EQ(*index.find(0x5678), 2);
+
+	EXPECT_EQ(index.find(0x9ABC), static_cast<int *>(0));
+
+	// Accessing an existing value doesn't insert a new one
+	index[0x1234] = 3;
+
+	EXPECT_EQ(index.size(), 2);
+	EXPECT_EQ(*index.find(0x1234), 3);
+}
+
+GTEST_TEST(HashIndex, erase) {
+	Common::HashIndex<int> index;
+
+	index[1] = 1;
+	index[2] = 2;
+	index[3] = 3;
+
+	EXPECT_TRUE(index.erase(2));
+	EXPECT_FALSE(index.erase(2));
+
+	EXPECT_EQ(index.size(), 2);
+
+	EXPECT_EQ(index.find(2), static_cast<int *>(0));
+
+	ASSERT_NE(index.find(1), static_cast<int *>(0));
+	ASSERT_NE(index.find(3), static_cast<int *>(0));
+
+	EXPECT_EQ(*index.find(1), 1);
+	EXPECT_EQ(*index.find(3), 3);
+
+	// A value inserted again starts afresh
+	EXPECT_EQ(index[2], 0);
+	EXPECT_EQ(index.size(), 3);
+}
+
+GTEST_TEST(HashIndex, collisions) {
+	Common::HashIndex<uint64_t> index;
+
+	// Hashes that only differ in their upper bits need to spread out as well
+	for (uint64_t i = 0; i < 1000; i++)
+		index[i << 40] = i;
+
+	EXPECT_EQ(index.size(), 1000);
+
+	for (uint64_t i = 0; i < 1000; i++) {
+		const uint64_t *value = index.find(i << 40);
+
+		ASSERT_NE(value, static_cast<uint64_t *>(0)) << "At index " << i;
+		EXPECT_EQ(*value, i) << "At index " << i;
+	}
+
+	// Erase every other one, the rest still needs to be reachable
+	for (uint64_t i = 0; i < 1000; i += 2)
+		EXPECT_TRUE(index.erase(i << 40)) << "At index " << i;
+
+	for (uint64_t i = 0; i < 1000; i++) {
+		const uint64_t *value = index.find(i << 40);
+
+		if ((i % 2) == 0) {
+			EXPECT_EQ(value, static_cast<uint64_t *>(0)) << "At index " << i;
+		} else {
+			ASSERT_NE(value, static_cast<uint64_t *>(0)) << "At index " << i;
+			EXPECT_EQ(*value, i) << "At index " << i;
+		}
+	}
+}
+
+GTEST_TEST(HashIndex, grow) {
+	Common::HashIndex<uint64_t> index;
+
+	for (uint64_t i = 0; i < 100000; i++)
+		index[i * 0x100000001ULL] = i;
+
+	EXPECT_EQ(index.size(), 100000);
+	EXPECT_GE(index.capacity(), index.size());
+
+	for (uint64_t i = 0; i < 100000; i++) {
+		const uint64_t *value = index.find(i * 0x100000001ULL);
+
+		ASSERT_NE(value, static_cast<uint64_t *>(0)) << "At index " << i;
+		EXPECT_EQ(*value, i) << "At index " << i;
+	}
+}
+
+GTEST_TEST(HashIndex, reuseDeleted) {
+	Common::HashIndex<int> index;
+
+	index.reserve(100);
+	const size_t capacity = index.capacity();
+
+	// Constantly inserting and erasing doesn't make the table grow
+
+	for (uint64_t i = 0; i < 10000; i++) {
+		index[i] = 1;
+		index.erase(i);
+	}
+
+	EXPECT_TRUE(index.empty());
+	EXPECT_EQ(index.capacity(), capacity);
+}
+
+GTEST_TEST(HashIndex, iterate) {
+	Common::HashIndex<int> index;
+
+	for (uint64_t i = 1; i <= 100; i++)
+		index[i] = (int)i;
+
+	index.erase(50);
+
+	const Common::HashIndex<int> &constIndex = index;
+
+	std::set<uint64_t> seen;
+	for (Common::HashIndex<int>::const_iterator i = constIndex.begin(); i != constIndex.end(); ++i) {
+		EXPECT_EQ((uint64_t)*i, i.hash());
+
+		seen.insert(i.hash());
+	}
+
+	EXPECT_EQ(seen.size(), 99);
+	EXPECT_EQ(seen.count(50), 0);
+}
+
+GTEST_TEST(HashIndex, clear) {
+	Common::HashIndex<int> index;
+
+	index[1] = 1;
+	index[2] = 2;
+
+	index.clear();
+
+	EXPECT_TRUE(index.empty());
+	EXPECT_EQ(index.find(1), static_cast<int *>(0));
+
+	index[1] = 3;
+	EXPECT_EQ(*index.find(1), 3);
+}
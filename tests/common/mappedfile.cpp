@@ -0,0 +1,175 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our memory-mapped file read stream.
+ */
+
+#include <memory>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/mappedfile.h"
+
+static const byte kData[8] = { 0x12, 0x34, 0x56, 0x78, 0x90, 0xAB, 0xCD, 0xEF };
+
+boost::filesystem::path kFilePath;
+boost::filesystem::path kEmptyFilePath;
+
+static void writeFile(const boost::filesystem::path &path, const byte *data, size_t size) {
+	boost::filesystem::ofstream testFile(path, std::ofstream::binary);
+
+	testFile.write(reinterpret_cast<const char *>(data), size);
+	testFile.close();
+}
+
+class MappedFileReadStream : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		boost::filesystem::path tmpPath = boost::filesystem::temp_directory_path();
+
+		kFilePath      = tmpPath / boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+		kEmptyFilePath = tmpPath / boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		writeFile(kFilePath, kData, ARRAYSIZE(kData));
+		writeFile(kEmptyFilePath, kData, 0);
+	}
+
+	static void TearDownTestCase() {
+		if (!kFilePath.empty())
+			boost::filesystem::remove(kFilePath);
+		if (!kEmptyFilePath.empty())
+			boost::filesystem::remove(kEmptyFilePath);
+	}
+};
+
+GTEST_TEST_F(MappedFileReadStream, read) {
+	Common::MappedFileReadStream stream(kFilePath.generic_string());
+
+	EXPECT_EQ(stream.size(), ARRAYSIZE(kData));
+	EXPECT_FALSE(stream.eos());
+
+	byte readData[ARRAYSIZE(kData)];
+	EXPECT_EQ(stream.read(readData, sizeof(readData)), ARRAYSIZE(kData));
+	EXPECT_FALSE(stream.eos());
+
+	for (size_t i = 0; i < ARRAYSIZE(kData); i++)
+		EXPECT_EQ(readData[i], kData[i]) << "At index " << i;
+
+	EXPECT_EQ(stream.read(readData, 1), 0);
+	EXPECT_TRUE(stream.eos());
+}
+
+GTEST_TEST_F(MappedFileReadStream, seek) {
+	Common::MappedFileReadStream stream(kFilePath.generic_string());
+
+	EXPECT_EQ(stream.pos(), 0);
+
+	stream.seek(4);
+	EXPECT_EQ(stream.pos(), 4);
+	EXPECT_EQ(stream.readByte(), kData[4]);
+
+	stream.seek(-1, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(stream.readByte(), kData[7]);
+
+	EXPECT_THROW(stream.seek(9), Common::Exception);
+}
+
+GTEST_TEST_F(MappedFileReadStream, readAt) {
+	Common::MappedFileReadStream stream(kFilePath.generic_string());
+
+	stream.seek(1);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(stream.readAt(5, readData, 4), 3);
+	EXPECT_EQ(readData[0], kData[5]);
+	EXPECT_EQ(readData[1], kData[6]);
+	EXPECT_EQ(readData[2], kData[7]);
+
+	EXPECT_EQ(stream.readAt(8, readData, 1), 0);
+
+	EXPECT_EQ(stream.pos(), 1);
+	EXPECT_FALSE(stream.eos());
+}
+
+GTEST_TEST_F(MappedFileReadStream, getData) {
+	Common::MappedFileReadStream stream(kFilePath.generic_string());
+
+	const byte *data = stream.getData();
+	ASSERT_NE(data, static_cast<const byte *>(0));
+
+	for (size_t i = 0; i < ARRAYSIZE(kData); i++)
+		EXPECT_EQ(data[i], kData[i]) << "At index " << i;
+}
+
+GTEST_TEST_F(MappedFileReadStream, createView) {
+	std::unique_ptr<Common::MappedFileReadStream> view;
+
+	{
+		Common::MappedFileReadStream stream(kFilePath.generic_string());
+
+		stream.seek(2);
+		view.reset(stream.createView(3, 6));
+
+		// The view doesn't copy, and it doesn't touch the parent's position
+		EXPECT_EQ(view->getData(), stream.getData() + 3);
+		EXPECT_EQ(stream.pos(), 2);
+
+		EXPECT_THROW(stream.createView(6, 3), Common::Exception);
+		EXPECT_THROW(stream.createView(0, 9), Common::Exception);
+	}
+
+	// The view stays valid after the parent stream is gone
+
+	ASSERT_EQ(view->size(), 3);
+
+	EXPECT_EQ(view->readByte(), kData[3]);
+	EXPECT_EQ(view->readByte(), kData[4]);
+	EXPECT_EQ(view->readByte(), kData[5]);
+
+	EXPECT_THROW(view->readByte(), Common::Exception);
+	EXPECT_TRUE(view->eos());
+
+	std::unique_ptr<Common::MappedFileReadStream> subView(view->createView(1, 2));
+	ASSERT_EQ(subView->size(), 1);
+	EXPECT_EQ(subView->readByte(), kData[4]);
+}
+
+GTEST_TEST_F(MappedFileReadStream, empty) {
+	Common::MappedFileReadStream stream(kEmptyFilePath.generic_string());
+
+	EXPECT_EQ(stream.size(), 0);
+
+	byte readData[1];
+	EXPECT_EQ(stream.read(readData, 1), 0);
+	EXPECT_TRUE(stream.eos());
+}
+
+GTEST_TEST_F(MappedFileReadStream, missing) {
+	EXPECT_THROW(Common::MappedFileReadStream stream(kFilePath.generic_string() + ".missing"), Common::Exception);
+}
@@ -105,6 +105,45 @@ GTEST_TEST(MemoryReadStream, readStream) {
 	EXPECT_THROW(stream.readStream(ARRAYSIZE(data) + 1), Common::Exception);
 }
 
+GTEST_TEST(MemoryReadStream, readAt) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	stream.seek(1);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(stream.readAt(2, readData, 2), 2);
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+
+	EXPECT_EQ(stream.readAt(3, readData, 4), 2);
+	EXPECT_EQ(readData[0], data[3]);
+	EXPECT_EQ(readData[1], data[4]);
+
+	EXPECT_EQ(stream.readAt(5, readData, 1), 0);
+
+	// The stream position and end-of-stream flag stay untouched
+	EXPECT_EQ(stream.pos(), 1);
+	EXPECT_FALSE(stream.eos());
+}
+
+GTEST_TEST(MemoryReadStream, readStreamAt) {
+	static const byte data[3] = { 0x12, 0x34, 0x56 };
+	Common::MemoryReadStream stream(data);
+
+	Common::MemoryReadStream *streamRead = stream.readStreamAt(1, 2);
+
+	EXPECT_EQ(streamRead->size(), 2);
+	EXPECT_EQ(streamRead->readByte(), data[1]);
+	EXPECT_EQ(streamRead->readByte(), data[2]);
+
+	delete streamRead;
+
+	EXPECT_EQ(stream.pos(), 0);
+
+	EXPECT_THROW(stream.readStreamAt(2, 2), Common::Exception);
+}
+
 GTEST_TEST(MemoryReadStream, readChar) {
 	static const byte data[3] = { 0x12, 0x34, 0x56 };
 	Common::MemoryReadStream stream(data);
@@ -315,6 +354,91 @@ GTEST_TEST(SeekableSubReadStream, fromMem) {
 	EXPECT_FALSE(subStream.eos());
 }
 
+GTEST_TEST(SeekableSubReadStream, independentPosition) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableSubReadStream subStream1(&stream, 1, 4);
+	Common::SeekableSubReadStream subStream2(&stream, 2, 5);
+
+	// Reading from the substreams in an interleaved fashion doesn't confuse them
+
+	EXPECT_EQ(subStream1.readByte(), data[1]);
+	EXPECT_EQ(subStream2.readByte(), data[2]);
+
+	stream.seek(0);
+
+	EXPECT_EQ(subStream1.readByte(), data[2]);
+	EXPECT_EQ(subStream2.readByte(), data[3]);
+
+	EXPECT_EQ(subStream1.pos(), 2);
+	EXPECT_EQ(subStream2.pos(), 2);
+
+	// And they don't touch the parent stream position
+	EXPECT_EQ(stream.pos(), 0);
+}
+
+GTEST_TEST(SeekableSubReadStream, readAt) {
+	static const byte data[5] = { 0x12, 0x34, 0x56, 0x78, 0x90 };
+	Common::MemoryReadStream stream(data);
+
+	Common::SeekableSubReadStream subStream(&stream, 1, 4);
+
+	byte readData[4] = { 0 };
+	EXPECT_EQ(subStream.readAt(1, readData, 4), 2);
+	EXPECT_EQ(readData[0], data[2]);
+	EXPECT_EQ(readData[1], data[3]);
+
+	EXPECT_EQ(subStream.readAt(3, readData, 1), 0);
+
+	EXPECT_EQ(subStream.pos(), 0);
+	EXPECT_FALSE(subStream.eos());
+}
+
+/** A memory stream counting the calls of readAt(). */
+class CountingReadStream : public Common::MemoryReadStream {
+public:
+	size_t readAtCount;
+
+	CountingReadStream(const byte *data, size_t dataSize) :
+		Common::MemoryReadStream(data, dataSize), readAtCount(0) {
+	}
+
+	size_t readAt(size_t offset, void *dataPtr, size_t dataSize) {
+		readAtCount++;
+
+		return Common::MemoryReadStream::readAt(offset, dataPtr, dataSize);
+	}
+};
+
+GTEST_TEST(SeekableSubReadStream, bufferedRead) {
+	byte data[256];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = (byte) i;
+
+	CountingReadStream stream(data, sizeof(data));
+
+	Common::SeekableSubReadStream subStream(&stream, 16, 240);
+
+	// Small reads go through the parent only once, to fill the buffer
+	for (size_t i = 16; i < 240; i++)
+		EXPECT_EQ(subStream.readByte(), data[i]) << "At index " << i;
+
+	EXPECT_EQ(stream.readAtCount, 1);
+
+	// Seeking within the buffered data doesn't need the parent
+	subStream.seek(4);
+	EXPECT_EQ(subStream.readUint32LE(), 0x17161514);
+
+	EXPECT_EQ(stream.readAtCount, 1);
+
+	subStream.seek(0, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_THROW(subStream.readByte(), Common::Exception) << "Reading past the substream's end";
+	EXPECT_TRUE(subStream.eos());
+
+	EXPECT_EQ(stream.pos(), 0);
+}
+
 GTEST_TEST(SeekableSubReadStreamEndian, streamEndianLE) {
 	static const byte data[4] = { 0x78, 0x56, 0x34, 0x12 };
 	Common::MemoryReadStream stream(data);
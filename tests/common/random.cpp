@@ -0,0 +1,80 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our random number generator.
+ */
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/random.h"
+
+GTEST_TEST(Random, range) {
+	for (int i = 0; i < 1000; i++) {
+		const int value = RNG.getNext(-5, 5);
+
+		EXPECT_GE(value, -5);
+		EXPECT_LT(value,  5);
+	}
+
+	for (int i = 0; i < 1000; i++) {
+		const float value = RNG.getNext(0.5f, 1.5f);
+
+		EXPECT_GE(value, 0.5f);
+		EXPECT_LT(value, 1.5f);
+	}
+}
+
+GTEST_TEST(Random, threads) {
+	static const size_t kThreadCount = 4;
+	static const size_t kValueCount  = 10000;
+
+	// Create the singleton up front, only the generators are per thread
+	RNG.getNext(0, 1);
+
+	std::vector<std::vector<int>> values(kThreadCount);
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < kThreadCount; t++) {
+		threads.push_back(std::thread([&values, t]() {
+			for (size_t i = 0; i < kValueCount; i++)
+				values[t].push_back(RNG.getNext(0, 1000000));
+		}));
+	}
+
+	for (size_t t = 0; t < kThreadCount; t++)
+		threads[t].join();
+
+	for (size_t t = 0; t < kThreadCount; t++) {
+		ASSERT_EQ(values[t].size(), kValueCount);
+
+		for (size_t i = 0; i < kValueCount; i++) {
+			EXPECT_GE(values[t][i], 0);
+			EXPECT_LT(values[t][i], 1000000);
+		}
+	}
+
+	// Every thread has its own generator, seeded on its own
+	for (size_t t = 1; t < kThreadCount; t++)
+		EXPECT_NE(values[t], values[0]) << "At thread " << t;
+}
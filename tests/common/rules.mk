@@ -70,6 +70,11 @@ tests_common_test_readfile_SOURCES  = tests/common/readfile.cpp
 tests_common_test_readfile_LDADD    = $(common_LIBS)
 tests_common_test_readfile_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                       += tests/common/test_mappedfile
+tests_common_test_mappedfile_SOURCES  = tests/common/mappedfile.cpp
+tests_common_test_mappedfile_LDADD    = $(common_LIBS)
+tests_common_test_mappedfile_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                      += tests/common/test_writefile
 tests_common_test_writefile_SOURCES  = tests/common/writefile.cpp
 tests_common_test_writefile_LDADD    = $(common_LIBS)
@@ -182,6 +187,11 @@ tests_common_test_hash_SOURCES  = tests/common/hash.cpp
 tests_common_test_hash_LDADD    = $(common_LIBS)
 tests_common_test_hash_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                      += tests/common/test_hashindex
+tests_common_test_hashindex_SOURCES  = tests/common/hashindex.cpp
+tests_common_test_hashindex_LDADD    = $(common_LIBS)
+tests_common_test_hashindex_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                += tests/common/test_md5
 tests_common_test_md5_SOURCES  = tests/common/md5.cpp
 tests_common_test_md5_LDADD    = $(common_LIBS)
@@ -250,3 +260,13 @@ check_PROGRAMS                   += tests/common/test_string
 tests_common_test_string_SOURCES  = tests/common/string.cpp
 tests_common_test_string_LDADD    = $(common_LIBS)
 tests_common_test_string_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                       += tests/common/test_threadpool
+tests_common_test_threadpool_SOURCES  = tests/common/threadpool.cpp
+tests_common_test_threadpool_LDADD    = $(common_LIBS)
+tests_common_test_threadpool_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                     += tests/common/test_random
+tests_common_test_random_SOURCES  = tests/common/random.cpp
+tests_common_test_random_LDADD    = $(common_LIBS)
+tests_common_test_random_CXXFLAGS = $(test_CXXFLAGS)
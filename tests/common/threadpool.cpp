@@ -0,0 +1,104 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our thread pool.
+ */
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/threadpool.h"
+
+GTEST_TEST(ThreadPool, threadCount) {
+	Common::ThreadPool pool(3);
+	EXPECT_EQ(pool.getThreadCount(), 3);
+
+	Common::ThreadPool defaultPool;
+	EXPECT_EQ(defaultPool.getThreadCount(), Common::ThreadPool::getHardwareThreadCount());
+}
+
+GTEST_TEST(ThreadPool, submit) {
+	Common::ThreadPool pool(2);
+
+	std::vector<std::future<int>> results;
+	for (int i = 0; i < 100; i++)
+		results.push_back(pool.submit([i]() { return i * 2; }));
+
+	for (int i = 0; i < 100; i++)
+		EXPECT_EQ(results[i].get(), i * 2) << "At index " << i;
+}
+
+GTEST_TEST(ThreadPool, exception) {
+	Common::ThreadPool pool(1);
+
+	std::future<void> result = pool.submit([]() { throw Common::Exception("Failed"); });
+
+	EXPECT_THROW(result.get(), Common::Exception);
+
+	// The worker survives
+	std::future<int> nextResult = pool.submit([]() { return 23; });
+	EXPECT_EQ(nextResult.get(), 23);
+}
+
+GTEST_TEST(ThreadPool, wait) {
+	Common::ThreadPool pool(4);
+
+	std::atomic<int> count(0);
+	for (int i = 0; i < 1000; i++)
+		pool.submit([&count]() { count++; });
+
+	pool.wait();
+	EXPECT_EQ(count.load(), 1000);
+
+	// Waiting on an idle pool returns right away
+	pool.wait();
+}
+
+GTEST_TEST(ThreadPool, parallelFor) {
+	Common::ThreadPool pool(3);
+
+	std::vector<int> values(1000, 0);
+	pool.parallelFor(values.size(), [&values](size_t i) { values[i] = i * 2; });
+
+	for (size_t i = 0; i < values.size(); i++)
+		EXPECT_EQ(values[i], i * 2) << "At index " << i;
+
+	// Nothing to do
+	pool.parallelFor(0, [](size_t) { throw Common::Exception("Failed"); });
+
+	EXPECT_THROW(pool.parallelFor(10, [](size_t i) { if (i == 5) throw Common::Exception("Failed"); }),
+	             Common::Exception);
+}
+
+GTEST_TEST(ThreadPool, parallelForNested) {
+	Common::ThreadPool pool(2);
+
+	// Jobs running parallelFor themselves mustn't deadlock, even with all workers busy
+	std::atomic<int> count(0);
+	pool.parallelFor(8, [&pool, &count](size_t) {
+		pool.parallelFor(8, [&count](size_t) { count++; });
+	});
+
+	EXPECT_EQ(count.load(), 64);
+}
@@ -0,0 +1,196 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for the Engines::AStar class.
+ *
+ *  The benchmark, which only runs on request, searches paths between
+ *  random points of a large grid walkmesh strewn with unwalkable faces.
+ */
+
+#include <vector>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "tests/benchmark.h"
+
+#include "src/common/util.h"
+
+#include "src/engines/aurora/astar.h"
+
+#include "tests/engines/gridpathfinding.h"
+
+static const uint32_t kBenchmarkGridSize  = 64;
+static const uint32_t kBenchmarkPathCount = 1000;
+
+GTEST_TEST(AStar, sameFace) {
+	Engines::GridPathfinding grid(4);
+	Engines::AStar aStar(&grid);
+
+	std::vector<uint32_t> path;
+	EXPECT_TRUE(aStar.findPath(0.8f, 0.2f, 0.7f, 0.1f, path));
+
+	ASSERT_EQ(path.size(), 1);
+	EXPECT_EQ(path[0], grid.findFace(0.8f, 0.2f));
+}
+
+GTEST_TEST(AStar, outside) {
+	Engines::GridPathfinding grid(4);
+	Engines::AStar aStar(&grid);
+
+	std::vector<uint32_t> path;
+	EXPECT_FALSE(aStar.findPath(0.5f, 0.2f, 5.5f, 0.5f, path));
+	EXPECT_TRUE(path.empty());
+}
+
+GTEST_TEST(AStar, straight) {
+	Engines::GridPathfinding grid(8);
+	Engines::AStar aStar(&grid);
+
+	std::vector<uint32_t> path;
+	ASSERT_TRUE(aStar.findPath(0.8f, 0.2f, 7.8f, 0.2f, path));
+
+	ASSERT_FALSE(path.empty());
+	EXPECT_EQ(path.front(), grid.findFace(0.8f, 0.2f));
+	EXPECT_EQ(path.back(), grid.findFace(7.8f, 0.2f));
+	checkPath(grid, path);
+
+	// Along the bottom row, alternating between upper and lower triangles
+	EXPECT_EQ(path.size(), 15);
+}
+
+GTEST_TEST(AStar, detour) {
+	Engines::GridPathfinding grid(8);
+
+	// A wall with a gap at the very top
+	for (uint32_t y = 0; y < 7; y++)
+		grid.block(4, y);
+
+	Engines::AStar aStar(&grid);
+
+	std::vector<uint32_t> path;
+	ASSERT_TRUE(aStar.findPath(0.5f, 0.2f, 7.5f, 0.2f, path));
+
+	EXPECT_EQ(path.front(), grid.findFace(0.5f, 0.2f));
+	EXPECT_EQ(path.back(), grid.findFace(7.5f, 0.2f));
+	checkPath(grid, path);
+
+	bool throughGap = false;
+	for (size_t i = 0; i < path.size(); i++)
+		throughGap |= (path[i] == grid.findFace(4.5f, 7.2f)) || (path[i] == grid.findFace(4.2f, 7.5f));
+
+	EXPECT_TRUE(throughGap);
+}
+
+GTEST_TEST(AStar, unreachable) {
+	Engines::GridPathfinding grid(8);
+
+	for (uint32_t y = 0; y < 8; y++)
+		grid.block(4, y);
+
+	Engines::AStar aStar(&grid);
+
+	// We get a path to the closest face we could find instead
+	std::vector<uint32_t> path;
+	ASSERT_FALSE(aStar.findPath(0.5f, 0.2f, 7.5f, 0.2f, path));
+
+	ASSERT_FALSE(path.empty());
+	EXPECT_EQ(path.front(), grid.findFace(0.5f, 0.2f));
+	checkPath(grid, path);
+
+	const uint32_t closest = path.back();
+	EXPECT_TRUE((closest == grid.findFace(3.8f, 0.2f)) || (closest == grid.findFace(3.2f, 0.8f)));
+}
+
+GTEST_TEST(AStar, maxIteration) {
+	Engines::GridPathfinding grid(16);
+	Engines::AStar aStar(&grid);
+
+	std::vector<uint32_t> path;
+	EXPECT_FALSE(aStar.findPath(0.5f, 0.2f, 15.5f, 15.2f, path, 0.f, 4));
+	EXPECT_FALSE(path.empty());
+	checkPath(grid, path);
+
+	// Searching again without a limit mustn't see anything of the previous search
+	ASSERT_TRUE(aStar.findPath(0.5f, 0.2f, 15.5f, 15.2f, path));
+	EXPECT_EQ(path.front(), grid.findFace(0.5f, 0.2f));
+	EXPECT_EQ(path.back(), grid.findFace(15.5f, 15.2f));
+	checkPath(grid, path);
+}
+
+GTEST_TEST(AStar, repeatable) {
+	Engines::GridPathfinding grid(16);
+	for (uint32_t y = 2; y < 16; y++)
+		grid.block(8, y);
+
+	Engines::AStar aStar(&grid);
+
+	std::vector<uint32_t> path1, path2, path3;
+	ASSERT_TRUE(aStar.findPath(1.5f, 12.2f, 14.5f, 12.2f, path1));
+	ASSERT_TRUE(aStar.findPath(14.5f, 1.2f, 1.5f, 1.2f, path2));
+	ASSERT_TRUE(aStar.findPath(1.5f, 12.2f, 14.5f, 12.2f, path3));
+
+	EXPECT_EQ(path1, path3);
+}
+
+GTEST_TEST(AStar, DISABLED_benchmark) {
+	Engines::GridPathfinding grid(kBenchmarkGridSize);
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(0.f, kBenchmarkGridSize);
+	std::uniform_int_distribution<uint32_t> cell(0, kBenchmarkGridSize - 1);
+
+	// Scatter some obstacles, so that the paths aren't all straight lines
+	for (uint32_t i = 0; i < (kBenchmarkGridSize * kBenchmarkGridSize) / 8; i++)
+		grid.block(cell(random), cell(random));
+
+	std::vector<float> points;
+	while (points.size() < (kBenchmarkPathCount * 4)) {
+		const float x = position(random);
+		const float y = position(random);
+
+		if (grid.findFace(x, y) == UINT32_MAX)
+			continue;
+
+		points.push_back(x);
+		points.push_back(y);
+	}
+
+	Engines::AStar aStar(&grid);
+
+	std::vector<uint32_t> path;
+	size_t found = 0, faces = 0;
+
+	const double ms = benchmarkTime([&]() {
+		for (uint32_t i = 0; i < kBenchmarkPathCount; i++) {
+			const float *p = &points[i * 4];
+
+			found += aStar.findPath(p[0], p[1], p[2], p[3], path, 0.f, UINT32_MAX) ? 1 : 0;
+			faces += path.size();
+		}
+	});
+
+	EXPECT_GT(found, 0);
+
+	benchmarkPrint("%u paths (%u found, %.1f faces average) over %u faces: %.2f ms (%.1f paths/s)",
+	               kBenchmarkPathCount, (uint)found, (double)faces / kBenchmarkPathCount,
+	               kBenchmarkGridSize * kBenchmarkGridSize * 2, ms, (kBenchmarkPathCount * 1000.0) / ms);
+}
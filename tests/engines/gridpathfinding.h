@@ -0,0 +1,179 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A square grid walkmesh, for testing the pathfinding classes, and a
+ *  check for the paths of faces found on it.
+ *
+ *  Each cell of the grid is split into two triangles, the way the
+ *  tile walkmeshes of NWN are built.
+ */
+
+#ifndef TESTS_ENGINES_GRIDPATHFINDING_H
+#define TESTS_ENGINES_GRIDPATHFINDING_H
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/aabbnode.h"
+
+#include "src/engines/aurora/pathfinding.h"
+#include "src/engines/aurora/astar.h"
+
+namespace Engines {
+
+// Utility class for testing Engines::Pathfinding and Engines::AStar
+class GridPathfinding : public Pathfinding {
+public:
+	GridPathfinding(uint32_t size);
+
+	using Pathfinding::findFace;
+	using Pathfinding::walkableSegment;
+
+	/** Make all faces of a cell unwalkable. */
+	void block(uint32_t cellX, uint32_t cellY);
+
+	bool isAdjacent(uint32_t faceA, uint32_t faceB) const;
+
+private:
+	uint32_t _size;
+
+	uint32_t getVertexID(uint32_t x, uint32_t y) const;
+	uint32_t getFaceID(uint32_t cellX, uint32_t cellY, uint32_t triangle) const;
+
+	/** Build an AABB tree over a rectangle of cells. */
+	Common::AABBNode *buildAABBTree(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2) const;
+};
+
+// Property 0 is unwalkable, property 1 is walkable.
+inline GridPathfinding::GridPathfinding(uint32_t size) : Pathfinding({ false, true }, 3), _size(size) {
+	_verticesCount = (_size + 1) * (_size + 1);
+	for (uint32_t y = 0; y <= _size; y++) {
+		for (uint32_t x = 0; x <= _size; x++) {
+			_vertices.push_back(x);
+			_vertices.push_back(y);
+			_vertices.push_back(0.f);
+		}
+	}
+
+	/* The lower triangle of a cell is (x, y), (x + 1, y), (x + 1, y + 1),
+	 * the upper triangle is (x, y), (x + 1, y + 1), (x, y + 1). Edge i of
+	 * a face goes from its vertex i to its vertex i + 1. */
+
+	_facesCount = _size * _size * 2;
+	_faces.resize(_facesCount * 3);
+	_adjFaces.resize(_facesCount * 3, UINT32_MAX);
+	_faceProperty.resize(_facesCount, 1);
+
+	for (uint32_t y = 0; y < _size; y++) {
+		for (uint32_t x = 0; x < _size; x++) {
+			const uint32_t lower = getFaceID(x, y, 0);
+			const uint32_t upper = getFaceID(x, y, 1);
+
+			_faces[lower * 3 + 0] = getVertexID(x    , y    );
+			_faces[lower * 3 + 1] = getVertexID(x + 1, y    );
+			_faces[lower * 3 + 2] = getVertexID(x + 1, y + 1);
+
+			_faces[upper * 3 + 0] = getVertexID(x    , y    );
+			_faces[upper * 3 + 1] = getVertexID(x + 1, y + 1);
+			_faces[upper * 3 + 2] = getVertexID(x    , y + 1);
+
+			if (y > 0)
+				_adjFaces[lower * 3 + 0] = getFaceID(x, y - 1, 1);
+			if (x < (_size - 1))
+				_adjFaces[lower * 3 + 1] = getFaceID(x + 1, y, 1);
+			_adjFaces[lower * 3 + 2] = upper;
+
+			_adjFaces[upper * 3 + 0] = lower;
+			if (y < (_size - 1))
+				_adjFaces[upper * 3 + 1] = getFaceID(x, y + 1, 0);
+			if (x > 0)
+				_adjFaces[upper * 3 + 2] = getFaceID(x - 1, y, 0);
+		}
+	}
+
+	_aabbTrees.push_back(buildAABBTree(0, 0, _size, _size));
+
+	setAStarAlgorithm(new AStar(this));
+}
+
+inline uint32_t GridPathfinding::getVertexID(uint32_t x, uint32_t y) const {
+	return y * (_size + 1) + x;
+}
+
+inline uint32_t GridPathfinding::getFaceID(uint32_t cellX, uint32_t cellY, uint32_t triangle) const {
+	return (cellY * _size + cellX) * 2 + triangle;
+}
+
+inline Common::AABBNode *GridPathfinding::buildAABBTree(uint32_t x1, uint32_t y1,
+                                                       uint32_t x2, uint32_t y2) const {
+
+	float min[3] = { (float) x1, (float) y1, 0.f };
+	float max[3] = { (float) x2, (float) y2, 0.f };
+
+	Common::AABBNode *node = new Common::AABBNode(min, max);
+
+	if (((x2 - x1) == 1) && ((y2 - y1) == 1)) {
+		node->setChildren(new Common::AABBNode(min, max, getFaceID(x1, y1, 0)),
+		                  new Common::AABBNode(min, max, getFaceID(x1, y1, 1)));
+		return node;
+	}
+
+	// Split along the longer side
+	if ((x2 - x1) >= (y2 - y1)) {
+		const uint32_t x = x1 + (x2 - x1) / 2;
+		node->setChildren(buildAABBTree(x1, y1, x, y2), buildAABBTree(x, y1, x2, y2));
+	} else {
+		const uint32_t y = y1 + (y2 - y1) / 2;
+		node->setChildren(buildAABBTree(x1, y1, x2, y), buildAABBTree(x1, y, x2, y2));
+	}
+
+	return node;
+}
+
+inline void GridPathfinding::block(uint32_t cellX, uint32_t cellY) {
+	_faceProperty[getFaceID(cellX, cellY, 0)] = 0;
+	_faceProperty[getFaceID(cellX, cellY, 1)] = 0;
+}
+
+inline bool GridPathfinding::isAdjacent(uint32_t faceA, uint32_t faceB) const {
+	for (uint32_t i = 0; i < 3; i++)
+		if (_adjFaces[faceA * 3 + i] == faceB)
+			return true;
+
+	return false;
+}
+
+/** Check that a path of faces is walkable and connected. */
+inline void checkPath(GridPathfinding &grid, const std::vector<uint32_t> &path) {
+	for (size_t i = 0; i < path.size(); i++) {
+		ASSERT_NE(path[i], UINT32_MAX);
+		EXPECT_TRUE(grid.faceWalkable(path[i]));
+
+		if (i > 0) {
+			EXPECT_TRUE(grid.isAdjacent(path[i - 1], path[i])) << "At index " << i;
+		}
+	}
+}
+
+} // End of namespace Engines
+
+#endif // TESTS_ENGINES_GRIDPATHFINDING_H
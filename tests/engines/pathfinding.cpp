@@ -0,0 +1,249 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for the walkmesh regions and the path
+ *  cache of the Engines::Pathfinding class.
+ *
+ *  When asked to run, the benchmark searches smoothed paths between
+ *  random points of a large grid walkmesh, first without regions, then
+ *  with regions, and then with regions and the path cache, with every
+ *  search repeated from points close by.
+ */
+
+#include <vector>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "tests/benchmark.h"
+
+#include "external/glm/geometric.hpp"
+
+#include "src/common/util.h"
+
+#include "tests/engines/gridpathfinding.h"
+
+static const uint32_t kBenchmarkGridSize  = 64;
+static const uint32_t kBenchmarkPathCount = 200;
+static const uint32_t kBenchmarkRepeats   = 10;
+
+static void checkPath(Engines::GridPathfinding &grid, const std::vector<glm::vec3> &path) {
+	// Smoothed paths touch the corners of unwalkable faces, so walkableSegment() is too strict
+	for (size_t i = 1; i < path.size(); i++) {
+		const glm::vec3 segment = path[i] - path[i - 1];
+		const uint32_t steps = glm::length(segment) * 20 + 1;
+
+		for (uint32_t step = 0; step <= steps; step++) {
+			const glm::vec3 point = path[i - 1] + segment * ((float) step / steps);
+
+			EXPECT_NE(grid.findFace(point[0], point[1]), UINT32_MAX) << "At index " << i;
+		}
+	}
+}
+
+static float getLength(const std::vector<glm::vec3> &path) {
+	float length = 0.f;
+	for (size_t i = 1; i < path.size(); i++)
+		length += glm::length(path[i] - path[i - 1]);
+
+	return length;
+}
+
+GTEST_TEST(Pathfinding, regions) {
+	Engines::GridPathfinding grid(16);
+
+	// An L-shaped wall in the way
+	for (uint32_t y = 0; y < 12; y++)
+		grid.block(8, y);
+	for (uint32_t x = 4; x < 8; x++)
+		grid.block(x, 11);
+
+	std::vector<glm::vec3> plainPath;
+	ASSERT_TRUE(grid.findSmoothPath(1.5f, 1.2f, 14.5f, 1.2f, plainPath));
+
+	grid.buildRegions(16);
+
+	std::vector<uint32_t> facePath;
+	ASSERT_TRUE(grid.findPath(1.5f, 1.2f, 14.5f, 1.2f, facePath));
+
+	EXPECT_EQ(facePath.front(), grid.findFace(1.5f, 1.2f));
+	EXPECT_EQ(facePath.back(), grid.findFace(14.5f, 1.2f));
+	checkPath(grid, facePath);
+
+	grid.setPathCacheSize(0);
+
+	std::vector<glm::vec3> regionPath;
+	ASSERT_TRUE(grid.findSmoothPath(1.5f, 1.2f, 14.5f, 1.2f, regionPath));
+	checkPath(grid, regionPath);
+
+	// Only searching along the regions might miss the shortest path, but not by much
+	EXPECT_LE(getLength(regionPath), getLength(plainPath) * 1.2f);
+}
+
+GTEST_TEST(Pathfinding, regionsUnreachable) {
+	Engines::GridPathfinding grid(16);
+
+	for (uint32_t y = 0; y < 16; y++)
+		grid.block(8, y);
+
+	grid.buildRegions(16);
+
+	// We still get a path to the closest face we could find
+	std::vector<uint32_t> facePath;
+	EXPECT_FALSE(grid.findPath(1.5f, 1.2f, 14.5f, 1.2f, facePath));
+
+	ASSERT_FALSE(facePath.empty());
+	EXPECT_EQ(facePath.front(), grid.findFace(1.5f, 1.2f));
+	checkPath(grid, facePath);
+
+	std::vector<glm::vec3> path;
+	EXPECT_FALSE(grid.findSmoothPath(1.5f, 1.2f, 14.5f, 1.2f, path));
+	EXPECT_TRUE(path.empty());
+}
+
+GTEST_TEST(Pathfinding, walkableSegmentWidth) {
+	Engines::GridPathfinding grid(8);
+
+	// A gap of a single cell
+	grid.block(4, 2);
+	grid.block(4, 4);
+
+	const glm::vec3 start(2.5f, 3.5f, 0.f);
+	const glm::vec3 end  (6.5f, 3.5f, 0.f);
+
+	EXPECT_TRUE(grid.walkableSegment(start, end));
+	EXPECT_TRUE(grid.walkableSegment(start, end, 0.5f));
+	EXPECT_FALSE(grid.walkableSegment(start, end, 1.5f));
+}
+
+GTEST_TEST(Pathfinding, pathCache) {
+	Engines::GridPathfinding grid(16);
+
+	for (uint32_t y = 0; y < 12; y++)
+		grid.block(8, y);
+
+	grid.buildRegions(16);
+
+	std::vector<glm::vec3> path1;
+	ASSERT_TRUE(grid.findSmoothPath(1.5f, 1.2f, 14.5f, 1.2f, path1));
+	checkPath(grid, path1);
+
+	ASSERT_GT(path1.size(), 2);
+
+	// Start and end a bit off, but within the same regions
+	std::vector<glm::vec3> path2;
+	ASSERT_TRUE(grid.findSmoothPath(1.6f, 1.4f, 14.3f, 1.1f, path2));
+	checkPath(grid, path2);
+
+	ASSERT_EQ(path2.size(), path1.size());
+
+	EXPECT_EQ(path2.front(), glm::vec3(1.6f, 1.4f, 0.f));
+	EXPECT_EQ(path2.back(), glm::vec3(14.3f, 1.1f, 0.f));
+
+	for (size_t i = 1; i < (path1.size() - 1); i++)
+		EXPECT_EQ(path2[i], path1[i]) << "At index " << i;
+}
+
+GTEST_TEST(Pathfinding, pathCacheBlocked) {
+	Engines::GridPathfinding grid(16);
+
+	for (uint32_t y = 0; y < 12; y++)
+		grid.block(8, y);
+
+	grid.buildRegions(16);
+
+	std::vector<glm::vec3> path;
+	ASSERT_TRUE(grid.findSmoothPath(7.5f, 1.2f, 9.5f, 1.2f, path));
+
+	/* Put something between our next start point and the cached path.
+	 * The cached path can't be used, and a new one is searched. The
+	 * regions are stale now, so the new path might not be optimal,
+	 * but it must be walkable. */
+	grid.block(6, 3);
+
+	ASSERT_TRUE(grid.findSmoothPath(6.5f, 2.2f, 9.5f, 1.2f, path));
+	checkPath(grid, path);
+}
+
+static void fillPoints(Engines::GridPathfinding &grid, std::mt19937 &random, std::vector<float> &points) {
+	std::uniform_real_distribution<float> position(0.f, kBenchmarkGridSize);
+
+	while (points.size() < (kBenchmarkPathCount * 4)) {
+		const float x = position(random);
+		const float y = position(random);
+
+		if (grid.findFace(x, y) == UINT32_MAX)
+			continue;
+
+		points.push_back(x);
+		points.push_back(y);
+	}
+}
+
+static void benchmarkPaths(const char *what, Engines::GridPathfinding &grid, const std::vector<float> &points) {
+	std::mt19937 random(4321);
+	std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+
+	std::vector<glm::vec3> path;
+	size_t found = 0;
+
+	const double ms = benchmarkTime([&]() {
+		for (uint32_t i = 0; i < kBenchmarkPathCount; i++) {
+			const float *p = &points[i * 4];
+
+			for (uint32_t j = 0; j < kBenchmarkRepeats; j++)
+				found += grid.findSmoothPath(p[0] + jitter(random), p[1] + jitter(random),
+				                             p[2] + jitter(random), p[3] + jitter(random), path, 0.f, UINT32_MAX) ? 1 : 0;
+		}
+	});
+
+	EXPECT_GT(found, 0);
+
+	const uint32_t count = kBenchmarkPathCount * kBenchmarkRepeats;
+
+	benchmarkPrint("%s: %u paths (%u found) over %u faces: %.2f ms (%.1f us/path)",
+	               what, count, (uint)found, kBenchmarkGridSize * kBenchmarkGridSize * 2, ms, (ms * 1000.0) / count);
+}
+
+GTEST_TEST(Pathfinding, DISABLED_benchmark) {
+	Engines::GridPathfinding grid(kBenchmarkGridSize);
+
+	std::mt19937 random(1234);
+	std::uniform_int_distribution<uint32_t> cell(0, kBenchmarkGridSize - 1);
+
+	// Scatter some obstacles, so that the paths aren't all straight lines
+	for (uint32_t i = 0; i < (kBenchmarkGridSize * kBenchmarkGridSize) / 8; i++)
+		grid.block(cell(random), cell(random));
+
+	std::vector<float> points;
+	fillPoints(grid, random, points);
+
+	benchmarkPaths("No regions", grid, points);
+
+	grid.buildRegions();
+	grid.setPathCacheSize(0);
+
+	benchmarkPaths("Regions", grid, points);
+
+	grid.setPathCacheSize(kBenchmarkPathCount);
+
+	benchmarkPaths("Regions and path cache", grid, points);
+}
@@ -30,7 +30,29 @@ engines_LIBS = \
     external/imgui/libimgui.la \
     $(LDADD)
 
+noinst_HEADERS += tests/engines/gridpathfinding.h
+
+check_PROGRAMS                   += tests/engines/test_astar
+tests_engines_test_astar_SOURCES  = tests/engines/astar.cpp
+tests_engines_test_astar_LDADD    = $(engines_LIBS)
+tests_engines_test_astar_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                         += tests/engines/test_pathfinding
+tests_engines_test_pathfinding_SOURCES  = tests/engines/pathfinding.cpp
+tests_engines_test_pathfinding_LDADD    = $(engines_LIBS)
+tests_engines_test_pathfinding_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                     += tests/engines/test_trigger
 tests_engines_test_trigger_SOURCES  = tests/engines/trigger.cpp
 tests_engines_test_trigger_LDADD    = $(engines_LIBS)
 tests_engines_test_trigger_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                             += tests/engines/test_scriptscheduler
+tests_engines_test_scriptscheduler_SOURCES  = tests/engines/scriptscheduler.cpp
+tests_engines_test_scriptscheduler_LDADD    = $(engines_LIBS)
+tests_engines_test_scriptscheduler_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                         += tests/engines/test_scriptqueue
+tests_engines_test_scriptqueue_SOURCES  = tests/engines/scriptqueue.cpp
+tests_engines_test_scriptqueue_LDADD    = $(engines_LIBS)
+tests_engines_test_scriptqueue_CXXFLAGS = $(test_CXXFLAGS)
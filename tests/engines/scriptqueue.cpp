@@ -0,0 +1,392 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the Engines::ScriptQueue class.
+ */
+
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/platform.h"
+#include "src/common/writefile.h"
+
+#include "src/aurora/resman.h"
+
+#include "src/aurora/nwscript/ncsfile.h"
+#include "src/aurora/nwscript/ncsprogram.h"
+#include "src/aurora/nwscript/ncscache.h"
+#include "src/aurora/nwscript/ncsprofiler.h"
+#include "src/aurora/nwscript/functionman.h"
+#include "src/aurora/nwscript/functioncontext.h"
+
+#include "src/engines/aurora/scriptqueue.h"
+
+namespace NWScript = Aurora::NWScript;
+
+static const uint32_t kFunctionRecord = 0;
+
+/** The values passed to Record() by the scripts, in order. */
+static std::vector<int32_t> records;
+
+static boost::filesystem::path kBasePath;
+
+/** A tiny NWScript bytecode writer. */
+class Script {
+public:
+	Script() {
+		static const byte kHeader[] = { 'N', 'C', 'S', ' ', 'V', '1', '.', '0', 0x42, 0, 0, 0, 0 };
+
+		_data.assign(kHeader, kHeader + sizeof(kHeader));
+	}
+
+	uint32_t pos() const {
+		return _data.size();
+	}
+
+	void op(NWScript::Opcode opcode, NWScript::InstructionType type = NWScript::kInstTypeNone) {
+		_data.push_back(opcode);
+		_data.push_back(type);
+	}
+
+	void int16(int16_t value) {
+		_data.push_back((value >> 8) & 0xFF);
+		_data.push_back( value       & 0xFF);
+	}
+
+	void int32(int32_t value) {
+		int16((value >> 16) & 0xFFFF);
+		int16( value        & 0xFFFF);
+	}
+
+	void constInt(int32_t value) {
+		op(NWScript::kOpcodeCONST, NWScript::kInstTypeInt);
+		int32(value);
+	}
+
+	/** Call Record() with the value on top of the stack. */
+	void record() {
+		op(NWScript::kOpcodeACTION);
+		int16(kFunctionRecord);
+		_data.push_back(1);
+	}
+
+	void jump(NWScript::Opcode opcode, uint32_t target) {
+		const uint32_t address = pos();
+
+		op(opcode);
+		int32(target - address);
+	}
+
+	void write(const Common::UString &name) {
+		const uint32_t size = _data.size();
+		_data[ 9] = (size >> 24) & 0xFF;
+		_data[10] = (size >> 16) & 0xFF;
+		_data[11] = (size >>  8) & 0xFF;
+		_data[12] =  size        & 0xFF;
+
+		Common::WriteFile file((kBasePath / (name + ".ncs").c_str()).generic_string());
+
+		file.write(&_data[0], _data.size());
+
+		file.flush();
+		file.close();
+	}
+
+private:
+	std::vector<byte> _data;
+};
+
+/** A script that records this value. */
+static void writeRecordScript(const Common::UString &name, int32_t value) {
+	Script script;
+
+	script.constInt(value);
+	script.record();
+	script.op(NWScript::kOpcodeRETN);
+
+	script.write(name);
+}
+
+/** A script that counts down from this value, then records the 0. */
+static void writeCountdownScript(const Common::UString &name, int32_t count) {
+	Script script;
+
+	script.constInt(count);
+
+	const uint32_t loop = script.pos();
+
+	// Copy the counter to the top of the stack and leave the loop once it's 0
+	script.op(NWScript::kOpcodeCPTOPSP, NWScript::kInstTypeDirect);
+	script.int32(-4);
+	script.int16(4);
+
+	const uint32_t exit = script.pos() + 6 + 6 + 6;
+	script.jump(NWScript::kOpcodeJZ, exit);
+
+	script.op(NWScript::kOpcodeDECSP, NWScript::kInstTypeInt);
+	script.int32(-4);
+
+	script.jump(NWScript::kOpcodeJMP, loop);
+
+	script.record();
+	script.op(NWScript::kOpcodeRETN);
+
+	script.write(name);
+}
+
+/** A script that never ends. */
+static void writeForeverScript(const Common::UString &name) {
+	Script script;
+
+	script.jump(NWScript::kOpcodeJMP, script.pos());
+
+	script.write(name);
+}
+
+static void add(Engines::ScriptQueue &queue, Engines::ScriptQueue::Priority priority, const Common::UString &script) {
+	queue.add(priority, script, NWScript::NCSFile::getEmptyState(),
+	          NWScript::ObjectReference(), NWScript::ObjectReference());
+}
+
+class ScriptQueue : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kBasePath = boost::filesystem::temp_directory_path() /
+		            boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directories(kBasePath);
+
+		writeRecordScript("one"  , 1);
+		writeRecordScript("two"  , 2);
+		writeRecordScript("three", 3);
+
+		writeCountdownScript("countdown", 100000);
+
+		writeForeverScript("forever");
+
+		NWScript::Signature signature;
+		signature.push_back(NWScript::kTypeVoid);
+		signature.push_back(NWScript::kTypeInt);
+
+		FunctionMan.registerFunction("Record", kFunctionRecord, [](NWScript::FunctionContext &ctx) {
+			records.push_back(ctx.getParams()[0].getInt());
+		}, signature);
+
+		ResMan.registerDataBase(kBasePath.generic_string());
+	}
+
+	static void TearDownTestCase() {
+		ResMan.clear();
+		NWScript::NCSCache::destroy();
+		NWScript::NCSProfiler::destroy();
+
+		if (!kBasePath.empty())
+			boost::filesystem::remove_all(kBasePath);
+	}
+
+	void SetUp() {
+		records.clear();
+	}
+};
+
+GTEST_TEST_F(ScriptQueue, unlimited) {
+	Engines::ScriptQueue queue;
+	queue.setBudget(0.0);
+
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "one");
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "countdown");
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "two");
+
+	EXPECT_EQ(queue.size(), 3U);
+
+	queue.run();
+
+	EXPECT_TRUE(queue.empty());
+
+	ASSERT_EQ(records.size(), 3U);
+	EXPECT_EQ(records[0], 1);
+	EXPECT_EQ(records[1], 0);
+	EXPECT_EQ(records[2], 2);
+
+	const Engines::ScriptQueue::Stats stats = queue.getStats();
+	EXPECT_EQ(stats.queued   , 0U);
+	EXPECT_EQ(stats.suspended, 0U);
+	EXPECT_EQ(stats.slices   , 3U);
+	EXPECT_EQ(stats.finished , 3U);
+}
+
+GTEST_TEST_F(ScriptQueue, priority) {
+	Engines::ScriptQueue queue;
+	queue.setBudget(0.0);
+
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "one");
+	add(queue, Engines::ScriptQueue::kPriorityPlayer , "two");
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "three");
+
+	queue.run();
+
+	ASSERT_EQ(records.size(), 3U);
+	EXPECT_EQ(records[0], 2);
+	EXPECT_EQ(records[1], 1);
+	EXPECT_EQ(records[2], 3);
+}
+
+GTEST_TEST_F(ScriptQueue, resume) {
+	Engines::ScriptQueue queue;
+
+	// A budget big enough for everything
+	queue.setBudget(10000.0);
+
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "countdown");
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "one");
+
+	queue.run();
+
+	EXPECT_TRUE(queue.empty());
+
+	// The countdown was resumed slice after slice until it was done, then the next script ran
+	ASSERT_EQ(records.size(), 2U);
+	EXPECT_EQ(records[0], 0);
+	EXPECT_EQ(records[1], 1);
+
+	// 100000 iterations of 4 instructions each
+	const Engines::ScriptQueue::Stats stats = queue.getStats();
+	EXPECT_GE(stats.slices  , (400000 / Engines::ScriptQueue::kSliceInstructions) + 1);
+	EXPECT_EQ(stats.finished, 2U);
+}
+
+GTEST_TEST_F(ScriptQueue, timeSlicing) {
+	NCSProfilerMan.clear();
+	NCSProfilerMan.setEnabled(true);
+
+	Engines::ScriptQueue queue;
+
+	// A budget so small that only one slice runs per frame
+	queue.setBudget(0.000001);
+
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "countdown");
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "one");
+
+	queue.run();
+
+	EXPECT_TRUE(records.empty());
+	EXPECT_EQ(queue.size(), 2U);
+	EXPECT_EQ(queue.getStats().suspended, 1U);
+	EXPECT_EQ(queue.getStats().slices, 1U);
+
+	// The countdown continues in the following frames, the other script waits for it
+	size_t frames = 1;
+	while (records.empty() && (frames < 1000)) {
+		queue.run();
+		frames++;
+	}
+
+	ASSERT_FALSE(records.empty());
+	EXPECT_EQ(records[0], 0);
+
+	// 100000 iterations of 4 instructions each
+	EXPECT_GE(frames, (400000 / Engines::ScriptQueue::kSliceInstructions) + 1);
+
+	const size_t countdownFrames = frames;
+
+	while (!queue.empty() && (frames < 1000)) {
+		queue.run();
+		frames++;
+	}
+
+	EXPECT_TRUE(queue.empty());
+
+	ASSERT_EQ(records.size(), 2U);
+	EXPECT_EQ(records[1], 1);
+
+	const std::vector<NWScript::NCSProfiler::ScriptStats> stats = NCSProfilerMan.getStats();
+
+	bool found = false;
+	for (std::vector<NWScript::NCSProfiler::ScriptStats>::const_iterator s = stats.begin(); s != stats.end(); ++s) {
+		if (s->name != "countdown")
+			continue;
+
+		found = true;
+
+		EXPECT_EQ(s->runs, 1U);
+		EXPECT_EQ(s->slices, countdownFrames);
+		EXPECT_GE(s->instructions, 400000U);
+	}
+
+	EXPECT_TRUE(found);
+
+	NCSProfilerMan.setEnabled(false);
+}
+
+GTEST_TEST_F(ScriptQueue, noProfiling) {
+	NCSProfilerMan.clear();
+
+	Engines::ScriptQueue queue;
+	queue.setBudget(0.0);
+
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "one");
+
+	queue.run();
+
+	ASSERT_EQ(records.size(), 1U);
+	EXPECT_TRUE(NCSProfilerMan.getStats().empty());
+}
+
+GTEST_TEST_F(ScriptQueue, clear) {
+	Engines::ScriptQueue queue;
+	queue.setBudget(0.000001);
+
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "forever");
+	add(queue, Engines::ScriptQueue::kPriorityPlayer , "one");
+
+	for (size_t i = 0; i < 10; i++)
+		queue.run();
+
+	// The player script ran first, the other one is still going
+	ASSERT_EQ(records.size(), 1U);
+	EXPECT_EQ(queue.size(), 1U);
+	EXPECT_EQ(queue.getStats().suspended, 1U);
+
+	queue.clear();
+
+	EXPECT_TRUE(queue.empty());
+	EXPECT_EQ(queue.getStats().suspended, 0U);
+}
+
+GTEST_TEST_F(ScriptQueue, missing) {
+	Engines::ScriptQueue queue;
+
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "doesnotexist");
+	add(queue, Engines::ScriptQueue::kPriorityAmbient, "one");
+
+	queue.run();
+
+	EXPECT_TRUE(queue.empty());
+
+	ASSERT_EQ(records.size(), 1U);
+	EXPECT_EQ(records[0], 1);
+}
@@ -0,0 +1,390 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the Engines::ScriptScheduler class.
+ *
+ *  Two benchmarks, only run on demand, hold the timer wheel against a
+ *  multiset sorted by timestamp, which is how we used to queue actions.
+ */
+
+#include <set>
+#include <vector>
+#include <random>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+#include "tests/benchmark.h"
+
+#include "src/common/util.h"
+#include "src/common/ustring.h"
+#include "src/common/strutil.h"
+
+#include "src/engines/aurora/scriptscheduler.h"
+
+typedef std::vector<Common::UString> ScriptList;
+
+static void addScript(Engines::ScriptScheduler &scheduler, uint32_t timestamp, const Common::UString &script) {
+	Aurora::NWScript::ScriptState state;
+	state.offset = timestamp;
+
+	scheduler.add(timestamp, script, std::move(state),
+	              Aurora::NWScript::ObjectReference(), Aurora::NWScript::ObjectReference());
+}
+
+static ScriptList update(Engines::ScriptScheduler &scheduler, uint32_t now) {
+	ScriptList scripts;
+
+	scheduler.update(now, [&scripts](Engines::ScriptScheduler::Action &action) {
+		scripts.push_back(action.script);
+	});
+
+	return scripts;
+}
+
+GTEST_TEST(ScriptScheduler, empty) {
+	Engines::ScriptScheduler scheduler;
+
+	EXPECT_TRUE(scheduler.empty());
+	EXPECT_EQ(scheduler.size(), 0U);
+
+	EXPECT_TRUE(update(scheduler, 1000).empty());
+}
+
+GTEST_TEST(ScriptScheduler, order) {
+	Engines::ScriptScheduler scheduler;
+
+	addScript(scheduler, 30, "c");
+	addScript(scheduler, 10, "a");
+	addScript(scheduler, 20, "b");
+
+	EXPECT_FALSE(scheduler.empty());
+	EXPECT_EQ(scheduler.size(), 3U);
+
+	EXPECT_TRUE(update(scheduler, 9).empty());
+
+	const ScriptList scripts1 = update(scheduler, 20);
+	ASSERT_EQ(scripts1.size(), 2U);
+	EXPECT_STREQ(scripts1[0].c_str(), "a");
+	EXPECT_STREQ(scripts1[1].c_str(), "b");
+
+	const ScriptList scripts2 = update(scheduler, 30);
+	ASSERT_EQ(scripts2.size(), 1U);
+	EXPECT_STREQ(scripts2[0].c_str(), "c");
+
+	EXPECT_TRUE(scheduler.empty());
+}
+
+GTEST_TEST(ScriptScheduler, sameTimestamp) {
+	Engines::ScriptScheduler scheduler;
+
+	// One close, one far away, so that they end up in different levels first
+	addScript(scheduler, 100000, "a");
+	update(scheduler, 99900);
+	addScript(scheduler, 100000, "b");
+	addScript(scheduler, 100000, "c");
+
+	const ScriptList scripts = update(scheduler, 100000);
+	ASSERT_EQ(scripts.size(), 3U);
+	EXPECT_STREQ(scripts[0].c_str(), "a");
+	EXPECT_STREQ(scripts[1].c_str(), "b");
+	EXPECT_STREQ(scripts[2].c_str(), "c");
+}
+
+GTEST_TEST(ScriptScheduler, longDelays) {
+	Engines::ScriptScheduler scheduler;
+
+	static const uint32_t kTimestamps[] = {
+		1, 255, 256, 257, 16383, 16384, 16385, 1000000, 67108863, 67108864, 0x7FFFFFFF, 0xFFFFFFF0
+	};
+
+	for (size_t i = 0; i < ARRAYSIZE(kTimestamps); i++)
+		addScript(scheduler, kTimestamps[i], Common::composeString(kTimestamps[i]));
+
+	uint32_t now = 0;
+	for (size_t i = 0; i < ARRAYSIZE(kTimestamps); i++) {
+		EXPECT_TRUE(update(scheduler, kTimestamps[i] - 1).empty()) << "At index " << i;
+
+		const ScriptList scripts = update(scheduler, kTimestamps[i]);
+		ASSERT_EQ(scripts.size(), 1U) << "At index " << i;
+		EXPECT_STREQ(scripts[0].c_str(), Common::composeString(kTimestamps[i]).c_str()) << "At index " << i;
+
+		now = kTimestamps[i];
+	}
+
+	EXPECT_TRUE(scheduler.empty());
+	EXPECT_TRUE(update(scheduler, now + 10).empty());
+}
+
+GTEST_TEST(ScriptScheduler, frames) {
+	Engines::ScriptScheduler scheduler;
+
+	std::mt19937 random(42);
+	std::uniform_int_distribution<uint32_t> delays(0, 100000);
+
+	std::multiset<uint32_t> expected;
+	for (size_t i = 0; i < 1000; i++) {
+		const uint32_t timestamp = delays(random);
+
+		addScript(scheduler, timestamp, "a");
+		expected.insert(timestamp);
+	}
+
+	uint32_t lastFired = 0;
+	for (uint32_t now = 0; now < 100016; now += 16) {
+		scheduler.update(now, [&](Engines::ScriptScheduler::Action &action) {
+			ASSERT_FALSE(expected.empty());
+			EXPECT_EQ(action.timestamp, *expected.begin());
+			EXPECT_EQ(action.state.offset, action.timestamp);
+
+			EXPECT_LE(action.timestamp, now);
+			EXPECT_GE(action.timestamp, lastFired);
+
+			lastFired = action.timestamp;
+			expected.erase(expected.begin());
+		});
+
+		// Everything due has been fired
+		if (!expected.empty()) {
+			EXPECT_GT(*expected.begin(), now);
+		}
+	}
+
+	EXPECT_TRUE(expected.empty());
+	EXPECT_TRUE(scheduler.empty());
+}
+
+GTEST_TEST(ScriptScheduler, overdue) {
+	Engines::ScriptScheduler scheduler;
+
+	update(scheduler, 5000);
+
+	addScript(scheduler, 10, "a");
+	addScript(scheduler, 4000, "b");
+
+	const ScriptList scripts = update(scheduler, 5001);
+	ASSERT_EQ(scripts.size(), 2U);
+	EXPECT_STREQ(scripts[0].c_str(), "a");
+	EXPECT_STREQ(scripts[1].c_str(), "b");
+}
+
+GTEST_TEST(ScriptScheduler, addWhileFiring) {
+	Engines::ScriptScheduler scheduler;
+
+	addScript(scheduler, 100, "a");
+
+	ScriptList scripts;
+	scheduler.update(200, [&](Engines::ScriptScheduler::Action &action) {
+		scripts.push_back(action.script);
+
+		// Immediately due: fired within the same update
+		if (action.script == "a") {
+			addScript(scheduler, 100, "b");
+			addScript(scheduler, 150, "c");
+			addScript(scheduler, 300, "d");
+		}
+	});
+
+	ASSERT_EQ(scripts.size(), 3U);
+	EXPECT_STREQ(scripts[0].c_str(), "a");
+	EXPECT_STREQ(scripts[1].c_str(), "b");
+	EXPECT_STREQ(scripts[2].c_str(), "c");
+
+	EXPECT_EQ(scheduler.size(), 1U);
+
+	const ScriptList scripts2 = update(scheduler, 300);
+	ASSERT_EQ(scripts2.size(), 1U);
+	EXPECT_STREQ(scripts2[0].c_str(), "d");
+}
+
+GTEST_TEST(ScriptScheduler, actionKeptWhileAdding) {
+	Engines::ScriptScheduler scheduler;
+
+	addScript(scheduler, 100, "a");
+
+	scheduler.update(100, [&](Engines::ScriptScheduler::Action &action) {
+		// The record of the running action is free again and gets reused
+		for (uint32_t i = 0; i < 1000; i++)
+			addScript(scheduler, 200 + i, "b");
+
+		EXPECT_STREQ(action.script.c_str(), "a");
+		EXPECT_EQ(action.state.offset, 100U);
+	});
+
+	EXPECT_EQ(scheduler.size(), 1000U);
+}
+
+GTEST_TEST(ScriptScheduler, throwingRunner) {
+	Engines::ScriptScheduler scheduler;
+
+	addScript(scheduler, 10, "a");
+	addScript(scheduler, 10, "b");
+	addScript(scheduler, 10, "c");
+
+	EXPECT_THROW(scheduler.update(10, [](Engines::ScriptScheduler::Action &action) {
+		if (action.script == "a")
+			throw std::runtime_error("a");
+	}), std::runtime_error);
+
+	EXPECT_EQ(scheduler.size(), 2U);
+
+	const ScriptList scripts = update(scheduler, 10);
+	ASSERT_EQ(scripts.size(), 2U);
+	EXPECT_STREQ(scripts[0].c_str(), "b");
+	EXPECT_STREQ(scripts[1].c_str(), "c");
+}
+
+GTEST_TEST(ScriptScheduler, clear) {
+	Engines::ScriptScheduler scheduler;
+
+	addScript(scheduler, 10, "a");
+	addScript(scheduler, 100000, "b");
+
+	scheduler.clear();
+
+	EXPECT_TRUE(scheduler.empty());
+	EXPECT_TRUE(update(scheduler, 200000).empty());
+
+	addScript(scheduler, 200010, "c");
+
+	const ScriptList scripts = update(scheduler, 200010);
+	ASSERT_EQ(scripts.size(), 1U);
+	EXPECT_STREQ(scripts[0].c_str(), "c");
+}
+
+GTEST_TEST(ScriptScheduler, stats) {
+	Engines::ScriptScheduler scheduler;
+
+	addScript(scheduler, 10, "a");
+	addScript(scheduler, 20, "b");
+	addScript(scheduler, 30, "c");
+
+	update(scheduler, 20);
+
+	Engines::ScriptScheduler::Stats stats = scheduler.getStats();
+	EXPECT_EQ(stats.pending   , 1U);
+	EXPECT_EQ(stats.peak      , 3U);
+	EXPECT_EQ(stats.added     , 3U);
+	EXPECT_EQ(stats.fired     , 2U);
+	EXPECT_EQ(stats.totalAdded, 3U);
+	EXPECT_EQ(stats.totalFired, 2U);
+
+	update(scheduler, 30);
+
+	stats = scheduler.getStats();
+	EXPECT_EQ(stats.pending   , 0U);
+	EXPECT_EQ(stats.peak      , 3U);
+	EXPECT_EQ(stats.added     , 0U);
+	EXPECT_EQ(stats.fired     , 1U);
+	EXPECT_EQ(stats.totalAdded, 3U);
+	EXPECT_EQ(stats.totalFired, 3U);
+}
+
+
+/** The number of actions constantly waiting in the benchmarks. */
+static const size_t   kBenchmarkPending = 50000;
+/** The number of frames the benchmarks run for. */
+static const uint32_t kBenchmarkFrames  = 4000;
+/** The length of a frame in the benchmarks, in milliseconds. */
+static const uint32_t kBenchmarkFrame   = 16;
+/** The longest delay of an action in the benchmarks, in milliseconds. */
+static const uint32_t kBenchmarkDelay   = 30000;
+
+/** A delayed action the way it used to be queued, sorted by timestamp. */
+struct SortedAction {
+	uint32_t timestamp;
+
+	Common::UString script;
+	Aurora::NWScript::ScriptState state;
+
+	Aurora::NWScript::ObjectReference owner;
+	Aurora::NWScript::ObjectReference triggerer;
+
+	bool operator<(const SortedAction &s) const {
+		return timestamp < s.timestamp;
+	}
+};
+
+static void printBenchmark(const char *what, size_t fired, double ms) {
+	benchmarkPrint("%s: %u frames, %u actions fired: %.2f ms (%.2f us/frame)",
+	               what, kBenchmarkFrames, (uint)fired, ms, (ms * 1000.0) / kBenchmarkFrames);
+}
+
+/* Keep many actions waiting, with every fired action queueing a new one,
+ * like lots of creatures running heartbeat-like DelayCommand() loops. */
+
+GTEST_TEST(ScriptScheduler, DISABLED_benchmarkMultiset) {
+	std::mt19937 random(42);
+	std::uniform_int_distribution<uint32_t> delays(0, kBenchmarkDelay);
+
+	std::multiset<SortedAction> actions;
+	for (size_t i = 0; i < kBenchmarkPending; i++) {
+		SortedAction action;
+		action.timestamp = delays(random);
+		action.script    = "benchmark";
+
+		actions.insert(action);
+	}
+
+	size_t fired = 0;
+
+	const double ms = benchmarkTime([&]() {
+		for (uint32_t frame = 0, now = 0; frame < kBenchmarkFrames; frame++, now += kBenchmarkFrame) {
+			while (!actions.empty() && (actions.begin()->timestamp <= now)) {
+				SortedAction action = *actions.begin();
+				actions.erase(actions.begin());
+
+				fired++;
+
+				action.timestamp = now + delays(random);
+				actions.insert(action);
+			}
+		}
+	});
+
+	EXPECT_EQ(actions.size(), kBenchmarkPending);
+
+	printBenchmark("Sorted multiset", fired, ms);
+}
+
+GTEST_TEST(ScriptScheduler, DISABLED_benchmarkScheduler) {
+	std::mt19937 random(42);
+	std::uniform_int_distribution<uint32_t> delays(0, kBenchmarkDelay);
+
+	Engines::ScriptScheduler scheduler;
+	for (size_t i = 0; i < kBenchmarkPending; i++)
+		addScript(scheduler, delays(random), "benchmark");
+
+	size_t fired = 0;
+
+	const double ms = benchmarkTime([&]() {
+		for (uint32_t frame = 0, now = 0; frame < kBenchmarkFrames; frame++, now += kBenchmarkFrame) {
+			scheduler.update(now, [&](Engines::ScriptScheduler::Action &action) {
+				fired++;
+
+				scheduler.add(now + delays(random), action.script, std::move(action.state), action.owner, action.triggerer);
+			});
+		}
+	});
+
+	EXPECT_EQ(scheduler.size(), kBenchmarkPending);
+
+	printBenchmark("Timer wheel", fired, ms);
+}
@@ -0,0 +1,285 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for the Graphics::AABBTree class.
+ *
+ *  The benchmark scatters boxes over a large area, moves a part of them
+ *  around every frame and casts rays through them, comparing the tree
+ *  with testing every box in turn. It has to be run explicitly.
+ */
+
+#include <vector>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "tests/benchmark.h"
+
+#include "external/glm/vec3.hpp"
+
+#include "src/common/util.h"
+
+#include "src/graphics/aabbtree.h"
+
+using Graphics::AABBTree;
+
+static const size_t kBenchmarkBoxCount = 5000;
+static const size_t kBenchmarkRayCount = 2000;
+static const size_t kBenchmarkFrames   = 50;
+
+struct Box {
+	float min[3];
+	float max[3];
+
+	uint32_t leaf;
+};
+
+static void setBox(Box &box, float x, float y, float z, float size) {
+	box.min[0] = x - size; box.min[1] = y - size; box.min[2] = z - size;
+	box.max[0] = x + size; box.max[1] = y + size; box.max[2] = z + size;
+}
+
+static bool acceptAll(void *UNUSED(data)) {
+	return true;
+}
+
+/** Find the box closest to the start of the segment by testing them all. */
+static Box *findClosest(std::vector<Box> &boxes, const glm::vec3 &start, const glm::vec3 &end) {
+	const glm::vec3 direction = end - start;
+
+	Box *closest = 0;
+	float closestT = 2.0f;
+
+	for (std::vector<Box>::iterator b = boxes.begin(); b != boxes.end(); ++b) {
+		float tMin = 0.0f, tMax = 1.0f;
+
+		for (int i = 0; i < 3; i++) {
+			float t1 = (b->min[i] - start[i]) / direction[i];
+			float t2 = (b->max[i] - start[i]) / direction[i];
+			if (t1 > t2)
+				std::swap(t1, t2);
+
+			tMin = MAX(tMin, t1);
+			tMax = MIN(tMax, t2);
+		}
+
+		if ((tMin <= tMax) && (tMin < closestT)) {
+			closest  = &*b;
+			closestT = tMin;
+		}
+	}
+
+	return closest;
+}
+
+static void fillBoxes(std::vector<Box> &boxes, size_t count, std::mt19937 &random) {
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> size(0.5f, 2.0f);
+
+	boxes.resize(count);
+	for (std::vector<Box>::iterator b = boxes.begin(); b != boxes.end(); ++b)
+		setBox(*b, position(random), position(random), position(random) / 50.0f, size(random));
+}
+
+static void makeRay(std::mt19937 &random, glm::vec3 &start, glm::vec3 &end) {
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+
+	// From high above down at a slant onto the ground, like a camera would
+	start = glm::vec3(position(random), position(random), 100.0f);
+	end   = glm::vec3(start[0] + position(random) / 10.0f, start[1] + position(random) / 10.0f, -100.0f);
+}
+
+GTEST_TEST(AABBTree, insertRemove) {
+	AABBTree tree;
+
+	EXPECT_EQ(tree.getCount(), 0U);
+	EXPECT_EQ(tree.getHeight(), 0U);
+
+	std::vector<Box> boxes(3);
+	for (size_t i = 0; i < boxes.size(); i++) {
+		setBox(boxes[i], i * 10.0f, 0.0f, 0.0f, 1.0f);
+		boxes[i].leaf = tree.insert(boxes[i].min, boxes[i].max, &boxes[i]);
+	}
+
+	EXPECT_EQ(tree.getCount(), 3U);
+	EXPECT_EQ(tree.getHeight(), 3U);
+
+	for (size_t i = 0; i < boxes.size(); i++)
+		EXPECT_EQ(tree.getData(boxes[i].leaf), &boxes[i]);
+
+	tree.remove(boxes[1].leaf);
+	EXPECT_EQ(tree.getCount(), 2U);
+
+	EXPECT_EQ(tree.getData(boxes[0].leaf), &boxes[0]);
+	EXPECT_EQ(tree.getData(boxes[2].leaf), &boxes[2]);
+
+	tree.remove(boxes[0].leaf);
+	tree.remove(boxes[2].leaf);
+
+	EXPECT_EQ(tree.getCount(), 0U);
+	EXPECT_EQ(tree.getHeight(), 0U);
+}
+
+GTEST_TEST(AABBTree, balanced) {
+	AABBTree tree;
+
+	// Inserting boxes along a line would make a list, if the tree weren't rebalanced
+	std::vector<Box> boxes(1024);
+	for (size_t i = 0; i < boxes.size(); i++) {
+		setBox(boxes[i], i * 4.0f, 0.0f, 0.0f, 1.0f);
+		boxes[i].leaf = tree.insert(boxes[i].min, boxes[i].max, &boxes[i]);
+	}
+
+	EXPECT_EQ(tree.getCount(), 1024U);
+	EXPECT_LE(tree.getHeight(), 20U);
+}
+
+GTEST_TEST(AABBTree, move) {
+	AABBTree tree(0.5f);
+
+	Box box;
+	setBox(box, 0.0f, 0.0f, 0.0f, 1.0f);
+	box.leaf = tree.insert(box.min, box.max, &box);
+
+	// Still within the margin
+	setBox(box, 0.2f, 0.0f, 0.0f, 1.0f);
+	EXPECT_FALSE(tree.move(box.leaf, box.min, box.max));
+
+	setBox(box, 10.0f, 0.0f, 0.0f, 1.0f);
+	EXPECT_TRUE(tree.move(box.leaf, box.min, box.max));
+
+	EXPECT_EQ(tree.rayCast(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, -10.0f), acceptAll), (void *) 0);
+	EXPECT_EQ(tree.rayCast(glm::vec3(10.0f, 0.0f, 10.0f), glm::vec3(10.0f, 0.0f, -10.0f), acceptAll), &box);
+}
+
+GTEST_TEST(AABBTree, rayCastClosest) {
+	AABBTree tree;
+
+	// A stack of boxes, from the top down
+	std::vector<Box> boxes(3);
+	for (size_t i = 0; i < boxes.size(); i++) {
+		setBox(boxes[i], 0.0f, 0.0f, i * -10.0f, 1.0f);
+		boxes[i].leaf = tree.insert(boxes[i].min, boxes[i].max, &boxes[i]);
+	}
+
+	const glm::vec3 top(0.0f, 0.0f, 20.0f), bottom(0.0f, 0.0f, -40.0f);
+
+	EXPECT_EQ(tree.rayCast(top, bottom, acceptAll), &boxes[0]);
+	EXPECT_EQ(tree.rayCast(bottom, top, acceptAll), &boxes[2]);
+
+	// The test can reject boxes
+	const AABBTree::RayTest skipFirst = [&](void *data) { return data != &boxes[0]; };
+	const AABBTree::RayTest rejectAll = [](void *UNUSED(data)) { return false; };
+
+	EXPECT_EQ(tree.rayCast(top, bottom, skipFirst), &boxes[1]);
+	EXPECT_EQ(tree.rayCast(top, bottom, rejectAll), (void *) 0);
+
+	// Segments that end before reaching any box
+	EXPECT_EQ(tree.rayCast(top, glm::vec3(0.0f, 0.0f, 5.0f), acceptAll), (void *) 0);
+}
+
+GTEST_TEST(AABBTree, rayCastRandom) {
+	std::mt19937 random(1234);
+
+	std::vector<Box> boxes;
+	fillBoxes(boxes, 500, random);
+
+	AABBTree tree;
+	for (std::vector<Box>::iterator b = boxes.begin(); b != boxes.end(); ++b)
+		b->leaf = tree.insert(b->min, b->max, &*b);
+
+	// Move a few boxes around, so that some leaves are reinserted
+	std::uniform_real_distribution<float> step(-5.0f, 5.0f);
+	for (size_t i = 0; i < boxes.size(); i += 3) {
+		const float d[3] = { step(random), step(random), step(random) };
+
+		for (int j = 0; j < 3; j++) {
+			boxes[i].min[j] += d[j];
+			boxes[i].max[j] += d[j];
+		}
+
+		tree.move(boxes[i].leaf, boxes[i].min, boxes[i].max);
+	}
+
+	for (size_t i = 0; i < 1000; i++) {
+		glm::vec3 start, end;
+		makeRay(random, start, end);
+
+		EXPECT_EQ(tree.rayCast(start, end, acceptAll), findClosest(boxes, start, end)) << "At ray " << i;
+	}
+}
+
+GTEST_TEST(AABBTree, DISABLED_benchmark) {
+	std::mt19937 random(1234);
+
+	std::vector<Box> boxes;
+	fillBoxes(boxes, kBenchmarkBoxCount, random);
+
+	AABBTree tree;
+	for (std::vector<Box>::iterator b = boxes.begin(); b != boxes.end(); ++b)
+		b->leaf = tree.insert(b->min, b->max, &*b);
+
+	std::vector<glm::vec3> rays(kBenchmarkRayCount * 2);
+	for (size_t i = 0; i < kBenchmarkRayCount; i++)
+		makeRay(random, rays[i * 2], rays[i * 2 + 1]);
+
+	std::uniform_real_distribution<float> step(-0.3f, 0.3f);
+
+	size_t hitsLinear = 0, hitsTree = 0;
+	double msLinear = 0.0, msTree = 0.0, msMove = 0.0;
+
+	const size_t raysPerFrame = kBenchmarkRayCount / kBenchmarkFrames;
+
+	for (size_t frame = 0; frame < kBenchmarkFrames; frame++) {
+		// Every tenth box wanders around a bit
+		for (size_t i = frame % 10; i < boxes.size(); i += 10) {
+			const float d[3] = { step(random), step(random), 0.0f };
+
+			for (int j = 0; j < 3; j++) {
+				boxes[i].min[j] += d[j];
+				boxes[i].max[j] += d[j];
+			}
+		}
+
+		msMove += benchmarkTime([&]() {
+			for (size_t i = frame % 10; i < boxes.size(); i += 10)
+				tree.move(boxes[i].leaf, boxes[i].min, boxes[i].max);
+		});
+
+		const glm::vec3 *ray = &rays[frame * raysPerFrame * 2];
+
+		msLinear += benchmarkTime([&]() {
+			for (size_t i = 0; i < raysPerFrame; i++)
+				hitsLinear += findClosest(boxes, ray[i * 2], ray[i * 2 + 1]) ? 1 : 0;
+		});
+
+		msTree += benchmarkTime([&]() {
+			for (size_t i = 0; i < raysPerFrame; i++)
+				hitsTree += tree.rayCast(ray[i * 2], ray[i * 2 + 1], acceptAll) ? 1 : 0;
+		});
+	}
+
+	EXPECT_EQ(hitsTree, hitsLinear);
+
+	benchmarkPrint("%u boxes, %u rays: linear %.2f ms, tree %.2f ms (+ %.2f ms moving), tree height %u",
+	               (uint)kBenchmarkBoxCount, (uint)(raysPerFrame * kBenchmarkFrames), msLinear, msTree, msMove,
+	               (uint)tree.getHeight());
+}
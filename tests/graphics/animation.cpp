@@ -0,0 +1,191 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for the keyframe interpolation of animations.
+ *
+ *  The benchmark only runs when requested. It plays a long animation
+ *  forward in small steps, once without a cursor (searching the keyframes
+ *  from the start, as a fresh cursor would) and once with a cursor kept
+ *  from one step to the next.
+ */
+
+#include <cmath>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "tests/benchmark.h"
+
+#include "external/glm/geometric.hpp"
+#include "external/glm/gtc/quaternion.hpp"
+
+#include "src/common/util.h"
+
+#include "src/graphics/aurora/modelnode.h"
+#include "src/graphics/aurora/animation.h"
+
+using Graphics::Aurora::Animation;
+using Graphics::Aurora::PositionKeyFrame;
+using Graphics::Aurora::QuaternionKeyFrame;
+
+static const size_t kBenchmarkFrameCount = 2000;
+static const size_t kBenchmarkSteps      = 100000;
+
+static std::vector<PositionKeyFrame> createPositions(size_t count) {
+	std::vector<PositionKeyFrame> frames(count);
+
+	// x follows the time, y goes up and down
+	for (size_t i = 0; i < count; i++) {
+		frames[i].time = i * 0.5f;
+		frames[i].x    = i * 2.0f;
+		frames[i].y    = (i % 2) ? 1.0f : -1.0f;
+		frames[i].z    = 0.0f;
+	}
+
+	return frames;
+}
+
+GTEST_TEST(Animation, positionSingle) {
+	std::vector<PositionKeyFrame> frames = createPositions(1);
+
+	size_t frame = 0;
+	EXPECT_EQ(Animation::interpolatePosition(frames, 5.0f, frame), glm::vec3(0.0f, -1.0f, 0.0f));
+}
+
+GTEST_TEST(Animation, positionClamp) {
+	std::vector<PositionKeyFrame> frames = createPositions(4);
+	for (size_t i = 0; i < frames.size(); i++)
+		frames[i].time += 1.0f;
+
+	size_t frame = 0;
+	EXPECT_EQ(Animation::interpolatePosition(frames, 0.0f, frame), glm::vec3(0.0f, -1.0f, 0.0f));
+	EXPECT_EQ(frame, 0U);
+
+	EXPECT_EQ(Animation::interpolatePosition(frames, 10.0f, frame), glm::vec3(6.0f, 1.0f, 0.0f));
+	EXPECT_EQ(frame, 3U);
+}
+
+GTEST_TEST(Animation, positionForward) {
+	std::vector<PositionKeyFrame> frames = createPositions(16);
+
+	size_t frame = 0;
+	for (float time = 0.0f; time < 7.5f; time += 0.125f) {
+		const glm::vec3 pos = Animation::interpolatePosition(frames, time, frame);
+
+		EXPECT_FLOAT_EQ(pos.x, time * 4.0f) << "At time " << time;
+		EXPECT_LE(frames[frame].time, time);
+		EXPECT_GE(frames[frame + 1].time, time);
+	}
+}
+
+GTEST_TEST(Animation, positionSeek) {
+	std::vector<PositionKeyFrame> frames = createPositions(64);
+
+	// Jumping ahead, then back to the start, as when the animation loops
+	const float times[] = { 1.0f, 20.25f, 20.5f, 0.0f, 0.1f, 31.0f, 3.3f };
+
+	size_t frame = 0;
+	for (size_t i = 0; i < ARRAYSIZE(times); i++) {
+		size_t fresh = 0;
+
+		const glm::vec3 pos = Animation::interpolatePosition(frames, times[i], frame);
+
+		EXPECT_EQ(pos, Animation::interpolatePosition(frames, times[i], fresh)) << "At time " << times[i];
+		EXPECT_EQ(frame, fresh) << "At time " << times[i];
+		EXPECT_FLOAT_EQ(pos.x, times[i] * 4.0f) << "At time " << times[i];
+	}
+}
+
+GTEST_TEST(Animation, orientationFlip) {
+	std::vector<QuaternionKeyFrame> frames(2);
+
+	// The same orientation, once as q and once as -q
+	frames[0].time = 0.0f;
+	frames[0].x    = 0.0f;
+	frames[0].y    = 0.0f;
+	frames[0].z    = std::sin(0.25f);
+	frames[0].q    = std::cos(0.25f);
+
+	frames[1].time = 1.0f;
+	frames[1].x    = -frames[0].x;
+	frames[1].y    = -frames[0].y;
+	frames[1].z    = -frames[0].z;
+	frames[1].q    = -frames[0].q;
+
+	size_t frame = 0;
+	const glm::quat ori = Animation::interpolateOrientation(frames, 0.5f, frame);
+
+	EXPECT_NEAR(ori.x, frames[0].x, 0.0001f);
+	EXPECT_NEAR(ori.y, frames[0].y, 0.0001f);
+	EXPECT_NEAR(ori.z, frames[0].z, 0.0001f);
+	EXPECT_NEAR(ori.w, frames[0].q, 0.0001f);
+}
+
+GTEST_TEST(Animation, orientationNormalized) {
+	std::vector<QuaternionKeyFrame> frames(2);
+
+	frames[0].time = 0.0f;
+	frames[0].x    = 1.0f;
+	frames[0].y    = 0.0f;
+	frames[0].z    = 0.0f;
+	frames[0].q    = 0.0f;
+
+	frames[1].time = 1.0f;
+	frames[1].x    = 0.0f;
+	frames[1].y    = 0.0f;
+	frames[1].z    = 0.0f;
+	frames[1].q    = 1.0f;
+
+	size_t frame = 0;
+	for (float time = 0.0f; time <= 1.0f; time += 0.1f) {
+		const glm::quat ori = Animation::interpolateOrientation(frames, time, frame);
+
+		EXPECT_NEAR(glm::length(ori), 1.0f, 0.0001f) << "At time " << time;
+	}
+}
+
+GTEST_TEST(Animation, DISABLED_benchmark) {
+	std::vector<PositionKeyFrame> frames = createPositions(kBenchmarkFrameCount);
+
+	const float step = (frames.back().time - frames.front().time) / kBenchmarkSteps;
+
+	float sumSearch = 0.0f, sumCursor = 0.0f;
+
+	const double msSearch = benchmarkTime([&]() {
+		for (size_t i = 0; i < kBenchmarkSteps; i++) {
+			size_t frame = 0;
+			sumSearch += Animation::interpolatePosition(frames, i * step, frame).x;
+		}
+	});
+
+	const double msCursor = benchmarkTime([&]() {
+		size_t frame = 0;
+		for (size_t i = 0; i < kBenchmarkSteps; i++)
+			sumCursor += Animation::interpolatePosition(frames, i * step, frame).x;
+	});
+
+	EXPECT_FLOAT_EQ(sumCursor, sumSearch);
+
+	benchmarkPrint("%u steps over %u keyframes", (uint)kBenchmarkSteps, (uint)kBenchmarkFrameCount);
+	benchmarkPrint("Search: %.2f ms (%.1f ns/step)", msSearch, (msSearch * 1000000.0) / kBenchmarkSteps);
+	benchmarkPrint("Cursor: %.2f ms (%.1f ns/step)", msCursor, (msCursor * 1000000.0) / kBenchmarkSteps);
+}
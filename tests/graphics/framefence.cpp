@@ -0,0 +1,117 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the Graphics::FrameFence class.
+ */
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "gtest/gtest.h"
+
+#include "src/graphics/framefence.h"
+
+using Graphics::FrameFence;
+
+/** Signal frames every millisecond until told to stop. */
+static void renderFrames(FrameFence &fence, std::atomic<bool> &stop) {
+	while (!stop.load()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		fence.signal();
+	}
+}
+
+GTEST_TEST(FrameFence, wait) {
+	FrameFence fence;
+
+	std::atomic<bool> stop(false);
+	std::thread render(renderFrames, std::ref(fence), std::ref(stop));
+
+	for (int i = 0; i < 20; i++)
+		EXPECT_TRUE(fence.wait());
+
+	stop.store(true);
+	render.join();
+
+	const FrameFence::Stats stats = fence.getStats();
+
+	EXPECT_EQ(stats.waits, 20U);
+	EXPECT_LE(stats.sleeps, stats.waits);
+	EXPECT_LE(stats.maxTime, stats.totalTime);
+}
+
+GTEST_TEST(FrameFence, waitForNextFrame) {
+	FrameFence fence;
+
+	// Frames that ended before the wait started don't count
+	fence.signal();
+	fence.signal();
+
+	int polls = 0;
+	EXPECT_FALSE(fence.wait([&polls]() { return ++polls > 2; }));
+	EXPECT_EQ(polls, 3);
+
+	const FrameFence::Stats stats = fence.getStats();
+
+	EXPECT_EQ(stats.waits , 1U);
+	EXPECT_EQ(stats.sleeps, 1U);
+}
+
+GTEST_TEST(FrameFence, wakeSleepers) {
+	FrameFence fence;
+
+	std::atomic<int> woken(0);
+
+	std::thread waiters[4];
+	for (size_t i = 0; i < 4; i++)
+		waiters[i] = std::thread([&fence, &woken]() {
+			if (fence.wait())
+				woken++;
+		});
+
+	// Give them time to start sleeping
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	fence.signal();
+
+	for (size_t i = 0; i < 4; i++)
+		waiters[i].join();
+
+	EXPECT_EQ(woken.load(), 4);
+	EXPECT_EQ(fence.getStats().sleeps, 4U);
+}
+
+GTEST_TEST(FrameFence, resetStats) {
+	FrameFence fence;
+
+	EXPECT_FALSE(fence.wait([]() { return true; }));
+	EXPECT_EQ(fence.getStats().waits, 1U);
+
+	fence.resetStats();
+
+	const FrameFence::Stats stats = fence.getStats();
+
+	EXPECT_EQ(stats.waits    , 0U);
+	EXPECT_EQ(stats.sleeps   , 0U);
+	EXPECT_EQ(stats.totalTime, 0U);
+	EXPECT_EQ(stats.maxTime  , 0U);
+}
@@ -0,0 +1,116 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the Graphics::Frustum class.
+ */
+
+#include "gtest/gtest.h"
+
+#include "external/glm/mat4x4.hpp"
+#include "external/glm/gtc/matrix_transform.hpp"
+
+#include "src/common/boundingbox.h"
+
+#include "src/graphics/frustum.h"
+
+static Graphics::Frustum makeFrustum() {
+	// Looking down the negative Z axis, seeing from 1 to 100 units far
+	const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f);
+
+	Graphics::Frustum frustum;
+	frustum.set(projection);
+
+	return frustum;
+}
+
+static bool isBoxVisible(const Graphics::Frustum &frustum, float x, float y, float z, float size) {
+	const float min[3] = { x - size, y - size, z - size };
+	const float max[3] = { x + size, y + size, z + size };
+
+	return frustum.isVisible(min, max);
+}
+
+GTEST_TEST(Frustum, empty) {
+	Graphics::Frustum frustum;
+
+	EXPECT_TRUE(isBoxVisible(frustum,    0.0f, 0.0f,   10.0f, 1.0f));
+	EXPECT_TRUE(isBoxVisible(frustum, 1000.0f, 0.0f, -500.0f, 1.0f));
+}
+
+GTEST_TEST(Frustum, inside) {
+	const Graphics::Frustum frustum = makeFrustum();
+
+	EXPECT_TRUE(isBoxVisible(frustum,  0.0f,  0.0f, -10.0f,  1.0f));
+	EXPECT_TRUE(isBoxVisible(frustum,  8.0f, -8.0f, -10.0f,  1.0f));
+	EXPECT_TRUE(isBoxVisible(frustum,  0.0f,  0.0f, -50.0f, 60.0f));
+}
+
+GTEST_TEST(Frustum, outside) {
+	const Graphics::Frustum frustum = makeFrustum();
+
+	// Behind the camera
+	EXPECT_FALSE(isBoxVisible(frustum,   0.0f,   0.0f,   10.0f, 1.0f));
+	// Left, right, below, above
+	EXPECT_FALSE(isBoxVisible(frustum, -20.0f,   0.0f, -10.0f, 1.0f));
+	EXPECT_FALSE(isBoxVisible(frustum,  20.0f,   0.0f, -10.0f, 1.0f));
+	EXPECT_FALSE(isBoxVisible(frustum,   0.0f, -20.0f, -10.0f, 1.0f));
+	EXPECT_FALSE(isBoxVisible(frustum,   0.0f,  20.0f, -10.0f, 1.0f));
+	// Too close and too far away
+	EXPECT_FALSE(isBoxVisible(frustum,   0.0f,   0.0f,  -0.5f, 0.2f));
+	EXPECT_FALSE(isBoxVisible(frustum,   0.0f,   0.0f, -200.0f, 1.0f));
+}
+
+GTEST_TEST(Frustum, intersecting) {
+	const Graphics::Frustum frustum = makeFrustum();
+
+	// Straddling the left plane and the far plane
+	EXPECT_TRUE(isBoxVisible(frustum, -11.0f, 0.0f,  -10.0f, 1.5f));
+	EXPECT_TRUE(isBoxVisible(frustum,   0.0f, 0.0f, -100.0f, 1.0f));
+}
+
+GTEST_TEST(Frustum, view) {
+	// Camera at (0, 0, 50), looking along the positive Y axis
+	const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f);
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 50.0f), glm::vec3(0.0f, 1.0f, 50.0f),
+	                                   glm::vec3(0.0f, 0.0f, 1.0f));
+
+	Graphics::Frustum frustum;
+	frustum.set(projection * view);
+
+	EXPECT_TRUE (isBoxVisible(frustum, 0.0f,  10.0f, 50.0f, 1.0f));
+	EXPECT_FALSE(isBoxVisible(frustum, 0.0f, -10.0f, 50.0f, 1.0f));
+}
+
+GTEST_TEST(Frustum, boundingBox) {
+	const Graphics::Frustum frustum = makeFrustum();
+
+	Common::BoundingBox box;
+	EXPECT_TRUE(frustum.isVisible(box));
+
+	box.add(-1.0f, -1.0f, -11.0f);
+	box.add( 1.0f,  1.0f,  -9.0f);
+	box.absolutize();
+	EXPECT_TRUE(frustum.isVisible(box));
+
+	box.translate(0.0f, 0.0f, 20.0f);
+	box.absolutize();
+	EXPECT_FALSE(frustum.isVisible(box));
+}
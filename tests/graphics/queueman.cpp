@@ -0,0 +1,292 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for the graphics queue manager.
+ *
+ *  The benchmark, off unless requested, moves a lot of objects around a
+ *  bit every frame, like a moving camera does, and compares sorting the
+ *  queue by distance with sorting a std::list of the same objects.
+ */
+
+#include <list>
+#include <vector>
+#include <memory>
+#include <random>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "tests/benchmark.h"
+
+#include "src/graphics/queueman.h"
+#include "src/graphics/queueable.h"
+
+using Graphics::QueueManager;
+
+static const Graphics::QueueType kQueue = Graphics::kQueueVisibleWorldObject;
+
+static const size_t kBenchmarkObjectCount = 5000;
+static const size_t kBenchmarkFrames      = 100;
+
+class TestObject : public Graphics::Queueable {
+public:
+	float distance;
+
+	TestObject(float d = 0.0f) : distance(d) {
+	}
+
+	bool operator<(const Graphics::Queueable &q) const {
+		return distance < static_cast<const TestObject &>(q).distance;
+	}
+
+	void add() {
+		addToQueue(kQueue);
+	}
+
+	void remove() {
+		removeFromQueue(kQueue);
+	}
+
+	void sort() {
+		sortQueue(kQueue);
+	}
+
+	bool isQueued() const {
+		return isInQueue(kQueue);
+	}
+};
+
+/** Return the objects in the queue, skipping the slots of removed objects. */
+static std::vector<TestObject *> getObjects() {
+	std::vector<TestObject *> objects;
+
+	QueueMan.lockQueue(kQueue);
+
+	const std::vector<Graphics::Queueable *> &queue = QueueMan.getQueue(kQueue);
+	for (size_t i = 0; i < queue.size(); i++)
+		if (queue[i])
+			objects.push_back(static_cast<TestObject *>(queue[i]));
+
+	QueueMan.unlockQueue(kQueue);
+
+	return objects;
+}
+
+GTEST_TEST(QueueManager, addRemove) {
+	TestObject a, b, c;
+
+	EXPECT_TRUE(QueueMan.isQueueEmpty(kQueue));
+
+	a.add();
+	b.add();
+	c.add();
+
+	EXPECT_FALSE(QueueMan.isQueueEmpty(kQueue));
+	EXPECT_TRUE(b.isQueued());
+
+	b.remove();
+	EXPECT_FALSE(b.isQueued());
+
+	const std::vector<TestObject *> objects = getObjects();
+	ASSERT_EQ(objects.size(), 2U);
+	EXPECT_EQ(objects[0], &a);
+	EXPECT_EQ(objects[1], &c);
+
+	a.remove();
+	c.remove();
+
+	EXPECT_TRUE(QueueMan.isQueueEmpty(kQueue));
+}
+
+GTEST_TEST(QueueManager, removeWhileLocked) {
+	TestObject a, b, c;
+
+	a.add();
+	b.add();
+	c.add();
+
+	QueueMan.lockQueue(kQueue);
+
+	// Removing objects leaves their slot empty, so that iterating the queue stays safe
+	b.remove();
+
+	const std::vector<Graphics::Queueable *> &queue = QueueMan.getQueue(kQueue);
+	ASSERT_EQ(queue.size(), 3U);
+	EXPECT_EQ(queue[0], &a);
+	EXPECT_EQ(queue[1], nullptr);
+	EXPECT_EQ(queue[2], &c);
+
+	QueueMan.unlockQueue(kQueue);
+
+	// The empty slots are cleaned up eventually
+	a.remove();
+
+	QueueMan.lockQueue(kQueue);
+	EXPECT_EQ(QueueMan.getQueue(kQueue).size(), 1U);
+	QueueMan.unlockQueue(kQueue);
+
+	// The remaining object can still remove itself
+	c.remove();
+	EXPECT_TRUE(QueueMan.isQueueEmpty(kQueue));
+}
+
+GTEST_TEST(QueueManager, destroy) {
+	TestObject a;
+	a.add();
+
+	{
+		TestObject b;
+		b.add();
+	}
+
+	const std::vector<TestObject *> objects = getObjects();
+	ASSERT_EQ(objects.size(), 1U);
+	EXPECT_EQ(objects[0], &a);
+}
+
+GTEST_TEST(QueueManager, sort) {
+	std::vector<std::unique_ptr<TestObject>> objects;
+	for (size_t i = 0; i < 100; i++) {
+		objects.emplace_back(std::make_unique<TestObject>(100.0f - i));
+		objects.back()->add();
+	}
+
+	objects[0]->sort();
+
+	std::vector<TestObject *> sorted = getObjects();
+	ASSERT_EQ(sorted.size(), 100U);
+
+	for (size_t i = 0; i < sorted.size(); i++)
+		EXPECT_EQ(sorted[i], objects[99 - i].get()) << "At index " << i;
+
+	// Removing an object after sorting removes the right one
+	objects[50]->remove();
+
+	sorted = getObjects();
+	ASSERT_EQ(sorted.size(), 99U);
+
+	for (size_t i = 0; i < sorted.size(); i++)
+		EXPECT_NE(sorted[i], objects[50].get()) << "At index " << i;
+}
+
+GTEST_TEST(QueueManager, sortNearlySorted) {
+	std::vector<std::unique_ptr<TestObject>> objects;
+	for (size_t i = 0; i < 100; i++) {
+		objects.emplace_back(std::make_unique<TestObject>(i));
+		objects.back()->add();
+	}
+
+	// Swap a few neighbours, and move one object to the back
+	objects[10]->distance = 11.5f;
+	objects[40]->distance = 39.5f;
+	objects[0]->distance  = 200.0f;
+
+	objects[0]->sort();
+
+	const std::vector<TestObject *> sorted = getObjects();
+	ASSERT_EQ(sorted.size(), 100U);
+
+	for (size_t i = 1; i < sorted.size(); i++)
+		EXPECT_LE(sorted[i - 1]->distance, sorted[i]->distance) << "At index " << i;
+
+	EXPECT_EQ(sorted.back(), objects[0].get());
+}
+
+GTEST_TEST(QueueManager, sortStable) {
+	TestObject a(1.0f), b(0.0f), c(1.0f), d(0.0f);
+
+	a.add();
+	b.add();
+	c.add();
+	d.add();
+
+	a.sort();
+
+	const std::vector<TestObject *> sorted = getObjects();
+	ASSERT_EQ(sorted.size(), 4U);
+	EXPECT_EQ(sorted[0], &b);
+	EXPECT_EQ(sorted[1], &d);
+	EXPECT_EQ(sorted[2], &a);
+	EXPECT_EQ(sorted[3], &c);
+}
+
+GTEST_TEST(QueueManager, clear) {
+	TestObject a, b;
+
+	a.add();
+	b.add();
+
+	QueueMan.clearQueue(kQueue);
+
+	EXPECT_TRUE(QueueMan.isQueueEmpty(kQueue));
+	EXPECT_FALSE(a.isQueued());
+	EXPECT_FALSE(b.isQueued());
+
+	// The objects can be queued again
+	a.add();
+	EXPECT_TRUE(a.isQueued());
+}
+
+static bool compareObjects(const TestObject *a, const TestObject *b) {
+	return *a < *b;
+}
+
+GTEST_TEST(QueueManager, DISABLED_benchmark) {
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+	std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+
+	std::vector<std::unique_ptr<TestObject>> objects;
+	for (size_t i = 0; i < kBenchmarkObjectCount; i++)
+		objects.emplace_back(std::make_unique<TestObject>(position(random)));
+
+	std::list<TestObject *> list;
+	for (size_t i = 0; i < objects.size(); i++) {
+		list.push_back(objects[i].get());
+		objects[i]->add();
+	}
+
+	// Collect the distances of all frames up front, each changed a bit from the last
+	std::vector<float> distances;
+	distances.reserve(kBenchmarkObjectCount * kBenchmarkFrames);
+	for (size_t i = 0; i < objects.size(); i++)
+		distances.push_back(objects[i]->distance);
+
+	for (size_t frame = 1; frame < kBenchmarkFrames; frame++)
+		for (size_t i = 0; i < objects.size(); i++)
+			distances.push_back(distances[(frame - 1) * objects.size() + i] + jitter(random));
+
+	double msList = 0.0, msQueue = 0.0;
+	for (size_t frame = 0; frame < kBenchmarkFrames; frame++) {
+		for (size_t i = 0; i < objects.size(); i++)
+			objects[i]->distance = distances[frame * objects.size() + i];
+
+		msList  += benchmarkTime([&list]() { list.sort(compareObjects); });
+		msQueue += benchmarkTime([&objects]() { objects[0]->sort(); });
+	}
+
+	const std::vector<TestObject *> sorted = getObjects();
+	ASSERT_EQ(sorted.size(), list.size());
+	EXPECT_TRUE(std::equal(sorted.begin(), sorted.end(), list.begin()));
+
+	benchmarkPrint("%u objects over %u frames: std::list::sort() %.2f ms, sortQueue() %.2f ms",
+	               (uint)kBenchmarkObjectCount, (uint)kBenchmarkFrames, msList, msQueue);
+}
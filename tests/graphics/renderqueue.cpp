@@ -0,0 +1,241 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for the sorting of the render queue.
+ *
+ *  The benchmark queues a scene of instanced meshes, a few shader programs
+ *  and a lot of materials and surfaces, and compares the sort by sort keys
+ *  with a std::sort over the queued items. Normal test runs leave it out.
+ */
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "tests/benchmark.h"
+
+#include "external/glm/mat4x4.hpp"
+#include "external/glm/gtc/matrix_transform.hpp"
+
+#include "src/common/util.h"
+
+#include "src/graphics/mesh/mesh.h"
+
+#include "src/graphics/shader/shader.h"
+#include "src/graphics/shader/shadermaterial.h"
+#include "src/graphics/shader/shadersurface.h"
+
+#include "src/graphics/render/renderqueue.h"
+
+using Graphics::Render::RenderQueue;
+
+static const size_t kBenchmarkProgramCount  = 16;
+static const size_t kBenchmarkMaterialCount = 400;
+static const size_t kBenchmarkSurfaceCount  = 200;
+static const size_t kBenchmarkMeshCount     = 2000;
+static const size_t kBenchmarkItemCount     = 50000;
+static const size_t kBenchmarkIterations    = 20;
+
+/** The shader objects of a scene, without any OpenGL state. */
+struct Scene {
+	Graphics::Shader::ShaderObject vertexShader;
+	Graphics::Shader::ShaderObject fragmentShader;
+
+	std::vector<std::unique_ptr<Graphics::Shader::ShaderProgram>>  programs;
+	std::vector<std::unique_ptr<Graphics::Shader::ShaderMaterial>> materials;
+	std::vector<std::unique_ptr<Graphics::Shader::ShaderSurface>>  surfaces;
+	std::vector<std::unique_ptr<Graphics::Mesh::Mesh>>             meshes;
+
+	std::vector<glm::mat4> transforms;
+
+	Scene(size_t programCount, size_t materialCount, size_t surfaceCount, size_t meshCount) {
+		for (size_t i = 0; i < programCount; i++) {
+			programs.emplace_back(new Graphics::Shader::ShaderProgram);
+			programs.back()->glid = i + 1;
+		}
+
+		for (size_t i = 0; i < materialCount; i++)
+			materials.emplace_back(new Graphics::Shader::ShaderMaterial(&fragmentShader));
+		for (size_t i = 0; i < surfaceCount; i++)
+			surfaces.emplace_back(new Graphics::Shader::ShaderSurface(&vertexShader));
+		for (size_t i = 0; i < meshCount; i++)
+			meshes.emplace_back(new Graphics::Mesh::Mesh);
+	}
+
+	const glm::mat4 *addTransform(float x, float y, float z) {
+		transforms.push_back(glm::translate(glm::mat4(), glm::vec3(x, y, z)));
+		return &transforms.back();
+	}
+};
+
+GTEST_TEST(RenderQueue, sortShader) {
+	Scene scene(3, 4, 1, 6);
+	scene.transforms.reserve(60);
+
+	RenderQueue queue;
+
+	std::mt19937 random(1234);
+	std::uniform_int_distribution<size_t> program(0, 2), material(0, 3), mesh(0, 5);
+
+	std::vector<std::vector<size_t>> combinations;
+
+	for (size_t i = 0; i < 60; i++) {
+		const std::vector<size_t> combination = { program(random), material(random), mesh(random) };
+		combinations.push_back(combination);
+
+		queue.queueItem(scene.programs[combination[0]].get(), scene.surfaces[0].get(),
+		                scene.materials[combination[1]].get(), scene.meshes[combination[2]].get(),
+		                scene.addTransform(i, 0.0f, 0.0f), 1.0f);
+	}
+
+	/* When the items are grouped, each program is bound once, together with
+	 * the surface. Each material is bound once per program, and each mesh
+	 * once per program and material. */
+	std::sort(combinations.begin(), combinations.end());
+
+	uint32_t expected = 0;
+	for (size_t i = 0; i < combinations.size(); i++) {
+		if ((i == 0) || (combinations[i][0] != combinations[i - 1][0]))
+			expected += 4;
+		else if (combinations[i][1] != combinations[i - 1][1])
+			expected += 2;
+		else if (combinations[i][2] != combinations[i - 1][2])
+			expected += 1;
+	}
+
+	EXPECT_GT(queue.getStateChanges(), expected);
+
+	queue.sortShader();
+
+	EXPECT_EQ(queue.getStateChanges(), expected);
+}
+
+GTEST_TEST(RenderQueue, sortDepth) {
+	Scene scene(2, 1, 1, 3);
+	scene.transforms.reserve(3);
+
+	RenderQueue queue;
+
+	// Near and far use the first program, the one in the middle the second
+	queue.queueItem(scene.programs[0].get(), scene.surfaces[0].get(), scene.materials[0].get(),
+	                scene.meshes[0].get(), scene.addTransform(1.0f, 0.0f, 0.0f), 1.0f);
+	queue.queueItem(scene.programs[0].get(), scene.surfaces[0].get(), scene.materials[0].get(),
+	                scene.meshes[1].get(), scene.addTransform(0.0f, 0.0f, 30.0f), 1.0f);
+	queue.queueItem(scene.programs[1].get(), scene.surfaces[0].get(), scene.materials[0].get(),
+	                scene.meshes[2].get(), scene.addTransform(0.0f, -5.0f, 0.0f), 1.0f);
+
+	EXPECT_EQ(queue.getStateChanges(), 9U);
+
+	// Sorted by depth, the programs alternate
+	queue.sortDepth();
+
+	EXPECT_EQ(queue.getStateChanges(), 12U);
+
+	// Sorted by shader, the first program is only bound once
+	queue.sortShader();
+
+	EXPECT_EQ(queue.getStateChanges(), 9U);
+}
+
+/** Sort the way the render queue used to, comparing the pointers. */
+static bool compareShader(const RenderQueue::RenderQueueNode &a, const RenderQueue::RenderQueueNode &b) {
+	if (a.program != b.program)
+		return a.program > b.program;
+	if (a.material != b.material)
+		return a.material > b.material;
+
+	return a.mesh > b.mesh;
+}
+
+GTEST_TEST(RenderQueue, DISABLED_benchmark) {
+	Scene scene(kBenchmarkProgramCount, kBenchmarkMaterialCount, kBenchmarkSurfaceCount, kBenchmarkMeshCount);
+	scene.transforms.reserve(kBenchmarkItemCount);
+
+	std::mt19937 random(1234);
+
+	/* Each mesh always uses the same program, material and surface. A few
+	 * programs and meshes are used a lot more often than the others. */
+	std::geometric_distribution<size_t> program(0.3), mesh(0.002);
+	std::uniform_int_distribution<size_t> material(0, kBenchmarkMaterialCount - 1);
+	std::uniform_int_distribution<size_t> surface(0, kBenchmarkSurfaceCount - 1);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+
+	std::vector<RenderQueue::RenderQueueNode> items;
+	std::vector<RenderQueue::RenderQueueNode> meshStates;
+
+	for (size_t i = 0; i < kBenchmarkMeshCount; i++)
+		meshStates.push_back(RenderQueue::RenderQueueNode(scene.programs[MIN(program(random), kBenchmarkProgramCount - 1)].get(),
+		                                                  scene.surfaces[surface(random)].get(),
+		                                                  scene.materials[material(random)].get(),
+		                                                  scene.meshes[i].get(), 0));
+
+	for (size_t i = 0; i < kBenchmarkItemCount; i++) {
+		RenderQueue::RenderQueueNode item = meshStates[MIN(mesh(random), kBenchmarkMeshCount - 1)];
+		item.transform = scene.addTransform(position(random), position(random), position(random));
+
+		items.push_back(item);
+	}
+
+	RenderQueue queue(kBenchmarkItemCount);
+
+	const auto queueItems = [&queue](const std::vector<RenderQueue::RenderQueueNode> &nodes) {
+		queue.clear();
+		for (const auto &n : nodes)
+			queue.queueItem(n.program, n.surface, n.material, n.mesh, n.transform, n.alpha);
+	};
+
+	queueItems(items);
+	const uint32_t changesUnsorted = queue.getStateChanges();
+
+	// Sorting a copy of the items with std::sort, the way the queue used to
+	double msStdSort = 0.0;
+	std::vector<RenderQueue::RenderQueueNode> sorted;
+	for (size_t i = 0; i < kBenchmarkIterations; i++) {
+		sorted = items;
+
+		msStdSort += benchmarkTime([&sorted]() { std::sort(sorted.begin(), sorted.end(), compareShader); });
+	}
+
+	queueItems(sorted);
+	const uint32_t changesStdSort = queue.getStateChanges();
+
+	// Sorting by sort keys
+	double msSortKeys = 0.0;
+	for (size_t i = 0; i < kBenchmarkIterations; i++) {
+		queueItems(items);
+
+		msSortKeys += benchmarkTime([&queue]() { queue.sortShader(); });
+	}
+
+	const uint32_t changesSortKeys = queue.getStateChanges();
+
+	EXPECT_LT(changesSortKeys, changesUnsorted);
+
+	benchmarkPrint("%u items, %u meshes, %u programs, %u materials, %u surfaces",
+	               (uint)kBenchmarkItemCount, (uint)kBenchmarkMeshCount, (uint)kBenchmarkProgramCount,
+	               (uint)kBenchmarkMaterialCount, (uint)kBenchmarkSurfaceCount);
+	benchmarkPrint("Unsorted:  %u state changes", changesUnsorted);
+	benchmarkPrint("std::sort: %.2f ms per sort, %u state changes", msStdSort / kBenchmarkIterations, changesStdSort);
+	benchmarkPrint("Sort keys: %.2f ms per sort, %u state changes", msSortKeys / kBenchmarkIterations, changesSortKeys);
+}
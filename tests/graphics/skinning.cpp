@@ -0,0 +1,205 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for our vertex skinning.
+ *
+ *  The benchmark is skipped unless explicitly asked for. It pits the
+ *  per-bone reference blend against the scalar and the default kernel.
+ */
+
+#include <cmath>
+
+#include <vector>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "tests/benchmark.h"
+
+#include "external/glm/mat4x4.hpp"
+#include "external/glm/gtc/type_ptr.hpp"
+#include "external/glm/gtc/matrix_transform.hpp"
+
+#include "src/common/util.h"
+
+#include "src/graphics/skinning.h"
+
+static const size_t kBonesPerVertex = 4;
+
+static const size_t kBenchmarkVertexCount = 5000;
+static const size_t kBenchmarkBoneCount   = 40;
+static const size_t kBenchmarkIterations  = 200;
+
+struct SkinningData {
+	std::vector<float> coords;
+	std::vector<float> boneIndices;
+	std::vector<float> boneWeights;
+
+	std::vector<glm::mat4> bones;
+};
+
+static void createData(SkinningData &data, size_t vertexCount, size_t boneCount) {
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-2.0f, 2.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+	std::uniform_int_distribution<int> bone(-1, boneCount - 1);
+
+	for (size_t i = 0; i < vertexCount * 3; i++)
+		data.coords.push_back(position(random));
+
+	for (size_t i = 0; i < vertexCount; i++) {
+		for (size_t j = 0; j < kBonesPerVertex; j++) {
+			data.boneIndices.push_back(bone(random));
+			data.boneWeights.push_back(1.0f / kBonesPerVertex);
+		}
+	}
+
+	for (size_t i = 0; i < boneCount; i++) {
+		glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+		m = glm::rotate(m, angle(random), glm::normalize(glm::vec3(0.3f, position(random), 1.0f)));
+		m = glm::scale(m, glm::vec3(1.5f, 1.0f, 0.5f));
+
+		data.bones.push_back(m);
+	}
+}
+
+/** Blend the transformed vertices, the way SkeletalAnimation used to. */
+static void skinReference(const SkinningData &data, std::vector<float> &out) {
+	const size_t vertexCount = data.coords.size() / 3;
+
+	out.assign(vertexCount * 3, 0.0f);
+	for (size_t i = 0; i < vertexCount; i++) {
+		const glm::vec4 v(data.coords[i * 3 + 0], data.coords[i * 3 + 1], data.coords[i * 3 + 2], 1.0f);
+
+		for (size_t j = 0; j < kBonesPerVertex; j++) {
+			const int bone = static_cast<int>(data.boneIndices[i * kBonesPerVertex + j]);
+			if (bone == -1)
+				continue;
+
+			const glm::vec4 t = data.bones[bone] * v;
+			const float weight = data.boneWeights[i * kBonesPerVertex + j];
+
+			out[i * 3 + 0] += t.x * weight;
+			out[i * 3 + 1] += t.y * weight;
+			out[i * 3 + 2] += t.z * weight;
+		}
+	}
+}
+
+GTEST_TEST(Skinning, prepare) {
+	SkinningData data;
+	createData(data, 2, 3);
+
+	data.boneIndices = { 0, 2, -1, -1,   -1, -1, -1, -1 };
+
+	Graphics::SkinningVertices vertices;
+	EXPECT_TRUE(vertices.empty());
+
+	vertices.set(data.coords, data.boneIndices, data.boneWeights, kBonesPerVertex);
+
+	EXPECT_FALSE(vertices.empty());
+	EXPECT_EQ(vertices.getVertexCount(), 2);
+	EXPECT_EQ(vertices.getBoneCount(), 3);
+
+	vertices.clear();
+
+	EXPECT_TRUE(vertices.empty());
+	EXPECT_EQ(vertices.getVertexCount(), 0);
+	EXPECT_EQ(vertices.getBoneCount(), 0);
+}
+
+GTEST_TEST(Skinning, skin) {
+	SkinningData data;
+	createData(data, 1000, 20);
+
+	std::vector<float> reference;
+	skinReference(data, reference);
+
+	Graphics::SkinningVertices vertices;
+	vertices.set(data.coords, data.boneIndices, data.boneWeights, kBonesPerVertex);
+
+	std::vector<float> scalar(reference.size()), simd(reference.size());
+
+	vertices.skinScalar(glm::value_ptr(data.bones[0]), scalar.data(), 3);
+	vertices.skin(glm::value_ptr(data.bones[0]), simd.data(), 3);
+
+	for (size_t i = 0; i < reference.size(); i++) {
+		EXPECT_NEAR(scalar[i], reference[i], 1e-4f) << "At index " << i;
+		EXPECT_NEAR(simd[i]  , reference[i], 1e-4f) << "At index " << i;
+	}
+}
+
+GTEST_TEST(Skinning, stride) {
+	SkinningData data;
+	createData(data, 100, 10);
+
+	std::vector<float> reference;
+	skinReference(data, reference);
+
+	Graphics::SkinningVertices vertices;
+	vertices.set(data.coords, data.boneIndices, data.boneWeights, kBonesPerVertex);
+
+	// Interleaved with other vertex attributes, which must stay untouched
+	static const size_t kStride = 8;
+	std::vector<float> buffer(100 * kStride, 23.0f);
+
+	vertices.skin(glm::value_ptr(data.bones[0]), buffer.data(), kStride);
+
+	for (size_t i = 0; i < 100; i++) {
+		for (size_t j = 0; j < 3; j++)
+			EXPECT_NEAR(buffer[i * kStride + j], reference[i * 3 + j], 1e-4f) << "At index " << i;
+
+		for (size_t j = 3; j < kStride; j++)
+			EXPECT_EQ(buffer[i * kStride + j], 23.0f) << "At index " << i;
+	}
+}
+
+GTEST_TEST(Skinning, DISABLED_benchmark) {
+	SkinningData data;
+	createData(data, kBenchmarkVertexCount, kBenchmarkBoneCount);
+
+	Graphics::SkinningVertices vertices;
+	vertices.set(data.coords, data.boneIndices, data.boneWeights, kBonesPerVertex);
+
+	std::vector<float> out(kBenchmarkVertexCount * 3);
+
+	const double msReference = benchmarkTime([&]() {
+		for (size_t i = 0; i < kBenchmarkIterations; i++)
+			skinReference(data, out);
+	});
+
+	const double msScalar = benchmarkTime([&]() {
+		for (size_t i = 0; i < kBenchmarkIterations; i++)
+			vertices.skinScalar(glm::value_ptr(data.bones[0]), out.data(), 3);
+	});
+
+	const double msSkin = benchmarkTime([&]() {
+		for (size_t i = 0; i < kBenchmarkIterations; i++)
+			vertices.skin(glm::value_ptr(data.bones[0]), out.data(), 3);
+	});
+
+	const double vertexCount = kBenchmarkVertexCount * kBenchmarkIterations;
+
+	benchmarkPrint("Reference: %.2f ms (%.1f ns/vertex)", msReference, (msReference * 1000000.0) / vertexCount);
+	benchmarkPrint("Scalar:    %.2f ms (%.1f ns/vertex)", msScalar, (msScalar * 1000000.0) / vertexCount);
+	benchmarkPrint("%s %.2f ms (%.1f ns/vertex)", Graphics::SkinningVertices::isVectorized() ? "SSE2:     " : "Default:  ",
+	               msSkin, (msSkin * 1000000.0) / vertexCount);
+}
@@ -0,0 +1,151 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for decoding Graphics::Aurora::Texture images in the background.
+ */
+
+#include <memory>
+#include <future>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/platform.h"
+#include "src/common/writefile.h"
+#include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
+
+#include "src/aurora/resman.h"
+#include "src/aurora/erfwriter.h"
+
+#include "src/graphics/images/decoder.h"
+
+#include "src/graphics/aurora/texture.h"
+
+/** An uncompressed 4x2 TGA with alpha. */
+static const byte kTGA[18 + 4 * 2 * 4] = {
+	0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x04, 0x00, 0x02, 0x00, 0x20, 0x08,
+
+	0xFF, 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00,
+	0xFF, 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00
+};
+
+/** A TGA with a color map, which we don't support. */
+static const byte kBrokenTGA[18] = {
+	0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x04, 0x00, 0x02, 0x00, 0x08, 0x00
+};
+
+class AsyncTexture : public ::testing::Test {
+protected:
+	static boost::filesystem::path _basePath;
+
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		_basePath = boost::filesystem::temp_directory_path() /
+		            boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directory(_basePath);
+
+		Common::WriteFile file(_basePath.generic_string() + "/textures.erf");
+
+		Aurora::ERFWriter erf(MKTAG('E', 'R', 'F', ' '), 2, file);
+
+		Common::MemoryReadStream tga(kTGA, sizeof(kTGA));
+		Common::MemoryReadStream brokenTGA(kBrokenTGA, sizeof(kBrokenTGA));
+
+		erf.add("image" , Aurora::kFileTypeTGA, tga);
+		erf.add("broken", Aurora::kFileTypeTGA, brokenTGA);
+
+		file.flush();
+		file.close();
+	}
+
+	static void TearDownTestCase() {
+		ResMan.clear();
+
+		if (!_basePath.empty())
+			boost::filesystem::remove_all(_basePath);
+	}
+
+	void SetUp() {
+		ResMan.clear();
+		ResMan.registerDataBase(_basePath.generic_string());
+
+		ResMan.indexArchive("textures.erf", 100);
+	}
+};
+
+boost::filesystem::path AsyncTexture::_basePath;
+
+GTEST_TEST_F(AsyncTexture, decode) {
+	Common::ThreadPool pool(1);
+
+	// Keep the only worker busy, so that the decoding can't start yet
+	std::promise<void> go;
+	std::shared_future<void> goFuture = go.get_future().share();
+	pool.submit([goFuture]() { goFuture.wait(); });
+
+	std::unique_ptr<Graphics::Aurora::Texture> texture(Graphics::Aurora::Texture::createAsync("image", pool));
+
+	EXPECT_TRUE(texture->isLoading());
+	EXPECT_FALSE(texture->hasLoadingFailed());
+
+	go.set_value();
+
+	// Asking for the size waits for the decoding and then returns the real image's
+	EXPECT_EQ(texture->getWidth() , 4);
+	EXPECT_EQ(texture->getHeight(), 2);
+	EXPECT_TRUE(texture->hasAlpha());
+
+	EXPECT_FALSE(texture->isLoading());
+	EXPECT_FALSE(texture->hasLoadingFailed());
+
+	EXPECT_EQ(texture->getImage().getMipMap(0).width, 4);
+}
+
+GTEST_TEST_F(AsyncTexture, decodeFailed) {
+	Common::ThreadPool pool(1);
+
+	// Only the decoding happens in the background, so creating the texture still works
+	std::unique_ptr<Graphics::Aurora::Texture> texture;
+	ASSERT_NO_THROW(texture.reset(Graphics::Aurora::Texture::createAsync("broken", pool)));
+
+	pool.wait();
+
+	EXPECT_FALSE(texture->isLoading());
+	EXPECT_TRUE(texture->hasLoadingFailed());
+
+	// We're left with the 1x1 placeholder
+	EXPECT_EQ(texture->getWidth() , 1);
+	EXPECT_EQ(texture->getHeight(), 1);
+	EXPECT_EQ(texture->getImage().getMipMap(0).width, 1);
+}
+
+GTEST_TEST_F(AsyncTexture, missing) {
+	Common::ThreadPool pool(1);
+
+	EXPECT_THROW(Graphics::Aurora::Texture::createAsync("nope", pool), Common::Exception);
+}
@@ -0,0 +1,153 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the texture memory handling of Graphics::Aurora::TextureManager.
+ */
+
+#include "gtest/gtest.h"
+
+#include "src/common/threads.h"
+
+#include "src/graphics/images/surface.h"
+#include "src/graphics/images/cubemapcombiner.h"
+
+#include "src/graphics/aurora/texture.h"
+#include "src/graphics/aurora/textureman.h"
+
+/** A texture that pretends to be uploaded, without any OpenGL. */
+class FakeTexture : public Graphics::Aurora::Texture {
+public:
+	FakeTexture(size_t size) : Graphics::Aurora::Texture("", new Graphics::Surface(1, 1), ::Aurora::kFileTypeNone),
+		_size(size) {
+	}
+
+	~FakeTexture() {
+		doDestroy();
+	}
+
+protected:
+	void doRebuild() {
+		_textureID = 1;
+		setMemorySize(_size);
+	}
+
+	void doDestroy() {
+		_textureID = 0;
+		setMemorySize(0);
+	}
+
+private:
+	size_t _size;
+};
+
+class TextureMemory : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		if (!Common::initedThreads())
+			Common::initThreads();
+	}
+
+	void TearDown() {
+		TextureMan.clear();
+		TextureMan.setMemoryBudget(0);
+	}
+
+	/** Add a fake texture that's already uploaded. */
+	static Graphics::Aurora::TextureHandle add(const Common::UString &name, size_t size) {
+		FakeTexture *texture = new FakeTexture(size);
+		texture->rebuild();
+
+		return TextureMan.add(texture, name);
+	}
+};
+
+GTEST_TEST(TextureMemorySize, estimate) {
+	// A single mip map gets the rest generated by OpenGL
+	Graphics::Surface surface(4, 4);
+	EXPECT_EQ(Graphics::Aurora::Texture::estimateMemorySize(surface), 64 + 21);
+
+	Graphics::Surface bigSurface(16, 8);
+	EXPECT_EQ(Graphics::Aurora::Texture::estimateMemorySize(bigSurface), 512 + 170);
+
+	// Every side of a cube map counts
+	Graphics::ImageDecoder *sides[6];
+	for (size_t i = 0; i < 6; i++)
+		sides[i] = new Graphics::Surface(4, 4);
+
+	Graphics::CubeMapCombiner cubeMap(sides);
+	EXPECT_EQ(Graphics::Aurora::Texture::estimateMemorySize(cubeMap), 6 * 64 + 128);
+}
+
+GTEST_TEST_F(TextureMemory, noBudget) {
+	Graphics::Aurora::TextureHandle a = add("a", 100);
+	Graphics::Aurora::TextureHandle b = add("b", 100);
+
+	TextureMan.touch(a, 10000);
+
+	EXPECT_EQ(TextureMan.getMemoryStats().evictedCount, 0);
+	EXPECT_NE(b.getTexture().getID(), 0);
+}
+
+GTEST_TEST_F(TextureMemory, evictIdle) {
+	TextureMan.setMemoryBudget(150);
+
+	Graphics::Aurora::TextureHandle a = add("a", 100);
+	Graphics::Aurora::TextureHandle b = add("b", 100);
+
+	const size_t memorySize = Graphics::Aurora::Texture::getTotalMemorySize();
+
+	const Graphics::Aurora::TextureManager::MemoryStats startStats = TextureMan.getMemoryStats();
+
+	// Over budget, but nothing has been idle for long enough yet
+	TextureMan.touch(a, 100);
+	EXPECT_EQ(TextureMan.getMemoryStats().evictedCount, 0);
+
+	// Now b, which hasn't been used since it was added, gets evicted
+	TextureMan.touch(a, 1000);
+
+	Graphics::Aurora::TextureManager::MemoryStats stats = TextureMan.getMemoryStats();
+	EXPECT_EQ(stats.evictedCount, 1);
+	EXPECT_EQ(stats.evictions, startStats.evictions + 1);
+	EXPECT_EQ(stats.memorySize, memorySize - 100);
+
+	EXPECT_NE(a.getTexture().getID(), 0);
+	EXPECT_EQ(b.getTexture().getID(), 0);
+
+	// Using b again uploads it again
+	TextureMan.touch(b, 1010);
+
+	stats = TextureMan.getMemoryStats();
+	EXPECT_EQ(stats.evictedCount, 0);
+	EXPECT_EQ(stats.reuploads, startStats.reuploads + 1);
+	EXPECT_EQ(stats.memorySize, memorySize);
+
+	EXPECT_NE(b.getTexture().getID(), 0);
+
+	// And then a is the one that has been idle for too long
+	TextureMan.touch(b, 1400);
+
+	stats = TextureMan.getMemoryStats();
+	EXPECT_EQ(stats.evictedCount, 1);
+	EXPECT_EQ(stats.evictions, startStats.evictions + 2);
+
+	EXPECT_EQ(a.getTexture().getID(), 0);
+	EXPECT_NE(b.getTexture().getID(), 0);
+}
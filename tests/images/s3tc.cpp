@@ -0,0 +1,348 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests and a benchmark for our S3TC DXTn decompression.
+ *
+ *  The benchmark decodes large random DXT1 and DXT5 images, with the
+ *  original decoder reading through the stream API and the current one
+ *  working on memory, with and without a thread pool. Being slow, it
+ *  is only run when explicitly selected.
+ */
+
+#include <cstring>
+
+#include <vector>
+#include <random>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "tests/benchmark.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
+
+#include "src/graphics/images/s3tc.h"
+
+static const uint32_t kBenchmarkSize       = 1024;
+static const uint32_t kBenchmarkIterations = 5;
+
+// --- The original decoder, reading through the stream API, for comparison ---
+
+static inline uint32_t convert565To8888(uint16_t color) {
+	return ((color & 0x1F) << 11) | ((color & 0x7E0) << 13) | ((color & 0xF800) << 16) | 0xFF;
+}
+
+static inline uint32_t interpolate32(double weight, uint32_t color_0, uint32_t color_1) {
+	byte r[3], g[3], b[3], a[3];
+	r[0] = color_0 >> 24;
+	r[1] = color_1 >> 24;
+	r[2] = (byte)((1.0f - weight) * (double)r[0] + weight * (double)r[1]);
+	g[0] = (color_0 >> 16) & 0xFF;
+	g[1] = (color_1 >> 16) & 0xFF;
+	g[2] = (byte)((1.0f - weight) * (double)g[0] + weight * (double)g[1]);
+	b[0] = (color_0 >> 8) & 0xFF;
+	b[1] = (color_1 >> 8) & 0xFF;
+	b[2] = (byte)((1.0f - weight) * (double)b[0] + weight * (double)b[1]);
+	a[0] = color_0 & 0xFF;
+	a[1] = color_1 & 0xFF;
+	a[2] = (byte)((1.0f - weight) * (double)a[0] + weight * (double)a[1]);
+	return r[2] << 24 | g[2] << 16 | b[2] << 8 | a[2];
+}
+
+static void referenceDXT1(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
+	for (int32_t ty = height; ty > 0; ty -= 4) {
+		for (uint32_t tx = 0; tx < width; tx += 4) {
+			const uint16_t color_0 = src.readUint16LE();
+			const uint16_t color_1 = src.readUint16LE();
+			uint32_t cpx = src.readUint32BE();
+
+			uint32_t blended[4];
+			blended[0] = convert565To8888(color_0);
+			blended[1] = convert565To8888(color_1);
+
+			if (color_0 > color_1) {
+				blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
+				blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
+			} else {
+				blended[2] = interpolate32(0.5f, blended[0], blended[1]);
+				blended[3] = 0;
+			}
+
+			for (byte y = 0; y < 4; ++y) {
+				for (byte x = 0; x < 4; ++x) {
+					const uint32_t destY = height - 1 - (ty - 4 + y);
+
+					WRITE_BE_UINT32(dest + destY * pitch + (tx + x) * 4, blended[cpx & 3]);
+					cpx >>= 2;
+				}
+			}
+		}
+	}
+}
+
+static void referenceDXT5(byte *dest, Common::SeekableReadStream &src, uint32_t width, uint32_t height, uint32_t pitch) {
+	for (int32_t ty = height; ty > 0; ty -= 4) {
+		for (uint32_t tx = 0; tx < width; tx += 4) {
+			byte alphab[8];
+			alphab[0] = src.readByte();
+			alphab[1] = src.readByte();
+
+			uint64_t alphabl = src.readUint32LE();
+			alphabl |= ((uint64_t)src.readUint16LE() << 32);
+
+			const uint16_t color_0 = src.readUint16LE();
+			const uint16_t color_1 = src.readUint16LE();
+			uint32_t cpx = src.readUint32BE();
+
+			if (alphab[0] > alphab[1]) {
+				for (int i = 1; i < 7; i++)
+					alphab[1 + i] = (byte)(((7 - i) * (double)alphab[0] + i * (double)alphab[1] + 3.0f) / 7.0f);
+			} else {
+				for (int i = 1; i < 5; i++)
+					alphab[1 + i] = (byte)(((5 - i) * (double)alphab[0] + i * (double)alphab[1] + 2.0f) / 5.0f);
+
+				alphab[6] = 0;
+				alphab[7] = 255;
+			}
+
+			uint32_t blended[4];
+			blended[0] = convert565To8888(color_0) & 0xFFFFFF00;
+			blended[1] = convert565To8888(color_1) & 0xFFFFFF00;
+			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
+			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
+
+			for (byte y = 0; y < 4; ++y) {
+				for (byte x = 0; x < 4; ++x) {
+					const uint32_t destY = height - 1 - (ty - 4 + y);
+
+					const uint32_t alpha = alphab[(alphabl >> (3 * (4 * (3 - y) + x))) & 7];
+					WRITE_BE_UINT32(dest + destY * pitch + (tx + x) * 4, blended[cpx & 3] | alpha);
+					cpx >>= 2;
+				}
+			}
+		}
+	}
+}
+
+// --- Helpers ---
+
+static std::vector<byte> makeRandomData(uint32_t width, uint32_t height, uint32_t blockSize, uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> value(0, 255);
+
+	std::vector<byte> data(((width + 3) / 4) * ((height + 3) / 4) * blockSize);
+	for (std::vector<byte>::iterator d = data.begin(); d != data.end(); ++d)
+		*d = value(random);
+
+	return data;
+}
+
+static const byte *getPixel(const std::vector<byte> &image, uint32_t width, uint32_t x, uint32_t y) {
+	return &image[(y * width + x) * 4];
+}
+
+// --- Tests ---
+
+GTEST_TEST(S3TC, DXT1) {
+	// Red and blue, and all four pixels of each row picking the same color
+	static const byte kBlock[8] = { 0x00, 0xF8, 0x1F, 0x00, 0x00, 0x55, 0xAA, 0xFF };
+
+	std::vector<byte> image(4 * 4 * 4);
+	Graphics::decompressDXT1(image.data(), kBlock, sizeof(kBlock), 4, 4, 4 * 4);
+
+	static const byte kRed[4]  = { 0xF8, 0x00, 0x00, 0xFF };
+	static const byte kBlue[4] = { 0x00, 0x00, 0xF8, 0xFF };
+
+	for (uint32_t x = 0; x < 4; x++) {
+		EXPECT_EQ(std::memcmp(getPixel(image, 4, x, 0), kRed , 4), 0) << "At " << x;
+		EXPECT_EQ(std::memcmp(getPixel(image, 4, x, 1), kBlue, 4), 0) << "At " << x;
+
+		// 2/3 red and 1/3 blue, and the other way around
+		EXPECT_EQ(getPixel(image, 4, x, 2)[0], 0xA5);
+		EXPECT_EQ(getPixel(image, 4, x, 2)[2], 0x52);
+		EXPECT_EQ(getPixel(image, 4, x, 3)[0], 0x52);
+		EXPECT_EQ(getPixel(image, 4, x, 3)[2], 0xA5);
+	}
+}
+
+GTEST_TEST(S3TC, DXT1Transparent) {
+	// The first color is smaller than the second, so index 3 is transparent black
+	static const byte kBlock[8] = { 0x1F, 0x00, 0x00, 0xF8, 0xFF, 0xFF, 0xFF, 0xFF };
+
+	std::vector<byte> image(4 * 4 * 4, 0x42);
+	Graphics::decompressDXT1(image.data(), kBlock, sizeof(kBlock), 4, 4, 4 * 4);
+
+	for (size_t i = 0; i < image.size(); i++)
+		EXPECT_EQ(image[i], 0x00) << "At " << i;
+}
+
+GTEST_TEST(S3TC, DXT3Alpha) {
+	// Alpha rows 0x0, 0x5, 0xA, 0xF from the top, white color
+	static const byte kBlock[16] = { 0x00, 0x00, 0x55, 0x55, 0xAA, 0xAA, 0xFF, 0xFF,
+	                                 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00 };
+
+	std::vector<byte> image(4 * 4 * 4);
+	Graphics::decompressDXT3(image.data(), kBlock, sizeof(kBlock), 4, 4, 4 * 4);
+
+	static const byte kAlpha[4] = { 0x00, 0x50, 0xA0, 0xF0 };
+
+	for (uint32_t y = 0; y < 4; y++) {
+		for (uint32_t x = 0; x < 4; x++) {
+			EXPECT_EQ(getPixel(image, 4, x, y)[0], 0xF8) << "At " << x << "." << y;
+			EXPECT_EQ(getPixel(image, 4, x, y)[3], kAlpha[y]) << "At " << x << "." << y;
+		}
+	}
+}
+
+GTEST_TEST(S3TC, smallImage) {
+	// A 2x2 image still uses the top left corner of a full block
+	static const byte kBlock[8] = { 0x00, 0xF8, 0x1F, 0x00, 0x04, 0x01, 0xAA, 0xFF };
+
+	std::vector<byte> image(2 * 2 * 4);
+	Graphics::decompressDXT1(image.data(), kBlock, sizeof(kBlock), 2, 2, 2 * 4);
+
+	EXPECT_EQ(getPixel(image, 2, 0, 0)[0], 0xF8);
+	EXPECT_EQ(getPixel(image, 2, 1, 0)[2], 0xF8);
+	EXPECT_EQ(getPixel(image, 2, 0, 1)[2], 0xF8);
+	EXPECT_EQ(getPixel(image, 2, 1, 1)[0], 0xF8);
+}
+
+GTEST_TEST(S3TC, oddSize) {
+	// A 6x6 image only uses parts of the blocks in the last row and column
+	const std::vector<byte> data = makeRandomData(6, 6, 16, 5);
+
+	std::vector<byte> full(8 * 8 * 4);
+	Graphics::decompressDXT5(full.data(), data.data(), data.size(), 8, 8, 8 * 4);
+
+	// Rows padded by 2 pixels, and more room after the image, all of which has to stay untouched
+	static const uint32_t kPitch = (6 + 2) * 4;
+
+	std::vector<byte> image(6 * kPitch + 64, 0x42);
+	Graphics::decompressDXT5(image.data(), data.data(), data.size(), 6, 6, kPitch);
+
+	for (uint32_t y = 0; y < 6; y++) {
+		EXPECT_EQ(std::memcmp(&image[y * kPitch], &full[y * 8 * 4], 6 * 4), 0) << "At row " << y;
+
+		for (uint32_t x = 6 * 4; x < kPitch; x++)
+			EXPECT_EQ(image[y * kPitch + x], 0x42) << "At " << x << "." << y;
+	}
+
+	for (size_t i = 6 * kPitch; i < image.size(); i++)
+		EXPECT_EQ(image[i], 0x42) << "At " << i;
+}
+
+GTEST_TEST(S3TC, matchesReference) {
+	const std::vector<byte> dxt1 = makeRandomData(64, 32, 8, 1);
+	const std::vector<byte> dxt5 = makeRandomData(64, 32, 16, 2);
+
+	std::vector<byte> image(64 * 32 * 4), reference(64 * 32 * 4);
+
+	Common::MemoryReadStream stream1(dxt1.data(), dxt1.size());
+	referenceDXT1(reference.data(), stream1, 64, 32, 64 * 4);
+	Graphics::decompressDXT1(image.data(), dxt1.data(), dxt1.size(), 64, 32, 64 * 4);
+
+	EXPECT_EQ(image, reference);
+
+	Common::MemoryReadStream stream5(dxt5.data(), dxt5.size());
+	referenceDXT5(reference.data(), stream5, 64, 32, 64 * 4);
+	Graphics::decompressDXT5(image.data(), dxt5.data(), dxt5.size(), 64, 32, 64 * 4);
+
+	EXPECT_EQ(image, reference);
+}
+
+GTEST_TEST(S3TC, stream) {
+	const std::vector<byte> data = makeRandomData(16, 16, 16, 3);
+
+	std::vector<byte> image(16 * 16 * 4), fromStream(16 * 16 * 4);
+	Graphics::decompressDXT5(image.data(), data.data(), data.size(), 16, 16, 16 * 4);
+
+	Common::MemoryReadStream stream(data.data(), data.size());
+	Graphics::decompressDXT5(fromStream.data(), stream, 16, 16, 16 * 4);
+
+	EXPECT_EQ(fromStream, image);
+	EXPECT_TRUE(stream.eos() || (stream.pos() == stream.size()));
+
+	// Not enough data
+	Common::MemoryReadStream shortStream(data.data(), data.size() - 1);
+	EXPECT_THROW(Graphics::decompressDXT5(fromStream.data(), shortStream, 16, 16, 16 * 4), Common::Exception);
+	EXPECT_THROW(Graphics::decompressDXT5(image.data(), data.data(), data.size() - 1, 16, 16, 16 * 4), Common::Exception);
+}
+
+GTEST_TEST(S3TC, parallel) {
+	const std::vector<byte> data = makeRandomData(512, 512, 16, 4);
+
+	std::vector<byte> image(512 * 512 * 4), parallel(512 * 512 * 4);
+	Graphics::decompressDXT3(image.data(), data.data(), data.size(), 512, 512, 512 * 4);
+
+	Common::ThreadPool pool(3);
+	Graphics::decompressDXT3(parallel.data(), data.data(), data.size(), 512, 512, 512 * 4, &pool);
+
+	EXPECT_EQ(parallel, image);
+}
+
+template<typename F>
+static double measure(F decode) {
+	return benchmarkTime([&]() {
+		for (uint32_t i = 0; i < kBenchmarkIterations; i++)
+			decode();
+	});
+}
+
+GTEST_TEST(S3TC, DISABLED_benchmark) {
+	const std::vector<byte> dxt1 = makeRandomData(kBenchmarkSize, kBenchmarkSize, 8, 5);
+	const std::vector<byte> dxt5 = makeRandomData(kBenchmarkSize, kBenchmarkSize, 16, 6);
+
+	std::vector<byte> image(kBenchmarkSize * kBenchmarkSize * 4);
+
+	const uint32_t size  = kBenchmarkSize;
+	const uint32_t pitch = kBenchmarkSize * 4;
+
+	Common::ThreadPool pool;
+
+	const double msStream1 = measure([&]() {
+		Common::MemoryReadStream stream(dxt1.data(), dxt1.size());
+		referenceDXT1(image.data(), stream, size, size, pitch);
+	});
+	const double msMemory1 = measure([&]() {
+		Graphics::decompressDXT1(image.data(), dxt1.data(), dxt1.size(), size, size, pitch);
+	});
+	const double msPool1 = measure([&]() {
+		Graphics::decompressDXT1(image.data(), dxt1.data(), dxt1.size(), size, size, pitch, &pool);
+	});
+
+	const double msStream5 = measure([&]() {
+		Common::MemoryReadStream stream(dxt5.data(), dxt5.size());
+		referenceDXT5(image.data(), stream, size, size, pitch);
+	});
+	const double msMemory5 = measure([&]() {
+		Graphics::decompressDXT5(image.data(), dxt5.data(), dxt5.size(), size, size, pitch);
+	});
+	const double msPool5 = measure([&]() {
+		Graphics::decompressDXT5(image.data(), dxt5.data(), dxt5.size(), size, size, pitch, &pool);
+	});
+
+	benchmarkPrint("%ux%u DXT1, %u times: stream %.2f ms, memory %.2f ms, %u threads %.2f ms",
+	               size, size, kBenchmarkIterations, msStream1, msMemory1, (uint)pool.getThreadCount(), msPool1);
+	benchmarkPrint("%ux%u DXT5, %u times: stream %.2f ms, memory %.2f ms, %u threads %.2f ms",
+	               size, size, kBenchmarkIterations, msStream5, msMemory5, (uint)pool.getThreadCount(), msPool5);
+}
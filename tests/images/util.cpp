@@ -20,11 +20,17 @@
 
 /** @file
  *  Unit tests for our utility image functions.
+ *
+ *  The de-swizzling benchmark compares the tiled implementation against
+ *  the old pixel by pixel loop. It needs to be asked for by name.
  */
 
 #include <cstring>
 
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "tests/benchmark.h"
 
 #include "src/common/error.h"
 
@@ -422,3 +428,92 @@ GTEST_TEST(ImagesUtil, deSwizzleOffset) {
 	for (size_t i = 0; i < (kWidth * kHeight); i++)
 		EXPECT_EQ(buffer[i], kSwizzled[i]) << "At index " << i;
 }
+
+/** Fill a large image with a pattern that differs from pixel to pixel. */
+static std::vector<byte> makeImage(uint32_t width, uint32_t height, uint32_t bpp) {
+	std::vector<byte> image(width * height * bpp);
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = (i * 7) ^ (i >> 8);
+
+	return image;
+}
+
+GTEST_TEST(ImageUtil, rotate90Large) {
+	// Sizes crossing the tile boundaries, even and odd
+	static const int kSizes[] = { 37, 40 };
+
+	for (size_t s = 0; s < ARRAYSIZE(kSizes); s++) {
+		const int n = kSizes[s];
+
+		const std::vector<byte> image = makeImage(n, n, 3);
+
+		for (int steps = 1; steps < 4; steps++) {
+			std::vector<byte> rotated = image;
+			Graphics::rotate90(rotated.data(), n, n, 3, steps);
+
+			for (int y = 0; y < n; y++) {
+				for (int x = 0; x < n; x++) {
+					// Where the pixel now at (x, y) came from
+					int srcX = x, srcY = y;
+					for (int i = 0; i < steps; i++) {
+						const int tmp = srcX;
+
+						srcX = srcY;
+						srcY = n - 1 - tmp;
+					}
+
+					ASSERT_EQ(std::memcmp(&rotated[(y * n + x) * 3], &image[(srcY * n + srcX) * 3], 3), 0)
+						<< "At size " << n << ", steps " << steps << ", pixel " << x << "." << y;
+				}
+			}
+		}
+	}
+}
+
+GTEST_TEST(ImagesUtil, deSwizzle) {
+	static const uint32_t kWidth = 64, kHeight = 16;
+
+	for (uint32_t bpp = 3; bpp <= 4; bpp++) {
+		const std::vector<byte> swizzled = makeImage(kWidth, kHeight, bpp);
+
+		std::vector<byte> image(swizzled.size());
+		Graphics::deSwizzle(image.data(), swizzled.data(), kWidth, kHeight, bpp);
+
+		for (uint32_t y = 0; y < kHeight; y++) {
+			for (uint32_t x = 0; x < kWidth; x++) {
+				const uint32_t offset = Graphics::deSwizzleOffset(x, y, kWidth, kHeight) * bpp;
+
+				ASSERT_EQ(std::memcmp(&image[(y * kWidth + x) * bpp], &swizzled[offset], bpp), 0)
+					<< "At bpp " << bpp << ", pixel " << x << "." << y;
+			}
+		}
+	}
+}
+
+GTEST_TEST(ImagesUtil, DISABLED_deSwizzleBenchmark) {
+	static const uint32_t kSize = 1024, kBPP = 4;
+
+	const std::vector<byte> swizzled = makeImage(kSize, kSize, kBPP);
+	std::vector<byte> image1(swizzled.size()), image2(swizzled.size());
+
+	// The way we used to do it, pixel by pixel
+	const double msPixels = benchmarkTime([&]() {
+		byte *dst = image1.data();
+		for (uint32_t y = 0; y < kSize; y++) {
+			for (uint32_t x = 0; x < kSize; x++) {
+				const uint32_t offset = Graphics::deSwizzleOffset(x, y, kSize, kSize) * kBPP;
+
+				for (uint32_t p = 0; p < kBPP; p++)
+					*dst++ = swizzled[offset + p];
+			}
+		}
+	});
+
+	const double msTiles = benchmarkTime([&]() {
+		Graphics::deSwizzle(image2.data(), swizzled.data(), kSize, kSize, kBPP);
+	});
+
+	EXPECT_EQ(image1, image2);
+
+	benchmarkPrint("De-swizzling %ux%u: per pixel %.2f ms, tiled %.2f ms", kSize, kSize, msPixels, msTiles);
+}
@@ -33,6 +33,7 @@ test_CXXFLAGS = $(GTEST_FLAGS) $(AM_CXXFLAGS)
 
 noinst_HEADERS += \
     tests/skip.h \
+    tests/benchmark.h \
     $(EMPTY)
 
 include tests/engines/rules.mk
@@ -40,6 +41,7 @@ include tests/version/rules.mk
 include tests/common/rules.mk
 include tests/aurora/rules.mk
 include tests/images/rules.mk
+include tests/graphics/rules.mk
 include tests/engines/nwn2/rules.mk
 
 TESTS += $(check_PROGRAMS)